@@ -0,0 +1,67 @@
+// Greeks by algorithmic differentiation (adjoint and forward-over-adjoint) of the pricing formulas
+
+#ifndef ALGORITHMICGREEKS_H
+#define ALGORITHMICGREEKS_H
+
+#include <cstddef>
+#include "EuropeanOption.h"
+#include "Greeks.h"  // GreeksResult
+
+// Inputs the sensitivities are taken with respect to, in the order of the arrays below
+enum class AdInput { Spot, Strike, Maturity, Volatility, Rate, Carry };
+const std::size_t AdInputCount = 6;
+
+// Price and its first derivatives: first[i] = dV / d input i (AdInput order).
+// Rate and Carry are the partial derivatives with r and b moved separately; Greeks::Rho moves both together.
+struct Sensitivities
+{
+    double price;
+    double first[AdInputCount];
+
+    double operator[](AdInput i) const { return first[static_cast<std::size_t>(i)]; }
+};
+
+// Adds the symmetric Hessian: second[i][j] = d2V / d input i d input j
+struct SecondOrderSensitivities : Sensitivities
+{
+    double second[AdInputCount][AdInputCount];
+
+    double operator()(AdInput i, AdInput j) const { return second[static_cast<std::size_t>(i)][static_cast<std::size_t>(j)]; }
+};
+
+// The pricing formulas are written as templates over their number type and evaluated on the types of AutoDiff.h:
+//   European closed form, AmericanOption perpetual closed form, and AmericanOption on the lattice (the roll-back of
+//   LatticeEngine itself, including the tree geometry and the Richardson extrapolation).
+//
+//   First()  : records one evaluation on a tape and sweeps it backwards once, giving all six first derivatives at a
+//              small constant multiple of one price (no step size, no per-Greek reprice).
+//   Second() : forward-over-reverse, one recording and sweep per input (six), giving the full Hessian;
+//              the gradient comes out of the same sweeps.
+//   Greeks() : GreeksResult from a single forward-over-reverse sweep seeded on the spot, which returns the
+//              gradient and Gamma together. Lattice contracts use First() and the tree-node Gamma instead
+//              (see the note in Lattice.h).
+//
+// The tapes are kept per thread and reused, so after the first call on a thread no allocation happens for the
+// closed forms and the lattice.
+// Contract types without a generic formula (any other class derived from EuropeanOption) give NaN everywhere.
+// On the lattice the roll-back is not recorded node by node: the tree is kept and swept backwards by hand, and only
+// the result goes on the tape. That costs about 8 plain lattice prices (about 2x the bumped LatticeEngine::Greeks);
+// what it adds is exact tree derivatives in all six inputs, K, T and b included.
+// Pathwise tree derivatives are only meaningful on Leisen-Reimer trees (the default): CRR and trinomial prices have a
+// kink in S wherever a node lands on the strike, so on those trees First() and Greeks() take Delta from the nodes
+// (LatticeEngine::NodeGreeks), like Gamma, and their other derivatives are those of a tree with such kinks.
+
+class AlgorithmicGreeks
+{
+public:
+    // True when opt has a generic formula (EuropeanOption, AmericanOption)
+    static bool Supports(const EuropeanOption& opt);
+
+    static Sensitivities First(const EuropeanOption& opt, double S);
+    static SecondOrderSensitivities Second(const EuropeanOption& opt, double S);
+
+    // Theta = -dV/dT and Rho = dV/dr + dV/db, matching Greeks::Theta / Greeks::Rho
+    static GreeksResult Greeks(const EuropeanOption& opt, double S);
+};
+
+#endif
@@ -3,21 +3,57 @@
 #define AMERICANOPTION_H
 
 #include "EuropeanOption.h" // Inherit from EuropeanOption for parameter reuse
+#include "Lattice.h"        // Lattice engine for finite maturities
 #include <string>
 #include <cmath>
 
 // This class represents Perpetual American Options.
 // It inherits from EuropeanOption to reuse common parameters (K, r, sig, etc.) and basic interface (Price(), toggle()).
 // Perpetual American options can be exercised at any time and have closed-form solutions in the Black-Scholes framework for infinite maturity.
+// Finite-maturity contracts have no exact closed form; with method = AmericanMethod::Lattice, Price() uses T and
+// prices on the binomial/trinomial lattice described by the lattice settings, and the two approximation methods
+// give a closed-form estimate for real-time quoting (see AmericanApproximation.h).
+
+// Pricing method used by AmericanOption::Price()
+//   Perpetual          : closed-form perpetual formulas, T is ignored (the original behaviour and the default)
+//   Lattice            : finite maturity T on LatticeEngine
+//   BaroneAdesiWhaley  : finite maturity T, quadratic approximation with a Newton solve for the critical price
+//   BjerksundStensland : finite maturity T, Bjerksund-Stensland (2002) two-step flat boundary
+enum class AmericanMethod { Perpetual, Lattice, BaroneAdesiWhaley, BjerksundStensland };
+
+// Spot-independent part of the perpetual formulas: the exponents y1 (call) and y2 (put) with their scale factors,
+// stored with the parameters (r, sig, K, b) they were computed from
+struct PerpetualInvariants
+{
+    double r, sig, K, b;
+    bool valid;
+
+    double y1, callScale, callRatio; // call = callScale * pow(callRatio * S / K, y1), callScale = K / (y1 - 1)
+    double y2, putScale, putRatio;   // put  = putScale  * pow(putRatio  * S / K, y2), putScale  = K / (1 - y2)
+
+    bool Matches(double r_, double sig_, double K_, double b_) const
+    {
+        return valid && r == r_ && sig == sig_ && K == K_ && b == b_;
+    }
+};
 
 class AmericanOption : public EuropeanOption
 {
 private:
     // Private helper functions implement the closed-form formulas for perpetual American calls/puts
-    double CallPriceAmerican(double S) const;
-    double PutPriceAmerican(double S) const;
+    static double CallPriceAmerican(const PerpetualInvariants& c, double S);
+    static double PutPriceAmerican(const PerpetualInvariants& c, double S);
+
+    PerpetualInvariants perpetual; // cache behind Reprice()
+    double criticalRatio;          // last Barone-Adesi-Whaley S*/K, the warm start of the next Reprice()
+
+    // Exponents and scale factors for the current r, sig, K and b
+    PerpetualInvariants ComputePerpetual() const;
 
 public:
+    AmericanMethod method;    // Perpetual by default
+    LatticeSettings lattice;  // Tree type, steps and extrapolation used when method == AmericanMethod::Lattice
+
     // Default constructor initializes parameters with typical defaults
     AmericanOption();
 
@@ -27,6 +63,22 @@ public:
     // Overrides the EuropeanOption::Price() function and calls the appropriate perpetual American pricing formula
     // This allows polymorphic usage where external code calls Price() without knowing the option type
     double Price(double S) const override;
+
+    // Price(S) with r and b set to the zero rates of curves at T (see EuropeanOption), with this option's method
+    double Price(double S, const TermStructure& curves) const override;
+
+    // Spot-only repricing: the perpetual exponents (a sqrt and a pow per call in Price()) are cached and refreshed
+    // when r, sig, K or b change, with the same result as Price(). Lattice pricing has no spot-free part to cache
+    // and goes straight to Price(). Barone-Adesi-Whaley reprices from the cached European invariants with the last
+    // critical price as the Newton start, so an unchanged contract skips the root-find (same price as Price() to
+    // within the solver tolerance).
+    double Reprice(double S) override;
+
+    // Price and Greeks taken from the lattice (finite maturity T, regardless of method)
+    GreeksResult LatticeGreeks(double S) const;
+
+    // Polymorphic copy, so parallel engines price perpetual American options with the right formula
+    std::unique_ptr<EuropeanOption> Clone() const override;
 };
 
 #endif
@@ -0,0 +1,398 @@
+// Algorithmic differentiation: forward-mode dual numbers and a tape for reverse (adjoint) mode
+
+#ifndef AUTODIFF_H
+#define AUTODIFF_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "NormalDistribution.h"
+
+// Pricing formulas written as templates over their number type (see AlgorithmicGreeks and the lattice engine) are
+// instantiated with the types below instead of double. Every arithmetic operation then also carries derivatives,
+// exact to rounding, with no step size to choose.
+//
+//   Dual            : value v and one directional derivative d (forward mode). One evaluation gives the derivative
+//                     along one direction, so n inputs need n evaluations.
+//   Adjoint<double> : value plus an index into the active Tape, where the operation and its local partials are
+//                     recorded (reverse mode). One recording plus one backward sweep over the tape gives the
+//                     derivative of the output with respect to every input, at a small constant multiple of one
+//                     evaluation whatever the number of inputs.
+//   Adjoint<Dual>   : forward-over-reverse. The values carry a tangent along one input direction e, so the backward
+//                     sweep returns both the gradient (the v parts) and the Hessian row H e (the d parts).
+//
+// Comparisons look at values only, so branches (std::max in the lattice roll-back, the sign tests in the closed
+// forms) follow the branch taken by the plain double evaluation and differentiate that branch.
+
+// ---------------- Forward mode ----------------
+
+struct Dual
+{
+    double v; // value
+    double d; // derivative along the seeded direction
+
+    Dual() : v(0.0), d(0.0) {}
+    Dual(double value) : v(value), d(0.0) {}
+    Dual(double value, double derivative) : v(value), d(derivative) {}
+
+    Dual& operator+=(const Dual& o) { v += o.v; d += o.d; return *this; }
+    Dual& operator-=(const Dual& o) { v -= o.v; d -= o.d; return *this; }
+    Dual& operator*=(const Dual& o) { d = d * o.v + v * o.d; v *= o.v; return *this; }
+    Dual& operator/=(const Dual& o) { v /= o.v; d = (d - v * o.d) / o.v; return *this; }
+};
+
+inline Dual operator-(const Dual& a) { return Dual(-a.v, -a.d); }
+inline Dual operator+(const Dual& a, const Dual& b) { return Dual(a.v + b.v, a.d + b.d); }
+inline Dual operator-(const Dual& a, const Dual& b) { return Dual(a.v - b.v, a.d - b.d); }
+inline Dual operator*(const Dual& a, const Dual& b) { return Dual(a.v * b.v, a.d * b.v + a.v * b.d); }
+inline Dual operator/(const Dual& a, const Dual& b) { double q = a.v / b.v; return Dual(q, (a.d - q * b.d) / b.v); }
+inline Dual operator+(const Dual& a, double s) { return Dual(a.v + s, a.d); }
+inline Dual operator+(double s, const Dual& a) { return Dual(s + a.v, a.d); }
+inline Dual operator-(const Dual& a, double s) { return Dual(a.v - s, a.d); }
+inline Dual operator-(double s, const Dual& a) { return Dual(s - a.v, -a.d); }
+inline Dual operator*(const Dual& a, double s) { return Dual(a.v * s, a.d * s); }
+inline Dual operator*(double s, const Dual& a) { return Dual(s * a.v, s * a.d); }
+inline Dual operator/(const Dual& a, double s) { return Dual(a.v / s, a.d / s); }
+inline Dual operator/(double s, const Dual& a) { double q = s / a.v; return Dual(q, -q * a.d / a.v); }
+
+inline bool operator<(const Dual& a, const Dual& b) { return a.v < b.v; }
+inline bool operator>(const Dual& a, const Dual& b) { return a.v > b.v; }
+inline bool operator<=(const Dual& a, const Dual& b) { return a.v <= b.v; }
+inline bool operator>=(const Dual& a, const Dual& b) { return a.v >= b.v; }
+
+inline Dual exp(const Dual& a) { double e = std::exp(a.v); return Dual(e, e * a.d); }
+inline Dual log(const Dual& a) { return Dual(std::log(a.v), a.d / a.v); }
+inline Dual sqrt(const Dual& a) { double s = std::sqrt(a.v); return Dual(s, 0.5 * a.d / s); }
+inline Dual pow(const Dual& a, double p) { double q = std::pow(a.v, p - 1.0); return Dual(q * a.v, p * q * a.d); }
+inline Dual pow(const Dual& a, const Dual& p)
+{
+    double value = std::pow(a.v, p.v);
+    return Dual(value, value * (p.d * std::log(a.v) + p.v * a.d / a.v));
+}
+inline Dual N_pdf(const Dual& a) { double n = N_pdf(a.v); return Dual(n, -a.v * n * a.d); }
+inline Dual N_cdf(const Dual& a) { return Dual(N_cdf(a.v), N_pdf(a.v) * a.d); }
+
+// Value of a plain or dual number, used for comparisons
+inline double Primal(double x) { return x; }
+inline double Primal(const Dual& x) { return x.v; }
+
+// ---------------- Vector forward mode ----------------
+
+// Value v and N directional derivatives d[0..N-1] carried together: one evaluation seeded with the N unit directions
+// gives the whole gradient in N inputs at about 2N + 1 times the arithmetic of a plain evaluation, and records
+// nothing. For short evaluations on few inputs (the lattice tree geometry) this is cheaper than a tape, which would
+// record and sweep every operation. T is double, or Dual to carry the tangents of forward-over-reverse.
+template<class T, std::size_t N>
+struct DualVector
+{
+    T v;
+    T d[N];
+
+    DualVector() : v() { for (std::size_t i = 0; i < N; ++i) d[i] = T(); }
+    DualVector(const T& value) : v(value) { for (std::size_t i = 0; i < N; ++i) d[i] = T(); }
+    template<class U = T, typename std::enable_if<!std::is_same<U, double>::value, int>::type = 0>
+    DualVector(double value) : v(value) { for (std::size_t i = 0; i < N; ++i) d[i] = T(); }
+
+    // Seeded on direction k: dv/dx_k = 1
+    static DualVector Variable(const T& value, std::size_t k)
+    {
+        DualVector x(value);
+        x.d[k] = T(1.0);
+        return x;
+    }
+
+    DualVector& operator+=(const DualVector& o) { return *this = *this + o; }
+    DualVector& operator-=(const DualVector& o) { return *this = *this - o; }
+    DualVector& operator*=(const DualVector& o) { return *this = *this * o; }
+    DualVector& operator/=(const DualVector& o) { return *this = *this / o; }
+
+    // Result with value value and derivatives scale * a.d (the chain rule of a unary function)
+    static DualVector Chain(const T& value, const DualVector& a, const T& scale)
+    {
+        DualVector r(value);
+        for (std::size_t i = 0; i < N; ++i) r.d[i] = scale * a.d[i];
+        return r;
+    }
+
+    friend DualVector operator-(const DualVector& a) { return Chain(-a.v, a, T(-1.0)); }
+    friend DualVector operator+(const DualVector& a, const DualVector& b)
+    {
+        DualVector r(a.v + b.v);
+        for (std::size_t i = 0; i < N; ++i) r.d[i] = a.d[i] + b.d[i];
+        return r;
+    }
+    friend DualVector operator-(const DualVector& a, const DualVector& b)
+    {
+        DualVector r(a.v - b.v);
+        for (std::size_t i = 0; i < N; ++i) r.d[i] = a.d[i] - b.d[i];
+        return r;
+    }
+    friend DualVector operator*(const DualVector& a, const DualVector& b)
+    {
+        DualVector r(a.v * b.v);
+        for (std::size_t i = 0; i < N; ++i) r.d[i] = a.d[i] * b.v + a.v * b.d[i];
+        return r;
+    }
+    friend DualVector operator/(const DualVector& a, const DualVector& b)
+    {
+        const T inv = T(1.0) / b.v;
+        const T q = a.v * inv;
+        DualVector r(q);
+        for (std::size_t i = 0; i < N; ++i) r.d[i] = (a.d[i] - q * b.d[i]) * inv;
+        return r;
+    }
+    friend DualVector operator+(const DualVector& a, double s) { DualVector r(a); r.v = a.v + s; return r; }
+    friend DualVector operator+(double s, const DualVector& a) { return a + s; }
+    friend DualVector operator-(const DualVector& a, double s) { DualVector r(a); r.v = a.v - s; return r; }
+    friend DualVector operator-(double s, const DualVector& a) { return Chain(s - a.v, a, T(-1.0)); }
+    friend DualVector operator*(const DualVector& a, double s) { return Chain(a.v * s, a, T(s)); }
+    friend DualVector operator*(double s, const DualVector& a) { return Chain(s * a.v, a, T(s)); }
+    friend DualVector operator/(const DualVector& a, double s) { return Chain(a.v / s, a, T(1.0 / s)); }
+    friend DualVector operator/(double s, const DualVector& a)
+    {
+        const T q = s / a.v;
+        return Chain(q, a, -q / a.v);
+    }
+
+    friend bool operator<(const DualVector& a, const DualVector& b) { return Primal(a.v) < Primal(b.v); }
+    friend bool operator>(const DualVector& a, const DualVector& b) { return Primal(a.v) > Primal(b.v); }
+    friend bool operator<=(const DualVector& a, const DualVector& b) { return Primal(a.v) <= Primal(b.v); }
+    friend bool operator>=(const DualVector& a, const DualVector& b) { return Primal(a.v) >= Primal(b.v); }
+    friend bool operator<(const DualVector& a, double s) { return Primal(a.v) < s; }
+    friend bool operator>(const DualVector& a, double s) { return Primal(a.v) > s; }
+    friend bool operator<=(const DualVector& a, double s) { return Primal(a.v) <= s; }
+    friend bool operator>=(const DualVector& a, double s) { return Primal(a.v) >= s; }
+
+    friend DualVector exp(const DualVector& a)
+    {
+        using std::exp;
+        const T e = exp(a.v);
+        return Chain(e, a, e);
+    }
+    friend DualVector log(const DualVector& a)
+    {
+        using std::log;
+        return Chain(log(a.v), a, T(1.0) / a.v);
+    }
+    friend DualVector sqrt(const DualVector& a)
+    {
+        using std::sqrt;
+        const T r = sqrt(a.v);
+        return Chain(r, a, 0.5 / r);
+    }
+    friend DualVector pow(const DualVector& a, double p)
+    {
+        using std::pow;
+        const T q = pow(a.v, p - 1.0);
+        return Chain(q * a.v, a, p * q);
+    }
+};
+
+template<class T, std::size_t N> double Primal(const DualVector<T, N>& x) { return Primal(x.v); }
+
+// ---------------- Reverse mode ----------------
+
+template<class T> class Adjoint;
+
+// Linear record of the operations on Adjoint<T> values. Node i holds up to two parents and the partial derivative
+// of node i with respect to each; inputs are nodes without parents. Clear() keeps the capacity, so one tape reused
+// across evaluations stops allocating after the first.
+//
+// Operations record on the tape made active for the current thread with ActiveTape; values that do not depend on
+// any input (constants, or operations on constants only) are never recorded.
+template<class T>
+class Tape
+{
+public:
+    static const std::uint32_t Passive = 0xFFFFFFFFu; // index of values that are not on the tape
+
+    struct Node
+    {
+        std::uint32_t parent[2];
+        T partial[2];
+    };
+
+    void Clear() { nodes.clear(); }
+    std::size_t Size() const { return nodes.size(); }
+    void Reserve(std::size_t n) { nodes.reserve(n); }
+
+    // New independent input with the given value
+    Adjoint<T> Variable(const T& value)
+    {
+        return Adjoint<T>(value, Record(Passive, T(), Passive, T()));
+    }
+
+    std::uint32_t Record(std::uint32_t p0, const T& d0, std::uint32_t p1, const T& d1)
+    {
+        Node n;
+        n.parent[0] = p0; n.partial[0] = d0;
+        n.parent[1] = p1; n.partial[1] = d1;
+        nodes.push_back(n);
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+
+    // Backward sweep from output: adjoints[i] = d output / d node i for every node on the tape.
+    // A passive output (no dependence on any input) leaves all adjoints at zero.
+    void Gradient(const Adjoint<T>& output, std::vector<T>& adjoints) const
+    {
+        adjoints.assign(nodes.size(), T());
+        if (output.index == Passive) return;
+
+        adjoints[output.index] = T(1.0);
+        for (std::size_t i = output.index + 1; i-- > 0; )
+        {
+            const Node& n = nodes[i];
+            const T& a = adjoints[i];
+            if (n.parent[0] != Passive) adjoints[n.parent[0]] += n.partial[0] * a;
+            if (n.parent[1] != Passive) adjoints[n.parent[1]] += n.partial[1] * a;
+        }
+    }
+
+    // Tape recording on this thread, or nullptr
+    static Tape*& Active()
+    {
+        static thread_local Tape* active = nullptr;
+        return active;
+    }
+
+private:
+    std::vector<Node> nodes;
+};
+
+// Makes a tape the active one for the current thread for the lifetime of the scope
+template<class T>
+class ActiveTape
+{
+public:
+    explicit ActiveTape(Tape<T>& tape) : previous(Tape<T>::Active()) { Tape<T>::Active() = &tape; }
+    ~ActiveTape() { Tape<T>::Active() = previous; }
+
+    ActiveTape(const ActiveTape&) = delete;
+    ActiveTape& operator=(const ActiveTape&) = delete;
+
+private:
+    Tape<T>* previous;
+};
+
+template<class T>
+class Adjoint
+{
+public:
+    T value;
+    std::uint32_t index; // node on the active tape, or Tape<T>::Passive
+
+    Adjoint() : value(), index(Tape<T>::Passive) {}
+    Adjoint(const T& v) : value(v), index(Tape<T>::Passive) {}
+    template<class U = T, typename std::enable_if<!std::is_same<U, double>::value, int>::type = 0>
+    Adjoint(double v) : value(v), index(Tape<T>::Passive) {}
+    Adjoint(const T& v, std::uint32_t i) : value(v), index(i) {}
+
+    // Result of a unary operation with local partial d
+    static Adjoint Unary(const T& v, const Adjoint& a, const T& d)
+    {
+        if (a.index == Tape<T>::Passive) return Adjoint(v);
+        return Adjoint(v, Tape<T>::Active()->Record(a.index, d, Tape<T>::Passive, T()));
+    }
+
+    // Result of a binary operation with local partials da and db
+    static Adjoint Binary(const T& v, const Adjoint& a, const T& da, const Adjoint& b, const T& db)
+    {
+        if (a.index == Tape<T>::Passive) return Unary(v, b, db);
+        if (b.index == Tape<T>::Passive) return Unary(v, a, da);
+        return Adjoint(v, Tape<T>::Active()->Record(a.index, da, b.index, db));
+    }
+
+    Adjoint& operator+=(const Adjoint& o) { return *this = *this + o; }
+    Adjoint& operator-=(const Adjoint& o) { return *this = *this - o; }
+    Adjoint& operator*=(const Adjoint& o) { return *this = *this * o; }
+    Adjoint& operator/=(const Adjoint& o) { return *this = *this / o; }
+};
+
+template<class T> Adjoint<T> operator-(const Adjoint<T>& a) { return Adjoint<T>::Unary(-a.value, a, T(-1.0)); }
+
+template<class T> Adjoint<T> operator+(const Adjoint<T>& a, const Adjoint<T>& b)
+{
+    return Adjoint<T>::Binary(a.value + b.value, a, T(1.0), b, T(1.0));
+}
+template<class T> Adjoint<T> operator-(const Adjoint<T>& a, const Adjoint<T>& b)
+{
+    return Adjoint<T>::Binary(a.value - b.value, a, T(1.0), b, T(-1.0));
+}
+template<class T> Adjoint<T> operator*(const Adjoint<T>& a, const Adjoint<T>& b)
+{
+    return Adjoint<T>::Binary(a.value * b.value, a, b.value, b, a.value);
+}
+template<class T> Adjoint<T> operator/(const Adjoint<T>& a, const Adjoint<T>& b)
+{
+    T inv = T(1.0) / b.value;
+    T q = a.value * inv;
+    return Adjoint<T>::Binary(q, a, inv, b, -q * inv);
+}
+
+template<class T> Adjoint<T> operator+(const Adjoint<T>& a, double s) { return Adjoint<T>::Unary(a.value + s, a, T(1.0)); }
+template<class T> Adjoint<T> operator+(double s, const Adjoint<T>& a) { return Adjoint<T>::Unary(s + a.value, a, T(1.0)); }
+template<class T> Adjoint<T> operator-(const Adjoint<T>& a, double s) { return Adjoint<T>::Unary(a.value - s, a, T(1.0)); }
+template<class T> Adjoint<T> operator-(double s, const Adjoint<T>& a) { return Adjoint<T>::Unary(s - a.value, a, T(-1.0)); }
+template<class T> Adjoint<T> operator*(const Adjoint<T>& a, double s) { return Adjoint<T>::Unary(a.value * s, a, T(s)); }
+template<class T> Adjoint<T> operator*(double s, const Adjoint<T>& a) { return Adjoint<T>::Unary(s * a.value, a, T(s)); }
+template<class T> Adjoint<T> operator/(const Adjoint<T>& a, double s) { return Adjoint<T>::Unary(a.value / s, a, T(1.0 / s)); }
+template<class T> Adjoint<T> operator/(double s, const Adjoint<T>& a)
+{
+    T q = s / a.value;
+    return Adjoint<T>::Unary(q, a, -q / a.value);
+}
+
+template<class T> bool operator<(const Adjoint<T>& a, const Adjoint<T>& b) { return Primal(a.value) < Primal(b.value); }
+template<class T> bool operator>(const Adjoint<T>& a, const Adjoint<T>& b) { return Primal(a.value) > Primal(b.value); }
+template<class T> bool operator<=(const Adjoint<T>& a, const Adjoint<T>& b) { return Primal(a.value) <= Primal(b.value); }
+template<class T> bool operator>=(const Adjoint<T>& a, const Adjoint<T>& b) { return Primal(a.value) >= Primal(b.value); }
+template<class T> bool operator<(const Adjoint<T>& a, double s) { return Primal(a.value) < s; }
+template<class T> bool operator>(const Adjoint<T>& a, double s) { return Primal(a.value) > s; }
+template<class T> bool operator<=(const Adjoint<T>& a, double s) { return Primal(a.value) <= s; }
+template<class T> bool operator>=(const Adjoint<T>& a, double s) { return Primal(a.value) >= s; }
+
+template<class T> Adjoint<T> exp(const Adjoint<T>& a)
+{
+    using std::exp;
+    T e = exp(a.value);
+    return Adjoint<T>::Unary(e, a, e);
+}
+template<class T> Adjoint<T> log(const Adjoint<T>& a)
+{
+    using std::log;
+    return Adjoint<T>::Unary(log(a.value), a, T(1.0) / a.value);
+}
+template<class T> Adjoint<T> sqrt(const Adjoint<T>& a)
+{
+    using std::sqrt;
+    T s = sqrt(a.value);
+    return Adjoint<T>::Unary(s, a, 0.5 / s);
+}
+template<class T> Adjoint<T> pow(const Adjoint<T>& a, double p)
+{
+    using std::pow;
+    T q = pow(a.value, p - 1.0);
+    return Adjoint<T>::Unary(q * a.value, a, p * q);
+}
+template<class T> Adjoint<T> pow(const Adjoint<T>& a, const Adjoint<T>& p)
+{
+    using std::pow; using std::log;
+    T value = pow(a.value, p.value);
+    return Adjoint<T>::Binary(value, a, p.value * value / a.value, p, value * log(a.value));
+}
+template<class T> Adjoint<T> N_pdf(const Adjoint<T>& a)
+{
+    T n = N_pdf(a.value);
+    return Adjoint<T>::Unary(n, a, -a.value * n);
+}
+template<class T> Adjoint<T> N_cdf(const Adjoint<T>& a)
+{
+    return Adjoint<T>::Unary(N_cdf(a.value), a, N_pdf(a.value));
+}
+
+inline double Primal(const Adjoint<double>& x) { return x.value; }
+inline double Primal(const Adjoint<Dual>& x) { return x.value.v; }
+
+#endif
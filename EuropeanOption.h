@@ -3,6 +3,30 @@
 #define EUROPEANOPTION_H
 
 #include <string>
+#include <memory>
+
+class TermStructure; // rate and carry curves, see RateCurve.h
+struct TermFactors;
+
+// Spot-independent terms of the Black-Scholes formulas, stored with the parameters they were computed from.
+// When only the spot moves (the common case for a live quote) these stay valid and a reprice needs just
+// log(S/K) and the two normal CDFs.
+struct OptionInvariants
+{
+    double r, sig, K, T, b; // parameters at the last refresh
+    bool valid;             // false until the first refresh
+
+    double volSqrtT;        // sigma*sqrt(T)
+    double drift;           // (b + 0.5*sigma^2) * T, the spot-free part of d1's numerator
+    double carry;           // exp((b-r)T)
+    double K_df;            // K * exp(-rT)
+
+    // True when the stored terms were computed from exactly these parameters
+    bool Matches(double r_, double sig_, double K_, double T_, double b_) const
+    {
+        return valid && r == r_ && sig == sig_ && K == K_ && T == T_ && b == b_;
+    }
+};
 
 // The EuropeanOption class encapsulates all the data and functionality needed to price a European option using the Black-Scholes formula.
 
@@ -11,8 +35,14 @@ class EuropeanOption
 private:
     // These helper functions compute the exact Call and Put prices 
     // keeping them private ensures that external code uses the unified Price() interface.
-    double CallPrice(double S) const; // Compute exact call price for a given spot
-    double PutPrice(double S) const;  // Compute exact put price for a given spot
+    // Both take the spot-independent terms, so the full and the cached path evaluate the same expressions.
+    static double CallPrice(const OptionInvariants& c, double S); // Compute exact call price for a given spot
+    static double PutPrice(const OptionInvariants& c, double S);  // Compute exact put price for a given spot
+
+    OptionInvariants invariants; // cache behind Invariants() / Reprice()
+
+    // The American approximations add an early-exercise premium to these same formulas
+    friend class AmericanApproximation;
 
 public:
 	// Public member variables for option parameters
@@ -33,8 +63,39 @@ public:
     // Using a public method to call price allows for a unified interface
     // We can call Price without worrying about call vs put
 	// The correct pricing function is chosen internally based on optType
+    // Price() uses the cached invariants when they still match r, sig, K, T and b, and otherwise recomputes them
+    // for this call without touching the cache. It never writes the option, but it does read the cache, so calling it
+    // from several threads is safe only while no thread calls Reprice() or Invariants() on the same object; a thread
+    // that reprices needs its own copy from Clone().
     virtual double Price(double S) const;
     void toggle();
+
+    // Spot-only repricing path: refreshes the cache if any of r, sig, K, T or b changed since the last call
+    // (detected by comparing the stored values, so assigning the public members is enough to invalidate it),
+    // then prices from the cached terms. Gives exactly the same result as Price(). Not const: an option repriced
+    // from several threads needs one copy per thread, as the parallel engines already take with Clone().
+    virtual double Reprice(double S);
+
+    // Cached invariants for the current parameters, refreshed when stale
+    const OptionInvariants& Invariants();
+
+    // Invariants computed from the current parameters without using the cache
+    OptionInvariants ComputeInvariants() const;
+
+    // ---------------- Rate and carry curves ----------------
+    // Price with the rate and carry taken from curves at this option's T instead of the members r and b: the zero
+    // rates over [0, T] stand in for r and b, which prices time-dependent rates exactly in the European closed form.
+    // Virtual so derived contracts price with their own method at those zero rates, like MatrixPricer on curves.
+    virtual double Price(double S, const TermStructure& curves) const;
+
+    // Invariants from factors already computed for this option's maturity (factors.T == T), so contracts sharing
+    // an expiry share the exponentials; r and b of the result are the zero rates of the factors
+    OptionInvariants ComputeInvariants(const TermFactors& factors) const;
+
+    // Virtual destructor and polymorphic copy so engines can take private copies of any option type
+    // (e.g. one per worker thread) instead of mutating the caller's object
+    virtual ~EuropeanOption() = default;
+    virtual std::unique_ptr<EuropeanOption> Clone() const;
 };
 
 
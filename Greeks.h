@@ -2,6 +2,7 @@
 #ifndef GREEKS_H
 #define GREEKS_H
 
+#include <cstdint>
 #include "EuropeanOption.h"
 
 
@@ -14,6 +15,33 @@ enum class GreekType { Delta, Gamma, Vega, Theta, Rho };
 // This is for numerical approximations of Greeks based ons tep size h.
 enum class NumericGreekType { DeltaFD, GammaFD };
 
+// Plain result struct holding the price and all five exact Greeks of one contract at one spot.
+// Returned by Greeks::All so a risk report gets everything from a single evaluation.
+struct GreeksResult
+{
+    double price;
+    double delta;
+    double gamma;
+    double vega;
+    double theta;
+    double rho;
+};
+
+// GreeksResult in single precision, written by the float batch kernel
+struct GreeksResultF
+{
+    float price;
+    float delta;
+    float gamma;
+    float vega;
+    float theta;
+    float rho;
+};
+
+struct OptionBatch; // Structure-of-arrays contract storage, see BatchPricer.h
+struct OptionBatchF; // Its single-precision counterpart
+class TermStructure; // Rate and carry curves, see RateCurve.h
+
 class Greeks
 {
 public:
@@ -30,6 +58,37 @@ public:
     static double Theta(const EuropeanOption& opt, double S);
     static double Rho(const EuropeanOption& opt, double S);
 
+    // Computes the Black-Scholes price and all five Greeks above in one pass.
+    // sigma*sqrt(T), log(S/K), d1/d2, the carry/discount exponentials and the CDF/PDF values are each evaluated once,
+    // instead of once per Greek. Like the individual functions it uses the European closed form.
+    static GreeksResult All(const EuropeanOption& opt, double S);
+
+    // All with the rate and carry taken from curves at opt.T instead of opt.r and opt.b (see EuropeanOption::Price
+    // with a TermStructure). Theta includes the roll along the curves: the rate terms use the instantaneous forwards
+    // at T, so it is -dV/dT with the curves held fixed. Rho is the parallel shift of both curves.
+    static GreeksResult All(const EuropeanOption& opt, double S, const TermStructure& curves);
+
+    // Batch version of All: contract i of the batch is evaluated at spot S[i] and written to out[i].
+    // Runs on the SIMD array kernels in VectorMath and performs no allocation.
+    static void AllBatch(const OptionBatch& batch, const double* S, GreeksResult* out);
+
+    // AllBatch for a book whose contracts share expiries: contract i takes its rates and its two exponentials from
+    // factors[expiry[i]] (the factors at batch.T[i]; the batch's r and b are ignored), so exp((b-r)T) and exp(-rT)
+    // are evaluated once per entry of the table instead of once per contract.
+    static void AllBatch(const OptionBatch& batch, const TermFactors* factors, const std::uint32_t* expiry,
+        const double* S, GreeksResult* out);
+
+    // Float instantiation of the same kernel, on the book described at BatchPricer::PriceBatch for OptionBatchF.
+    // Absolute errors against the double path, with X = S + K:
+    //   price 2e-7 X, delta 4e-6, gamma 1e-4 X / S^2, vega 2e-6 X sqrt(T), theta 1e-7 X / T, rho 2e-6 X T
+    // Most of it is the float rounding of ln(S/K) divided by sig sqrt(T), so the bounds grow for shorter or
+    // lower-volatility contracts than the book's.
+    static void AllBatch(const OptionBatchF& batch, const float* S, GreeksResultF* out);
+
+    // Mixed precision as in BatchPricer::PriceBatchMixed: everything in float, then the contracts within refineBand
+    // standard deviations of the forward evaluated again in double
+    static void AllBatchMixed(const OptionBatch& batch, const double* S, GreeksResult* out, double refineBand = 0.25);
+
     // These functions approximate Greeks numerically using central finite differences.
 	// The step size h is passed explicitly to study behavior as h varies.
 
@@ -0,0 +1,59 @@
+// Implied volatility: inverts the Black-Scholes price for single quotes and for whole batches of market quotes
+
+#ifndef IMPLIEDVOLATILITY_H
+#define IMPLIEDVOLATILITY_H
+
+#include <cstddef>
+#include <vector>
+#include "EuropeanOption.h"
+#include "ThreadPool.h"
+
+struct OptionBatch; // Structure-of-arrays contract storage, see BatchPricer.h
+
+// Solver controls. The defaults solve to near machine precision in a handful of iterations for ordinary quotes.
+struct ImpliedVolSettings
+{
+    double priceTolerance = 1e-12;  // stop when |model - quote| <= priceTolerance * max(quote, 1e-8)
+    double volTolerance = 1e-14;    // or when the volatility step falls below this
+    int maxIterations = 100;        // Halley steps plus bisection fallbacks
+    double volLower = 1e-8;         // search bracket for sigma
+    double volUpper = 10.0;
+};
+
+// Statistics for a SolveBatch run
+struct ImpliedVolStats
+{
+    std::size_t quotes = 0;
+    std::size_t converged = 0;
+    std::size_t failed = 0;           // quotes outside the no-arbitrage bounds or not converged within maxIterations
+    std::size_t totalIterations = 0;
+    std::size_t bisectionSteps = 0;   // steps where the Halley update was rejected and the bracket was halved
+    int maxIterations = 0;
+    std::vector<std::size_t> iterationHistogram; // iterationHistogram[k] = quotes that needed k iterations
+    double seconds = 0.0;
+
+    double QuotesPerSecond() const { return seconds > 0.0 ? quotes / seconds : 0.0; }
+    double MeanIterations() const { return quotes > 0 ? double(totalIterations) / quotes : 0.0; }
+};
+
+// The solver prices with EuropeanOption::Price and differentiates with Greeks::Vega, so it inverts exactly the model
+// the rest of the library uses. Each quote starts from the Corrado-Miller rational approximation, then takes
+// safeguarded Halley steps (Newton with the volga correction) inside a bracket that always contains the root;
+// any step that leaves the bracket or meets a vanishing Vega (deep ITM/OTM, near expiry) becomes a bisection step instead.
+
+class ImpliedVolatility
+{
+public:
+    // Implied volatility of one quote. opt supplies T, K, r, b and the option type; its sig is ignored.
+    // Returns NaN when the price is outside the no-arbitrage bounds or the solver does not converge.
+    static double Solve(const EuropeanOption& opt, double S, double price,
+        const ImpliedVolSettings& settings = ImpliedVolSettings(), int* iterations = nullptr);
+
+    // Solves every quote of the batch: contract i with spot S[i] and market price prices[i] writes its volatility to vols[i].
+    // The batch's sig array is ignored. Quotes are spread across the thread pool in blocks of options.grain (default 1024).
+    static ImpliedVolStats SolveBatch(const OptionBatch& batch, const double* S, const double* prices, double* vols,
+        const ImpliedVolSettings& settings = ImpliedVolSettings(),
+        const ParallelOptions& options = ParallelOptions());
+};
+
+#endif
@@ -0,0 +1,130 @@
+// Log-linear latency histogram with lock-free recording and percentile queries
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Values (nanoseconds) below 64 get one bucket each; above that every power of two is split into 32 equal buckets,
+// so a reported percentile is within about 3% of the true value at any scale, from tens of nanoseconds up to the
+// largest trackable value (about 36 minutes; larger values land in the last bucket). Memory is fixed (about 9 KB).
+//
+// Record() is a relaxed atomic increment, so one thread can record on a hot path while others read percentiles
+// at any time; a read that overlaps recording sees a consistent-enough snapshot (each bucket is exact,
+// the total may be a few counts behind).
+
+class LatencyHistogram
+{
+public:
+    static const int SubBucketBits = 5;
+    static const int MaxBits = 42;
+    static const std::size_t Buckets = (MaxBits - SubBucketBits + 1) << SubBucketBits;
+
+    LatencyHistogram() { Reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(std::uint64_t ns)
+    {
+        counts[Index(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+
+        std::uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (ns > seen && !maximum.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+    }
+
+    // Record for a histogram that only the calling thread writes (readers may still run at any time): plain relaxed
+    // loads and stores instead of read-modify-writes, so the hot path has no locked instruction
+    void RecordExclusive(std::uint64_t ns)
+    {
+        std::atomic<std::uint64_t>& bucket = counts[Index(ns)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (ns > maximum.load(std::memory_order_relaxed)) maximum.store(ns, std::memory_order_relaxed);
+    }
+
+    // Adds the counts of other, which may still be recording
+    void Merge(const LatencyHistogram& other)
+    {
+        for (std::size_t i = 0; i < Buckets; ++i)
+        {
+            const std::uint64_t n = other.counts[i].load(std::memory_order_relaxed);
+            if (n) counts[i].fetch_add(n, std::memory_order_relaxed);
+        }
+        total.fetch_add(other.total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        const std::uint64_t top = other.maximum.load(std::memory_order_relaxed);
+        std::uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (top > seen && !maximum.compare_exchange_weak(seen, top, std::memory_order_relaxed)) {}
+    }
+
+    void Reset()
+    {
+        for (std::size_t i = 0; i < Buckets; ++i) counts[i].store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        maximum.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t Count() const { return total.load(std::memory_order_relaxed); }
+    std::uint64_t Max() const { return maximum.load(std::memory_order_relaxed); }
+
+    // Upper edge of the bucket holding the p-quantile, p in [0, 1] (e.g. 0.99 for p99); 0 when empty
+    std::uint64_t Percentile(double p) const
+    {
+        std::uint64_t n = 0;
+        for (std::size_t i = 0; i < Buckets; ++i) n += counts[i].load(std::memory_order_relaxed);
+        if (n == 0) return 0;
+
+        std::uint64_t rank = static_cast<std::uint64_t>(p * static_cast<double>(n) + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > n) rank = n;
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < Buckets; ++i)
+        {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                std::uint64_t edge = UpperEdge(i);
+                std::uint64_t top = Max();
+                return (edge < top || top == 0) ? edge : top;
+            }
+        }
+        return Max();
+    }
+
+private:
+    static std::size_t Index(std::uint64_t v)
+    {
+        const std::uint64_t linear = std::uint64_t(1) << (SubBucketBits + 1);
+        if (v < linear) return static_cast<std::size_t>(v);
+
+        // Position of the highest set bit, by halving
+        int msb = 0;
+        for (int step = 32; step > 0; step >>= 1)
+            if (v >> (msb + step)) msb += step;
+        if (msb >= MaxBits) return Buckets - 1;
+
+        const int shift = msb - SubBucketBits;
+        return (static_cast<std::size_t>(shift + 1) << SubBucketBits) + static_cast<std::size_t>((v >> shift) - (std::uint64_t(1) << SubBucketBits));
+    }
+
+    static std::uint64_t UpperEdge(std::size_t index)
+    {
+        const std::size_t linear = std::size_t(1) << (SubBucketBits + 1);
+        if (index < linear) return index;
+
+        const int shift = static_cast<int>(index >> SubBucketBits) - 1;
+        const std::uint64_t sub = (index & ((std::size_t(1) << SubBucketBits) - 1)) + (std::uint64_t(1) << SubBucketBits);
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::atomic<std::uint64_t> counts[Buckets];
+    std::atomic<std::uint64_t> total;
+    std::atomic<std::uint64_t> maximum;
+};
+
+#endif
@@ -0,0 +1,88 @@
+// Binomial and trinomial lattice engine for finite-maturity American (and European) options
+
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <cstddef>
+#include <vector>
+#include "AutoDiff.h"
+#include "EuropeanOption.h"
+#include "Greeks.h"      // GreeksResult
+#include "ThreadPool.h"
+
+struct OptionBatch; // Structure-of-arrays contract storage, see BatchPricer.h
+
+// Tree construction
+//   CRR          : Cox-Ross-Rubinstein, u = exp(sig*sqrt(dt)), d = 1/u
+//   LeisenReimer : Leisen-Reimer with Peizer-Pratt inversion; nodes centred on the strike, uses an odd number of steps
+//   Trinomial    : recombining trinomial tree in log-spot with spacing sig*sqrt(3*dt)
+enum class LatticeType { CRR, LeisenReimer, Trinomial };
+
+struct LatticeSettings
+{
+    LatticeType type = LatticeType::LeisenReimer;
+    unsigned steps = 201;       // Time steps of the (coarser) tree; LeisenReimer rounds even counts up to the next odd one
+    bool richardson = true;     // Extrapolate from trees with steps and 2*steps time steps
+    bool earlyExercise = true;  // false prices the European contract on the same tree (useful as a control)
+};
+
+// Contract parameters on a generic number type, for the algorithmic-differentiation entry points below
+template<class Real>
+struct LatticeContract
+{
+    Real T, K, sig, r, b;
+    bool call;
+};
+
+// The engine reads T, K, sig, r, b and optType from the option, exactly like the closed-form European pricer,
+// so the same contract can be priced by both and compared.
+//
+// Each tree is rolled back in place in one buffer of steps + 1 (binomial) or 2 * steps + 1 (trinomial) values:
+// node j of time step i overwrites node j of step i + 1 once that value is no longer needed, so memory is O(N)
+// rather than the O(N^2) of a stored tree. The discounted up/down probabilities and the spot ratio between
+// neighbouring nodes are computed once per tree, and a table of powers of that ratio gives each node's spot with one
+// multiply, leaving a short independent multiply-add and max per node that the compiler can vectorize.
+// Calls with b >= r are never exercised early, so the exercise test is skipped for them.
+//
+// With richardson = true the price is extrapolated from a tree with N steps and one with 2N steps:
+//   P = (n2^p * P(n2) - n1^p * P(n1)) / (n2^p - n1^p)
+// with order p = 2 for Leisen-Reimer on contracts without early exercise and p = 1 otherwise.
+
+class LatticeEngine
+{
+public:
+    // Price of one contract at spot S
+    static double Price(const EuropeanOption& opt, double S, const LatticeSettings& settings = LatticeSettings());
+
+    // Price plus Greeks. Delta, Gamma and Theta are read off the first time steps of the same tree
+    // (no extra pricing); Vega and Rho come from central bumps of sigma and r repriced on the lattice,
+    // with b bumped together with r as in Greeks::Rho.
+    // Theta follows Greeks::Theta and is the change in value as calendar time passes (dV/dt = -dV/dT).
+    static GreeksResult Greeks(const EuropeanOption& opt, double S, const LatticeSettings& settings = LatticeSettings());
+
+    // Price, Delta, Gamma and Theta from the tree nodes only, without the bumped reprices (Vega and Rho are NaN)
+    static GreeksResult NodeGreeks(const EuropeanOption& opt, double S, const LatticeSettings& settings = LatticeSettings());
+
+    // Price with the number types of AutoDiff.h, recorded on the active tape: one backward sweep then gives the
+    // derivative of the lattice price in S and every contract parameter, including through the tree geometry
+    // (u, d and p depend on sigma, r, b and T). Each tree is rolled back once keeping its nodes, swept backwards once
+    // by hand, and only the resulting partials are taped, at about 8 times the cost of Price.
+    // Forward-over-reverse (Adjoint<Dual>) adds one Hessian row per sweep.
+    // These are derivatives of the discrete tree price with the exercise decisions held fixed, so second
+    // derivatives in S miss the nodes crossing the payoff kink and the exercise boundary: take Gamma from the
+    // tree nodes (NodeGreeks) instead. On CRR and trinomial trees the price has a kink in S wherever a node lands on
+    // the strike, so the first derivative in S is only meaningful on Leisen-Reimer trees.
+    static Adjoint<double> Price(const LatticeContract<Adjoint<double>>& c, const Adjoint<double>& S,
+        const LatticeSettings& settings = LatticeSettings());
+    static Adjoint<Dual> Price(const LatticeContract<Adjoint<Dual>>& c, const Adjoint<Dual>& S,
+        const LatticeSettings& settings = LatticeSettings());
+
+    // Batch versions: contract i of the batch at spot S[i], written to out[i].
+    // Contracts are spread across the thread pool in blocks of options.grain (default 8); each block reuses one buffer.
+    static void PriceBatch(const OptionBatch& batch, const double* S, double* out,
+        const LatticeSettings& settings = LatticeSettings(), const ParallelOptions& options = ParallelOptions());
+    static void GreeksBatch(const OptionBatch& batch, const double* S, GreeksResult* out,
+        const LatticeSettings& settings = LatticeSettings(), const ParallelOptions& options = ParallelOptions());
+};
+
+#endif
@@ -6,7 +6,12 @@
 #include <vector>
 #include "EuropeanOption.h"
 #include "Greeks.h"
+#include "ThreadPool.h"
+#include "Surface.h"
 
+class SurfaceFile;
+class VolSurface;
+class TermStructure;
 
 // Using an enum class for type safety and clear semantic meaning.
 enum class OutputType
@@ -21,6 +26,26 @@ enum class OutputType
     GammaFD     // Finite-difference Gamma
 };
 
+// Finite-difference outputs of MatrixPricer::MatrixStencil, each rows x spots like Matrix()
+struct StencilSurfaces
+{
+    Surface price;
+    Surface delta;  // central difference over the neighbouring spots of the mesh
+    Surface gamma;
+    Surface vega;   // difference over the rows that differ only in sigma
+    Surface theta;  // -dV/dT over the rows that differ only in T
+
+    std::size_t pricings = 0;      // Price evaluations made
+    std::size_t naivePricings = 0; // evaluations of per-point bump-and-reprice for the same five outputs (10 per point)
+};
+
+// Steps used for rows that have no sigma / T neighbour in paramMatrix
+struct StencilSettings
+{
+    double volBump = 0.01;          // absolute sigma step
+    double timeBump = 1.0 / 365.0;  // maturity step (one day)
+};
+
 // Provides static methods for computing option values and Greeks across vectors or matrices 
 
 class MatrixPricer
@@ -44,6 +69,208 @@ public:
         const std::vector<double>& S_values,
         OutputType output,
         double h = 0.01);
+
+    // "All Greeks" output mode: one GreeksResult (price, Delta, Gamma, Vega, Theta, Rho) per spot price,
+    // computed with Greeks::All so the shared d1/d2 work is done once per point instead of once per OutputType
+    static std::vector<GreeksResult> VectorAll(const EuropeanOption& opt,
+        const std::vector<double>& S_values);
+
+    // Surface version of VectorAll; paramMatrix rows are interpreted exactly as in Matrix()
+    static std::vector<std::vector<GreeksResult>> MatrixAll(EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values);
+
+    // Parallel version of Matrix(). The surface is cut into (parameter row x spot block) tiles that run on a work-stealing ThreadPool.
+    // The input option is not modified: each thread taking part prices on its own Clone(), so the result is identical to the serial Matrix()
+    // and the call is safe to issue from several threads at once.
+    // options.threads caps the threads used for this call and options.grain sets the spot points per tile (default 256).
+    static std::vector<std::vector<double>> MatrixParallel(const EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        double h = 0.01,
+        const ParallelOptions& options = ParallelOptions());
+
+    // ---------------- Caller-provided output buffers ----------------
+    // These overloads write into memory owned by the caller and perform no heap allocation,
+    // so a revaluation loop that reuses its buffers allocates nothing after the first pass.
+
+    // Writes one output per spot: out[j] for S_values[j], j in [0, n)
+    static void Vector(const EuropeanOption& opt,
+        const double* S_values, std::size_t n,
+        OutputType output,
+        double* out,
+        double h = 0.01);
+
+    // Writes a rows x S_values.size() surface into out using the given layout.
+    // Like Matrix(), the row parameters are written into opt as the loop proceeds.
+    static void Matrix(EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        double* out,
+        SurfaceLayout layout,
+        double h = 0.01);
+
+    // Same as above into a Surface, which is resized (keeping its layout and capacity) to fit
+    static void Matrix(EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        Surface& out,
+        double h = 0.01);
+
+    // ---------------- Parallel into caller-provided output buffers ----------------
+    // Parallel versions writing into a caller-owned buffer / Surface; the input option is not modified. Unlike the
+    // serial overloads above these allocate on every call: one Clone() of the option per thread that takes part and
+    // the small array holding the copies, so at most threads + 1 allocations. The pool keeps its task storage across
+    // calls, so the count does not grow with the number of tiles.
+    static void MatrixParallel(const EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        double* out,
+        SurfaceLayout layout,
+        double h = 0.01,
+        const ParallelOptions& options = ParallelOptions());
+
+    static void MatrixParallel(const EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        Surface& out,
+        double h = 0.01,
+        const ParallelOptions& options = ParallelOptions());
+
+    // ---------------- Memory-mapped output ----------------
+    // These overloads compute straight into the data section of a SurfaceFile opened with Create(), so the surface
+    // lands on disk without an in-memory copy or text formatting. The file must have been created for the same
+    // paramMatrix, S_values and output; false is returned (and nothing written) when the shape or OutputType differ
+    // or the file is not writable. Padding between the file's aligned blocks is left untouched.
+    static bool Matrix(EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        SurfaceFile& out,
+        double h = 0.01);
+
+    static bool MatrixParallel(const EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        SurfaceFile& out,
+        double h = 0.01,
+        const ParallelOptions& options = ParallelOptions());
+
+    // ---------------- Volatility surface ----------------
+    // paramMatrix rows as in Matrix(), except that each row is priced at vols.Vol(K, T) of its own strike and
+    // maturity; the row's sig entry is ignored (any placeholder). The row vols are looked up in one batch call,
+    // after which pricing runs exactly as in Matrix() / MatrixParallel().
+    static std::vector<std::vector<double>> Matrix(EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        const VolSurface& vols,
+        double h = 0.01);
+
+    static void MatrixParallel(const EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        const VolSurface& vols,
+        Surface& out,
+        double h = 0.01,
+        const ParallelOptions& options = ParallelOptions());
+
+    // ---------------- Rate and carry curves ----------------
+    // paramMatrix rows as in Matrix(), except that r and b are the zero rates of curves at each row's T; the row's r
+    // and b entries are ignored (a 4-entry row is fine). The curve factors are computed once per distinct maturity
+    // and handed to the pricing loops as they are, so the discount and carry exponentials are not taken again.
+    // Theta is the flat-rate Theta at those zero rates; Greeks::All with a TermStructure includes the curve roll.
+    static std::vector<std::vector<double>> Matrix(EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        const TermStructure& curves,
+        double h = 0.01);
+
+    static void MatrixParallel(const EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        const TermStructure& curves,
+        Surface& out,
+        double h = 0.01,
+        const ParallelOptions& options = ParallelOptions());
+
+    // ---------------- Stencil finite differences ----------------
+    // DeltaFD / GammaFD price S-h, S and S+h at every point, three times the pricing work of the surface itself, and
+    // on a spot mesh with step h the neighbours are already mesh points. MatrixStencil prices each distinct parameter
+    // row once over the mesh extended by one point at each end, and takes every output as a stencil over those
+    // shared prices:
+    //   Delta, Gamma : the neighbouring spots of the mesh (step = the mesh spacing, not h)
+    //   Vega, Theta  : the nearest rows of paramMatrix with the same T, K, r, b (resp. K, sigma, r, b) on each side;
+    //                  a missing side is filled with one extra row at the mirrored distance (settings steps when
+    //                  there is no neighbour at all), priced once over the mesh and shared by all points
+    // The three-point formulas use the actual spacings, so non-uniform meshes and parameter grids are exact to second
+    // order as well; on a uniform mesh they reduce to Greeks::DeltaFD / GammaFD with h = the mesh step.
+    // S_values must be strictly increasing with at least two points; false (and nothing written) otherwise.
+    // Rows are priced in parallel on the ThreadPool; every row goes through Fill(), so the result does not depend
+    // on the thread count.
+    static bool MatrixStencil(const EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        StencilSurfaces& out,
+        const StencilSettings& settings = StencilSettings(),
+        const ParallelOptions& options = ParallelOptions());
+
+    // One row with the option's own T, K, sig, r and b
+    static bool VectorStencil(const EuropeanOption& opt,
+        const std::vector<double>& S_values,
+        StencilSurfaces& out,
+        const StencilSettings& settings = StencilSettings());
+
+private:
+    // Common loops behind every buffer overload: element (row, col) goes to out[row * rowStride + col * colStride]
+    static void MatrixStrided(EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        double* out, std::size_t rowStride, std::size_t colStride,
+        double h,
+        const TermFactors* rowFactors = nullptr);
+
+    static void MatrixParallelStrided(const EuropeanOption& opt,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        double* out, std::size_t rowStride, std::size_t colStride,
+        double h,
+        const ParallelOptions& options,
+        const TermFactors* rowFactors = nullptr);
+
+    // True when out was created for this paramMatrix / S_values / output and can be written
+    static bool Matches(const SurfaceFile& out, std::size_t rows, std::size_t cols, OutputType output);
+
+    // Writes out[j * stride] for S[j], j in [0, n): through the compile-time specialised PricingKernels loops when
+    // they cover this option type and output, otherwise one Evaluate() per spot. Every serial and parallel path
+    // goes through here, so they all produce identical numbers. factors, when given, are the curve factors at opt.T.
+    static void Fill(const EuropeanOption& opt, const double* S, std::size_t n, OutputType output,
+        double* out, std::size_t stride, double h, const TermFactors* factors = nullptr);
+
+    // Evaluates one output at one spot through the virtual Price() / Greeks functions; fallback of Fill()
+    static double Evaluate(const EuropeanOption& opt, double S, OutputType output, double h);
+
+    // Copy of paramMatrix with the sig entry of every row replaced by vols.Vol(K, T)
+    static std::vector<std::vector<double>> WithSurfaceVols(const std::vector<std::vector<double>>& paramMatrix,
+        const VolSurface& vols);
+
+    // Curve factors at every row's T, from one table of the distinct maturities
+    static std::vector<TermFactors> RowFactors(const std::vector<std::vector<double>>& paramMatrix,
+        const TermStructure& curves);
+
+    // Maps a paramMatrix row (T, K, sig, r[, b]) onto an option object; with factors, r and b are their zero rates
+    static void ApplyParams(EuropeanOption& opt, const std::vector<double>& p, const TermFactors* factors = nullptr);
 };
 
 #endif
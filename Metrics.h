@@ -0,0 +1,231 @@
+// Optional hot-path instrumentation: call counts, tick timers and latency histograms with JSON / Prometheus snapshots
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "LatencyHistogram.h"
+#include "MatrixPricer.h" // OutputType
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define METRICS_TSC 1
+#else
+#include <chrono>
+#define METRICS_TSC 0
+#endif
+
+// Compiled in only when OPTIONPRICING_METRICS is defined to 1 (cmake -DOPTIONPRICING_METRICS=ON). Otherwise the
+// PRICING_METRICS_* macros in the instrumented functions expand to nothing, so the pricing code is exactly what it is
+// without this header; the snapshot API below still links and reports enabled = false.
+//
+// Instrumented: EuropeanOption::Price, AmericanOption::Price, every Greeks function and MatrixPricer::Vector / Matrix.
+// Each call adds one to its site's call count and the elapsed timestamp-counter ticks (rdtsc, about a cycle at the
+// nominal frequency) to its time; Vector and Matrix calls also add their points priced and land in a latency
+// histogram per OutputType. Times are inclusive: Greeks::DeltaFD also counts the two EuropeanOption::Price calls it
+// makes. Overloads that delegate (Matrix on a Surface, a VolSurface or curves) are counted once, by the overload
+// they delegate to.
+//
+// Every thread records into a block of its own, registered on its first call and merged into a retired block when
+// the thread exits, so recording is a plain load and store per counter with no shared cache line and no locked
+// instruction. Snapshot() walks the blocks under the registry mutex, which recording never takes.
+//
+// Cost when enabled is almost all the two timestamp-counter reads, so it follows the platform's rdtsc. Measured with
+// the benchmark in both builds on a virtual machine where rdtsc traps (16 ns a read): an empty scope
+// (Metrics::Scope) costs 32 ns, and back-to-back calls lose more because each read also drains the pipeline:
+// Greeks::Gamma 24 -> 90 ns, Greeks::All 190 -> 260 ns, EuropeanOption::Price 185 -> 215 ns. Calls that do real
+// work per scope are unaffected within noise: MatrixPricer::Vector over 1024 spots (5-7 ns a point), Matrix and
+// Greeks::AllBatch over 65536 contracts (27 ns). Leave it off for latency-critical builds that price single
+// points in tight loops.
+//
+//   #include "Metrics.h"
+//   std::string error;
+//   Metrics::Write("/var/lib/node_exporter/pricing.prom", MetricsFormat::Prometheus, error);
+
+#ifndef OPTIONPRICING_METRICS
+#define OPTIONPRICING_METRICS 0
+#endif
+
+enum class MetricSite
+{
+    EuropeanPrice,    // EuropeanOption::Price
+    AmericanPrice,    // AmericanOption::Price
+    Delta,            // Greeks::Delta
+    Gamma,
+    Vega,
+    Theta,
+    Rho,
+    All,              // Greeks::All
+    AllBatch,         // Greeks::AllBatch and AllBatchMixed (elements = contracts)
+    DeltaFD,
+    GammaFD,
+    Vector,           // MatrixPricer::Vector (elements = spots)
+    Matrix,           // MatrixPricer::Matrix (elements = rows x spots)
+    Count
+};
+
+enum class MetricsFormat { Json, Prometheus };
+
+const std::size_t MetricSiteCount = static_cast<std::size_t>(MetricSite::Count);
+const std::size_t MetricOutputCount = 8;
+static_assert(static_cast<std::size_t>(OutputType::GammaFD) + 1 == MetricOutputCount, "one histogram per OutputType");
+
+// Counter written by a single thread and read by any: the owner's increment is a relaxed load and store
+struct MetricsCounter
+{
+    std::atomic<std::uint64_t> value{ 0 };
+
+    void Add(std::uint64_t n) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    std::uint64_t Load() const { return value.load(std::memory_order_relaxed); }
+};
+
+// Per-thread counters; histograms are in ticks, indexed [Vector / Matrix][OutputType]
+struct alignas(64) MetricsThreadBlock
+{
+    MetricsCounter calls[MetricSiteCount];
+    MetricsCounter ticks[MetricSiteCount];
+    MetricsCounter elements[MetricSiteCount];
+    MetricsCounter latencyTicks[2][MetricOutputCount];
+    LatencyHistogram latency[2][MetricOutputCount];
+};
+
+// Totals merged over all threads, with times converted to nanoseconds
+struct MetricsSnapshot
+{
+    struct Site
+    {
+        std::uint64_t calls = 0;
+        std::uint64_t elements = 0;
+        double ns = 0.0;
+    };
+
+    // Latency of single Vector / Matrix calls for one OutputType; percentiles are bucket upper edges (within 3%)
+    struct Latency
+    {
+        std::uint64_t count = 0;
+        double sumNs = 0.0;
+        double p50Ns = 0.0;
+        double p90Ns = 0.0;
+        double p99Ns = 0.0;
+        double p999Ns = 0.0;
+        double maxNs = 0.0;
+    };
+
+    bool enabled = false;
+    double ticksPerNs = 1.0;    // timestamp-counter rate used for the conversion
+    std::size_t threads = 0;    // threads that have recorded (live and exited)
+    Site sites[MetricSiteCount];
+    Latency latency[2][MetricOutputCount];
+
+    std::string Json() const;
+    std::string Prometheus() const;
+    std::string Format(MetricsFormat format) const { return format == MetricsFormat::Json ? Json() : Prometheus(); }
+};
+
+inline thread_local MetricsThreadBlock* metricsThreadBlock = nullptr;
+
+class Metrics
+{
+public:
+    static constexpr bool Compiled = OPTIONPRICING_METRICS != 0;
+
+    static const char* SiteName(MetricSite site);
+    static const char* OutputName(OutputType output);
+
+    static MetricsSnapshot Snapshot();
+
+    // Zeroes every block. Meant for quiet moments (between runs): an increment racing with it may survive the reset.
+    static void Reset();
+
+    // Snapshot written to a temporary file next to path and renamed over it, so a scraper never reads half a file
+    static bool Write(const std::string& path, MetricsFormat format, std::string& error);
+
+    // Snapshot sent over a connection to the Unix-domain stream socket at socketPath (POSIX only)
+    static bool Send(const std::string& socketPath, MetricsFormat format, std::string& error);
+
+    static std::uint64_t Ticks()
+    {
+#if METRICS_TSC
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    static MetricsThreadBlock& Local()
+    {
+        MetricsThreadBlock* block = metricsThreadBlock;
+        return block ? *block : Register();
+    }
+
+    static void Record(MetricSite site, std::uint64_t ticks, std::size_t elements)
+    {
+        MetricsThreadBlock& block = Local();
+        const std::size_t s = static_cast<std::size_t>(site);
+        block.calls[s].Add(1);
+        block.ticks[s].Add(ticks);
+        block.elements[s].Add(elements);
+    }
+
+    static void Record(MetricSite site, OutputType output, std::uint64_t ticks, std::size_t elements)
+    {
+        Record(site, ticks, elements);
+        const std::size_t kind = (site == MetricSite::Matrix) ? 1 : 0;
+        const std::size_t o = static_cast<std::size_t>(output);
+        MetricsThreadBlock& block = Local();
+        block.latencyTicks[kind][o].Add(ticks);
+        block.latency[kind][o].RecordExclusive(ticks);
+    }
+
+private:
+    static MetricsThreadBlock& Register();
+};
+
+// Times its own lifetime and records it on destruction
+class MetricsScope
+{
+public:
+    explicit MetricsScope(MetricSite site, std::size_t elements = 1)
+        : site(site), output(OutputType::Price), elements(elements), histogram(false), start(Metrics::Ticks()) {}
+
+    MetricsScope(MetricSite site, OutputType output, std::size_t elements)
+        : site(site), output(output), elements(elements), histogram(true), start(Metrics::Ticks()) {}
+
+    MetricsScope(const MetricsScope&) = delete;
+    MetricsScope& operator=(const MetricsScope&) = delete;
+
+    ~MetricsScope()
+    {
+        const std::uint64_t ticks = Metrics::Ticks() - start;
+        if (histogram) Metrics::Record(site, output, ticks, elements);
+        else Metrics::Record(site, ticks, elements);
+    }
+
+private:
+    MetricSite site;
+    OutputType output;
+    std::size_t elements;
+    bool histogram;
+    std::uint64_t start;
+};
+
+#if OPTIONPRICING_METRICS
+#define PRICING_METRICS_SCOPE(site) MetricsScope pricingMetricsScope(MetricSite::site)
+#define PRICING_METRICS_SCOPE_N(site, elements) MetricsScope pricingMetricsScope(MetricSite::site, (elements))
+#define PRICING_METRICS_SCOPE_OUTPUT(site, output, elements) \
+    MetricsScope pricingMetricsScope(MetricSite::site, (output), (elements))
+#else
+#define PRICING_METRICS_SCOPE(site) ((void)0)
+#define PRICING_METRICS_SCOPE_N(site, elements) ((void)0)
+#define PRICING_METRICS_SCOPE_OUTPUT(site, output, elements) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+// Monte Carlo pricing of path-dependent and basket payoffs under the Black-Scholes (GBM) model
+
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "EuropeanOption.h"
+#include "ThreadPool.h"
+
+// ---------------- Payoffs ----------------
+// A payoff sees a whole block of simulated paths at once, so it can loop over paths in the inner loop (vectorizable)
+// instead of being called once per path. Layout: S[(a * steps + k) * paths + p] is the spot of asset a at monitoring
+// date k + 1 (dates t_k = (k + 1) * T / steps) on path p. Evaluate writes the undiscounted payoff of every path to out.
+
+class McPayoff
+{
+public:
+    virtual ~McPayoff() = default;
+    virtual void Evaluate(const double* S, std::size_t paths, std::size_t steps, std::size_t assets, double* out) const = 0;
+};
+
+// Vanilla call/put on asset 0 at maturity
+class VanillaPayoff : public McPayoff
+{
+public:
+    VanillaPayoff(double K, bool call) : K(K), call(call) {}
+    void Evaluate(const double* S, std::size_t paths, std::size_t steps, std::size_t assets, double* out) const override;
+
+    double K;
+    bool call;
+};
+
+// Fixed-strike arithmetic-average (Asian) call/put on asset 0, averaged over all monitoring dates
+class AsianPayoff : public McPayoff
+{
+public:
+    AsianPayoff(double K, bool call) : K(K), call(call) {}
+    void Evaluate(const double* S, std::size_t paths, std::size_t steps, std::size_t assets, double* out) const override;
+
+    double K;
+    bool call;
+};
+
+// Knock-out call/put on asset 0 with the barrier monitored at every date; pays nothing once the barrier is touched
+class BarrierPayoff : public McPayoff
+{
+public:
+    BarrierPayoff(double K, double barrier, bool up, bool call) : K(K), barrier(barrier), up(up), call(call) {}
+    void Evaluate(const double* S, std::size_t paths, std::size_t steps, std::size_t assets, double* out) const override;
+
+    double K;
+    double barrier;
+    bool up;    // true: knocked out when S >= barrier, false: when S <= barrier
+    bool call;
+};
+
+// Call/put on a weighted basket sum_a weights[a] * S_a(T)
+class BasketPayoff : public McPayoff
+{
+public:
+    BasketPayoff(const std::vector<double>& weights, double K, bool call) : weights(weights), K(K), call(call) {}
+    void Evaluate(const double* S, std::size_t paths, std::size_t steps, std::size_t assets, double* out) const override;
+
+    std::vector<double> weights;
+    double K;
+    bool call;
+};
+
+// ---------------- Engine ----------------
+
+enum class McSampling
+{
+    PseudoRandom,   // Philox4x32-10 counter-based streams
+    Sobol           // Sobol points with random digital shifts (randomised QMC)
+};
+
+struct McSettings
+{
+    std::size_t samples = 100000;   // Estimator samples (an antithetic pair counts as one sample)
+    unsigned steps = 1;             // Monitoring dates / time steps
+    std::uint64_t seed = 20240601;
+    McSampling sampling = McSampling::PseudoRandom;
+    bool antithetic = false;        // Average each path with its mirror (-z) path
+    bool controlVariate = false;    // Use the discounted vanilla payoff of asset 0, priced by Black-Scholes, as control
+    bool brownianBridge = true;     // Build paths by Brownian bridge (puts the most important Sobol coordinates first)
+    unsigned replicates = 16;       // Sobol only: independent digital shifts used for the standard error
+    std::size_t blockSize = 256;    // Samples per block; fixes the summation order, so keep it constant to reproduce results
+};
+
+struct McResult
+{
+    double price = 0.0;
+    double standardError = 0.0;
+    std::size_t samples = 0;
+    std::size_t paths = 0;          // Simulated paths (2 * samples with antithetic variates)
+    double beta = 0.0;              // Control-variate coefficient (0 without control variate)
+    double seconds = 0.0;
+
+    double PathsPerSecond() const { return seconds > 0.0 ? paths / seconds : 0.0; }
+};
+
+// Assets follow dS = b S dt + sig S dW under the pricing measure, with b, sig taken from each asset's EuropeanOption and
+// r, T (discounting and maturity) taken from the first one. The vanilla control uses K and optType of the first asset.
+//
+// Reproducibility: path i always uses the random numbers of counter i (or Sobol point i) and samples are summed
+// in fixed blocks whose partial sums are combined in block order, so a given seed returns bit-identical results for
+// any thread count. Paths are generated block by block in structure-of-arrays buffers (one array per date and asset),
+// with the log-spot increments exponentiated by VectorMath::Exp.
+//
+// With Sobol sampling the first SobolSequence::MaxDimensions coordinates (in Brownian-bridge order across assets) come
+// from the Sobol points and the rest from Philox; the standard error is the spread of the replicates' estimates.
+
+class MonteCarlo
+{
+public:
+    // Single asset at spot S
+    static McResult Price(const EuropeanOption& model, double S, const McPayoff& payoff,
+        const McSettings& settings = McSettings(), const ParallelOptions& options = ParallelOptions());
+
+    // Correlated basket; correlation is assets x assets and must be positive definite (NaN price otherwise)
+    static McResult PriceBasket(const std::vector<EuropeanOption>& assets, const std::vector<double>& spots,
+        const std::vector<std::vector<double>>& correlation, const McPayoff& payoff,
+        const McSettings& settings = McSettings(), const ParallelOptions& options = ParallelOptions());
+};
+
+#endif
@@ -4,6 +4,10 @@
 #define NORMALDISTRIBUTION_H
 
 #include <boost/math/distributions/normal.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "VectorMath.h"
 
 // We are using the Boost library for the normal distribution functions (CDF and PDF) 
 // instead of implementing approximate formulas ourselves. Boost provides highly precise cumulative and probability density calculations, and
@@ -31,4 +35,151 @@ inline double N_pdf(double x)
 }
 
 
+// ---------------- Bivariate Cumulative Normal ----------------
+// Gauss-Legendre rules of N_cdf2 with 6, 12 and 20 points; the rules are symmetric, so only the negative
+// abscissae are stored and each node is used with both signs
+inline constexpr int N_cdf2Points[3] = { 3, 6, 10 };
+inline constexpr double N_cdf2Weights[3][10] = {
+    { 0.1713244923791705, 0.3607615730481384, 0.4679139345726904 },
+    { 0.04717533638651177, 0.1069393259953183, 0.1600783285433464, 0.2031674267230659, 0.2334925365383547,
+      0.2491470458134029 },
+    { 0.01761400713915212, 0.04060142980038694, 0.06267204833410906, 0.08327674157670475, 0.1019301198172404,
+      0.1181945319615184, 0.1316886384491766, 0.1420961093183821, 0.1491729864726037, 0.1527533871307259 } };
+inline constexpr double N_cdf2Nodes[3][10] = {
+    { -0.9324695142031522, -0.6612093864662647, -0.2386191860831970 },
+    { -0.9815606342467191, -0.9041172563704750, -0.7699026741943050, -0.5873179542866171, -0.3678314989981802,
+      -0.1252334085114692 },
+    { -0.9931285991850949, -0.9639719272779138, -0.9122344282513259, -0.8391169718222188, -0.7463319064601508,
+      -0.6360536807265150, -0.5108670019508271, -0.3737060887154196, -0.2277858511416451, -0.07652652113349733 } };
+
+// P(X <= a, Y <= b) for standard normals with correlation rho, by Genz's method (Drezner-Wesolowsky with the
+// rules above chosen by |rho|, and the Owen substitution near |rho| = 1). Absolute error about 1e-15.
+// Used by the Bjerksund-Stensland American approximation.
+inline double N_cdf2(double a, double b, double rho)
+{
+    const double twoPi = 6.283185307179586;
+
+    const double absRho = std::fabs(rho);
+    const int set = (absRho < 0.3) ? 0 : (absRho < 0.75) ? 1 : 2;
+    const int points = N_cdf2Points[set];
+    const double* w = N_cdf2Weights[set];
+    const double* x = N_cdf2Nodes[set];
+
+    // Upper orthant P(X > h, Y > k) with h = -a, k = -b
+    double h = -a, k = -b, hk = h * k;
+    double bvn = 0.0;
+    if (absRho < 0.925)
+    {
+        const double hs = 0.5 * (h * h + k * k);
+        const double asr = std::asin(rho);
+        for (int i = 0; i < points; ++i)
+            for (double sign : { -1.0, 1.0 })
+            {
+                const double sn = std::sin(0.5 * asr * (sign * x[i] + 1.0));
+                bvn += w[i] * std::exp((sn * hk - hs) / (1.0 - sn * sn));
+            }
+        bvn = bvn * asr / (2.0 * twoPi) + N_cdf(-h) * N_cdf(-k);
+    }
+    else
+    {
+        if (rho < 0.0) { k = -k; hk = -hk; }
+        if (absRho < 1.0)
+        {
+            const double as = (1.0 - rho) * (1.0 + rho);
+            double aa = std::sqrt(as);
+            const double bs = (h - k) * (h - k);
+            const double c = (4.0 - hk) / 8.0, d = (12.0 - hk) / 16.0;
+            double asr = -0.5 * (bs / as + hk);
+            if (asr > -100.0)
+                bvn = aa * std::exp(asr) * (1.0 - c * (bs - as) * (1.0 - d * bs / 5.0) / 3.0 + c * d * as * as / 5.0);
+            if (-hk < 100.0)
+            {
+                const double bb = std::sqrt(bs);
+                bvn -= std::exp(-0.5 * hk) * std::sqrt(twoPi) * N_cdf(-bb / aa) * bb
+                    * (1.0 - c * bs * (1.0 - d * bs / 5.0) / 3.0);
+            }
+            aa *= 0.5;
+            for (int i = 0; i < points; ++i)
+                for (double sign : { -1.0, 1.0 })
+                {
+                    const double xs = aa * (sign * x[i] + 1.0) * aa * (sign * x[i] + 1.0);
+                    const double rs = std::sqrt(1.0 - xs);
+                    asr = -0.5 * (bs / xs + hk);
+                    if (asr > -100.0)
+                        bvn += aa * w[i] * std::exp(asr)
+                            * (std::exp(-hk * (1.0 - rs) / (2.0 * (1.0 + rs))) / rs - (1.0 + c * xs * (1.0 + d * xs)));
+                }
+            bvn = -bvn / twoPi;
+        }
+        if (rho > 0.0) bvn += N_cdf(-std::max(h, k));
+        else bvn = -bvn + std::max(0.0, N_cdf(-h) - N_cdf(-k));
+    }
+    return bvn;
+}
+
+
+// ---------------- Array versions ----------------
+// Evaluate n values at once with the SIMD kernels in VectorMath (AVX2/AVX-512 when available, scalar otherwise).
+// Used by the batch pricers, where the per-value Boost call dominates the cost. Error bounds versus Boost are documented in VectorMath.h.
+// out may alias x.
+inline void N_cdf(const double* x, double* out, std::size_t n)
+{
+    VectorMath::NormCdf(x, out, n);
+}
+
+inline void N_pdf(const double* x, double* out, std::size_t n)
+{
+    VectorMath::NormPdf(x, out, n);
+}
+
+// Single-precision arrays for the float batch kernels
+inline void N_cdf(const float* x, float* out, std::size_t n)
+{
+    VectorMath::NormCdf(x, out, n);
+}
+
+inline void N_pdf(const float* x, float* out, std::size_t n)
+{
+    VectorMath::NormPdf(x, out, n);
+}
+
+
+// ---------------- Inverse Cumulative Normal ----------------
+// Computes x with N_cdf(x) = p for 0 < p < 1 using Acklam's rational approximation (relative error below 1.2e-9).
+// Used to turn uniform (pseudo- or quasi-) random numbers into normal samples, where that accuracy is far below
+// the Monte Carlo noise and the cost is a few multiplies in the central region instead of an iterative inversion.
+inline double N_inv(double p)
+{
+    static const double a[6] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                  1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+    static const double b[5] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                  6.680131188771972e+01, -1.328068155288572e+01 };
+    static const double c[6] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                 -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+    static const double d[4] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                  3.754408661907416e+00 };
+    const double pLow = 0.02425;
+
+    if (p < pLow || p > 1.0 - pLow)
+    {
+        // Tails: rational function of sqrt(-2 log(tail probability))
+        double q = std::sqrt(-2.0 * std::log(p < pLow ? p : 1.0 - p));
+        double x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5])
+            / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+        return (p < pLow) ? x : -x;
+    }
+
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q
+        / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+inline void N_inv(const double* p, double* out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = N_inv(p[i]);
+}
+
+
 #endif
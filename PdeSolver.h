@@ -0,0 +1,80 @@
+// Finite-difference (Crank-Nicolson) pricing of European and American options over a whole spot mesh in one solve
+
+#ifndef PDESOLVER_H
+#define PDESOLVER_H
+
+#include <cstddef>
+#include <vector>
+#include "EuropeanOption.h"
+
+// How the early-exercise constraint V >= payoff is enforced in each time step
+//   Penalty : penalty iteration (Forsyth-Vetzal); each iteration is one tridiagonal Thomas solve, usually 2-3 per step
+//   PSOR    : projected successive over-relaxation on the Crank-Nicolson system
+enum class EarlyExerciseMethod { Penalty, PSOR };
+
+struct PdeSettings
+{
+    unsigned timeSteps = 200;       // Time steps from maturity back to today
+    unsigned rannacherSteps = 2;    // Leading steps replaced by two fully implicit half steps each, damping the payoff kink
+    bool earlyExercise = false;     // true prices the American contract
+    EarlyExerciseMethod method = EarlyExerciseMethod::Penalty;
+    double penalty = 1e8;           // Penalty factor; the constraint is met to about payoff / penalty
+    double tolerance = 1e-9;        // Convergence of the penalty / PSOR iterations (relative change)
+    unsigned maxIterations = 100;   // Per time step
+    double omega = 1.5;             // PSOR relaxation factor
+    double farField = 5.0;          // The grid extends to this many standard deviations above the mesh and the strike
+    double growth = 1.1;            // Spacing growth factor of the extension nodes outside the mesh
+    double resolution = 0.05;       // Largest node spacing inside the mesh, in units of sig sqrt(T) max(K, S);
+                                    // 0 solves on the mesh nodes alone
+};
+
+// Buffers of one solve. Their capacity only ever grows, so a workspace reused across solves on the same (or a smaller)
+// mesh does not allocate. A workspace must not be shared by two solves running at the same time.
+class PdeWorkspace
+{
+public:
+    // Grid actually solved on: the mesh, the nodes inserted between its spots and the extension nodes below and
+    // above it
+    const std::vector<double>& Grid() const { return grid; }
+
+private:
+    friend class PdeSolver;
+
+    std::vector<double> grid;
+    std::vector<std::size_t> meshIndex;           // grid index of each mesh spot
+    std::vector<double> lower, diag, upper;       // spatial operator L, constant in time
+    std::vector<double> aLower, aDiag, aUpper;    // A = I - 0.5*dt*L, the left-hand side of every step
+    std::vector<double> factor, pivot;            // Thomas factorisation of A
+    std::vector<double> values, rhs, payoff;
+    std::vector<double> iterate, penalty, scratch; // American iterations
+};
+
+// The spots of the mesh (e.g. from MeshGenerator::Uniform) are grid nodes, so prices are returned at exactly the
+// requested spots without interpolation, but the accuracy does not depend on how densely the caller samples: where
+// two neighbouring spots are further apart than the resolution allows, equally spaced nodes are inserted between
+// them. The spacing limit sig sqrt(T) max(K, S) is uniform below the strike and grows with S above it, so a wide
+// ladder costs a few hundred nodes. Below the mesh the grid is extended to S = 0, where the PDE reduces to
+// dV/dt = -rV, and above it to farField standard deviations beyond the larger of the last spot and the strike,
+// where the European asymptotic value is imposed. Extension spacing grows geometrically, so truncation costs only
+// a few dozen nodes. The grid is non-uniform in general and uses three-point non-uniform differences.
+//
+// The Black-Scholes operator  L V = 0.5 sig^2 S^2 V_SS + b S V_S - r V  has constant coefficients in time, so the
+// tridiagonal system is factorised once per solve. A Crank-Nicolson step and a Rannacher half step (implicit Euler
+// over dt/2) have the same left-hand side I - 0.5*dt*L, so one factorisation serves both, and each European time step
+// is one matrix-vector product plus a forward and back substitution.
+
+class PdeSolver
+{
+public:
+    // Prices the option (T, K, sig, r, b, optType) at every point of S_mesh, which must be strictly increasing
+    // and non-negative with at least two points. delta and gamma are optional and come from the grid as well.
+    // On an invalid mesh every output is set to NaN.
+    static void Solve(const EuropeanOption& opt, const std::vector<double>& S_mesh, const PdeSettings& settings,
+        PdeWorkspace& work, double* price, double* delta = nullptr, double* gamma = nullptr);
+
+    // Convenience form allocating its own workspace and result
+    static std::vector<double> Vector(const EuropeanOption& opt, const std::vector<double>& S_mesh,
+        const PdeSettings& settings = PdeSettings());
+};
+
+#endif
@@ -0,0 +1,57 @@
+// Counter-based random number generator (Philox4x32-10) for reproducible parallel Monte Carlo
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstdint>
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3") maps a 128-bit counter and a 64-bit key
+// to 128 random bits. There is no sequential state: the numbers for path i, dimension j are a pure function of (i, j, seed),
+// so any thread can generate any part of the stream directly and results do not depend on how work is split across threads.
+
+class Philox
+{
+public:
+    struct Block { std::uint32_t v[4]; };
+
+    explicit Philox(std::uint64_t seed) : k0(static_cast<std::uint32_t>(seed)), k1(static_cast<std::uint32_t>(seed >> 32)) {}
+
+    // 128 random bits for counter (c0, c1, c2, c3)
+    Block operator()(std::uint32_t c0, std::uint32_t c1, std::uint32_t c2, std::uint32_t c3) const
+    {
+        Block c = { { c0, c1, c2, c3 } };
+        std::uint32_t key0 = k0, key1 = k1;
+        for (int round = 0; round < 10; ++round)
+        {
+            std::uint64_t p0 = static_cast<std::uint64_t>(0xD2511F53u) * c.v[0];
+            std::uint64_t p1 = static_cast<std::uint64_t>(0xCD9E8D57u) * c.v[2];
+            Block next = { { static_cast<std::uint32_t>(p1 >> 32) ^ c.v[1] ^ key0, static_cast<std::uint32_t>(p1),
+                             static_cast<std::uint32_t>(p0 >> 32) ^ c.v[3] ^ key1, static_cast<std::uint32_t>(p0) } };
+            c = next;
+            key0 += 0x9E3779B9u;
+            key1 += 0xBB67AE85u;
+        }
+        return c;
+    }
+
+    // Two uniforms in (0, 1) with 53 random bits each for a (64-bit index, 64-bit sub-index) counter
+    void Uniform2(std::uint64_t index, std::uint64_t sub, double& u0, double& u1) const
+    {
+        Block r = (*this)(static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index >> 32),
+            static_cast<std::uint32_t>(sub), static_cast<std::uint32_t>(sub >> 32));
+        u0 = ToUnit(r.v[0], r.v[1]);
+        u1 = ToUnit(r.v[2], r.v[3]);
+    }
+
+    // 53 bits from two 32-bit words, centred in their interval so 0 and 1 never occur
+    static double ToUnit(std::uint32_t hi, std::uint32_t lo)
+    {
+        std::uint64_t bits = (static_cast<std::uint64_t>(hi) << 21) ^ (lo >> 11);
+        return (static_cast<double>(bits & ((1ull << 53) - 1)) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    std::uint32_t k0, k1;
+};
+
+#endif
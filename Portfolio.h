@@ -0,0 +1,100 @@
+// Book of option positions with aggregated Greeks and spot x volatility scenario grids
+
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "EuropeanOption.h"
+#include "Surface.h"
+#include "ThreadPool.h"
+
+// Quantity-weighted value and Greeks. Delta and Gamma are per unit of the underlying's spot, so they are only
+// meaningful per underlying; the book total adds them up as they are. Vega and Rho are per 1.0 of volatility / rate.
+struct BookGreeks
+{
+    double value = 0.0;
+    double delta = 0.0;
+    double gamma = 0.0;
+    double vega = 0.0;
+    double theta = 0.0;
+    double rho = 0.0;
+};
+
+struct PortfolioRisk
+{
+    BookGreeks total;
+    std::vector<BookGreeks> byUnderlying;  // indexed by underlying id
+    std::size_t positions = 0;
+    std::size_t lines = 0;                 // distinct contracts actually evaluated (see grouping below)
+    double seconds = 0.0;
+};
+
+// How the scenario grid is revalued
+//   FullRevaluation : every contract is repriced at the shocked spot and volatility
+//   Taylor          : second-order expansion from the base Greeks, per underlying
+//                     dV = delta dS + 0.5 gamma dS^2 + vega dsig
+//                     which costs O(underlyings) per scenario but misses higher-order and cross (vanna/volga) terms
+enum class ScenarioMethod { FullRevaluation, Taylor };
+
+// A Portfolio holds positions (private clones of the options passed in, with a signed quantity and an underlying id)
+// and the current spot of each underlying.
+//
+// As positions are added they are grouped into lines: contracts with the same dynamic type, underlying, option
+// type and parameters (and lattice settings for AmericanOption) are merged and their quantities added, so every
+// distinct contract is evaluated once however many times it is held. Lines are ordered by underlying, expiry, rates
+// and volatility. European lines go into structure-of-arrays chunks valued with Greeks::AllBatch /
+// BatchPricer::PriceBatch (SIMD), where the lines of one slice (same T, r and b, any strike) share one carry and one
+// discount factor, computed when the book is grouped rather than per line or per scenario. AmericanOption lines use
+// the lattice (LatticeGreeks) or, for perpetual contracts and the closed-form approximations, central differences on
+// Price().
+//
+// Risk() and Scenarios() run on the ThreadPool: risk over chunks of lines, scenarios over grid points. Partial sums
+// are combined in a fixed order, so the results do not depend on the thread count.
+
+class Portfolio
+{
+public:
+    Portfolio();
+    ~Portfolio();
+
+    // Adds quantity (negative for short) of a clone of opt on the given underlying; returns the position index
+    std::size_t Add(const EuropeanOption& opt, double quantity, std::uint32_t underlying);
+
+    void SetSpot(std::uint32_t underlying, double S);
+    double Spot(std::uint32_t underlying) const;
+
+    std::size_t Positions() const { return positions.size(); }
+    std::size_t Underlyings() const { return spots.size(); }
+
+    // Book value and Greeks at the current spots, in total and per underlying
+    PortfolioRisk Risk(const ParallelOptions& options = ParallelOptions()) const;
+
+    // P&L of the book versus the current state over a grid of shocks applied to every underlying at once:
+    // pnl(i, j) for spot multiplied by (1 + spotShocks[i]) and volatility shifted by volShocks[j] (absolute).
+    // pnl is resized to spotShocks.size() x volShocks.size(), keeping its layout.
+    void Scenarios(const std::vector<double>& spotShocks, const std::vector<double>& volShocks,
+        Surface& pnl, ScenarioMethod method = ScenarioMethod::FullRevaluation,
+        const ParallelOptions& options = ParallelOptions()) const;
+
+private:
+    struct Position
+    {
+        std::unique_ptr<EuropeanOption> option;
+        double quantity;
+        std::uint32_t underlying;
+    };
+
+    struct LineIndex;  // distinct contracts and their summed quantities, kept up to date by Add()
+    struct Book;       // the lines laid out for evaluation, built per calculation
+
+    void Group(Book& book) const;
+
+    std::vector<Position> positions;
+    std::unique_ptr<LineIndex> index;
+    std::vector<double> spots;  // NaN until set
+};
+
+#endif
@@ -0,0 +1,149 @@
+// Precomputed piecewise Chebyshev table of the Black-Scholes price for fast lookups, with per-tile error estimates
+
+#ifndef PRICETABLE_H
+#define PRICETABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "EuropeanOption.h"
+#include "Greeks.h"      // GreeksResult
+#include "ThreadPool.h"
+
+// Dimensions: the generalised Black-Scholes price divided by the discounted strike depends on two numbers only,
+//   c(x, v) = V / (K exp(-rT)) = exp(x) N(x/v + v/2) - N(x/v - v/2)   (call; put = c - exp(x) + 1)
+// with log forward moneyness x = log(S/K) + bT and total volatility v = sigma sqrt(T). The carry enters only through
+// the forward, so a table over (moneyness, total vol) covers every r, b and T without a third axis.
+//
+// The table stores the out-of-the-money value (the call for x < 0, the put for x >= 0) over z = x / v (moneyness
+// in standard deviations) and v, where it is smooth and bounded by 1 even for short expiries and large total
+// volatility; the other type follows by put-call parity. [-zMax, zMax] x [vMin, vMax] is cut into zTiles x vTiles
+// tiles (zTiles even, so z = 0 is a tile edge), each holding a tensor Chebyshev expansion of the given degree in both
+// directions, fitted to EuropeanOption::Price at the tile's Chebyshev nodes and stored converted to the monomial basis.
+// A lookup finds its tile with two multiplies and truncations, then sums degree^2 coefficients from one contiguous
+// block against powers of the tile coordinates; the Greeks differentiate the same polynomial. Outside [-zMax, zMax]
+// the option is deep in or out of the money and the table returns the discounted intrinsic value, whose error is
+// included in the estimates.
+//
+// Every tile carries an error estimate for the value and for its derivatives dc/dx, d2c/dx2 and dc/dv. FitTile
+// compares the fit with the closed form on a grid of 4x the degree per direction, tile edges included. The estimate is
+// the largest error on that grid plus a margin for the points in between: the largest change of the error between
+// neighbouring grid points in z plus the same in v. For the value the Chebyshev tail (the sum of the magnitudes of
+// the highest-order coefficients) is the estimate when it is larger. These are estimates, not guaranteed bounds:
+// the margin covers the points off the grid only while the error changes no faster there than between grid points,
+// and no bound on the derivatives of c over the tile backs that up. Only the region beyond zMax has a proven bound
+// (see ApplyTolerance). Tiles whose estimate exceeds any of Settings().tolerance are served by the closed form
+// instead of the polynomial, and ErrorEstimates() is the largest estimate over the tiles still served by the table
+// and the region beyond zMax. With the default settings every tile meets the default tolerance and the estimates
+// are about 1.4e-8 for c, 1.2e-7 for dc/dx, 6e-5 for d2c/dx2 and 5e-8 for dc/dv, 2 to 30 times the largest errors
+// Validate() finds. A lower degree, fewer tiles or a tighter tolerance moves tiles to the closed form (ExactTiles()).
+// Validate() checks all four estimates again on random points.
+//
+// Tables are built in parallel (one task per tile row) and can be saved to and loaded from a binary file.
+
+// Errors of the normalised out-of-the-money value c = price / (K exp(-rT)) and its derivatives in x = log forward
+// moneyness and v. In contract units they scale to price K_df, delta K_df / S, (gamma + delta) K_df / S^2 and
+// vega K_df sqrt(T).
+struct PriceTableErrors
+{
+    double price;  // c
+    double delta;  // dc/dx
+    double gamma;  // d2c/dx2
+    double vega;   // dc/dv
+};
+
+struct PriceTableSettings
+{
+    double zMax = 8.0;     // moneyness range in standard deviations
+    double vMin = 0.01;    // total volatility sigma*sqrt(T) covered
+    double vMax = 2.0;
+    unsigned zTiles = 32;  // even
+    unsigned vTiles = 16;
+    unsigned degree = 8;   // Chebyshev coefficients per direction and tile (at most MaxDegree)
+    PriceTableErrors tolerance = { 1e-7, 1e-6, 1e-4, 1e-6 };  // tiles with a larger estimate use the closed form
+};
+
+// Largest errors of the normalised values (see PriceTableErrors) over random points of the table's domain
+struct PriceTableValidation
+{
+    std::size_t samples = 0;
+    double priceError = 0.0;   // max |value - exact|
+    double deltaError = 0.0;   // max |d/dx - exact|
+    double gammaError = 0.0;   // max |d2/dx2 - exact|
+    double vegaError = 0.0;    // max |d/dv - exact|
+    bool withinEstimates = false; // every error <= the matching member of ErrorEstimates()
+};
+
+class PriceTable
+{
+public:
+    static const std::uint32_t Version = 3;  // 2: monomial-basis coefficients; 3: per-tile error estimates and tolerance
+    static const unsigned MaxDegree = 16;
+
+    PriceTable();
+
+    // Fits every tile; returns false and sets Error() for an invalid settings combination
+    bool Build(const PriceTableSettings& settings = PriceTableSettings(), const ParallelOptions& options = ParallelOptions());
+
+    bool Save(const std::string& path) const;
+    bool Load(const std::string& path);
+    const std::string& Error() const { return error; }
+
+    bool Built() const { return !coefficients.empty(); }
+    const PriceTableSettings& Settings() const { return settings; }
+    std::size_t Bytes() const { return (coefficients.size() + tileEstimates.size()) * sizeof(double) + exact.size(); }
+
+    // Estimated errors of every lookup (see above and PriceTableErrors); not guaranteed bounds; NaN before Build() or Load(). In-the-money prices
+    // add the rounding of the parity term, of order 1e-16 * forward.
+    const PriceTableErrors& ErrorEstimates() const { return estimates; }
+
+    // Tiles served by the closed form because their estimate exceeds the tolerance
+    std::size_t ExactTiles() const;
+
+    // True when sigma*sqrt(T) of the contract lies in [vMin, vMax]
+    bool Covers(const OptionInvariants& c) const;
+
+    // Lookups from the cached invariants of a contract (EuropeanOption::Invariants()), so only log(S/K) is computed per
+    // call. NaN when the table does not cover the contract or has not been built.
+    double Price(const OptionInvariants& c, double S, bool call) const;
+    GreeksResult Greeks(const OptionInvariants& c, double S, bool call) const;
+
+    // Convenience forms computing the invariants on every call
+    double Price(const EuropeanOption& opt, double S) const;
+    GreeksResult Greeks(const EuropeanOption& opt, double S) const;
+
+    // Compares the table with the exact formulas at samples random points (fixed seed, so repeatable)
+    PriceTableValidation Validate(std::size_t samples = 100000, std::uint32_t seed = 1) const;
+
+private:
+    // Index of the tile holding (z, v), clamped into the table, and the point's coordinates (u, w) in [-1, 1]^2 there
+    std::size_t Locate(double z, double v, double& u, double& w) const;
+
+    // Fitted (out-of-the-money) value of a tile at (u, w) and its derivatives in z and v
+    void Evaluate(std::size_t tile, double u, double w, double* value, double* dz, double* dzz, double* dv) const;
+
+    // Normalised call or put value c and, when wanted, dc/dx, d2c/dx2 and dc/dv (x = z v), including the intrinsic
+    // region and the exact tiles. ex = exp(x).
+    void Normalised(double x, double ex, double v, bool call, double& c, double* cx, double* cxx, double* cv) const;
+
+    // The Chebyshev sums of one tile at (u, w) in [-1, 1]^2, derivatives in u and w
+    template<unsigned Degree>
+    static void Contract(const double* a, unsigned n, double u, double w, double* value, double* du, double* duu, double* dw);
+
+    void FitTile(unsigned zi, unsigned vi, PriceTableErrors& tileEstimate);
+
+    // Marks the tiles over the tolerance and sets the estimates from the rest
+    void ApplyTolerance();
+
+    PriceTableSettings settings;
+    double zScale, vScale;             // tiles per unit of z and v
+    PriceTableErrors estimates;
+    std::vector<double> tileEstimates; // price, delta, gamma and vega estimate per tile, in the order of the coefficients
+    std::vector<unsigned char> exact;  // per tile: 1 when lookups use the closed form
+    std::vector<double> coefficients;  // degree^2 monomial coefficients per tile, tile (zi, vi) at (vi * zTiles + zi) * degree^2,
+                                       // b[j * degree + k] multiplying w^j u^k
+    std::string error;
+};
+
+#endif
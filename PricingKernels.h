@@ -0,0 +1,48 @@
+// Black-Scholes loops specialised at compile time on option kind (call/put) and OutputType
+
+#ifndef PRICINGKERNELS_H
+#define PRICINGKERNELS_H
+
+#include <cstddef>
+#include "EuropeanOption.h"
+#include "MatrixPricer.h" // OutputType
+
+// Call/put as a compile-time parameter instead of the optType string
+enum class OptionKind { Call, Put };
+
+// The string-based API (EuropeanOption::Price, Greeks::*, MatrixPricer) decides the call/put branch and the output kind
+// once per element. The kernels here move both decisions out of the loop: Vector() decodes optType and OutputType once
+// and jumps to Loop<Kind, Output>, a separate instantiation per (kind, output) pair in which the sign w = +1 / -1 and
+// the choice of formula are constants (if constexpr), so the inner loops have no branches.
+//
+// Everything that does not depend on spot (sqrt(T), sigma*sqrt(T), the carry and discount factors, the d1 drift)
+// is computed once per call. The spot-dependent transcendentals run in 256-element chunks through the VectorMath
+// array kernels (AVX2/AVX-512), and each instantiation evaluates only the CDF/PDF terms its output needs.
+// Results agree with the scalar functions to within the VectorMath error bounds (about 1e-13 relative), and each
+// element is computed independently, so the split of a spot range into sub-ranges never changes the numbers.
+// GammaFD divides price differences by h^2, which magnifies that difference (about 1e-8 relative at h = 0.01,
+// well below the O(h^2) truncation error of the difference itself).
+
+class PricingKernels
+{
+public:
+    static OptionKind KindOf(const EuropeanOption& opt) { return opt.optType == "C" ? OptionKind::Call : OptionKind::Put; }
+
+    // False when output must go through the virtual Price() of a derived class (e.g. AmericanOption for
+    // Price/DeltaFD/GammaFD); the exact Greeks are the European closed form for every option type.
+    static bool Supports(const EuropeanOption& opt, OutputType output);
+
+    // Writes out[j * stride] for S[j], j in [0, n). Requires Supports(opt, output). h is the DeltaFD/GammaFD step.
+    // With factors (curve factors at opt.T) the rates and the two exponentials are taken from them instead of
+    // from opt.r and opt.b.
+    static void Vector(const EuropeanOption& opt, const double* S, std::size_t n,
+        OutputType output, double* out, std::size_t stride, double h, const TermFactors* factors = nullptr);
+
+private:
+    // One instantiation per (Kind, Output) pair; Vector() selects it at run time
+    template <OptionKind Kind, OutputType Output>
+    static void Loop(const EuropeanOption& opt, const TermFactors* factors, const double* S, std::size_t n,
+        double* out, std::size_t stride, double h);
+};
+
+#endif
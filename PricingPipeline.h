@@ -0,0 +1,69 @@
+// Streaming pricing driver: parse a quote file, price it and write the results through a bounded three-stage pipeline
+
+#ifndef PRICINGPIPELINE_H
+#define PRICINGPIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// File formats
+//   Csv    : one contract per line "T,K,sig,r,b,S,type" with type C or P; blank lines are skipped, and so is the first
+//            line when it is a header (none of its fields is numeric). Any other malformed line, the first one included,
+//            is written out as a row of NaN, so output row i always belongs to contract i.
+//   Binary : packed QuoteRecord structs (native byte order); a truncated last record is written out as a row of NaN
+enum class QuoteFormat { Csv, Binary };
+
+struct QuoteRecord
+{
+    double T, K, sig, r, b, S;
+    std::int32_t call;  // 1 call, 0 put
+    std::int32_t pad;
+};
+
+struct PipelineSettings
+{
+    QuoteFormat inputFormat = QuoteFormat::Csv;
+    QuoteFormat outputFormat = QuoteFormat::Csv;
+    bool greeks = false;            // false: price only; true: price, delta, gamma, vega, theta, rho
+    std::size_t chunkRows = 16384;  // Contracts per chunk handed between stages
+    std::size_t chunks = 4;         // Chunks in flight; memory is fixed at about chunks * chunkRows rows
+    std::size_t ioBufferBytes = 1 << 20;
+    unsigned pricingThreads = 1;    // Threads in the pricing stage; chunks are still written in file order
+};
+
+// Per-stage throughput: rows handled and the time the stage spent working (excluding waits on the queues).
+// For a stage with several threads busySeconds is the per-thread average. The stage with the lowest rows/sec is the bottleneck.
+struct StageStats
+{
+    std::size_t rows = 0;
+    double busySeconds = 0.0;
+    double RowsPerSecond() const { return busySeconds > 0.0 ? rows / busySeconds : 0.0; }
+};
+
+struct PipelineStats
+{
+    bool ok = false;
+    std::string error;              // Set when a file cannot be opened or written
+    std::size_t rejectedRows = 0;   // Malformed CSV lines and a truncated binary record; each gets an output row, of NaN
+    StageStats parse, price, write;
+    double wallSeconds = 0.0;
+};
+
+// Threads joined by bounded queues: parser -> pricer(s) -> writer. Chunks (structure-of-arrays contract storage plus
+// result arrays) are allocated once and cycle back from the writer to the parser through a free queue, so memory does
+// not grow with the file size. The parser reads the file in fixed-size blocks and converts fields in place with
+// std::from_chars, without creating a string per line or field; the writer formats with std::to_chars into one buffer.
+// Prices come from BatchPricer::PriceBatch, Greeks from Greeks::AllBatch.
+
+class PricingPipeline
+{
+public:
+    static PipelineStats Run(const std::string& inputPath, const std::string& outputPath,
+        const PipelineSettings& settings = PipelineSettings());
+
+    // Writes `rows` pseudo-random contracts in the given format (test and benchmark input)
+    static bool WriteSampleFile(const std::string& path, std::size_t rows, QuoteFormat format, std::uint64_t seed = 1);
+};
+
+#endif
@@ -0,0 +1,137 @@
+// Term structures of the risk-free rate and the cost of carry, with discount and carry factors per maturity
+
+#ifndef RATECURVE_H
+#define RATECURVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// How the instantaneous forward rate f(t) runs between the knots of a curve
+//   PiecewiseFlat   : f(t) = forwards[i] on (times[i-1], times[i]] (times[-1] = 0)
+//   PiecewiseLinear : f(t) linear between consecutive knots (times[i], forwards[i])
+// Both hold the first forward before the first knot and the last forward after the last knot.
+enum class CurveInterpolation { PiecewiseFlat, PiecewiseLinear };
+
+// A curve of one continuously compounded rate, defined by its instantaneous forwards. The integral of f up to each
+// knot is precomputed, so the integral up to any T costs one binary search and a short polynomial:
+//   Integral(T) = int_0^T f(t) dt,  ZeroRate(T) = Integral(T) / T,  Discount(T) = exp(-Integral(T))
+// Used for the risk-free rate (discounting) and for the cost of carry b (r minus the dividend or foreign rate).
+class RateCurve
+{
+public:
+    // Flat curve at rate
+    explicit RateCurve(double rate = 0.0);
+
+    // Replaces the knots; false (curve unchanged) unless times are positive and strictly increasing, the sizes
+    // match and there is at least one knot
+    bool Set(const std::vector<double>& times, const std::vector<double>& forwards,
+        CurveInterpolation interpolation = CurveInterpolation::PiecewiseFlat);
+
+    const std::vector<double>& Times() const { return times; }
+    const std::vector<double>& Forwards() const { return forwards; }
+    CurveInterpolation Interpolation() const { return interpolation; }
+
+    double Forward(double T) const;   // instantaneous forward f(T)
+    double Integral(double T) const;
+    double ZeroRate(double T) const;  // f(0) at T = 0
+    double Discount(double T) const;
+
+    // out[i] = ZeroRate(T[i]) and out[i] = Discount(T[i]) for i in [0, n); no allocation
+    void ZeroRates(const double* T, std::size_t n, double* out) const;
+    void Discounts(const double* T, std::size_t n, double* out) const;
+
+private:
+    // Knot index i with times[i-1] < T <= times[i], or times.size() past the last knot
+    std::size_t Segment(double T) const;
+
+    std::vector<double> times;
+    std::vector<double> forwards;
+    std::vector<double> integrals;  // integrals[i] = Integral(times[i])
+    CurveInterpolation interpolation;
+};
+
+// Everything the pricing formulas need from the curves at one maturity. r and b are the zero rates over [0, T], so
+// the flat-rate formulas priced with them reproduce the curve prices exactly; forwardR / forwardB are the
+// instantaneous forwards at T, which enter Theta (see Greeks::All with a TermStructure).
+struct TermFactors
+{
+    double T;
+    double r, b;                  // zero rates
+    double discount;              // exp(-rT)
+    double carry;                 // exp((b - r)T)
+    double forwardR, forwardB;
+};
+
+// Open-addressed hash from a maturity to its position among the distinct maturities added so far (in the order they
+// were first added). Keyed on the bit pattern of T, so every value, NaN included, finds its own entry. Collecting
+// the distinct expiries of n contracts costs O(n) whatever their number and order, with no sort of all n.
+class MaturityIndex
+{
+public:
+    MaturityIndex();
+
+    // Position of T, appending it to Maturities() when it is new
+    std::size_t Add(double T);
+
+    std::size_t Size() const { return maturities.size(); }
+    const std::vector<double>& Maturities() const { return maturities; }
+
+private:
+    void Grow();
+
+    // Key and position side by side, so a probe touches one cache line
+    struct Slot
+    {
+        std::uint64_t key;
+        std::size_t position;  // position + 1, or 0 when the slot is empty
+    };
+
+    std::vector<Slot> slots;
+    std::vector<double> maturities;
+    unsigned shift;                      // 64 - log2(slots): the hash keeps the top bits of key * golden ratio
+};
+
+// Rate and carry curves of one underlying. Factors(T) evaluates both curves and the two exponentials; a book
+// with a few listed expiries calls Precompute() with them once, after which Factors() for those maturities is a
+// binary search in the cached grid. The batch lookup also reuses the previous result while T repeats, and the
+// engines that take a TermStructure compute each distinct expiry once per pricing run, so contracts sharing an
+// expiry share one discount-factor computation.
+class TermStructure
+{
+public:
+    TermStructure() {}
+    TermStructure(const RateCurve& rateCurve, const RateCurve& carryCurve) : rate(rateCurve), carry(carryCurve) {}
+
+    const RateCurve& Rate() const { return rate; }
+    const RateCurve& Carry() const { return carry; }
+
+    // Replace a curve. The cached grid was computed from the old curves and is dropped: call Precompute() again
+    void SetRate(const RateCurve& curve) { rate = curve; grid.clear(); }
+    void SetCarry(const RateCurve& curve) { carry = curve; grid.clear(); }
+
+    // Caches the factors of the given maturities (any order, duplicates and non-positive values ignored)
+    void Precompute(const std::vector<double>& maturities);
+    std::size_t CachedMaturities() const { return grid.size(); }
+
+    TermFactors Factors(double T) const;
+
+    // out[i] = Factors(T[i]) for i in [0, n); no allocation
+    void Factors(const double* T, std::size_t n, TermFactors* out) const;
+
+    // Factors of the distinct values among T[0, n), in increasing T: one MaturityIndex pass collects the distinct
+    // values, only those are sorted, then one evaluation per expiry. The matrix engines build this table once per pricing run and look rows up in it with Find().
+    std::vector<TermFactors> DistinctFactors(const double* T, std::size_t n) const;
+
+    // Entry of table (increasing T, as returned by DistinctFactors) with exactly this T, or nullptr
+    static const TermFactors* Find(const std::vector<TermFactors>& table, double T);
+
+private:
+    TermFactors Compute(double T) const;
+
+    RateCurve rate;
+    RateCurve carry;
+    std::vector<TermFactors> grid;  // increasing T, from the current curves
+};
+
+#endif
@@ -0,0 +1,163 @@
+// Lock-free bounded ring buffers: single-producer/single-consumer and multi-producer/single-consumer
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Both rings have a power-of-two capacity (rounded up), never allocate after construction, and never block:
+// TryPush fails when the ring is full and TryPop fails when it is empty, leaving the caller to decide whether to
+// retry, drop or coalesce. T must be default-constructible and copy/move-assignable.
+//
+// The producer and consumer indices live on separate cache lines so the two sides do not invalidate each other's
+// line on every operation.
+
+const std::size_t RingCacheLine = 64;
+
+inline std::size_t RingCapacity(std::size_t requested)
+{
+    std::size_t capacity = 2;
+    while (capacity < requested) capacity <<= 1;
+    return capacity;
+}
+
+// One producer thread, one consumer thread. Each side caches the other side's index and re-reads it
+// only when the ring looks full (producer) or empty (consumer).
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(std::size_t capacity)
+        : mask(RingCapacity(capacity) - 1), slots(new T[mask + 1]),
+        head(0), tailCache(0), tail(0), headCache(0)
+    {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t Capacity() const { return mask + 1; }
+
+    // Producer side
+    bool TryPush(const T& item)
+    {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h - tailCache > mask)
+        {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h - tailCache > mask) return false;
+        }
+        slots[h & mask] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool TryPop(T& out)
+    {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t == headCache)
+        {
+            headCache = head.load(std::memory_order_acquire);
+            if (t == headCache) return false;
+        }
+        out = slots[t & mask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a third thread
+    std::size_t Size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+private:
+    const std::size_t mask;
+    std::unique_ptr<T[]> slots;
+
+    alignas(RingCacheLine) std::atomic<std::size_t> head; // next slot to write (producer)
+    std::size_t tailCache;                                // producer's copy of tail
+    alignas(RingCacheLine) std::atomic<std::size_t> tail; // next slot to read (consumer)
+    std::size_t headCache;                                // consumer's copy of head
+};
+
+// Any number of producer threads, one consumer thread (Vyukov's bounded queue). Every slot carries a sequence number:
+// a producer claims a position with one compare-exchange on head and publishes the slot by advancing its sequence,
+// so producers never wait for each other apart from retrying a lost claim.
+template <typename T>
+class MpscRing
+{
+public:
+    explicit MpscRing(std::size_t capacity)
+        : mask(RingCapacity(capacity) - 1), cells(new Cell[mask + 1]), head(0), tail(0)
+    {
+        for (std::size_t i = 0; i <= mask; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    std::size_t Capacity() const { return mask + 1; }
+
+    // Producer side, any thread
+    bool TryPush(const T& item)
+    {
+        std::size_t pos = head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = cells[pos & mask];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = item;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // the slot still holds an item from one lap ago: full
+            else
+                pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Consumer side, one thread
+    bool TryPop(T& out)
+    {
+        const std::size_t pos = tail.load(std::memory_order_relaxed);
+        Cell& cell = cells[pos & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+        out = cell.value;
+        cell.sequence.store(pos + mask + 1, std::memory_order_release);
+        tail.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Approximate when producers are active
+    std::size_t Size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<Cell[]> cells;
+
+    alignas(RingCacheLine) std::atomic<std::size_t> head; // next position to claim (producers)
+    alignas(RingCacheLine) std::atomic<std::size_t> tail; // next position to read (consumer)
+};
+
+#endif
@@ -0,0 +1,38 @@
+// Sobol low-discrepancy sequence for quasi-Monte Carlo
+
+#ifndef SOBOL_H
+#define SOBOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sobol points in up to MaxDimensions dimensions, from the Joe-Kuo (2008) primitive polynomials and direction numbers.
+// Points are produced in Gray-code order, so point n follows point n - 1 by a single XOR per dimension, and any point
+// can also be computed directly; that lets each thread start its block of the sequence anywhere.
+//
+// Coordinates are returned as 32-bit integers (the point is x / 2^32). Randomised QMC applies a digital shift:
+// XOR every coordinate with a random 32-bit word per dimension, which keeps the net structure of the point set.
+
+class SobolSequence
+{
+public:
+    static const unsigned MaxDimensions = 21;
+
+    // dimensions is clamped to [1, MaxDimensions]
+    explicit SobolSequence(unsigned dimensions);
+
+    unsigned Dimensions() const { return dims; }
+
+    // Point with Gray-code index n, written to out[0 .. Dimensions())
+    void Point(std::uint64_t n, std::uint32_t* out) const;
+
+    // Advances point (n - 1) held in out to point n (n >= 1)
+    void Next(std::uint64_t n, std::uint32_t* out) const;
+
+private:
+    unsigned dims;
+    std::vector<std::uint32_t> directions; // directions[d * 32 + bit]
+};
+
+#endif
@@ -0,0 +1,54 @@
+// Contiguous storage for a (parameter row x spot) surface of prices or Greeks
+
+#ifndef SURFACE_H
+#define SURFACE_H
+
+#include <vector>
+#include <cstddef>
+
+// Storage order of a Surface. RowMajor keeps each parameter row contiguous (one price-vs-spot curve per row),
+// ColumnMajor keeps each spot column contiguous (one value per parameter set at a fixed spot).
+enum class SurfaceLayout { RowMajor, ColumnMajor };
+
+// A Surface keeps all rows*cols values in one heap block instead of one std::vector per row.
+// Resize() keeps the existing capacity, so a Surface reused across revaluations allocates only the first time
+// (or when it has to grow), and neighbouring rows sit next to each other in memory.
+
+class Surface
+{
+public:
+    Surface();
+    Surface(std::size_t rows, std::size_t cols, SurfaceLayout layout = SurfaceLayout::RowMajor);
+
+    // Changes the shape; existing values are not preserved. Never releases memory.
+    void Resize(std::size_t rows, std::size_t cols, SurfaceLayout layout);
+    void Resize(std::size_t rows, std::size_t cols) { Resize(rows, cols, layout); }
+
+    std::size_t Rows() const { return rows; }
+    std::size_t Cols() const { return cols; }
+    SurfaceLayout Layout() const { return layout; }
+
+    // Element access by (parameter row, spot column) regardless of the layout
+    double& operator()(std::size_t row, std::size_t col) { return data[Index(row, col)]; }
+    double operator()(std::size_t row, std::size_t col) const { return data[Index(row, col)]; }
+
+    // Distance in elements between consecutive columns of a row / consecutive rows of a column
+    std::size_t ColStride() const { return layout == SurfaceLayout::RowMajor ? 1 : rows; }
+    std::size_t RowStride() const { return layout == SurfaceLayout::RowMajor ? cols : 1; }
+
+    double* Data() { return data.data(); }
+    const double* Data() const { return data.data(); }
+
+private:
+    std::size_t Index(std::size_t row, std::size_t col) const
+    {
+        return layout == SurfaceLayout::RowMajor ? row * cols + col : col * rows + row;
+    }
+
+    std::size_t rows;
+    std::size_t cols;
+    SurfaceLayout layout;
+    std::vector<double> data;
+};
+
+#endif
@@ -0,0 +1,128 @@
+// Versioned binary file format for computed surfaces, written and read through memory mapping
+
+#ifndef SURFACEFILE_H
+#define SURFACEFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MatrixPricer.h" // OutputType
+#include "Surface.h"      // SurfaceLayout
+
+// File layout (version 1, native byte order, all offsets in bytes from the start of the file):
+//   SurfaceFileHeader    128 bytes: magic, version, byte-order tag, OutputType, layout, shape, section offsets
+//   parameter axis       rows x 5 doubles (T, K, sig, r, b) with b = r filled in where the paramMatrix row had only 4 values
+//   spot axis            cols doubles
+//   data                 starts on a 4096-byte page boundary; one block per column (ColumnMajor) or per row (RowMajor),
+//                        each block padded to a multiple of 64 bytes so every block starts on a cache line
+//
+// Writers map the file read-write and compute straight into the mapping (see the MatrixPricer overloads taking a
+// SurfaceFile), so no intermediate buffer or text formatting is involved. Readers map it read-only: Row() and Column()
+// return views into the mapping, and the operating system pages in only what is touched. Views along the block
+// direction are contiguous; views across blocks are strided, so pick the layout matching the usual access pattern.
+
+struct SurfaceFileHeader
+{
+    char magic[8];              // "OPTSURF" followed by a zero byte
+    std::uint32_t version;
+    std::uint32_t byteOrder;    // 0x01020304 as written by the producing machine
+    std::uint32_t outputType;   // OutputType
+    std::uint32_t layout;       // SurfaceLayout
+    std::uint64_t rows;         // parameter rows
+    std::uint64_t cols;         // spots
+    std::uint64_t paramsPerRow; // 5
+    std::uint64_t paramOffset;
+    std::uint64_t spotOffset;
+    std::uint64_t dataOffset;
+    std::uint64_t blockStride;  // elements from the start of one block to the next
+    std::uint64_t fileBytes;
+    std::uint8_t reserved[40];
+};
+
+// Read-only view of one row or column inside a mapping (or any strided array)
+struct SurfaceSlice
+{
+    const double* data;
+    std::size_t size;
+    std::size_t stride;         // elements between consecutive values
+
+    double operator[](std::size_t i) const { return data[i * stride]; }
+    std::size_t Size() const { return size; }
+    bool Contiguous() const { return stride == 1; }
+};
+
+class SurfaceFile
+{
+public:
+    static const std::uint32_t Version = 1;
+
+    SurfaceFile();
+    ~SurfaceFile();
+
+    SurfaceFile(const SurfaceFile&) = delete;
+    SurfaceFile& operator=(const SurfaceFile&) = delete;
+
+    // Creates (or truncates) a file sized for paramMatrix.size() x S_values.size() values, writes the header and
+    // axes and maps the data writable. Values start out as zero. Returns false and sets Error() on failure.
+    bool Create(const std::string& path,
+        const std::vector<std::vector<double>>& paramMatrix,
+        const std::vector<double>& S_values,
+        OutputType output,
+        SurfaceLayout layout = SurfaceLayout::ColumnMajor);
+
+    // Maps an existing file read-only after checking magic, version, byte order and section sizes
+    bool Open(const std::string& path);
+
+    // Writes dirty pages back to the file (writable mappings only)
+    bool Flush();
+
+    // Flushes and unmaps; also done by the destructor
+    void Close();
+
+    bool IsOpen() const { return base != nullptr; }
+    bool Writable() const { return writable; }
+    const std::string& Error() const { return error; }
+
+    // Shape and type of the open surface; with nothing open a 0 x 0 Price surface in ColumnMajor layout
+    std::size_t Rows() const { return base ? static_cast<std::size_t>(header().rows) : 0; }
+    std::size_t Cols() const { return base ? static_cast<std::size_t>(header().cols) : 0; }
+    OutputType Output() const { return base ? static_cast<OutputType>(header().outputType) : OutputType::Price; }
+    SurfaceLayout Layout() const { return base ? static_cast<SurfaceLayout>(header().layout) : SurfaceLayout::ColumnMajor; }
+
+    // Parameter axis: 5 values (T, K, sig, r, b) for the given row; spot axis: Cols() values.
+    // The pointer accessors below return nullptr (views: empty, strides: 0) when nothing is open.
+    const double* Params(std::size_t row) const;
+    const double* Spots() const;
+
+    // Zero-copy views into the mapping
+    SurfaceSlice Row(std::size_t row) const;
+    SurfaceSlice Column(std::size_t col) const;
+
+    // Element access without checks: valid only on an open file, for row < Rows() and col < Cols()
+    double operator()(std::size_t row, std::size_t col) const { return Data()[row * RowStride() + col * ColStride()]; }
+
+    // Raw access for writers: element (row, col) is Data()[row * RowStride() + col * ColStride()]
+    double* Data();
+    const double* Data() const;
+    std::size_t RowStride() const;
+    std::size_t ColStride() const;
+
+private:
+    const SurfaceFileHeader& header() const { return *reinterpret_cast<const SurfaceFileHeader*>(base); }
+    bool Map(const std::string& path, std::size_t bytes, bool create);
+
+    unsigned char* base;    // start of the mapping (the header)
+    std::size_t bytes;
+    bool writable;
+    std::string error;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+};
+
+#endif
@@ -0,0 +1,57 @@
+// Reusable work-stealing thread pool used by the parallel pricing engines
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// The pool owns a fixed set of worker threads, each with its own task deque.
+// A worker pops work from the back of its own deque and, when that runs dry, steals from the front of the others,
+// so uneven tiles (e.g. deep ITM rows that take longer) even out without a central queue becoming a bottleneck.
+// The thread calling ParallelFor also executes tasks while it waits, so a pool with N workers runs N + 1 threads.
+// ParallelFor may be called from inside a body (nested): the worker making the call keeps running queued tasks,
+// of its own job first and then of any job, until its job is done, so nesting never leaves the pool without workers.
+//
+// Threads are created once and reused across calls; creating threads per pricing run would cost more than small surfaces.
+
+class ThreadPool
+{
+public:
+    // Range body: processes indices [begin, end)
+    typedef std::function<void(std::size_t begin, std::size_t end)> RangeFunction;
+
+    // workers = 0 uses std::thread::hardware_concurrency() - 1 workers (the caller is the remaining thread)
+    explicit ThreadPool(unsigned workers = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of worker threads (excluding the calling thread)
+    unsigned Workers() const;
+
+    // Splits [0, count) into ranges of at most grain indices and runs body on each, blocking until all are done.
+    // threads limits how many threads (caller included) may work on this call; 0 means all of them.
+    // The first exception thrown by body is rethrown in the caller after the remaining ranges have finished.
+    void ParallelFor(std::size_t count, std::size_t grain, const RangeFunction& body, unsigned threads = 0);
+
+    // Process-wide pool shared by the engines when the caller does not supply one
+    static ThreadPool& Shared();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+// Per-call parallel settings accepted by the parallel engines
+struct ParallelOptions
+{
+    unsigned threads = 0;       // Threads to use including the caller; 0 means every thread of the pool
+    std::size_t grain = 0;      // Work items per task; 0 lets the engine choose
+    ThreadPool* pool = nullptr; // Pool to run on; nullptr means ThreadPool::Shared()
+};
+
+#endif
@@ -0,0 +1,179 @@
+// In-process engine that reprices subscribed options on every underlying spot tick
+
+#ifndef TICKENGINE_H
+#define TICKENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EuropeanOption.h"
+#include "Greeks.h"
+#include "RingBuffer.h"
+#include "LatencyHistogram.h"
+
+// Spot update for one underlying. timestampNs is TickEngine::NowNs() when the tick entered the engine's queue.
+struct Tick
+{
+    std::uint32_t underlying;
+    double spot;
+    std::int64_t timestampNs;
+};
+
+// One repricing result, as delivered to consumers
+struct PriceUpdate
+{
+    std::uint32_t subscription;  // index returned by Subscribe()
+    std::uint32_t underlying;
+    double spot;
+    GreeksResult values;         // price and Greeks; Greeks are NaN where the model gives none (see below)
+    std::int64_t tickNs;         // when the tick that produced this update was queued
+    std::int64_t publishNs;      // when the update was published
+    std::uint64_t sequence;      // per-subscription update counter, starting at 1
+};
+
+struct TickEngineSettings
+{
+    std::size_t inputCapacity = 1 << 16;   // Tick ring size (rounded up to a power of two)
+    std::size_t maxBatch = 4096;           // Ticks drained per engine iteration before repricing
+    bool greeks = true;                    // false: price only (Greeks left NaN)
+    unsigned idleSpins = 256;              // Empty polls before the engine thread starts yielding the CPU
+};
+
+// Counters are written by the engine thread and may be read at any time
+struct TickEngineStats
+{
+    std::uint64_t ticksReceived = 0;
+    std::uint64_t ticksCoalesced = 0;      // superseded by a newer tick for the same underlying before being priced
+    std::uint64_t ticksRejected = 0;       // underlying nobody subscribed to
+    std::uint64_t pushFailures = 0;        // PushTick calls that found the ring full
+    std::uint64_t repricings = 0;          // option evaluations
+    std::uint64_t updatesPublished = 0;    // delivered into consumer rings
+    std::uint64_t updatesCoalesced = 0;    // replaced by a newer update while a consumer's ring was full
+};
+
+// Threads and data flow:
+//   feed threads --PushTick--> MPSC tick ring --> engine thread --> one SPSC ring per consumer
+//                                                              \--> latest-value board (any reader)
+//
+// The engine thread drains up to maxBatch ticks, keeps only the newest tick per underlying (older ones are stale by
+// the time they would be priced, so they are coalesced), then reprices every subscription on each ticked underlying
+// with the option's Reprice(), which reuses its cached spot-independent terms. Subscriptions are private clones of the
+// options passed to Subscribe(), so callers keep their objects.
+//
+// Results go out without locks in two forms:
+//   - Poll(consumer): a stream of updates through the consumer's SPSC ring. When a consumer falls behind and its ring
+//     is full, the engine parks the newest update per subscription and replaces it on later ticks, so a slow consumer
+//     receives fewer, fresher updates instead of stalling the engine or reading stale prices.
+//   - Latest(subscription): the newest update, held in a sequence-locked slot that readers retry if they overlap a write.
+//
+// Values: European contracts get the closed-form price and Greeks::All. AmericanOption on the lattice gets
+// LatticeGreeks(). Perpetual American contracts get price, Delta and Gamma (central differences on Reprice()),
+// Theta 0 (no maturity) and NaN Vega/Rho; the closed-form approximations (Barone-Adesi-Whaley, Bjerksund-Stensland)
+// get the same, with Theta from a one-day backward difference in maturity.
+//
+// Latency: every published update records publishNs - tickNs in TickToPrice(), covering queueing, coalescing,
+// pricing and publication.
+//
+// Subscribe() and AddConsumer() must be called before Start(); the engine's hot path then needs no locks.
+
+class TickEngine
+{
+public:
+    explicit TickEngine(const TickEngineSettings& settings = TickEngineSettings());
+    ~TickEngine();
+
+    TickEngine(const TickEngine&) = delete;
+    TickEngine& operator=(const TickEngine&) = delete;
+
+    // Registers a clone of opt for repricing on ticks of `underlying`; returns the subscription index,
+    // or NotRegistered once the engine has been started
+    std::size_t Subscribe(const EuropeanOption& opt, std::uint32_t underlying);
+
+    // Adds an update stream with its own SPSC ring; returns the consumer index for Poll(), or NotRegistered once started
+    std::size_t AddConsumer(std::size_t capacity = 4096);
+
+    static const std::size_t NotRegistered = static_cast<std::size_t>(-1);
+
+    // Starts / stops the engine thread. Stop() prices the ticks already queued before returning.
+    void Start();
+    void Stop();
+
+    // Feed side, any number of threads. Stamps the tick with NowNs(); returns false when the ring is full.
+    bool PushTick(std::uint32_t underlying, double spot);
+
+    // Consumer side: one thread per consumer index
+    bool Poll(std::size_t consumer, PriceUpdate& out);
+
+    // Newest update of a subscription from any thread; false before its first update
+    bool Latest(std::size_t subscription, PriceUpdate& out) const;
+
+    TickEngineStats Stats() const;
+    const LatencyHistogram& TickToPrice() const { return latency; }
+    std::size_t Subscriptions() const { return subscriptions.size(); }
+
+    // Monotonic clock in nanoseconds used for all timestamps
+    static std::int64_t NowNs();
+
+private:
+    struct Subscription;
+    struct Consumer;
+    struct BoardSlot;
+
+    void Run();
+    void PriceUnderlying(const Tick& tick);
+    void Publish(const PriceUpdate& update);
+    void FlushParked(Consumer& consumer);
+    bool ProcessBatch();
+
+    TickEngineSettings settings;
+    MpscRing<Tick> ticks;
+
+    std::vector<std::unique_ptr<Subscription>> subscriptions;
+    std::vector<std::vector<std::size_t>> byUnderlying;   // subscription indices per underlying id
+    std::vector<std::unique_ptr<Consumer>> consumers;
+    std::unique_ptr<BoardSlot[]> board;
+
+    // Engine-thread scratch for coalescing: newest pending tick per underlying and the list of underlyings touched
+    std::vector<Tick> pending;
+    std::vector<unsigned char> hasPending;
+    std::vector<std::uint32_t> touched;
+
+    std::thread worker;
+    std::atomic<bool> running;
+    bool started;
+
+    LatencyHistogram latency;
+    std::atomic<std::uint64_t> ticksReceived, ticksCoalesced, ticksRejected, pushFailures;
+    std::atomic<std::uint64_t> repricings, updatesPublished, updatesCoalesced;
+};
+
+// Market-data replay standing in for a live feed. Text file, one tick per line: "timestamp_ns,underlying,spot",
+// with timestamps from any origin (only differences are used). Blank lines and lines starting with '#' are skipped.
+struct ReplayTick
+{
+    std::int64_t timestampNs;
+    std::uint32_t underlying;
+    double spot;
+};
+
+class TickReplay
+{
+public:
+    // Returns false (with a message) if the file cannot be read or a line is malformed
+    static bool Load(const std::string& path, std::vector<ReplayTick>& ticks, std::string& error);
+
+    // Pushes the ticks into the engine from the calling thread. speed = 1 keeps the recorded spacing, 2 plays twice
+    // as fast, 0 pushes as fast as the ring accepts them. A full ring is retried, so no tick is dropped.
+    // Returns the number of ticks pushed.
+    static std::size_t Play(TickEngine& engine, const std::vector<ReplayTick>& ticks, double speed = 0.0);
+
+    // Writes a random-walk replay of `count` ticks over `underlyings` names spaced `intervalNs` apart (test input)
+    static bool WriteSample(const std::string& path, std::size_t count, std::uint32_t underlyings,
+        std::int64_t intervalNs = 1000, std::uint64_t seed = 1);
+};
+
+#endif
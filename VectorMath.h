@@ -0,0 +1,64 @@
+// Array versions of the transcendental functions used by the Black-Scholes pipeline (exp, log, sqrt, normal CDF/PDF)
+
+#ifndef VECTORMATH_H
+#define VECTORMATH_H
+
+#include <cstddef>
+
+// Instruction set used by the array kernels.
+// The best level supported by the CPU is detected once at runtime; the Scalar level works everywhere.
+enum class SimdLevel { Scalar, AVX2, AVX512 };
+
+// Every function reads n values from x and writes n values to out. out may alias x (in-place evaluation).
+//
+// Accuracy of the SIMD levels (measured by the demo in main.cpp: Exp over its finite range, Log and Sqrt over all
+// normal doubles, NormCdf/NormPdf against Boost):
+//   Exp     : relative error <= 4e-16; results below DBL_MIN follow gradual underflow
+//   Log     : relative error <= 5e-16; zero, negative, infinite and NaN inputs give the same result as std::log
+//   Sqrt    : exact (hardware square root)
+//   NormCdf : absolute error <= 3e-16 and relative error <= 3e-13 versus boost::math::cdf
+//   NormPdf : relative error <= 5e-16 versus boost::math::pdf
+// NormCdf uses Hart's rational approximation for |x| < 4 and a continued fraction beyond that at every level,
+// so the Scalar fallback has the same error profile as the SIMD levels.
+//
+// The float overloads run the same algorithms with shorter series and are accurate to a few float ulps (2^-24 = 6e-8):
+//   Exp     : relative error <= 8e-8; overflow above ln(FLT_MAX), gradual underflow below
+//   Log     : relative error <= 2.3e-7
+//   NormCdf : absolute error <= 1.1e-7, relative error <= 4e-7 for x <= 0
+//   NormPdf : relative error <= 2.4e-7
+// The Scalar level evaluates the float overloads in double and rounds once.
+
+class VectorMath
+{
+public:
+    // Best level the running CPU supports
+    static SimdLevel DetectedLevel();
+
+    // Level currently used by the array kernels (defaults to DetectedLevel())
+    static SimdLevel ActiveLevel();
+
+    // Forces a level, e.g. to compare paths against each other. Requests above DetectedLevel() are clamped.
+    static void SetActiveLevel(SimdLevel level);
+
+    static const char* LevelName(SimdLevel level);
+
+    static void Exp(const double* x, double* out, std::size_t n);
+    static void Log(const double* x, double* out, std::size_t n);
+    static void Sqrt(const double* x, double* out, std::size_t n);
+
+    // Standard normal cumulative distribution P(Z <= x)
+    static void NormCdf(const double* x, double* out, std::size_t n);
+
+    // Standard normal density f(x)
+    static void NormPdf(const double* x, double* out, std::size_t n);
+
+    // Single-precision versions: twice the lanes per register (8 with AVX2, 16 with AVX-512) and half the memory
+    // traffic, for batch work that only needs about six significant digits. See the float accuracy notes above.
+    static void Exp(const float* x, float* out, std::size_t n);
+    static void Log(const float* x, float* out, std::size_t n);
+    static void Sqrt(const float* x, float* out, std::size_t n);
+    static void NormCdf(const float* x, float* out, std::size_t n);
+    static void NormPdf(const float* x, float* out, std::size_t n);
+};
+
+#endif
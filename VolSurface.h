@@ -0,0 +1,126 @@
+// Implied volatility surface: SVI smile per expiry, total-variance interpolation in time, parallel calibration
+
+#ifndef VOLSURFACE_H
+#define VOLSURFACE_H
+
+#include <cstddef>
+#include <vector>
+#include "ThreadPool.h"
+
+// Raw SVI total implied variance at log forward moneyness k = log(K/F):
+//   w(k) = a + b (rho (k - m) + sqrt((k - m)^2 + sigma^2))
+// with b >= 0, |rho| <= 1, sigma > 0 and a + b sigma sqrt(1 - rho^2) >= 0 (the minimum of w is not negative).
+struct SviParams
+{
+    double a = 0.0;
+    double b = 0.0;
+    double rho = 0.0;
+    double m = 0.0;
+    double sigma = 0.1;
+};
+
+// One expiry of the surface
+struct VolSlice
+{
+    double T = 0.0;
+    double forward = 0.0;
+    SviParams svi;
+    std::size_t quotes = 0;  // quotes the slice was calibrated to (0 for slices added directly)
+    double rmse = 0.0;       // root mean square error of the fitted implied vols
+};
+
+// Market implied volatility of one strike and expiry; forward is the expiry's forward price
+struct VolQuote
+{
+    double T;
+    double K;
+    double forward;
+    double vol;
+    double weight = 1.0;
+};
+
+struct VolCalibrationSettings
+{
+    int maxIterations = 400;      // Nelder-Mead iterations over (m, log sigma) per start
+    double tolerance = 1e-20;     // stop when the simplex objective values agree to this (total variance squared)
+};
+
+struct VolCalibrationStats
+{
+    std::size_t expiries = 0;
+    std::size_t quotes = 0;
+    std::size_t rejected = 0;     // quotes with a non-positive T, K, forward, vol or weight
+    std::size_t iterations = 0;   // Nelder-Mead iterations over all expiries
+    double maxRmse = 0.0;         // worst slice vol RMSE
+    double seconds = 0.0;
+};
+
+// Between expiries the total variance is interpolated linearly in T at constant log forward moneyness (the
+// interpolated forward is log-linear in T), which keeps the surface free of calendar arbitrage when the slices are.
+// Before the first and after the last expiry the implied vol at a given moneyness is held flat. Vols depend on K and
+// T only (sticky strike), so a surface built against one set of forwards is used unchanged as the spot moves.
+//
+// Per slice, the SVI coefficients are stored ready for evaluation (b rho, sigma^2, log F and the time slopes to the
+// next slice), so a lookup costs one log, three square roots and a few multiplies. The batch lookup takes the
+// logarithms, the SVI square roots and the final sqrt(w / T) in SIMD chunks, and resolves the expiry interval and the
+// forward once per run of equal T, so a batch sorted by expiry costs about two thirds of one with T changing at
+// every contract.
+//
+// Calibrate() fits each expiry separately, in parallel across expiries. For fixed (m, sigma) the SVI variance is
+// linear in (a, b rho, b), so those three come from a weighted least-squares solve (with the constraints above
+// enforced on the boundary when the free solution breaks them) and only (m, sigma) is searched by Nelder-Mead:
+// the quasi-explicit calibration of De Marco and Martini. Each slice is independent, so the result does not
+// depend on the thread count.
+
+class VolSurface
+{
+public:
+    // Calibrates one slice per distinct quote expiry (quotes of an expiry must share T exactly), replacing the surface.
+    // Expiries with fewer than five quotes get a flat smile at their mean total variance.
+    VolCalibrationStats Calibrate(const std::vector<VolQuote>& quotes,
+        const VolCalibrationSettings& settings = VolCalibrationSettings(),
+        const ParallelOptions& options = ParallelOptions());
+
+    // Adds or replaces the slice at slice.T; false when T, forward or the SVI parameters are invalid
+    bool SetSlice(const VolSlice& slice);
+
+    void Clear();
+    bool Empty() const { return slices.empty(); }
+    const std::vector<VolSlice>& Slices() const { return slices; }
+
+    // Implied vol and total variance sigma^2 T at strike K and maturity T; NaN for an empty surface or K, T <= 0
+    double Vol(double K, double T) const;
+    double TotalVariance(double K, double T) const;
+
+    // out[i] = Vol(K[i], T[i]) for i in [0, n); no allocation
+    void Vol(const double* K, const double* T, std::size_t n, double* out) const;
+
+    // SVI total variance of one slice at log forward moneyness k
+    static double Svi(const SviParams& p, double k);
+
+private:
+    // Evaluation form of a slice; slopes run to the next slice (the last one keeps the previous interval's)
+    struct Coefficients
+    {
+        double T;
+        double logForward;
+        double a, bRho, b, m, sigma2;
+        double logForwardSlope;  // d log F / dT
+        double invSpan;          // 1 / (T_next - T), 0 for the last slice
+    };
+
+    // Index of the slice starting the interval that holds T (0 before the first expiry), trying hint first
+    std::size_t Interval(double T, std::size_t hint) const;
+
+    // Total variance at log(K) and T within interval i
+    double VarianceAt(double logK, double T, std::size_t i) const;
+
+    static double Evaluate(const Coefficients& c, double k);
+
+    void Rebuild();
+
+    std::vector<VolSlice> slices;          // increasing T
+    std::vector<Coefficients> coefficients;
+};
+
+#endif
@@ -0,0 +1,235 @@
+
+#include "AlgorithmicGreeks.h"
+#include "AmericanOption.h"
+#include "AutoDiff.h"
+#include "Lattice.h"
+#include <cmath>
+#include <limits>
+#include <typeinfo>
+#include <vector>
+
+namespace
+{
+    using std::exp;
+    using std::log;
+    using std::pow;
+    using std::sqrt;
+
+    enum class Formula { European, Perpetual, Lattice, None };
+
+    Formula FormulaOf(const EuropeanOption& opt)
+    {
+        if (typeid(opt) == typeid(EuropeanOption)) return Formula::European;
+        if (typeid(opt) == typeid(AmericanOption))
+        {
+            const AmericanMethod method = static_cast<const AmericanOption&>(opt).method;
+            if (method == AmericanMethod::Lattice) return Formula::Lattice;
+            if (method == AmericanMethod::Perpetual) return Formula::Perpetual;
+        }
+        return Formula::None;
+    }
+
+    // x holds the inputs in AdInput order: S, K, T, sig, r, b
+
+    // Generalised Black-Scholes, the same expressions as EuropeanOption::CallPrice / PutPrice
+    template<class Real>
+    Real BlackScholes(const Real* x, bool call)
+    {
+        const Real& S = x[0]; const Real& K = x[1]; const Real& T = x[2];
+        const Real& sig = x[3]; const Real& r = x[4]; const Real& b = x[5];
+
+        Real volSqrtT = sig * sqrt(T);
+        Real d1 = (log(S / K) + (b + 0.5 * sig * sig) * T) / volSqrtT;
+        Real d2 = d1 - volSqrtT;
+        Real carry = exp((b - r) * T);
+        Real K_df = K * exp(-r * T);
+
+        if (call) return S * carry * N_cdf(d1) - K_df * N_cdf(d2);
+        else return K_df * N_cdf(-d2) - S * carry * N_cdf(-d1);
+    }
+
+    // Perpetual American formulas of AmericanOption::ComputePerpetual / CallPriceAmerican / PutPriceAmerican (T unused)
+    template<class Real>
+    Real Perpetual(const Real* x, bool call)
+    {
+        const Real& S = x[0]; const Real& K = x[1];
+        const Real& sig = x[3]; const Real& r = x[4]; const Real& b = x[5];
+
+        Real sig2 = sig * sig;
+        Real b_sig = b / sig2;
+        Real sqrtTerm = sqrt((b_sig - 0.5) * (b_sig - 0.5) + 2.0 * r / sig2);
+
+        if (call)
+        {
+            Real y1 = 0.5 - b_sig + sqrtTerm;
+            if (!(y1 > 1.0)) return Real(0.0);
+            return K / (y1 - 1.0) * pow((y1 - 1.0) / y1 * S / K, y1);
+        }
+        Real y2 = 0.5 - b_sig - sqrtTerm;
+        if (!(y2 < 0.0)) return Real(0.0);
+        return K / (1.0 - y2) * pow((y2 - 1.0) / y2 * S / K, y2);
+    }
+
+    template<class Real>
+    Real Evaluate(Formula formula, const EuropeanOption& opt, const Real* x)
+    {
+        const bool call = opt.optType == "C";
+        if (formula == Formula::European) return BlackScholes(x, call);
+        if (formula == Formula::Perpetual) return Perpetual(x, call);
+
+        LatticeContract<Real> c = { x[2], x[1], x[3], x[4], x[5], call };
+        return LatticeEngine::Price(c, x[0], static_cast<const AmericanOption&>(opt).lattice);
+    }
+
+    // Per-thread tapes and adjoint buffers, reused across calls
+    template<class T>
+    struct Workspace
+    {
+        Tape<T> tape;
+        std::vector<T> adjoints;
+    };
+
+    template<class T>
+    Workspace<T>& ThreadWorkspace()
+    {
+        static thread_local Workspace<T> work;
+        return work;
+    }
+
+    void Inputs(const EuropeanOption& opt, double S, double* in)
+    {
+        in[0] = S; in[1] = opt.K; in[2] = opt.T; in[3] = opt.sig; in[4] = opt.r; in[5] = opt.b;
+    }
+
+    // One forward-over-reverse sweep with the tangent seeded on input k:
+    // price, gradient and row k of the Hessian (hessianRow may be null)
+    void SweepAlong(Formula formula, const EuropeanOption& opt, double S, std::size_t k,
+        double& price, double* gradient, double* hessianRow)
+    {
+        Workspace<Dual>& work = ThreadWorkspace<Dual>();
+        work.tape.Clear();
+        ActiveTape<Dual> active(work.tape);
+
+        double in[AdInputCount];
+        Inputs(opt, S, in);
+        Adjoint<Dual> x[AdInputCount];
+        for (std::size_t i = 0; i < AdInputCount; ++i)
+            x[i] = work.tape.Variable(Dual(in[i], i == k ? 1.0 : 0.0));
+
+        Adjoint<Dual> v = Evaluate(formula, opt, x);
+        work.tape.Gradient(v, work.adjoints);
+
+        price = v.value.v;
+        for (std::size_t i = 0; i < AdInputCount; ++i)
+        {
+            gradient[i] = work.adjoints[x[i].index].v;
+            if (hessianRow) hessianRow[i] = work.adjoints[x[i].index].d;
+        }
+    }
+
+    void FillNaN(double* values, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) values[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // Price and gradient from one recording and backward sweep
+    Sensitivities Sweep(Formula formula, const EuropeanOption& opt, double S)
+    {
+        Workspace<double>& work = ThreadWorkspace<double>();
+        work.tape.Clear();
+        ActiveTape<double> active(work.tape);
+
+        double in[AdInputCount];
+        Inputs(opt, S, in);
+        Adjoint<double> x[AdInputCount];
+        for (std::size_t i = 0; i < AdInputCount; ++i)
+            x[i] = work.tape.Variable(in[i]);
+
+        Adjoint<double> v = Evaluate(formula, opt, x);
+        work.tape.Gradient(v, work.adjoints);
+
+        Sensitivities s;
+        s.price = v.value;
+        for (std::size_t i = 0; i < AdInputCount; ++i)
+            s.first[i] = work.adjoints[x[i].index];
+        return s;
+    }
+
+    // The CRR and trinomial tree prices have a kink in S wherever a node lands on the strike (at the money among
+    // others), so their pathwise Delta is off by a few percent there; Leisen-Reimer centres the strike between nodes
+    bool PathwiseDelta(const EuropeanOption& opt)
+    {
+        return static_cast<const AmericanOption&>(opt).lattice.type == LatticeType::LeisenReimer;
+    }
+}
+
+bool AlgorithmicGreeks::Supports(const EuropeanOption& opt)
+{
+    return FormulaOf(opt) != Formula::None;
+}
+
+Sensitivities AlgorithmicGreeks::First(const EuropeanOption& opt, double S)
+{
+    Sensitivities s;
+    const Formula formula = FormulaOf(opt);
+    if (formula == Formula::None)
+    {
+        s.price = std::numeric_limits<double>::quiet_NaN();
+        FillNaN(s.first, AdInputCount);
+        return s;
+    }
+
+    s = Sweep(formula, opt, S);
+    if (formula == Formula::Lattice && !PathwiseDelta(opt))
+        s.first[static_cast<std::size_t>(AdInput::Spot)] =
+            LatticeEngine::NodeGreeks(opt, S, static_cast<const AmericanOption&>(opt).lattice).delta;
+    return s;
+}
+
+SecondOrderSensitivities AlgorithmicGreeks::Second(const EuropeanOption& opt, double S)
+{
+    SecondOrderSensitivities s;
+    const Formula formula = FormulaOf(opt);
+    if (formula == Formula::None)
+    {
+        s.price = std::numeric_limits<double>::quiet_NaN();
+        FillNaN(s.first, AdInputCount);
+        FillNaN(&s.second[0][0], AdInputCount * AdInputCount);
+        return s;
+    }
+
+    for (std::size_t k = 0; k < AdInputCount; ++k)
+        SweepAlong(formula, opt, S, k, s.price, s.first, s.second[k]);
+    return s;
+}
+
+// One sweep seeded on the spot gives the whole gradient (value parts) and Gamma (tangent part of the spot adjoint)
+GreeksResult AlgorithmicGreeks::Greeks(const EuropeanOption& opt, double S)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    GreeksResult g = { nan, nan, nan, nan, nan, nan };
+    const Formula formula = FormulaOf(opt);
+    if (formula == Formula::None) return g;
+
+    double gradient[AdInputCount], spotRow[AdInputCount];
+    if (formula == Formula::Lattice)
+    {
+        // The pathwise second derivative of a tree misses the exercise boundary; Gamma comes from the nodes, and so
+        // does Delta off Leisen-Reimer
+        const Sensitivities s = Sweep(formula, opt, S);
+        const GreeksResult nodes = LatticeEngine::NodeGreeks(opt, S, static_cast<const AmericanOption&>(opt).lattice);
+        g.price = s.price;
+        for (std::size_t i = 0; i < AdInputCount; ++i) gradient[i] = s.first[i];
+        if (!PathwiseDelta(opt)) gradient[static_cast<std::size_t>(AdInput::Spot)] = nodes.delta;
+        spotRow[static_cast<std::size_t>(AdInput::Spot)] = nodes.gamma;
+    }
+    else
+        SweepAlong(formula, opt, S, static_cast<std::size_t>(AdInput::Spot), g.price, gradient, spotRow);
+
+    g.delta = gradient[static_cast<std::size_t>(AdInput::Spot)];
+    g.gamma = spotRow[static_cast<std::size_t>(AdInput::Spot)];
+    g.vega = gradient[static_cast<std::size_t>(AdInput::Volatility)];
+    g.theta = -gradient[static_cast<std::size_t>(AdInput::Maturity)];
+    g.rho = gradient[static_cast<std::size_t>(AdInput::Rate)] + gradient[static_cast<std::size_t>(AdInput::Carry)];
+    return g;
+}
@@ -0,0 +1,322 @@
+
+#include "AmericanApproximation.h"
+#include "BatchPricer.h"
+#include "NormalDistribution.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+    const int MAX_NEWTON = 100;
+    const double NEWTON_TOLERANCE = 1e-12; // |smooth-pasting residual| / K
+
+    OptionInvariants FromBatch(const OptionBatch& batch, std::size_t i)
+    {
+        OptionInvariants c;
+        c.r = batch.r[i]; c.sig = batch.sig[i]; c.K = batch.K[i]; c.T = batch.T[i]; c.b = batch.b[i];
+        c.valid = true;
+
+        c.volSqrtT = c.sig * std::sqrt(c.T);
+        c.drift = (c.b + 0.5 * c.sig * c.sig) * c.T;
+        c.carry = std::exp((c.b - c.r) * c.T);
+        c.K_df = c.K * std::exp(-c.r * c.T);
+        return c;
+    }
+
+    // M / (1 - exp(-rT)) with M = 2r / sig^2, which tends to 2 / (sig^2 T) as r goes to 0
+    double ScaledM(const OptionInvariants& c)
+    {
+        const double sig2 = c.sig * c.sig;
+        return (c.r != 0.0) ? 2.0 * c.r / (sig2 * -std::expm1(-c.r * c.T)) : 2.0 / (sig2 * c.T);
+    }
+
+    // ---------------- Bjerksund-Stensland (2002) ----------------
+    // Haug, The Complete Guide to Option Pricing Formulas (2nd ed.), section 3.3.3. The boundary steps at
+    // t1 = GOLDEN * T, so every bivariate normal of the formula has correlation +-sqrt(GOLDEN): the quadrature
+    // nodes of N_cdf2 are the same for every contract, and the price is a sum of 12 univariate and 20 bivariate
+    // terms that is gathered into one array of normal CDFs and one of exponentials for the SIMD kernels.
+
+    const double GOLDEN = 0.6180339887498949; // (sqrt(5) - 1) / 2
+
+    // Genz's rule of N_cdf2 for one fixed correlation (20 points, as N_cdf2 uses for 0.75 <= |rho| < 0.925):
+    //   N_cdf2(a, b, rho) = N(a) N(b) + scale * sum_i exp((sn_i h k - (h^2 + k^2) / 2) * inv_i + logW_i),  h = -a, k = -b
+    struct FixedCorrelation
+    {
+        static const int POINTS = 20;
+        double scale;
+        double sn[POINTS], inv[POINTS], logW[POINTS];
+
+        explicit FixedCorrelation(double rho)
+        {
+            const double asr = std::asin(rho);
+            scale = asr / (4.0 * 3.14159265358979323846);
+            for (int i = 0; i < POINTS / 2; ++i)
+                for (int side = 0; side < 2; ++side)
+                {
+                    const int j = 2 * i + side;
+                    sn[j] = std::sin(0.5 * asr * ((side ? 1.0 : -1.0) * N_cdf2Nodes[2][i] + 1.0));
+                    inv[j] = 1.0 / (1.0 - sn[j] * sn[j]);
+                    logW[j] = std::log(N_cdf2Weights[2][i]);
+                }
+        }
+    };
+
+    const FixedCorrelation& Positive() { static const FixedCorrelation rule(std::sqrt(GOLDEN)); return rule; }
+    const FixedCorrelation& Negative() { static const FixedCorrelation rule(-std::sqrt(GOLDEN)); return rule; }
+
+    // Sum of coef * N(x) and coef * N_cdf2(a, b, rho) terms, evaluated together
+    class NormalTerms
+    {
+    public:
+        void Add(double coef, double x)
+        {
+            uniCoef[uni] = coef;
+            cdf[uni++] = x;
+        }
+
+        void Add(double coef, double a, double b, const FixedCorrelation& rule)
+        {
+            bivCoef[biv] = coef;
+            bivArg[2 * biv] = a;
+            bivArg[2 * biv + 1] = b;
+            bivRule[biv++] = &rule;
+        }
+
+        double Sum()
+        {
+            const int P = FixedCorrelation::POINTS;
+            for (int j = 0; j < biv; ++j)
+            {
+                const double h = -bivArg[2 * j], k = -bivArg[2 * j + 1];
+                const double hk = h * k, hs = 0.5 * (h * h + k * k);
+                const FixedCorrelation& rule = *bivRule[j];
+                for (int i = 0; i < P; ++i)
+                    quadrature[P * j + i] = (rule.sn[i] * hk - hs) * rule.inv[i] + rule.logW[i];
+                cdf[uni + 2 * j] = bivArg[2 * j];
+                cdf[uni + 2 * j + 1] = bivArg[2 * j + 1];
+            }
+            VectorMath::Exp(quadrature, quadrature, P * biv);
+            VectorMath::NormCdf(cdf, cdf, uni + 2 * biv);
+
+            double sum = 0.0;
+            for (int j = 0; j < uni; ++j)
+                sum += uniCoef[j] * cdf[j];
+            for (int j = 0; j < biv; ++j)
+            {
+                double q = 0.0;
+                for (int i = 0; i < P; ++i) q += quadrature[P * j + i];
+                sum += bivCoef[j] * (cdf[uni + 2 * j] * cdf[uni + 2 * j + 1] + bivRule[j]->scale * q);
+            }
+            return sum;
+        }
+
+    private:
+        static const int MAX_UNI = 12, MAX_BIV = 20;
+        int uni = 0, biv = 0;
+        double uniCoef[MAX_UNI];
+        double bivCoef[MAX_BIV], bivArg[2 * MAX_BIV];
+        const FixedCorrelation* bivRule[MAX_BIV];
+        double cdf[MAX_UNI + 2 * MAX_BIV];
+        double quadrature[FixedCorrelation::POINTS * MAX_BIV];
+    };
+
+    // coef * phi(S, T, gamma, H, I) in Haug's notation, with phi's factor S^gamma replaced by (S / ref)^gamma: ref is
+    // the exercise level of the alpha terms, whose coefficients alpha = (I - K) I^-beta come in as I - K. At low volatility beta runs into the
+    // hundreds, where I^-beta underflows and S^beta overflows on their own, so every power of the formula is
+    // summed as a log ratio with the other exponents of its term and exponentiated once.
+    void Phi(NormalTerms& terms, double coef, double ref, double S, double T, double gamma, double H, double I,
+        double r, double b, double sig)
+    {
+        const double sig2 = sig * sig;
+        const double volSqrtT = sig * std::sqrt(T);
+        const double lambda = (-r + gamma * b + 0.5 * gamma * (gamma - 1.0) * sig2) * T;
+        const double d = -(std::log(S / H) + (b + (gamma - 0.5) * sig2) * T) / volSqrtT;
+        const double kappa = 2.0 * b / sig2 + 2.0 * gamma - 1.0;
+        const double logScale = lambda + gamma * std::log(S / ref);
+        const double logIS = std::log(I / S);
+        terms.Add(coef * std::exp(logScale), d);
+        terms.Add(-coef * std::exp(logScale + kappa * logIS), d - 2.0 * logIS / volSqrtT);
+    }
+
+    // coef * psi(S, T, gamma, H, I2, I1, t1) in Haug's notation, with S^gamma replaced by (S / ref)^gamma as in Phi
+    void Psi(NormalTerms& terms, double coef, double ref, double S, double T, double gamma, double H, double I2,
+        double I1, double t1, double r, double b, double sig)
+    {
+        const double sig2 = sig * sig;
+        const double drift = b + (gamma - 0.5) * sig2;
+        const double vol1 = sig * std::sqrt(t1), vol = sig * std::sqrt(T);
+
+        const double e1 = (std::log(S / I1) + drift * t1) / vol1;
+        const double e2 = (std::log(I2 * I2 / (S * I1)) + drift * t1) / vol1;
+        const double e3 = (std::log(S / I1) - drift * t1) / vol1;
+        const double e4 = (std::log(I2 * I2 / (S * I1)) - drift * t1) / vol1;
+        const double f1 = (std::log(S / H) + drift * T) / vol;
+        const double f2 = (std::log(I2 * I2 / (S * H)) + drift * T) / vol;
+        const double f3 = (std::log(I1 * I1 / (S * H)) + drift * T) / vol;
+        const double f4 = (std::log(S * I1 * I1 / (H * I2 * I2)) + drift * T) / vol;
+
+        const double lambda = -r + gamma * b + 0.5 * gamma * (gamma - 1.0) * sig2;
+        const double kappa = 2.0 * b / sig2 + 2.0 * gamma - 1.0;
+        const double logScale = lambda * T + gamma * std::log(S / ref);
+        terms.Add(coef * std::exp(logScale), -e1, -f1, Positive());
+        terms.Add(-coef * std::exp(logScale + kappa * std::log(I2 / S)), -e2, -f2, Positive());
+        terms.Add(-coef * std::exp(logScale + kappa * std::log(I1 / S)), -e3, -f3, Negative());
+        terms.Add(coef * std::exp(logScale + kappa * std::log(I1 / I2)), -e4, -f4, Negative());
+    }
+
+    // Call with b < r; puts arrive here through the put-call transformation
+    double BjerksundStenslandCall(double S, double K, double T, double r, double b, double sig)
+    {
+        // A zero strike (a put at zero spot) is worth exercising at once: holding only loses the carry
+        if (!(K > 0.0)) return S - K;
+
+        const double sig2 = sig * sig;
+        const double t1 = GOLDEN * T;
+
+        const double beta = (0.5 - b / sig2) + std::sqrt((b / sig2 - 0.5) * (b / sig2 - 0.5) + 2.0 * r / sig2);
+        const double bInfinity = beta / (beta - 1.0) * K;
+        const double b0 = std::max(K, r / (r - b) * K);
+        const double scale = K * K / ((bInfinity - b0) * b0);
+        const double I1 = b0 + (bInfinity - b0) * (1.0 - std::exp(-(b * t1 + 2.0 * sig * std::sqrt(t1)) * scale));
+        const double I2 = b0 + (bInfinity - b0) * (1.0 - std::exp(-(b * T + 2.0 * sig * std::sqrt(T)) * scale));
+        if (S >= I2) return S - K;
+
+        // alpha1 S^beta = (I1 - K)(S / I1)^beta and alpha2 S^beta = (I2 - K)(S / I2)^beta
+        const double alpha1 = I1 - K, alpha2 = I2 - K;
+
+        NormalTerms terms;
+        Phi(terms, -alpha2, I2, S, t1, beta, I2, I2, r, b, sig);
+        Phi(terms, 1.0, 1.0, S, t1, 1.0, I2, I2, r, b, sig);
+        Phi(terms, -1.0, 1.0, S, t1, 1.0, I1, I2, r, b, sig);
+        Phi(terms, -K, 1.0, S, t1, 0.0, I2, I2, r, b, sig);
+        Phi(terms, K, 1.0, S, t1, 0.0, I1, I2, r, b, sig);
+        Phi(terms, alpha1, I1, S, t1, beta, I1, I2, r, b, sig);
+        Psi(terms, -alpha1, I1, S, T, beta, I1, I2, I1, t1, r, b, sig);
+        Psi(terms, 1.0, 1.0, S, T, 1.0, I1, I2, I1, t1, r, b, sig);
+        Psi(terms, -1.0, 1.0, S, T, 1.0, K, I2, I1, t1, r, b, sig);
+        Psi(terms, -K, 1.0, S, T, 0.0, I1, I2, I1, t1, r, b, sig);
+        Psi(terms, K, 1.0, S, T, 0.0, K, I2, I1, t1, r, b, sig);
+        return alpha2 * std::exp(beta * std::log(S / I2)) + terms.Sum();
+    }
+}
+
+// ---------------- Barone-Adesi-Whaley ----------------
+// With N = 2b / sig^2 and M = 2r / sig^2, the premium solves the quadratic approximation of the pricing PDE with
+// exponents q = (-(N - 1) +- sqrt((N - 1)^2 + 4M / (1 - exp(-rT)))) / 2. The critical price S* makes value and
+// slope of European price plus premium meet the exercise value; Newton's method on that condition (Haug, 3.3.1)
+// starts from the seed S* = K + (S*_inf - K)(1 - exp(h)) built on the perpetual boundary S*_inf, or from the
+// caller's ratio.
+double AmericanApproximation::BaroneAdesiWhaley(const OptionInvariants& c, bool call, double S, double* criticalRatio)
+{
+    if (!(c.T > 0.0) || !(c.sig > 0.0)) return NaN;
+    if (call ? c.b >= c.r : c.r <= 0.0)
+        return call ? EuropeanOption::CallPrice(c, S) : EuropeanOption::PutPrice(c, S);
+
+    const double K = c.K;
+    const double sig2 = c.sig * c.sig;
+    const double nMinus1 = 2.0 * c.b / sig2 - 1.0;
+    const double root = std::sqrt(nMinus1 * nMinus1 + 4.0 * ScaledM(c));
+    const double q = call ? 0.5 * (-nMinus1 + root) : 0.5 * (-nMinus1 - root);
+
+    double Si;
+    const double ratio = criticalRatio ? *criticalRatio : 0.0;
+    if (call ? ratio > 1.0 : (ratio > 0.0 && ratio < 1.0))
+        Si = ratio * K;
+    else
+    {
+        // Perpetual boundary (the T -> infinity exponent), then the seed of Barone-Adesi and Whaley
+        const double rootInf = std::sqrt(nMinus1 * nMinus1 + 8.0 * c.r / sig2);
+        double qInf = call ? 0.5 * (-nMinus1 + rootInf) : 0.5 * (-nMinus1 - rootInf);
+        if (call ? !(qInf > 1.0) : !(qInf < 0.0)) qInf = q; // r < 0 has no perpetual boundary
+        const double SInf = K / (1.0 - 1.0 / qInf);
+        Si = call
+            ? K + (SInf - K) * (1.0 - std::exp(-(c.b * c.T + 2.0 * c.volSqrtT) * K / (SInf - K)))
+            : SInf + (K - SInf) * std::exp((c.b * c.T - 2.0 * c.volSqrtT) * K / (K - SInf));
+    }
+
+    // Residual of value matching: exercise value - (European + premium) at Si, with the premium's slope condition
+    // substituted in; the update is a Newton step on that residual. Each step needs the European value and
+    // N(w d1) at Si, so the value is written out here (the expression of EuropeanOption::CallPrice / PutPrice) to
+    // share N(w d1) with the slope, and both CDFs come from one VectorMath call.
+    const double w = call ? 1.0 : -1.0;
+    const double invSqrt2Pi = 0.3989422804014327;
+    double carryN = 0.0;
+    for (int iteration = 0; iteration <= MAX_NEWTON; ++iteration)
+    {
+        const double d1 = (std::log(Si / K) + c.drift) / c.volSqrtT;
+        double cdf[2] = { w * d1, w * (d1 - c.volSqrtT) }; // N(w d1), N(w d2)
+        VectorMath::NormCdf(cdf, cdf, 2);
+        carryN = c.carry * cdf[0];
+        const double european = w * (Si * carryN - c.K_df * cdf[1]);
+        const double density = c.carry * invSqrt2Pi * std::exp(-0.5 * d1 * d1) / c.volSqrtT;
+
+        // Call: S* - K = c(S*) + (1 - carry N(d1)) S* / q;  put: K - S* = p(S*) - (1 - carry N(-d1)) S* / q
+        const double rhs = european + w * (1.0 - carryN) * Si / q;
+        if (std::fabs(w * (Si - K) - rhs) <= NEWTON_TOLERANCE * K || iteration == MAX_NEWTON) break;
+        const double slope = carryN * (1.0 - 1.0 / q) + (1.0 - w * density) / q;
+        Si = (K + w * rhs - slope * Si) / (1.0 - slope);
+    }
+    if (criticalRatio) *criticalRatio = Si / K;
+
+    if (call)
+        return (S < Si) ? EuropeanOption::CallPrice(c, S) + (Si / q) * (1.0 - carryN) * std::pow(S / Si, q) : S - K;
+    return (S > Si) ? EuropeanOption::PutPrice(c, S) - (Si / q) * (1.0 - carryN) * std::pow(S / Si, q) : K - S;
+}
+
+double AmericanApproximation::BaroneAdesiWhaley(const EuropeanOption& opt, double S, double* criticalRatio)
+{
+    return BaroneAdesiWhaley(opt.ComputeInvariants(), opt.optType == "C", S, criticalRatio);
+}
+
+double AmericanApproximation::BjerksundStensland(const OptionInvariants& c, bool call, double S)
+{
+    if (!(c.T > 0.0) || !(c.sig > 0.0)) return NaN;
+    if (call ? c.b >= c.r : c.r <= 0.0)
+        return call ? EuropeanOption::CallPrice(c, S) : EuropeanOption::PutPrice(c, S);
+
+    const double american = call
+        ? BjerksundStenslandCall(S, c.K, c.T, c.r, c.b, c.sig)
+        : BjerksundStenslandCall(c.K, S, c.T, c.r - c.b, -c.b, c.sig);
+
+    // Exercising at the flat boundary is one admissible strategy, and so are holding to expiry and exercising now:
+    // the bound is the best of the three. This also covers what the formula loses to rounding (a NaN included)
+    // when its terms cancel at very low volatility.
+    const double european = call ? EuropeanOption::CallPrice(c, S) : EuropeanOption::PutPrice(c, S);
+    const double floor = std::max(european, std::max(call ? S - c.K : c.K - S, 0.0));
+    return (american > floor) ? american : floor;
+}
+
+double AmericanApproximation::BjerksundStensland(const EuropeanOption& opt, double S)
+{
+    return BjerksundStensland(opt.ComputeInvariants(), opt.optType == "C", S);
+}
+
+void AmericanApproximation::PriceBatch(const OptionBatch& batch, AmericanMethod method, const double* S, double* out,
+    const ParallelOptions& options)
+{
+    const std::size_t n = batch.Size();
+    if (method != AmericanMethod::BaroneAdesiWhaley && method != AmericanMethod::BjerksundStensland)
+    {
+        std::fill(out, out + n, NaN);
+        return;
+    }
+
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+    const std::size_t grain = (options.grain > 0) ? options.grain : 256;
+
+    pool.ParallelFor(n, grain, [&](std::size_t begin, std::size_t end)
+    {
+        double ratio[2] = { 0.0, 0.0 }; // warm starts for puts and calls, restarted in every block
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const OptionInvariants c = FromBatch(batch, i);
+            const bool call = batch.isCall[i] != 0;
+            out[i] = (method == AmericanMethod::BaroneAdesiWhaley)
+                ? BaroneAdesiWhaley(c, call, S[i], &ratio[call])
+                : BjerksundStensland(c, call, S[i]);
+        }
+    }, options.threads);
+}
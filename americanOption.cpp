@@ -1,62 +1,130 @@
 
 #include "AmericanOption.h"
+#include "AmericanApproximation.h"
+#include "Metrics.h"
+#include "RateCurve.h"
 #include <cmath>
 
 
 // Default constructor calls EuropeanOption default constructor to inherit standard parameters
-AmericanOption::AmericanOption() : EuropeanOption() {}
+AmericanOption::AmericanOption() : EuropeanOption(), method(AmericanMethod::Perpetual)
+{
+    perpetual.valid = false;
+    criticalRatio = 0.0; // no warm start yet
+}
 
 // Option type constructor: allows user to specify "C" or "P" and calls the corresponding EuropeanOption constructor to initialize common parameters
 AmericanOption::AmericanOption(const std::string& optionType)
-    : EuropeanOption(optionType) {
+    : EuropeanOption(optionType), method(AmericanMethod::Perpetual)
+{
+    perpetual.valid = false;
+    criticalRatio = 0.0;
 }
 
-// Implements closed-form formula for a perpetual American call option
-double AmericanOption::CallPriceAmerican(double S) const
+// Both exponents come from the same square root, so calls and puts share one cache entry
+PerpetualInvariants AmericanOption::ComputePerpetual() const
 {
+    PerpetualInvariants c;
+    c.r = r; c.sig = sig; c.K = K; c.b = b;
+    c.valid = true;
+
     // Precompute sigma squared to avoid repeated multiplication
     double sig2 = sig * sig;
 
     // b_sig is the normalized cost-of-carry parameter
     double b_sig = b / sig2;
 
-    // Compute the sqrt term in the y1 formula
+    // Compute the sqrt term in the y1/y2 formulas
     // This comes directly from the perpetual American option solution
-    double sqrtTerm = sqrt(pow((b / sig2 - 0.5), 2) + 2 * r / sig2);
+    double sqrtTerm = sqrt(pow((b_sig - 0.5), 2) + 2 * r / sig2);
+
+    // y1 / y2 exponents determine the shape of the call / put solution (positive / negative root)
+    c.y1 = 0.5 - b_sig + sqrtTerm;
+    c.y2 = 0.5 - b_sig - sqrtTerm;
 
-    // y1 exponent determines the shape of the solution
-    double y1 = 0.5 - (b / sig2) + sqrtTerm;
+    c.callScale = K / (c.y1 - 1.0);
+    c.callRatio = (c.y1 - 1.0) / c.y1;
+    c.putScale = K / (1.0 - c.y2);
+    c.putRatio = (c.y2 - 1.0) / c.y2;
+    return c;
+}
 
+// Implements closed-form formula for a perpetual American call option
+double AmericanOption::CallPriceAmerican(const PerpetualInvariants& c, double S)
+{
     // The formula only makes sense for y1 > 1
     // If y1 <= 1, option is effectively worthless (cannot exercise early profitably)
-    return (y1 > 1.0)
-        ? (K / (y1 - 1.0)) * pow(((y1 - 1.0) / y1 * S / K), y1)
+    return (c.y1 > 1.0)
+        ? c.callScale * pow((c.callRatio * S / c.K), c.y1)
         : 0.0;
 }
 
 // Implements closed-form formula for a perpetual American put option
-double AmericanOption::PutPriceAmerican(double S) const
+double AmericanOption::PutPriceAmerican(const PerpetualInvariants& c, double S)
 {
-    double sig2 = sig * sig;
-
-    // sqrt term for y2, similar to y1 but with negative root for put
-    double sqrtTerm = sqrt(pow((b / sig2 - 0.5), 2) + 2 * r / sig2);
-
-    // y2 exponent determines the shape of the put solution
-    double y2 = 0.5 - (b / sig2) - sqrtTerm;
-
     // Only makes sense for y2 < 0
     // Otherwise, the put cannot be exercised early profitably
-    return (y2 < 0.0)
-        ? (K / (1.0 - y2)) * pow(((y2 - 1.0) / y2 * S / K), y2)
+    return (c.y2 < 0.0)
+        ? c.putScale * pow((c.putRatio * S / c.K), c.y2)
         : 0.0;
 }
 
 // Polymorphic implementation of external code calls Price() without knowing the option type automatically chooses call or put perpetual formula based on optType
 double AmericanOption::Price(double S) const
 {
+    PRICING_METRICS_SCOPE(AmericanPrice);
+
+    // Finite maturity: early exercise is handled by the lattice
+    if (method == AmericanMethod::Lattice)
+        return LatticeEngine::Price(*this, S, lattice);
+    if (method == AmericanMethod::BaroneAdesiWhaley)
+        return AmericanApproximation::BaroneAdesiWhaley(*this, S);
+    if (method == AmericanMethod::BjerksundStensland)
+        return AmericanApproximation::BjerksundStensland(*this, S);
+
+    // Cached exponents when still valid; otherwise computed for this call only, leaving the cache untouched
+    const bool cached = perpetual.Matches(r, sig, K, b);
+    PerpetualInvariants local;
+    if (!cached) local = ComputePerpetual();
+    const PerpetualInvariants& c = cached ? perpetual : local;
+
+    if (optType == "C")
+        return CallPriceAmerican(c, S); // Call formula
+    else
+        return PutPriceAmerican(c, S);  // Put formula
+}
+
+double AmericanOption::Price(double S, const TermStructure& curves) const
+{
+    const TermFactors f = curves.Factors(T);
+    AmericanOption zeroRates(*this);
+    zeroRates.r = f.r;
+    zeroRates.b = f.b;
+    return zeroRates.Price(S);
+}
+
+double AmericanOption::Reprice(double S)
+{
+    if (method == AmericanMethod::BaroneAdesiWhaley)
+        return AmericanApproximation::BaroneAdesiWhaley(Invariants(), optType == "C", S, &criticalRatio);
+    if (method != AmericanMethod::Perpetual)
+        return Price(S);
+
+    if (!perpetual.Matches(r, sig, K, b))
+        perpetual = ComputePerpetual();
+
     if (optType == "C")
-        return CallPriceAmerican(S); // Call formula
+        return CallPriceAmerican(perpetual, S);
     else
-        return PutPriceAmerican(S);  // Put formula
+        return PutPriceAmerican(perpetual, S);
+}
+
+GreeksResult AmericanOption::LatticeGreeks(double S) const
+{
+    return LatticeEngine::Greeks(*this, S, lattice);
+}
+
+std::unique_ptr<EuropeanOption> AmericanOption::Clone() const
+{
+    return std::unique_ptr<EuropeanOption>(new AmericanOption(*this));
 }
@@ -0,0 +1,814 @@
+
+// Benchmark driver for the pricing kernels.
+// Times each kernel over several input sizes and reports ns/op, ops/sec and, on Linux, hardware counters
+// (cycles, instructions, branch and cache misses per op) read through perf_event_open.
+// The results can be written as JSON so runs of different versions can be compared by a script:
+//
+//   benchmark [--filter <text>] [--sizes n1,n2,...] [--min-time <ms>] [--repetitions <k>] [--json <file>|-] [--list]
+//
+// Every sample runs the kernel enough times to last at least --min-time; the reported ns/op is the median over
+// --repetitions samples (the minimum is reported as well). Input construction is not timed.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "EuropeanOption.h"
+#include "Greeks.h"
+#include "AlgorithmicGreeks.h"
+#include "PriceTable.h"
+#include "VolSurface.h"
+#include "BatchPricer.h"
+#include "MatrixPricer.h"
+#include "FourierPricer.h"
+#include "AmericanOption.h"
+#include "MeshGenerator.h"
+#include "VectorMath.h"
+#include "Metrics.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    // Checksums of every kernel call end up here so the optimiser cannot drop the work
+    volatile double g_sink = 0.0;
+
+    // ---------------- Hardware counters ----------------
+
+    const int CounterCount = 4;
+    const char* const CounterNames[CounterCount] = { "cycles", "instructions", "branch_misses", "cache_misses" };
+
+    // One perf event group (user space only) for the calling thread. Events the machine or the kernel settings do not
+    // allow are skipped; if not even the cycle counter opens, Available() is false and no counters are reported.
+    class PerfCounters
+    {
+    public:
+        PerfCounters()
+        {
+            for (int i = 0; i < CounterCount; ++i) { fds[i] = -1; present[i] = false; }
+#ifdef __linux__
+            const std::uint64_t configs[CounterCount] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES };
+            for (int i = 0; i < CounterCount; ++i)
+            {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = configs[i];
+                attr.disabled = (i == 0) ? 1 : 0; // members follow the leader
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, (i == 0) ? -1 : fds[0], 0));
+                if (fd < 0)
+                {
+                    if (i == 0) return;
+                    continue;
+                }
+                fds[i] = fd;
+                present[i] = true;
+            }
+#endif
+        }
+
+        ~PerfCounters()
+        {
+#ifdef __linux__
+            for (int i = CounterCount - 1; i >= 0; --i)
+                if (fds[i] >= 0) close(fds[i]);
+#endif
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        bool Available() const { return present[0]; }
+        bool Present(int i) const { return present[i]; }
+
+        void Start()
+        {
+#ifdef __linux__
+            if (!Available()) return;
+            ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+        }
+
+        // Stops counting and returns the counts, scaled up when the kernel multiplexed the counters
+        void Stop(double values[CounterCount])
+        {
+            for (int i = 0; i < CounterCount; ++i) values[i] = 0.0;
+#ifdef __linux__
+            if (!Available()) return;
+            ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            for (int i = 0; i < CounterCount; ++i)
+            {
+                std::uint64_t data[3] = { 0, 0, 0 }; // value, time enabled, time running
+                if (!present[i] || read(fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) continue;
+                values[i] = (data[2] > 0) ? static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]) : 0.0;
+            }
+#endif
+        }
+
+    private:
+        int fds[CounterCount];
+        bool present[CounterCount];
+    };
+
+    // ---------------- Kernels ----------------
+
+    // A prepared kernel performs a fixed number of operations per call and returns a checksum of the results
+    typedef function<double()> PreparedKernel;
+
+    struct Kernel
+    {
+        string name;
+        size_t opsDivisor;  // ops per call = size / opsDivisor (at least 1); keeps the slow kernels' samples short
+        function<PreparedKernel(size_t ops)> prepare;
+    };
+
+    struct Result
+    {
+        string name;
+        size_t size;
+        size_t ops;          // operations per kernel call
+        size_t calls;        // kernel calls per sample
+        int samples;
+        double nsPerOp;      // median over samples
+        double minNsPerOp;
+        double counters[CounterCount];  // per op; valid where counterPresent
+        bool counterPresent[CounterCount];
+    };
+
+    // Spot ladder of n points around the strike, so ITM, ATM and OTM branches are all exercised
+    vector<double> Spots(size_t n)
+    {
+        vector<double> S(n);
+        for (size_t i = 0; i < n; ++i)
+            S[i] = 60.0 + 80.0 * (static_cast<double>(i) + 0.5) / static_cast<double>(n);
+        return S;
+    }
+
+    EuropeanOption BenchOption(const string& optType = "C")
+    {
+        EuropeanOption opt(optType);
+        opt.T = 0.5; opt.K = 100.0; opt.sig = 0.25; opt.r = 0.05; opt.b = 0.05;
+        return opt;
+    }
+
+    // A book of n contracts with strikes 70-130, maturities 0.05-2 years and volatilities 15-45%, calls and puts
+    // alternating; the parameters follow additive recurrences so neighbouring contracts differ as in a real book
+    OptionBatch BenchBatch(size_t n)
+    {
+        OptionBatch batch;
+        batch.Reserve(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const double u = static_cast<double>(i);
+            batch.Add(0.05 + 1.95 * fmod(u * 0.6180339887, 1.0), 70.0 + 60.0 * fmod(u * 0.4142135624, 1.0),
+                0.15 + 0.30 * fmod(u * 0.7320508076, 1.0), 0.05, 0.02, i % 2 == 0);
+        }
+        return batch;
+    }
+
+    // Wraps a per-spot scalar function into a kernel looping over a spot ladder
+    Kernel SpotKernel(const string& name, function<double(const EuropeanOption&, double)> f, const string& optType = "C")
+    {
+        Kernel k;
+        k.name = name;
+        k.opsDivisor = 1;
+        k.prepare = [f, optType](size_t ops) -> PreparedKernel
+        {
+            EuropeanOption opt = BenchOption(optType);
+            vector<double> S = Spots(ops);
+            return [f, opt, S]()
+            {
+                double sum = 0.0;
+                for (double s : S) sum += f(opt, s);
+                return sum;
+            };
+        };
+        return k;
+    }
+
+    // Default-settings table, built once on first use
+    const PriceTable& BenchTable()
+    {
+        static PriceTable table;
+        if (!table.Built()) table.Build();
+        return table;
+    }
+
+    // Single-expiry-pair SVI surface (0.25y and 1y slices around the bench option's 0.5y maturity)
+    const VolSurface& BenchSurface()
+    {
+        static VolSurface surface;
+        if (surface.Empty())
+            for (double T : { 0.25, 1.0 })
+            {
+                VolSlice slice;
+                slice.T = T; slice.forward = 100.0 * exp(0.05 * T);
+                slice.svi.a = 0.02 * T; slice.svi.b = 0.08; slice.svi.rho = -0.6; slice.svi.m = 0.0; slice.svi.sigma = 0.2;
+                surface.SetSlice(slice);
+            }
+        return surface;
+    }
+
+    // PriceTable lookup from cached invariants over the spot ladder (compare with EuropeanOption::Reprice / Greeks::All)
+    Kernel TableKernel(const string& name, bool greeks, const string& optType = "C")
+    {
+        Kernel k;
+        k.name = name;
+        k.opsDivisor = 1;
+        k.prepare = [greeks, optType](size_t ops) -> PreparedKernel
+        {
+            const PriceTable& table = BenchTable();
+            EuropeanOption opt = BenchOption(optType);
+            const OptionInvariants inv = opt.ComputeInvariants();
+            const bool call = optType == "C";
+            vector<double> S = Spots(ops);
+            return [&table, inv, call, greeks, S]()
+            {
+                double sum = 0.0;
+                if (greeks) for (double s : S) sum += table.Greeks(inv, s, call).delta;
+                else for (double s : S) sum += table.Price(inv, s, call);
+                return sum;
+            };
+        };
+        return k;
+    }
+
+    vector<Kernel> Kernels()
+    {
+        vector<Kernel> kernels;
+
+        kernels.push_back(SpotKernel("EuropeanOption::Price/call", [](const EuropeanOption& o, double S) { return o.Price(S); }));
+        kernels.push_back(SpotKernel("EuropeanOption::Price/put", [](const EuropeanOption& o, double S) { return o.Price(S); }, "P"));
+        {
+            Kernel k;
+            k.name = "EuropeanOption::Reprice/call";
+            k.opsDivisor = 1;
+            k.prepare = [](size_t ops) -> PreparedKernel
+            {
+                EuropeanOption opt = BenchOption();
+                vector<double> S = Spots(ops);
+                return [opt, S]() mutable
+                {
+                    double sum = 0.0;
+                    for (double s : S) sum += opt.Reprice(s);
+                    return sum;
+                };
+            };
+            kernels.push_back(k);
+        }
+        kernels.push_back(SpotKernel("Greeks::Delta", [](const EuropeanOption& o, double S) { return Greeks::Delta(o, S); }));
+        kernels.push_back(SpotKernel("Greeks::Gamma", [](const EuropeanOption& o, double S) { return Greeks::Gamma(o, S); }));
+        kernels.push_back(SpotKernel("Greeks::Vega", [](const EuropeanOption& o, double S) { return Greeks::Vega(o, S); }));
+        kernels.push_back(SpotKernel("Greeks::Theta", [](const EuropeanOption& o, double S) { return Greeks::Theta(o, S); }));
+        kernels.push_back(SpotKernel("Greeks::Rho", [](const EuropeanOption& o, double S) { return Greeks::Rho(o, S); }));
+        kernels.push_back(SpotKernel("Greeks::All", [](const EuropeanOption& o, double S) { return Greeks::All(o, S).delta; }));
+        kernels.push_back(SpotKernel("Greeks::DeltaFD", [](const EuropeanOption& o, double S) { return Greeks::DeltaFD(o, S, 0.01); }));
+        kernels.push_back(SpotKernel("Greeks::GammaFD", [](const EuropeanOption& o, double S) { return Greeks::GammaFD(o, S, 0.01); }));
+        kernels.push_back(SpotKernel("AlgorithmicGreeks::First", [](const EuropeanOption& o, double S) { return AlgorithmicGreeks::First(o, S).first[0]; }));
+        kernels.push_back(SpotKernel("AlgorithmicGreeks::Greeks", [](const EuropeanOption& o, double S) { return AlgorithmicGreeks::Greeks(o, S).gamma; }));
+        kernels.push_back(SpotKernel("AlgorithmicGreeks::Second", [](const EuropeanOption& o, double S) { return AlgorithmicGreeks::Second(o, S).second[0][3]; }));
+        kernels.push_back(TableKernel("PriceTable::Price/call", false));
+        kernels.push_back(TableKernel("PriceTable::Price/put", false, "P"));
+        kernels.push_back(TableKernel("PriceTable::Greeks", true));
+        kernels.push_back(SpotKernel("VolSurface::Vol", [](const EuropeanOption& o, double S) { return BenchSurface().Vol(S, o.T); }));
+
+        // MatrixPricer::Vector into a reused buffer for every OutputType (one op = one spot)
+        const OutputType outputs[] = { OutputType::Price, OutputType::Delta, OutputType::Gamma, OutputType::Vega,
+            OutputType::Theta, OutputType::Rho, OutputType::DeltaFD, OutputType::GammaFD };
+        const char* outputNames[] = { "Price", "Delta", "Gamma", "Vega", "Theta", "Rho", "DeltaFD", "GammaFD" };
+        for (size_t o = 0; o < 8; ++o)
+        {
+            Kernel k;
+            k.name = string("MatrixPricer::Vector/") + outputNames[o];
+            k.opsDivisor = 1;
+            const OutputType output = outputs[o];
+            k.prepare = [output](size_t ops) -> PreparedKernel
+            {
+                EuropeanOption opt = BenchOption();
+                vector<double> S = Spots(ops);
+                vector<double> out(ops);
+                return [opt, S, out, output]() mutable
+                {
+                    MatrixPricer::Vector(opt, S.data(), S.size(), output, out.data());
+                    return out[0] + out[out.size() - 1];
+                };
+            };
+            kernels.push_back(k);
+        }
+
+        // MatrixPricer::Matrix: 16 volatility rows x (size / 16) spots into a reused Surface (one op = one surface point)
+        {
+            Kernel k;
+            k.name = "MatrixPricer::Matrix/Price";
+            k.opsDivisor = 1;
+            k.prepare = [](size_t ops) -> PreparedKernel
+            {
+                const size_t rows = (ops >= 16) ? 16 : 1;
+                vector<vector<double>> params;
+                for (size_t i = 0; i < rows; ++i)
+                    params.push_back({ 0.5, 100.0, 0.10 + 0.02 * static_cast<double>(i), 0.05 });
+                vector<double> S = Spots(ops / rows);
+                EuropeanOption opt = BenchOption();
+                Surface out(rows, S.size());
+                return [opt, params, S, out]() mutable
+                {
+                    MatrixPricer::Matrix(opt, params, S, OutputType::Price, out);
+                    return out(0, 0) + out(out.Rows() - 1, out.Cols() - 1);
+                };
+            };
+            kernels.push_back(k);
+        }
+
+        // Batch pricing and Greeks in double, float and mixed precision (one op = one contract); the mixed kernels
+        // refine the contracts within their default band of the forward
+        const char* precisions[] = { "double", "float", "mixed" };
+        for (int precision = 0; precision < 3; ++precision)
+        {
+            Kernel k;
+            k.name = string("BatchPricer::PriceBatch/") + precisions[precision];
+            k.opsDivisor = 1;
+            k.prepare = [precision](size_t ops) -> PreparedKernel
+            {
+                OptionBatch batch = BenchBatch(ops);
+                OptionBatchF batchF;
+                batchF.Assign(batch);
+                vector<double> S = Spots(ops), out(ops);
+                vector<float> SF(S.begin(), S.end()), outF(ops);
+                return [precision, batch, batchF, S, out, SF, outF]() mutable
+                {
+                    if (precision == 1)
+                    {
+                        BatchPricer::PriceBatch(batchF, SF.data(), outF.data());
+                        return static_cast<double>(outF[0] + outF[outF.size() - 1]);
+                    }
+                    if (precision == 0) BatchPricer::PriceBatch(batch, S.data(), out.data());
+                    else BatchPricer::PriceBatchMixed(batch, S.data(), out.data());
+                    return out[0] + out[out.size() - 1];
+                };
+            };
+            kernels.push_back(k);
+        }
+        for (int precision = 0; precision < 3; ++precision)
+        {
+            Kernel k;
+            k.name = string("Greeks::AllBatch/") + precisions[precision];
+            k.opsDivisor = 1;
+            k.prepare = [precision](size_t ops) -> PreparedKernel
+            {
+                OptionBatch batch = BenchBatch(ops);
+                OptionBatchF batchF;
+                batchF.Assign(batch);
+                vector<double> S = Spots(ops);
+                vector<float> SF(S.begin(), S.end());
+                vector<GreeksResult> out(ops);
+                vector<GreeksResultF> outF(ops);
+                return [precision, batch, batchF, S, SF, out, outF]() mutable
+                {
+                    if (precision == 1)
+                    {
+                        Greeks::AllBatch(batchF, SF.data(), outF.data());
+                        return static_cast<double>(outF[0].gamma + outF[outF.size() - 1].gamma);
+                    }
+                    if (precision == 0) Greeks::AllBatch(batch, S.data(), out.data());
+                    else Greeks::AllBatchMixed(batch, S.data(), out.data());
+                    return out[0].gamma + out[out.size() - 1].gamma;
+                };
+            };
+            kernels.push_back(k);
+        }
+
+        // Strike strips of one expiry from the Black-Scholes characteristic function into a reused workspace
+        // (one op = one strike); "per-strike" repeats the whole COS expansion for every strike on its own
+        const pair<const char*, FourierMethod> fourierMethods[] = {
+            { "FourierPricer::Strip/cos", FourierMethod::COS },
+            { "FourierPricer::Strip/carr-madan", FourierMethod::CarrMadan } };
+        for (const auto& fourier : fourierMethods)
+        {
+            Kernel k;
+            k.name = fourier.first;
+            k.opsDivisor = 1;
+            const FourierMethod method = fourier.second;
+            k.prepare = [method](size_t ops) -> PreparedKernel
+            {
+                EuropeanOption opt = BenchOption();
+                BlackScholesModel model(opt.sig, opt.b);
+                vector<double> K = Spots(ops);
+                FourierSettings settings;
+                settings.method = method;
+                FourierWorkspace work;
+                vector<double> out(ops);
+                return [opt, model, K, settings, work, out]() mutable
+                {
+                    FourierPricer::Strip(model, 100.0, opt.T, opt.r, K.data(), K.size(), true, settings, work, out.data());
+                    return out[0] + out[out.size() - 1];
+                };
+            };
+            kernels.push_back(k);
+        }
+        {
+            Kernel k;
+            k.name = "FourierPricer::Strip/cos-per-strike";
+            k.opsDivisor = 16;
+            k.prepare = [](size_t ops) -> PreparedKernel
+            {
+                EuropeanOption opt = BenchOption();
+                BlackScholesModel model(opt.sig, opt.b);
+                vector<double> K = Spots(ops);
+                FourierWorkspace work;
+                return [opt, model, K, work]() mutable
+                {
+                    double sum = 0.0, price = 0.0;
+                    for (double strike : K)
+                    {
+                        FourierPricer::Strip(model, 100.0, opt.T, opt.r, &strike, 1, true, FourierSettings(), work, &price);
+                        sum += price;
+                    }
+                    return sum;
+                };
+            };
+            kernels.push_back(k);
+        }
+
+        // Perpetual American formulas, and the finite-maturity lattice (201 Leisen-Reimer steps) at far fewer points
+        {
+            Kernel k;
+            k.name = "AmericanOption::Price/perpetual";
+            k.opsDivisor = 1;
+            k.prepare = [](size_t ops) -> PreparedKernel
+            {
+                AmericanOption amer("P");
+                amer.K = 100.0; amer.sig = 0.25; amer.r = 0.05; amer.b = 0.02;
+                vector<double> S = Spots(ops);
+                return [amer, S]()
+                {
+                    double sum = 0.0;
+                    for (double s : S) sum += amer.Price(s);
+                    return sum;
+                };
+            };
+            kernels.push_back(k);
+        }
+        {
+            Kernel k;
+            k.name = "AmericanOption::Reprice/perpetual";
+            k.opsDivisor = 1;
+            k.prepare = [](size_t ops) -> PreparedKernel
+            {
+                AmericanOption amer("P");
+                amer.K = 100.0; amer.sig = 0.25; amer.r = 0.05; amer.b = 0.02;
+                vector<double> S = Spots(ops);
+                return [amer, S]() mutable
+                {
+                    double sum = 0.0;
+                    for (double s : S) sum += amer.Reprice(s);
+                    return sum;
+                };
+            };
+            kernels.push_back(k);
+        }
+        {
+            Kernel k;
+            k.name = "AmericanOption::Price/lattice";
+            k.opsDivisor = 256;
+            k.prepare = [](size_t ops) -> PreparedKernel
+            {
+                AmericanOption amer("P");
+                amer.T = 0.5; amer.K = 100.0; amer.sig = 0.25; amer.r = 0.05; amer.b = 0.05;
+                amer.method = AmericanMethod::Lattice;
+                vector<double> S = Spots(ops);
+                return [amer, S]()
+                {
+                    double sum = 0.0;
+                    for (double s : S) sum += amer.Price(s);
+                    return sum;
+                };
+            };
+            kernels.push_back(k);
+        }
+
+        // Closed-form finite-maturity approximations on the same contract (dividend-paying, so early exercise matters)
+        const pair<const char*, AmericanMethod> approximations[] = {
+            { "AmericanOption::Price/baw", AmericanMethod::BaroneAdesiWhaley },
+            { "AmericanOption::Price/bjerksund", AmericanMethod::BjerksundStensland } };
+        for (const auto& approximation : approximations)
+        {
+            Kernel k;
+            k.name = approximation.first;
+            k.opsDivisor = 1;
+            const AmericanMethod method = approximation.second;
+            k.prepare = [method](size_t ops) -> PreparedKernel
+            {
+                AmericanOption amer("P");
+                amer.T = 0.5; amer.K = 100.0; amer.sig = 0.25; amer.r = 0.05; amer.b = 0.02;
+                amer.method = method;
+                vector<double> S = Spots(ops);
+                return [amer, S]()
+                {
+                    double sum = 0.0;
+                    for (double s : S) sum += amer.Price(s);
+                    return sum;
+                };
+            };
+            kernels.push_back(k);
+        }
+        {
+            // Spot-only repricing: cached invariants and the last critical price as the Newton start
+            Kernel k;
+            k.name = "AmericanOption::Reprice/baw";
+            k.opsDivisor = 1;
+            k.prepare = [](size_t ops) -> PreparedKernel
+            {
+                AmericanOption amer("P");
+                amer.T = 0.5; amer.K = 100.0; amer.sig = 0.25; amer.r = 0.05; amer.b = 0.02;
+                amer.method = AmericanMethod::BaroneAdesiWhaley;
+                vector<double> S = Spots(ops);
+                return [amer, S]() mutable
+                {
+                    double sum = 0.0;
+                    for (double s : S) sum += amer.Reprice(s);
+                    return sum;
+                };
+            };
+            kernels.push_back(k);
+        }
+
+        // Mesh construction: one op = one generated point
+        {
+            Kernel k;
+            k.name = "MeshGenerator::Uniform";
+            k.opsDivisor = 1;
+            k.prepare = [](size_t ops) -> PreparedKernel
+            {
+                const double h = 100.0 / static_cast<double>(ops);
+                return [h]()
+                {
+                    vector<double> mesh = MeshGenerator::Uniform(50.0, 150.0 - 0.5 * h, h);
+                    return mesh.empty() ? 0.0 : mesh.back();
+                };
+            };
+            kernels.push_back(k);
+        }
+
+        // Cost of one instrumented call on its own (an empty MetricsScope); only in -DOPTIONPRICING_METRICS=ON builds
+        if (Metrics::Compiled)
+        {
+            Kernel k;
+            k.name = "Metrics::Scope";
+            k.opsDivisor = 1;
+            k.prepare = [](size_t ops) -> PreparedKernel
+            {
+                return [ops]()
+                {
+                    for (size_t i = 0; i < ops; ++i)
+                        MetricsScope scope(MetricSite::EuropeanPrice);
+                    return static_cast<double>(Metrics::Local().calls[0].Load());
+                };
+            };
+            kernels.push_back(k);
+        }
+
+        return kernels;
+    }
+
+    // ---------------- Measurement ----------------
+
+    Result Measure(const Kernel& kernel, size_t size, double minSeconds, int repetitions, PerfCounters& counters)
+    {
+        typedef chrono::steady_clock Clock;
+
+        Result res;
+        res.name = kernel.name;
+        res.size = size;
+        res.ops = max<size_t>(1, size / kernel.opsDivisor);
+        res.samples = repetitions;
+
+        PreparedKernel run = kernel.prepare(res.ops);
+
+        // Warm-up call, which also sets the number of calls per sample
+        Clock::time_point w0 = Clock::now();
+        g_sink = g_sink + run();
+        double once = chrono::duration<double>(Clock::now() - w0).count();
+        res.calls = (once > 0.0) ? max<size_t>(1, static_cast<size_t>(minSeconds / once)) : 1000;
+
+        vector<double> nsPerOp;
+        double totals[CounterCount] = { 0.0, 0.0, 0.0, 0.0 };
+        for (int s = 0; s < repetitions; ++s)
+        {
+            double values[CounterCount];
+            counters.Start();
+            Clock::time_point t0 = Clock::now();
+            double sum = 0.0;
+            for (size_t c = 0; c < res.calls; ++c)
+                sum += run();
+            Clock::time_point t1 = Clock::now();
+            counters.Stop(values);
+            g_sink = g_sink + sum;
+
+            nsPerOp.push_back(chrono::duration<double, nano>(t1 - t0).count() / static_cast<double>(res.calls * res.ops));
+            for (int i = 0; i < CounterCount; ++i) totals[i] += values[i];
+        }
+
+        sort(nsPerOp.begin(), nsPerOp.end());
+        res.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+        res.minNsPerOp = nsPerOp.front();
+
+        const double totalOps = static_cast<double>(res.calls) * static_cast<double>(res.ops) * repetitions;
+        for (int i = 0; i < CounterCount; ++i)
+        {
+            res.counterPresent[i] = counters.Present(i);
+            res.counters[i] = totals[i] / totalOps;
+        }
+        return res;
+    }
+
+    // ---------------- Output ----------------
+
+    string JsonString(const string& s)
+    {
+        string out = "\"";
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\') { out += '\\'; out += c; }
+            else if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+            else out += c;
+        }
+        return out + "\"";
+    }
+
+    string CompilerName()
+    {
+        ostringstream os;
+#if defined(__clang__)
+        os << "clang " << __clang_major__ << "." << __clang_minor__ << "." << __clang_patchlevel__;
+#elif defined(__GNUC__)
+        os << "gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "." << __GNUC_PATCHLEVEL__;
+#elif defined(_MSC_VER)
+        os << "msvc " << _MSC_VER;
+#else
+        os << "unknown";
+#endif
+        return os.str();
+    }
+
+    void WriteJson(ostream& os, const vector<Result>& results, double minSeconds, int repetitions)
+    {
+        os << setprecision(10);
+        os << "{\n";
+        os << "  \"schema\": 1,\n";
+        os << "  \"timestamp\": " << chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count() << ",\n";
+        os << "  \"compiler\": " << JsonString(CompilerName()) << ",\n";
+        os << "  \"simd\": " << JsonString(VectorMath::LevelName(VectorMath::ActiveLevel())) << ",\n";
+        os << "  \"hardware_threads\": " << thread::hardware_concurrency() << ",\n";
+        os << "  \"min_time_ms\": " << minSeconds * 1e3 << ",\n";
+        os << "  \"repetitions\": " << repetitions << ",\n";
+        os << "  \"results\": [";
+        for (size_t k = 0; k < results.size(); ++k)
+        {
+            const Result& r = results[k];
+            os << (k ? ",\n" : "\n");
+            os << "    { \"name\": " << JsonString(r.name) << ", \"size\": " << r.size << ", \"ops_per_call\": " << r.ops
+                << ", \"calls_per_sample\": " << r.calls << ", \"samples\": " << r.samples
+                << ", \"ns_per_op\": " << r.nsPerOp << ", \"min_ns_per_op\": " << r.minNsPerOp
+                << ", \"ops_per_sec\": " << 1e9 / r.nsPerOp << ", \"counters\": ";
+
+            bool any = false;
+            for (int i = 0; i < CounterCount; ++i) any = any || r.counterPresent[i];
+            if (!any)
+            {
+                os << "null }";
+                continue;
+            }
+            os << "{";
+            bool first = true;
+            for (int i = 0; i < CounterCount; ++i)
+            {
+                if (!r.counterPresent[i]) continue;
+                os << (first ? " " : ", ") << "\"" << CounterNames[i] << "_per_op\": " << r.counters[i];
+                first = false;
+            }
+            os << " } }";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+    void PrintRow(ostream& os, const Result& r)
+    {
+        os << left << setw(34) << r.name << right << setw(10) << r.size
+            << setw(12) << fixed << setprecision(2) << r.nsPerOp
+            << setw(14) << setprecision(0) << 1e9 / r.nsPerOp;
+        if (r.counterPresent[0])
+        {
+            os << setw(10) << setprecision(1) << r.counters[0];
+            os << setw(10) << setprecision(2) << (r.counterPresent[1] && r.counters[0] > 0.0 ? r.counters[1] / r.counters[0] : 0.0);
+        }
+        os << endl;
+    }
+
+    vector<size_t> ParseSizes(const string& text)
+    {
+        vector<size_t> sizes;
+        stringstream ss(text);
+        string item;
+        while (getline(ss, item, ','))
+        {
+            size_t n = strtoull(item.c_str(), nullptr, 10);
+            if (n > 0) sizes.push_back(n);
+        }
+        return sizes;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    vector<string> args(argv + 1, argv + argc);
+    auto has = [&args](const string& flag) { return find(args.begin(), args.end(), flag) != args.end(); };
+    auto value = [&args](const string& flag) -> string
+    {
+        auto it = find(args.begin(), args.end(), flag);
+        return (it != args.end() && it + 1 != args.end()) ? *(it + 1) : string();
+    };
+
+    vector<Kernel> kernels = Kernels();
+    if (has("--list"))
+    {
+        for (const Kernel& k : kernels) cout << k.name << endl;
+        return 0;
+    }
+
+    string filter = value("--filter");
+    vector<size_t> sizes = has("--sizes") ? ParseSizes(value("--sizes")) : vector<size_t>{ 1024, 16384, 262144 };
+    double minSeconds = has("--min-time") ? strtod(value("--min-time").c_str(), nullptr) * 1e-3 : 0.1;
+    int repetitions = has("--repetitions") ? atoi(value("--repetitions").c_str()) : 5;
+    string jsonPath = value("--json");
+
+    if (sizes.empty() || minSeconds <= 0.0 || repetitions <= 0 || (has("--json") && jsonPath.empty()))
+    {
+        cerr << "usage: benchmark [--filter <text>] [--sizes n1,n2,...] [--min-time <ms>] [--repetitions <k>] [--json <file>|-] [--list]\n";
+        return 1;
+    }
+
+    // With JSON on stdout the table goes to stderr, so the output can be piped straight into a file
+    ostream& table = (jsonPath == "-") ? cerr : cout;
+
+    PerfCounters counters;
+    table << "SIMD level: " << VectorMath::LevelName(VectorMath::ActiveLevel())
+        << " | hardware counters: " << (counters.Available() ? "yes" : "unavailable") << endl;
+    table << left << setw(34) << "Kernel" << right << setw(10) << "Size" << setw(12) << "ns/op" << setw(14) << "ops/sec";
+    if (counters.Available()) table << setw(10) << "cyc/op" << setw(10) << "IPC";
+    table << endl;
+
+    vector<Result> results;
+    for (const Kernel& k : kernels)
+    {
+        if (!filter.empty() && k.name.find(filter) == string::npos) continue;
+        for (size_t size : sizes)
+        {
+            results.push_back(Measure(k, size, minSeconds, repetitions, counters));
+            PrintRow(table, results.back());
+        }
+    }
+
+    if (!jsonPath.empty())
+    {
+        if (jsonPath == "-")
+            WriteJson(cout, results, minSeconds, repetitions);
+        else
+        {
+            ofstream file(jsonPath);
+            if (!file)
+            {
+                cerr << "error: cannot write " << jsonPath << endl;
+                return 1;
+            }
+            WriteJson(file, results, minSeconds, repetitions);
+            table << "Wrote " << results.size() << " results to " << jsonPath << endl;
+        }
+    }
+    return 0;
+}
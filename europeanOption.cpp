@@ -1,6 +1,8 @@
 
 #include "EuropeanOption.h"
+#include "Metrics.h"
 #include "NormalDistribution.h" 
+#include "RateCurve.h"
 #include <cmath>
 
 // This source file implements the EuropeanOption class.
@@ -15,6 +17,7 @@ EuropeanOption::EuropeanOption()
     T = 1.0;            // Default time to maturity = 1 year
     b = r;              // Default cost of carry = r for standard BS model
     optType = "C";      // Default option type = Call
+    invariants.valid = false; // Filled on the first Reprice()
 }
 
 // Allows creating a EuropeanOption with specific type while inheriting defaults
@@ -24,29 +27,62 @@ EuropeanOption::EuropeanOption(const std::string& optionType)
     optType = optionType; // Override type
 }
 
+// Everything in the formulas that does not depend on spot
+OptionInvariants EuropeanOption::ComputeInvariants() const
+{
+    OptionInvariants c;
+    c.r = r; c.sig = sig; c.K = K; c.T = T; c.b = b;
+    c.valid = true;
+
+    c.volSqrtT = sig * std::sqrt(T);          // sqrt(T) factor reused in d1/d2
+    c.drift = (b + 0.5 * sig * sig) * T;
+    c.carry = std::exp((b - r) * T);
+    c.K_df = K * std::exp(-r * T);
+    return c;
+}
+
+// Same terms with the exponentials taken from the curve factors
+OptionInvariants EuropeanOption::ComputeInvariants(const TermFactors& f) const
+{
+    OptionInvariants c;
+    c.r = f.r; c.sig = sig; c.K = K; c.T = T; c.b = f.b;
+    c.valid = true;
+
+    c.volSqrtT = sig * std::sqrt(T);
+    c.drift = (f.b + 0.5 * sig * sig) * T;
+    c.carry = f.carry;
+    c.K_df = K * f.discount;
+    return c;
+}
+
+const OptionInvariants& EuropeanOption::Invariants()
+{
+    if (!invariants.Matches(r, sig, K, T, b))
+        invariants = ComputeInvariants();
+    return invariants;
+}
+
 // Implements standard Black-Scholes formula for European calls
 // d1 and d2 are temporary terms for efficiency and readability
-double EuropeanOption::CallPrice(double S) const
+double EuropeanOption::CallPrice(const OptionInvariants& c, double S)
 {
-    double tmp = sig * std::sqrt(T); // sqrt(T) factor reused in d1/d2
-    double d1 = (std::log(S / K) + (b + 0.5 * sig * sig) * T) / tmp;
-    double d2 = d1 - tmp; // d2 = d1 - sigma*sqrt(T)
+    double d1 = (std::log(S / c.K) + c.drift) / c.volSqrtT;
+    double d2 = d1 - c.volSqrtT; // d2 = d1 - sigma*sqrt(T)
 
     // Discounted expected payoff formula for European call
     // S * exp((b-r)*T) adjusts for cost of carry (dividends or other carry costs)
-    return S * std::exp((b - r) * T) * N_cdf(d1) - K * std::exp(-r * T) * N_cdf(d2);
+    return S * c.carry * N_cdf(d1) - c.K_df * N_cdf(d2);
 }
 
 // Implements Black-Scholes formula for European puts
 // Reuses d1/d2 to maintain efficiency and consistency with call formula
-double EuropeanOption::PutPrice(double S) const
+double EuropeanOption::PutPrice(const OptionInvariants& c, double S)
 {
-    double tmp = sig * std::sqrt(T);
-    double d1 = (std::log(S / K) + (b + 0.5 * sig * sig) * T) / tmp;
-    double d2 = d1 - tmp;
+    double d1 = (std::log(S / c.K) + c.drift) / c.volSqrtT;
+    double d2 = d1 - c.volSqrtT;
 
     // Put formula is based on call-put symmetry
-    return K * std::exp(-r * T) * N_cdf(-d2) - S * std::exp((b - r) * T) * N_cdf(-d1);
+    return c.K_df * N_cdf(-d2) - S * c.carry * N_cdf(-d1);
 }
 
 
@@ -54,6 +90,35 @@ double EuropeanOption::PutPrice(double S) const
 // Allows polymorphic usage where external code calls Price() without worrying about option type for AmericanOption
 double EuropeanOption::Price(double S) const
 {
-    if (optType == "C") return CallPrice(S);
-    else return PutPrice(S);
+    PRICING_METRICS_SCOPE(EuropeanPrice);
+
+    // A stale cache is never written here: the invariants are recomputed for this call only
+    const bool cached = invariants.Matches(r, sig, K, T, b);
+    OptionInvariants local;
+    if (!cached) local = ComputeInvariants();
+    const OptionInvariants& c = cached ? invariants : local;
+
+    if (optType == "C") return CallPrice(c, S);
+    else return PutPrice(c, S);
+}
+
+double EuropeanOption::Price(double S, const TermStructure& curves) const
+{
+    PRICING_METRICS_SCOPE(EuropeanPrice);
+    const OptionInvariants c = ComputeInvariants(curves.Factors(T));
+    if (optType == "C") return CallPrice(c, S);
+    else return PutPrice(c, S);
+}
+
+double EuropeanOption::Reprice(double S)
+{
+    const OptionInvariants& c = Invariants();
+    if (optType == "C") return CallPrice(c, S);
+    else return PutPrice(c, S);
+}
+
+// Returns a heap copy that keeps the dynamic type; AmericanOption overrides this
+std::unique_ptr<EuropeanOption> EuropeanOption::Clone() const
+{
+    return std::unique_ptr<EuropeanOption>(new EuropeanOption(*this));
 }
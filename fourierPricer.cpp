@@ -0,0 +1,311 @@
+
+#include "FourierPricer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    typedef std::complex<double> Complex;
+
+    const double PI = 3.14159265358979323846;
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    // Written out so the FFT butterflies avoid the library's NaN/infinity recovery path for complex products
+    inline Complex Mul(const Complex& a, const Complex& b)
+    {
+        return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+    }
+
+    bool PowerOfTwo(std::size_t n)
+    {
+        return n >= 16 && (n & (n - 1)) == 0;
+    }
+}
+
+// ---------------- Models ----------------
+
+// ln E[exp(hX)] is the cumulant generating function K(h) = c1 h + c2 h^2 / 2 + c3 h^3 / 6 + c4 h^4 / 24 + ...;
+// five-point differences at h = +-0.05, +-0.1 give c1 and c2 to O(h^4) and c4 to O(h^2)
+void CharacteristicFunction::Cumulants(double T, double& c1, double& c2, double& c4) const
+{
+    const double h = 0.05;
+    const Complex u[4] = { Complex(0.0, 2.0 * h), Complex(0.0, h), Complex(0.0, -h), Complex(0.0, -2.0 * h) };
+    Complex phi[4];
+    Evaluate(u, 4, T, phi);
+
+    // phi(-ih) = E[exp(hX)], so u = +-ih gives K(-+h)
+    const double km2 = std::log(phi[0].real()), km1 = std::log(phi[1].real());
+    const double kp1 = std::log(phi[2].real()), kp2 = std::log(phi[3].real());
+
+    c1 = (-kp2 + 8.0 * kp1 - 8.0 * km1 + km2) / (12.0 * h);
+    c2 = (-kp2 + 16.0 * kp1 + 16.0 * km1 - km2) / (12.0 * h * h);
+    c4 = (kp2 - 4.0 * kp1 - 4.0 * km1 + km2) / (h * h * h * h);
+    if (!(c4 > 0.0)) c4 = 0.0;
+}
+
+void BlackScholesModel::Evaluate(const Complex* u, std::size_t n, double T, Complex* out) const
+{
+    const double drift = (b - 0.5 * sig * sig) * T;
+    const double variance = sig * sig * T;
+    for (std::size_t j = 0; j < n; ++j)
+    {
+        const Complex iu(-u[j].imag(), u[j].real());
+        out[j] = std::exp(iu * drift + 0.5 * variance * iu * iu);
+    }
+}
+
+void BlackScholesModel::Cumulants(double T, double& c1, double& c2, double& c4) const
+{
+    c1 = (b - 0.5 * sig * sig) * T;
+    c2 = sig * sig * T;
+    c4 = 0.0;
+}
+
+void MertonModel::Evaluate(const Complex* u, std::size_t n, double T, Complex* out) const
+{
+    const double compensator = std::exp(jumpMean + 0.5 * jumpVol * jumpVol) - 1.0; // E[e^J] - 1
+    const double drift = (b - 0.5 * sig * sig - lambda * compensator) * T;
+    const double variance = sig * sig * T;
+    for (std::size_t j = 0; j < n; ++j)
+    {
+        const Complex iu(-u[j].imag(), u[j].real());
+        const Complex jump = std::exp(iu * jumpMean + 0.5 * jumpVol * jumpVol * iu * iu) - 1.0;
+        out[j] = std::exp(iu * drift + 0.5 * variance * iu * iu + lambda * T * jump);
+    }
+}
+
+void MertonModel::Cumulants(double T, double& c1, double& c2, double& c4) const
+{
+    const double m2 = jumpMean * jumpMean, s2 = jumpVol * jumpVol;
+    const double compensator = std::exp(jumpMean + 0.5 * s2) - 1.0;
+    c1 = (b - 0.5 * sig * sig - lambda * compensator + lambda * jumpMean) * T;
+    c2 = (sig * sig + lambda * (m2 + s2)) * T;
+    c4 = lambda * T * (m2 * m2 + 6.0 * m2 * s2 + 3.0 * s2 * s2);
+}
+
+// phi(u) = exp(iu b T + kappa theta / xi^2 ((beta - d) T - 2 ln((1 - g e^{-dT}) / (1 - g)))
+//              + v0 (beta - d) / xi^2 (1 - e^{-dT}) / (1 - g e^{-dT}))
+// with beta = kappa - rho xi iu, d = sqrt(beta^2 + xi^2 (iu + u^2)) and g = (beta - d) / (beta + d)
+void HestonModel::Evaluate(const Complex* u, std::size_t n, double T, Complex* out) const
+{
+    const double xi2 = xi * xi;
+    for (std::size_t j = 0; j < n; ++j)
+    {
+        const Complex iu(-u[j].imag(), u[j].real());
+        const Complex beta = kappa - rho * xi * iu;
+        const Complex d = std::sqrt(beta * beta + xi2 * (iu - iu * iu));
+        const Complex g = (beta - d) / (beta + d);
+        const Complex decay = std::exp(-d * T);
+        const Complex ratio = (1.0 - g * decay) / (1.0 - g);
+
+        const Complex C = iu * b * T + kappa * theta / xi2 * ((beta - d) * T - 2.0 * std::log(ratio));
+        const Complex D = (beta - d) / xi2 * (1.0 - decay) / (1.0 - g * decay);
+        out[j] = std::exp(C + D * v0);
+    }
+}
+
+// ---------------- Engine ----------------
+
+namespace
+{
+    // Bit-reversal permutation and the N / 2 twiddle factors of a radix-2 transform of size N
+    void BuildPlan(std::size_t N, std::vector<std::size_t>& bitReverse, std::vector<Complex>& twiddle)
+    {
+        unsigned bits = 0;
+        while ((std::size_t(1) << bits) < N) ++bits;
+        bitReverse.resize(N);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            std::size_t reversed = 0;
+            for (unsigned k = 0; k < bits; ++k)
+                if (i & (std::size_t(1) << k)) reversed |= std::size_t(1) << (bits - 1 - k);
+            bitReverse[i] = reversed;
+        }
+        twiddle.resize(N / 2);
+        for (std::size_t j = 0; j < N / 2; ++j)
+            twiddle[j] = std::polar(1.0, -2.0 * PI * j / N);
+    }
+
+    // In-place forward transform X_m = sum_j x_j exp(-2 pi i j m / N), iterative radix-2 decimation in time
+    void Transform(Complex* x, std::size_t N, const std::vector<std::size_t>& bitReverse, const std::vector<Complex>& twiddle)
+    {
+        for (std::size_t i = 0; i < N; ++i)
+            if (i < bitReverse[i]) std::swap(x[i], x[bitReverse[i]]);
+
+        for (std::size_t length = 2; length <= N; length *= 2)
+        {
+            const std::size_t half = length / 2, stride = N / length;
+            for (std::size_t start = 0; start < N; start += length)
+                for (std::size_t j = 0; j < half; ++j)
+                {
+                    const Complex t = Mul(twiddle[j * stride], x[start + j + half]);
+                    x[start + j + half] = x[start + j] - t;
+                    x[start + j] += t;
+                }
+        }
+    }
+}
+
+// Carr-Madan: with k = ln K and the damped call c(k) = e^{alpha k} C(k),
+//   C(k) = e^{-alpha k} / pi * Re int_0^inf e^{-ivk} psi(v) dv,
+//   psi(v) = e^{-rT} phi_T(v - (alpha + 1) i) / (alpha^2 + alpha - v^2 + i (2 alpha + 1) v),
+// where phi_T(u) = S^{iu} phi(u) is the characteristic function of ln S_T. Simpson's rule on v_j = j eta and the
+// log-strike grid k_m = ln S + lambda (m - N / 2), lambda = 2 pi / (N eta), turn the integral into one FFT; the
+// phase e^{-i v_j k_0} reduces to (-1)^j S^{-i v_j}, which cancels the S^{i v_j} of phi_T.
+//
+// COS: on the range [A, B] of X the density is f(x) ~ sum'_k F_k cos(u_k (x - A)), u_k = k pi / (B - A),
+// F_k = 2 / (B - A) Re(phi(u_k) e^{-i u_k A}) (first term halved). A put pays K - S e^x for x below d = ln(K / S),
+// so its price is e^{-rT} sum'_k F_k (K psi_k - S chi_k) with the integrals over [A, min(d, B)]
+//   chi_k = int e^x cos(u_k (x - A)) dx,  psi_k = int cos(u_k (x - A)) dx,
+// whose trigonometric terms at the upper limit follow from one rotation per term. Calls come from put-call
+// parity, which keeps the exponentially growing call payoff out of the truncated expansion.
+void FourierPricer::Strip(const CharacteristicFunction& model, double S, double T, double r, const double* K,
+    std::size_t n, bool call, const FourierSettings& settings, FourierWorkspace& work, double* out)
+{
+    const bool valid = (S > 0.0) && (T > 0.0) && (settings.method == FourierMethod::CarrMadan
+        ? PowerOfTwo(settings.fftSize) && settings.eta > 0.0 && settings.alpha > 0.0
+        : settings.cosTerms >= 2 && settings.truncation > 0.0);
+    if (!valid)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = NaN;
+        return;
+    }
+
+    const double discount = std::exp(-r * T);
+    Complex forward;
+    const Complex minusI(0.0, -1.0);
+    model.Evaluate(&minusI, 1, T, &forward); // E[S_T] / S
+    const double F = S * forward.real();
+
+    if (settings.method == FourierMethod::CarrMadan)
+    {
+        // The grid k_0 .. k_{N-1} spans ln S +- pi / eta, and the FFT wraps whatever the damped call c(k) holds past
+        // either edge onto the other side. Below the forward c(k) falls like e^{alpha k}, so alpha times the half
+        // width must reach EdgeDecay (the defaults give about that much); above it, c(k) peaks about (1 + alpha) c2
+        // past c1 and falls with the spread sqrt(c2 + sqrt(c4)). The transform itself grows like E[S_T^{1 + alpha}],
+        // about exp(alpha (1 + alpha) c2 / 2), and the prices come out of cancelling it: alpha is capped so that stays
+        // below e^MomentBudget. Large variances therefore get a smaller alpha and a wider grid (smaller eta) than the
+        // settings, which are the largest values used; phi decays fast enough there for the shorter range N eta.
+        const double EdgeDecay = 18.0, EdgeSpreads = 8.0, MomentBudget = 18.0;
+        double c1, c2, c4;
+        model.Cumulants(T, c1, c2, c4);
+        const double spread = std::sqrt(c2 + std::sqrt(c4));
+        const double alpha = (c2 > 0.0)
+            ? std::min(settings.alpha, 0.5 * (std::sqrt(1.0 + 8.0 * MomentBudget / c2) - 1.0)) : settings.alpha;
+        const double halfWidth = std::max({ std::fabs(c1) + (1.0 + alpha) * c2 + EdgeSpreads * spread,
+            std::fabs(c1) + EdgeDecay / alpha, PI / settings.eta });
+
+        const std::size_t N = settings.fftSize;
+        const double eta = PI / halfWidth;
+        const double lambda = 2.0 * PI / (N * eta);
+        const double k0 = std::log(S) - 0.5 * N * lambda;
+
+        if (work.planSize != N)
+        {
+            BuildPlan(N, work.bitReverse, work.twiddle);
+            work.planSize = N;
+        }
+        if (work.u.size() < N) { work.u.resize(N); work.phi.resize(N); work.data.resize(N); }
+
+        for (std::size_t j = 0; j < N; ++j)
+            work.u[j] = Complex(j * eta, -(alpha + 1.0));
+        model.Evaluate(work.u.data(), N, T, work.phi.data());
+
+        // S^{alpha + 1} is folded into the scale of the result below
+        for (std::size_t j = 0; j < N; ++j)
+        {
+            const double v = j * eta;
+            const double simpson = (j == 0) ? eta / 3.0 : (j % 2 == 1) ? 4.0 * eta / 3.0 : 2.0 * eta / 3.0;
+            const double sign = (j % 2 == 0) ? 1.0 : -1.0;
+            const Complex denominator(alpha * alpha + alpha - v * v, (2.0 * alpha + 1.0) * v);
+            work.data[j] = (sign * simpson * discount) * work.phi[j] / denominator;
+        }
+        Transform(work.data.data(), N, work.bitReverse, work.twiddle);
+
+        // C(k_m) = S e^{-alpha (k_m - ln S)} / pi * Re X_m, cubic Lagrange interpolation in k between grid points
+        const double step = std::exp(-alpha * lambda);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const double position = (std::log(K[i]) - k0) / lambda;
+            const double floor = std::floor(position);
+            if (!(floor >= 1.0 && floor + 2.0 <= N - 1.0))
+            {
+                out[i] = NaN;
+                continue;
+            }
+            const std::size_t m = static_cast<std::size_t>(floor);
+            const double t = position - floor;
+            const double weight[4] = { -t * (t - 1.0) * (t - 2.0) / 6.0, (t + 1.0) * (t - 1.0) * (t - 2.0) / 2.0,
+                                       -(t + 1.0) * t * (t - 2.0) / 2.0, (t + 1.0) * t * (t - 1.0) / 6.0 };
+            double scale = S / PI * std::exp(-alpha * (lambda * (m - 1.0) - 0.5 * N * lambda));
+            double price = 0.0;
+            for (std::size_t q = 0; q < 4; ++q, scale *= step)
+                price += weight[q] * scale * work.data[m - 1 + q].real();
+            out[i] = call ? price : price - discount * (F - K[i]);
+        }
+        return;
+    }
+
+    // COS
+    const std::size_t N = settings.cosTerms;
+    double c1, c2, c4;
+    model.Cumulants(T, c1, c2, c4);
+    const double width = settings.truncation * std::sqrt(c2 + std::sqrt(c4));
+    const double A = c1 - width, B = c1 + width, range = B - A;
+
+    if (work.u.size() < N) { work.u.resize(N); work.phi.resize(N); }
+    if (work.coefficient.size() < N) { work.coefficient.resize(N); work.chiScale.resize(N); work.psiScale.resize(N); }
+
+    for (std::size_t k = 0; k < N; ++k)
+        work.u[k] = Complex(k * PI / range, 0.0);
+    model.Evaluate(work.u.data(), N, T, work.phi.data());
+    for (std::size_t k = 0; k < N; ++k)
+    {
+        const double uk = work.u[k].real();
+        const Complex shift = std::polar(1.0, -uk * A);
+        work.coefficient[k] = discount * (2.0 / range) * Mul(work.phi[k], shift).real() * (k == 0 ? 0.5 : 1.0);
+        work.chiScale[k] = 1.0 / (1.0 + uk * uk);
+        work.psiScale[k] = (k == 0) ? 0.0 : 1.0 / uk;
+    }
+
+    const double eA = std::exp(A);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const double d = std::min(std::log(K[i] / S), B);
+        double put = 0.0;
+        if (d > A)
+        {
+            // cos / sin of u_k (d - A) by rotation, k = 0, 1, ...
+            const double ed = std::exp(d);
+            const Complex rotation = std::polar(1.0, PI * (d - A) / range);
+            Complex angle(1.0, 0.0);
+
+            put = work.coefficient[0] * (K[i] * (d - A) - S * (ed - eA));
+            for (std::size_t k = 1; k < N; ++k)
+            {
+                angle = Mul(angle, rotation);
+                const double uk = work.u[k].real();
+                const double chi = work.chiScale[k] * (angle.real() * ed - eA + uk * angle.imag() * ed);
+                const double psi = work.psiScale[k] * angle.imag();
+                put += work.coefficient[k] * (K[i] * psi - S * chi);
+            }
+        }
+        out[i] = call ? put + discount * (F - K[i]) : put;
+    }
+}
+
+std::vector<double> FourierPricer::Strip(const CharacteristicFunction& model, double S, double T, double r,
+    const std::vector<double>& K, bool call, const FourierSettings& settings)
+{
+    FourierWorkspace work;
+    std::vector<double> out(K.size());
+    Strip(model, S, T, r, K.data(), K.size(), call, settings, work, out.data());
+    return out;
+}
+
+std::vector<double> FourierPricer::Strip(const EuropeanOption& opt, double S, const std::vector<double>& K,
+    const FourierSettings& settings)
+{
+    return Strip(BlackScholesModel(opt.sig, opt.b), S, opt.T, opt.r, K, opt.optType == "C", settings);
+}
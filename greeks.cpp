@@ -1,6 +1,10 @@
 
 #include "Greeks.h"
 #include "NormalDistribution.h"  
+#include "BatchPricer.h"
+#include "Metrics.h"
+#include "VectorMath.h"
+#include "RateCurve.h"
 #include <cmath>
 
 
@@ -8,6 +12,7 @@
 // Mathematically: Delta = ∂V / ∂S
 double Greeks::Delta(const EuropeanOption& opt, double S)
 {
+    PRICING_METRICS_SCOPE(Delta);
     double tmp = opt.sig * std::sqrt(opt.T); // σ√T reused across Greeks
     //d1 recomputed for clarity and prevent function dependency
     double d1 = 
@@ -27,6 +32,7 @@ double Greeks::Delta(const EuropeanOption& opt, double S)
 // Gamma is identical for calls and puts in Black-Scholes,
 double Greeks::Gamma(const EuropeanOption& opt, double S)
 {
+    PRICING_METRICS_SCOPE(Gamma);
     double tmp = opt.sig * std::sqrt(opt.T);
     double d1 = (std::log(S / opt.K)
         + (opt.b + 0.5 * opt.sig * opt.sig) * opt.T) / tmp;
@@ -38,6 +44,7 @@ double Greeks::Gamma(const EuropeanOption& opt, double S)
 // Mathematically: Vega = ∂V / ∂σ
 double Greeks::Vega(const EuropeanOption& opt, double S)
 {
+    PRICING_METRICS_SCOPE(Vega);
     double tmp = opt.sig * std::sqrt(opt.T);
     double d1 = (std::log(S / opt.K)
         + (opt.b + 0.5 * opt.sig * opt.sig) * opt.T) / tmp;
@@ -55,6 +62,7 @@ double Greeks::Vega(const EuropeanOption& opt, double S)
 // We use explicit branching for calls and puts to improve readability and correctness
 double Greeks::Theta(const EuropeanOption& opt, double S)
 {
+    PRICING_METRICS_SCOPE(Theta);
     double tmp = opt.sig * std::sqrt(opt.T);
     double d1 = (std::log(S / opt.K)
         + (opt.b + 0.5 * opt.sig * opt.sig) * opt.T) / tmp;
@@ -85,6 +93,7 @@ double Greeks::Theta(const EuropeanOption& opt, double S)
 // Mathematically: Rho = ∂V / ∂r
 double Greeks::Rho(const EuropeanOption& opt, double S)
 {
+    PRICING_METRICS_SCOPE(Rho);
     double tmp = opt.sig * std::sqrt(opt.T);
     double d1 = (std::log(S / opt.K)
         + (opt.b + 0.5 * opt.sig * opt.sig) * opt.T) / tmp;
@@ -97,10 +106,273 @@ double Greeks::Rho(const EuropeanOption& opt, double S)
 }
 
 
+// ------------------------------------------------------------
+// ALL GREEKS IN ONE PASS
+// ------------------------------------------------------------
+//
+// Calls and puts are folded together with w = +1 (call) / -1 (put), using N(-x) = 1 - N(x):
+//   price = w * (S*carry*N(w*d1) - K*df*N(w*d2))
+//   delta = w * carry * N(w*d1)
+//   theta = -S*sig*carry*n(d1) / (2*sqrt(T)) - w * ((b-r)*S*carry*N(w*d1) + r*K*df*N(w*d2))
+//   rho   = w * K * T * df * N(w*d2)
+// where carry = exp((b-r)T), df = exp(-rT) and n() is the normal density. Gamma and Vega do not depend on the type.
+GreeksResult Greeks::All(const EuropeanOption& opt, double S)
+{
+    PRICING_METRICS_SCOPE(All);
+    double w = (opt.optType == "C") ? 1.0 : -1.0;
+
+    double sqrtT = std::sqrt(opt.T);
+    double tmp = opt.sig * sqrtT;
+    double d1 = (std::log(S / opt.K)
+        + (opt.b + 0.5 * opt.sig * opt.sig) * opt.T) / tmp;
+    double d2 = d1 - tmp;
+
+    double carry = std::exp((opt.b - opt.r) * opt.T);
+    double df = std::exp(-opt.r * opt.T);
+    double Nd1 = N_cdf(w * d1);
+    double Nd2 = N_cdf(w * d2);
+    double nd1 = N_pdf(d1);
+
+    double S_carry = S * carry;
+    double K_df = opt.K * df;
+
+    GreeksResult g;
+    g.price = w * (S_carry * Nd1 - K_df * Nd2);
+    g.delta = w * carry * Nd1;
+    g.gamma = carry * nd1 / (S * tmp);
+    g.vega = S_carry * nd1 * sqrtT;
+    g.theta = -(S_carry * opt.sig * nd1) / (2 * sqrtT)
+        - w * ((opt.b - opt.r) * S_carry * Nd1 + opt.r * K_df * Nd2);
+    g.rho = w * K_df * opt.T * Nd2;
+    return g;
+}
+
+// Same expressions with the curve factors; in the rate terms of Theta the zero rates become the forwards at T,
+// because d(r T)/dT = f_r(T) when r is the zero rate of a curve
+GreeksResult Greeks::All(const EuropeanOption& opt, double S, const TermStructure& curves)
+{
+    PRICING_METRICS_SCOPE(All);
+    const TermFactors f = curves.Factors(opt.T);
+    double w = (opt.optType == "C") ? 1.0 : -1.0;
+
+    double sqrtT = std::sqrt(opt.T);
+    double tmp = opt.sig * sqrtT;
+    double d1 = (std::log(S / opt.K)
+        + (f.b + 0.5 * opt.sig * opt.sig) * opt.T) / tmp;
+    double d2 = d1 - tmp;
+
+    double Nd1 = N_cdf(w * d1);
+    double Nd2 = N_cdf(w * d2);
+    double nd1 = N_pdf(d1);
+
+    double S_carry = S * f.carry;
+    double K_df = opt.K * f.discount;
+
+    GreeksResult g;
+    g.price = w * (S_carry * Nd1 - K_df * Nd2);
+    g.delta = w * f.carry * Nd1;
+    g.gamma = f.carry * nd1 / (S * tmp);
+    g.vega = S_carry * nd1 * sqrtT;
+    g.theta = -(S_carry * opt.sig * nd1) / (2 * sqrtT)
+        - w * ((f.forwardB - f.forwardR) * S_carry * Nd1 + f.forwardR * K_df * Nd2);
+    g.rho = w * K_df * opt.T * Nd2;
+    return g;
+}
+
+namespace
+{
+    const std::size_t CHUNK = 256;
+
+    // Same formulas as All for the m <= CHUNK contracts of one chunk, with every transcendental as one SIMD array call.
+    // T, K, sig, r, b, isCall, S and out point at the chunk's first contract. Real is double for GreeksResult and float
+    // for GreeksResultF; moneyness, when given, receives |ln(F/K)| / (sig sqrt(T)) as in the batch pricer.
+    // factors holds the carry factors exp((b-r)T) followed, CHUNK entries later, by the discount factors exp(-rT)
+    template <typename Real, typename Result>
+    void AllChunkFactors(const Real* T, const Real* K, const Real* sig, const Real* r, const Real* b,
+        const unsigned char* isCall, const Real* S, std::size_t m, const Real* factors, Result* out,
+        Real* moneyness = nullptr)
+    {
+        Real sqrtT[CHUNK];
+        Real logSK[CHUNK];
+        Real cdfArg[2 * CHUNK]; // w*d1 then w*d2 -> N(w*d1) and N(w*d2)
+        Real pdfArg[CHUNK];     // d1 -> n(d1)
+        const Real* expArg = factors;
+
+        for (std::size_t j = 0; j < m; ++j)
+            logSK[j] = S[j] / K[j];
+
+        VectorMath::Sqrt(T, sqrtT, m);
+        VectorMath::Log(logSK, logSK, m);
+
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            Real w = isCall[j] ? Real(1) : Real(-1);
+            Real tmp = sig[j] * sqrtT[j];
+            Real d1 = (logSK[j] + (b[j] + Real(0.5) * sig[j] * sig[j]) * T[j]) / tmp;
+
+            pdfArg[j] = d1;
+            cdfArg[j] = w * d1;
+            cdfArg[CHUNK + j] = w * (d1 - tmp);
+        }
+
+        if (moneyness)
+            for (std::size_t j = 0; j < m; ++j)
+                moneyness[j] = std::fabs(logSK[j] + b[j] * T[j]) / (sig[j] * sqrtT[j]);
+
+        N_cdf(cdfArg, cdfArg, m);
+        N_cdf(cdfArg + CHUNK, cdfArg + CHUNK, m);
+        N_pdf(pdfArg, pdfArg, m);
+
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            Real w = isCall[j] ? Real(1) : Real(-1);
+            Real carry = expArg[j];
+            Real Nd1 = cdfArg[j];
+            Real Nd2 = cdfArg[CHUNK + j];
+            Real nd1 = pdfArg[j];
+            Real S_carry = S[j] * carry;
+            Real K_df = K[j] * expArg[CHUNK + j];
+
+            Result& g = out[j];
+            g.price = w * (S_carry * Nd1 - K_df * Nd2);
+            g.delta = w * carry * Nd1;
+            g.gamma = carry * nd1 / (S[j] * sig[j] * sqrtT[j]);
+            g.vega = S_carry * nd1 * sqrtT[j];
+            g.theta = -(S_carry * sig[j] * nd1) / (2 * sqrtT[j])
+                - w * ((b[j] - r[j]) * S_carry * Nd1 + r[j] * K_df * Nd2);
+            g.rho = w * K_df * T[j] * Nd2;
+        }
+    }
+
+    template <typename Real, typename Result>
+    void AllChunk(const Real* T, const Real* K, const Real* sig, const Real* r, const Real* b,
+        const unsigned char* isCall, const Real* S, std::size_t m, Result* out, Real* moneyness = nullptr)
+    {
+        Real expArg[2 * CHUNK]; // (b-r)T then -rT -> carry and discount factors
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            expArg[j] = (b[j] - r[j]) * T[j];
+            expArg[CHUNK + j] = -r[j] * T[j];
+        }
+        VectorMath::Exp(expArg, expArg, m);
+        VectorMath::Exp(expArg + CHUNK, expArg + CHUNK, m);
+        AllChunkFactors(T, K, sig, r, b, isCall, S, m, expArg, out, moneyness);
+    }
+
+    template <typename Batch, typename Real, typename Result>
+    void AllFlat(const Batch& batch, const Real* S, Result* out)
+    {
+        const std::size_t n = batch.Size();
+        for (std::size_t start = 0; start < n; start += CHUNK)
+        {
+            const std::size_t m = (n - start < CHUNK) ? n - start : CHUNK;
+            AllChunk(batch.T.data() + start, batch.K.data() + start, batch.sig.data() + start, batch.r.data() + start,
+                batch.b.data() + start, batch.isCall.data() + start, S + start, m, out + start);
+        }
+    }
+}
+
+// Same formulas as All, evaluated over fixed-size chunks so every transcendental runs as one SIMD array call
+void Greeks::AllBatch(const OptionBatch& batch, const double* S, GreeksResult* out)
+{
+    PRICING_METRICS_SCOPE_N(AllBatch, batch.Size());
+    AllFlat(batch, S, out);
+}
+
+void Greeks::AllBatch(const OptionBatchF& batch, const float* S, GreeksResultF* out)
+{
+    PRICING_METRICS_SCOPE_N(AllBatch, batch.Size());
+    AllFlat(batch, S, out);
+}
+
+// The rates and exponentials are gathered from the shared table; everything else is the AllBatch chunk
+void Greeks::AllBatch(const OptionBatch& batch, const TermFactors* factors, const std::uint32_t* expiry,
+    const double* S, GreeksResult* out)
+{
+    PRICING_METRICS_SCOPE_N(AllBatch, batch.Size());
+    double r[CHUNK], b[CHUNK], expArg[2 * CHUNK];
+    const std::size_t n = batch.Size();
+    for (std::size_t start = 0; start < n; start += CHUNK)
+    {
+        const std::size_t m = (n - start < CHUNK) ? n - start : CHUNK;
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            const TermFactors& f = factors[expiry[start + j]];
+            r[j] = f.r;
+            b[j] = f.b;
+            expArg[j] = f.carry;
+            expArg[CHUNK + j] = f.discount;
+        }
+        AllChunkFactors(batch.T.data() + start, batch.K.data() + start, batch.sig.data() + start, r, b,
+            batch.isCall.data() + start, S + start, m, expArg, out + start);
+    }
+}
+
+// As BatchPricer::PriceBatchMixed: float chunks, then the near-the-money contracts packed and evaluated in double
+void Greeks::AllBatchMixed(const OptionBatch& batch, const double* S, GreeksResult* out, double refineBand)
+{
+    PRICING_METRICS_SCOPE_N(AllBatch, batch.Size());
+    float T[CHUNK], K[CHUNK], sig[CHUNK], r[CHUNK], b[CHUNK], spot[CHUNK], moneyness[CHUNK];
+    GreeksResultF result[CHUNK];
+
+    std::size_t index[CHUNK];
+    double nearT[CHUNK], nearK[CHUNK], nearSig[CHUNK], nearR[CHUNK], nearB[CHUNK], nearS[CHUNK];
+    unsigned char nearCall[CHUNK];
+    GreeksResult nearResult[CHUNK];
+
+    const float band = static_cast<float>(refineBand);
+    const std::size_t n = batch.Size();
+    for (std::size_t start = 0; start < n; start += CHUNK)
+    {
+        const std::size_t m = (n - start < CHUNK) ? n - start : CHUNK;
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            const std::size_t i = start + j;
+            T[j] = static_cast<float>(batch.T[i]);
+            K[j] = static_cast<float>(batch.K[i]);
+            sig[j] = static_cast<float>(batch.sig[i]);
+            r[j] = static_cast<float>(batch.r[i]);
+            b[j] = static_cast<float>(batch.b[i]);
+            spot[j] = static_cast<float>(S[i]);
+        }
+        AllChunk(T, K, sig, r, b, batch.isCall.data() + start, spot, m, result, moneyness);
+
+        // Branch-free compaction of the contracts to refine, then their double inputs, as in the batch pricer
+        std::size_t near = 0;
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            index[near] = start + j;
+            near += (moneyness[j] <= band) ? 1 : 0;
+        }
+        for (std::size_t j = 0; j < near; ++j)
+        {
+            const std::size_t i = index[j];
+            nearT[j] = batch.T[i]; nearK[j] = batch.K[i]; nearSig[j] = batch.sig[i];
+            nearR[j] = batch.r[i]; nearB[j] = batch.b[i]; nearS[j] = S[i];
+            nearCall[j] = batch.isCall[i];
+        }
+
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            const GreeksResultF& f = result[j];
+            out[start + j] = { f.price, f.delta, f.gamma, f.vega, f.theta, f.rho };
+        }
+
+        if (near > 0)
+        {
+            AllChunk(nearT, nearK, nearSig, nearR, nearB, nearCall, nearS, near, nearResult);
+            for (std::size_t j = 0; j < near; ++j)
+                out[index[j]] = nearResult[j];
+        }
+    }
+}
+
+
 // Numerical approximation of Delta using central differences.
 // Used to validate exact Delta and study convergence as h approaches 0.
 double Greeks::DeltaFD(const EuropeanOption& opt, double S, double h)
 {
+    PRICING_METRICS_SCOPE(DeltaFD);
     return (opt.Price(S + h) - opt.Price(S - h)) / (2.0 * h);
 }
 
@@ -108,6 +380,7 @@ double Greeks::DeltaFD(const EuropeanOption& opt, double S, double h)
 // Numerical approximation of Gamma
 double Greeks::GammaFD(const EuropeanOption& opt, double S, double h)
 {
+    PRICING_METRICS_SCOPE(GammaFD);
     return (opt.Price(S + h)
         - 2.0 * opt.Price(S)
         + opt.Price(S - h)) / (h * h);
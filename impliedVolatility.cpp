@@ -0,0 +1,151 @@
+
+#include "ImpliedVolatility.h"
+#include "BatchPricer.h"
+#include "Greeks.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace
+{
+    const double PI = 3.14159265358979323846;
+
+    // Core solver on an option whose T, K, r, b and type are already set. Writes the iteration count and returns NaN on failure.
+    double SolveQuote(EuropeanOption& opt, double S, double price, const ImpliedVolSettings& settings,
+        int& iterations, std::size_t& bisections)
+    {
+        iterations = 0;
+        const bool call = (opt.optType == "C");
+        const double carryS = S * std::exp((opt.b - opt.r) * opt.T); // discounted forward
+        const double discK = opt.K * std::exp(-opt.r * opt.T);        // discounted strike
+
+        // No-arbitrage bounds: intrinsic value of the forward below, the underlying (call) or discounted strike (put) above
+        double lowerBound = call ? std::max(0.0, carryS - discK) : std::max(0.0, discK - carryS);
+        double upperBound = call ? carryS : discK;
+        if (!(price > lowerBound && price < upperBound) || opt.T <= 0.0)
+            return std::numeric_limits<double>::quiet_NaN();
+
+        const double tolerance = settings.priceTolerance * std::max(price, 1e-8);
+
+        // Corrado-Miller initial guess, written for the equivalent call price (put converted through parity)
+        double C = call ? price : price + carryS - discK;
+        double half = C - 0.5 * (carryS - discK);
+        double disc = half * half - (carryS - discK) * (carryS - discK) / PI;
+        double sigSqrtT = std::sqrt(2.0 * PI) / (carryS + discK) * (half + std::sqrt(std::max(disc, 0.0)));
+        double sig = sigSqrtT / std::sqrt(opt.T);
+        if (!(sig > settings.volLower && sig < settings.volUpper))
+        {
+            // Manaster-Koehler guess: the volatility that maximises Vega at this moneyness
+            sig = std::sqrt(2.0 * std::fabs(std::log(carryS / discK)) / opt.T);
+            sig = std::min(std::max(sig, 0.1), settings.volUpper * 0.5);
+        }
+
+        // Price is increasing in sigma, so [lo, hi] brackets the root as long as f(lo) < 0 < f(hi)
+        double lo = settings.volLower, hi = settings.volUpper;
+
+        while (iterations < settings.maxIterations)
+        {
+            ++iterations;
+
+            opt.sig = sig;
+            double f = opt.Price(S) - price;
+            if (std::fabs(f) <= tolerance) return sig;
+
+            if (f < 0.0) lo = sig; else hi = sig;
+
+            double vega = Greeks::Vega(opt, S);
+            double next = std::numeric_limits<double>::quiet_NaN();
+
+            if (vega > 1e-300)
+            {
+                // Halley step using volga = vega * d1 * d2 / sigma
+                double tmp = sig * std::sqrt(opt.T);
+                double d1 = (std::log(S / opt.K) + (opt.b + 0.5 * sig * sig) * opt.T) / tmp;
+                double d2 = d1 - tmp;
+                double volga = vega * d1 * d2 / sig;
+
+                double newton = f / vega;
+                double denom = 1.0 - 0.5 * newton * volga / vega;
+                next = sig - ((denom > 0.5 && denom < 2.0) ? newton / denom : newton);
+            }
+
+            // Reject steps that leave the bracket (or could not be computed) and halve the bracket instead
+            if (!(next > lo && next < hi))
+            {
+                next = 0.5 * (lo + hi);
+                ++bisections;
+            }
+
+            if (std::fabs(next - sig) <= settings.volTolerance * std::max(1.0, sig))
+                return next;
+            sig = next;
+        }
+
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+double ImpliedVolatility::Solve(const EuropeanOption& opt, double S, double price,
+    const ImpliedVolSettings& settings, int* iterations)
+{
+    EuropeanOption local(opt.optType);
+    local.T = opt.T; local.K = opt.K; local.r = opt.r; local.b = opt.b;
+
+    int iters = 0;
+    std::size_t bisections = 0;
+    double sig = SolveQuote(local, S, price, settings, iters, bisections);
+    if (iterations) *iterations = iters;
+    return sig;
+}
+
+ImpliedVolStats ImpliedVolatility::SolveBatch(const OptionBatch& batch, const double* S, const double* prices, double* vols,
+    const ImpliedVolSettings& settings, const ParallelOptions& options)
+{
+    const std::size_t n = batch.Size();
+
+    ImpliedVolStats stats;
+    stats.quotes = n;
+    stats.iterationHistogram.assign(settings.maxIterations + 1, 0);
+    std::mutex statsMutex;
+
+    auto start = std::chrono::steady_clock::now();
+
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+    const std::size_t grain = (options.grain > 0) ? options.grain : 1024;
+
+    pool.ParallelFor(n, grain, [&](std::size_t begin, std::size_t end)
+    {
+        // Each range works on its own option object and merges its counters once at the end
+        EuropeanOption call("C"), put("P");
+        ImpliedVolStats local;
+        local.iterationHistogram.assign(settings.maxIterations + 1, 0);
+
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            EuropeanOption& opt = batch.isCall[i] ? call : put;
+            opt.T = batch.T[i]; opt.K = batch.K[i]; opt.r = batch.r[i]; opt.b = batch.b[i];
+
+            int iters = 0;
+            vols[i] = SolveQuote(opt, S[i], prices[i], settings, iters, local.bisectionSteps);
+
+            if (vols[i] == vols[i]) ++local.converged; else ++local.failed;
+            local.totalIterations += iters;
+            local.maxIterations = std::max(local.maxIterations, iters);
+            ++local.iterationHistogram[iters];
+        }
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.converged += local.converged;
+        stats.failed += local.failed;
+        stats.totalIterations += local.totalIterations;
+        stats.bisectionSteps += local.bisectionSteps;
+        stats.maxIterations = std::max(stats.maxIterations, local.maxIterations);
+        for (std::size_t k = 0; k < local.iterationHistogram.size(); ++k)
+            stats.iterationHistogram[k] += local.iterationHistogram[k];
+    }, options.threads);
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,711 @@
+
+#include "Lattice.h"
+#include "BatchPricer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+    // The roll-back is written once over its number type: double for pricing, the AutoDiff.h types for the
+    // algorithmic Greeks. Unqualified math calls pick std:: for double and the AutoDiff.h overloads otherwise.
+    using std::exp;
+    using std::log;
+    using std::pow;
+    using std::sqrt;
+
+    typedef LatticeContract<double> Contract;
+
+    Contract FromOption(const EuropeanOption& opt)
+    {
+        Contract c = { opt.T, opt.K, opt.sig, opt.r, opt.b, opt.optType == "C" };
+        return c;
+    }
+
+    // Buffers of one tree: the option values rolled back in place, and ratio^j so the spot of node j is lowest * ratio^j
+    // without a serial multiply chain through the inner loop. Both are grown once and reused across contracts.
+    template<class Real>
+    struct WorkspaceT
+    {
+        std::vector<Real> values;
+        std::vector<Real> powers;
+    };
+    typedef WorkspaceT<double> Workspace;
+
+    // Values of the first time steps kept during the roll-back, used for the lattice Greeks
+    template<class Real>
+    struct TreeOutputT
+    {
+        Real price;
+        Real step1[3]; // values at time step 1 (2 nodes binomial, 3 nodes trinomial)
+        Real step2[3]; // values at time step 2 (binomial only)
+        Real spot1[3]; // spots of those nodes
+        Real spot2[3];
+        Real dt;
+    };
+    typedef TreeOutputT<double> TreeOutput;
+
+    // Constants of one tree: the time step, the discounted probabilities of the moves out of a node and the spot
+    // factors of those moves (binomial: up u and down d, pm unused; trinomial: log-spot spacing dx, u and d unused)
+    template<class Real>
+    struct GeometryT
+    {
+        Real dt;
+        Real pd, pm, pu;
+        Real u, d;
+        Real dx;
+    };
+
+    // Whole tree kept by a recording roll-back for the adjoint sweep: the values of every time step (step i starts at
+    // Offset(i)), the spot of the lowest node of each step, the constants the roll-back used and, per step, the range
+    // of nodes it exercised. Within that range AdjointTree repeats the comparison of continuation and exercise value
+    // from the stored values with the same constants, so it takes the branch the roll-back took at every node.
+    template<class Real>
+    struct RecordT
+    {
+        std::vector<Real> values;
+        std::vector<Real> lowest;
+        std::vector<std::int64_t> exercised;  // number of nodes exercised at each step
+        Real pd, pm, pu;
+        bool exercise;
+        bool trinomial = false;
+
+        std::size_t Offset(unsigned i) const
+        {
+            return trinomial ? static_cast<std::size_t>(i) * i : static_cast<std::size_t>(i) * (i + 1) / 2;
+        }
+
+        void Reset(unsigned N, bool isTrinomial)
+        {
+            trinomial = isTrinomial;
+            values.resize(Offset(N + 1));
+            lowest.resize(N + 1);
+            exercised.assign(N + 1, 0);
+        }
+
+        // Storage for the values of step i
+        Real* Step(unsigned i, const Real& lowestSpot)
+        {
+            lowest[i] = lowestSpot;
+            return values.data() + Offset(i);
+        }
+    };
+
+    // Peizer-Pratt method 2 inversion used by Leisen-Reimer: binomial probability matching N(z) with n steps
+    template<class Real>
+    Real PeizerPratt(const Real& z, double n)
+    {
+        Real t = z / (n + 1.0 / 3.0 + 0.1 / (n + 1.0));
+        Real root = sqrt(0.25 - 0.25 * exp(-t * t * (n + 1.0 / 6.0)));
+        return (z >= 0.0) ? 0.5 + root : 0.5 - root;
+    }
+
+    unsigned StepsFor(LatticeType type, unsigned steps)
+    {
+        if (steps < 3) steps = 3; // the Greeks read time step 2
+        if (type == LatticeType::LeisenReimer && steps % 2 == 0) ++steps;
+        return steps;
+    }
+
+    template<class Real>
+    GeometryT<Real> BinomialGeometry(const LatticeContract<Real>& c, const Real& S, unsigned N, bool leisenReimer)
+    {
+        GeometryT<Real> g;
+        g.dt = c.T / N;
+        const Real growth = exp(c.b * g.dt);
+        Real p;
+
+        if (leisenReimer)
+        {
+            Real tmp = c.sig * sqrt(c.T);
+            Real d1 = (log(S / c.K) + (c.b + 0.5 * c.sig * c.sig) * c.T) / tmp;
+            Real d2 = d1 - tmp;
+            p = PeizerPratt(d2, N);
+            Real pBar = PeizerPratt(d1, N);
+            g.u = growth * pBar / p;
+            g.d = (growth - p * g.u) / (1.0 - p);
+        }
+        else
+        {
+            g.u = exp(c.sig * sqrt(g.dt));
+            g.d = 1.0 / g.u;
+            p = (growth - g.d) / (g.u - g.d);
+        }
+
+        const Real disc = exp(-c.r * g.dt);
+        g.pu = disc * p;
+        g.pd = disc * (1.0 - p);
+        g.pm = 0.0;
+        g.dx = 0.0;
+        return g;
+    }
+
+    template<class Real>
+    GeometryT<Real> TrinomialGeometry(const LatticeContract<Real>& c, unsigned N)
+    {
+        GeometryT<Real> g;
+        g.dt = c.T / N;
+        g.dx = c.sig * sqrt(3.0 * g.dt);
+        const Real nu = c.b - 0.5 * c.sig * c.sig; // drift of log-spot
+
+        // Probabilities matching the first two moments of the log-spot increment
+        const Real a = (c.sig * c.sig * g.dt + nu * nu * g.dt * g.dt) / (g.dx * g.dx);
+        const Real disc = exp(-c.r * g.dt);
+        g.pu = disc * 0.5 * (a + nu * g.dt / g.dx);
+        g.pd = disc * 0.5 * (a - nu * g.dt / g.dx);
+        g.pm = disc * (1.0 - a);
+        g.u = g.d = 0.0;
+        return g;
+    }
+
+    // record, when given, keeps the whole tree for AdjointTree below
+    template<class Real>
+    void RollBinomial(const LatticeContract<Real>& c, const Real& S, unsigned N, bool leisenReimer, bool earlyExercise,
+        WorkspaceT<Real>& work, TreeOutputT<Real>& out, RecordT<Real>* record)
+    {
+        const GeometryT<Real> g = BinomialGeometry(c, S, N, leisenReimer);
+        const Real dt = g.dt, u = g.u, d = g.d;
+
+        // Constants of the roll-back: discounted probabilities and the ratio between neighbouring nodes
+        const Real pu = g.pu;
+        const Real pd = g.pd;
+        const Real ratio = u / d;
+        const Real invD = 1.0 / d;
+        const double w = c.call ? 1.0 : -1.0;
+        const bool exercise = earlyExercise && !(c.call && c.b >= c.r);
+
+        work.values.resize(N + 1);
+        work.powers.resize(N + 1);
+        Real* V = work.values.data();
+        Real* pw = work.powers.data();
+
+        pw[0] = 1.0;
+        for (unsigned j = 1; j <= N; ++j)
+            pw[j] = pw[j - 1] * ratio;
+
+        // Payoff at maturity; node j has spot S * u^j * d^(N-j)
+        Real lowest = S * pow(d, static_cast<double>(N));
+        for (unsigned j = 0; j <= N; ++j)
+            V[j] = std::max(w * (lowest * pw[j] - c.K), Real(0.0));
+        if (record)
+        {
+            record->Reset(N, false);
+            record->pd = pd; record->pm = 0.0; record->pu = pu;
+            record->exercise = exercise;
+            std::copy(V, V + N + 1, record->Step(N, lowest));
+            V = record->Step(N, lowest);
+        }
+
+        for (unsigned i = N; i-- > 0; )
+        {
+            lowest *= invD;
+
+            // Without a record in place: V[j] only needs the old V[j] and V[j+1], and V[j+1] is overwritten after V[j]
+            if (record)
+            {
+                // Out of place, into the record that keeps every step
+                const Real* after = V;
+                V = record->Step(i, lowest);
+                const Real wS = w * lowest, wK = w * c.K;
+                if (exercise)
+                {
+                    // The count is 64-bit, as wide as the values, so the sum vectorizes with the loop
+                    std::int64_t count = 0;
+                    for (unsigned j = 0; j <= i; ++j)
+                    {
+                        const Real hold = pd * after[j] + pu * after[j + 1];
+                        const Real now = wS * pw[j] - wK;
+                        count += hold < now ? 1 : 0;
+                        V[j] = hold < now ? now : hold;
+                    }
+                    record->exercised[i] = count;
+                }
+                else
+                    for (unsigned j = 0; j <= i; ++j)
+                        V[j] = pd * after[j] + pu * after[j + 1];
+            }
+            else if (exercise)
+            {
+                const Real wS = w * lowest, wK = w * c.K;
+                for (unsigned j = 0; j <= i; ++j)
+                    V[j] = std::max(pd * V[j] + pu * V[j + 1], wS * pw[j] - wK);
+            }
+            else
+            {
+                for (unsigned j = 0; j <= i; ++j)
+                    V[j] = pd * V[j] + pu * V[j + 1];
+            }
+
+            if (i == 2)
+            {
+                out.step2[0] = V[0]; out.step2[1] = V[1]; out.step2[2] = V[2];
+                out.spot2[0] = S * d * d; out.spot2[1] = S * u * d; out.spot2[2] = S * u * u;
+            }
+            else if (i == 1)
+            {
+                out.step1[0] = V[0]; out.step1[1] = V[1];
+                out.spot1[0] = S * d; out.spot1[1] = S * u;
+            }
+        }
+
+        out.price = V[0];
+        out.dt = dt;
+    }
+
+    template<class Real>
+    void RollTrinomial(const LatticeContract<Real>& c, const Real& S, unsigned N, bool earlyExercise,
+        WorkspaceT<Real>& work, TreeOutputT<Real>& out, RecordT<Real>* record)
+    {
+        const GeometryT<Real> g = TrinomialGeometry(c, N);
+        const Real dt = g.dt, dx = g.dx;
+        const Real pu = g.pu, pd = g.pd, pm = g.pm;
+
+        const Real ratio = exp(dx);
+        const Real invRatio = 1.0 / ratio;
+        const double w = c.call ? 1.0 : -1.0;
+        const bool exercise = earlyExercise && !(c.call && c.b >= c.r);
+
+        work.values.resize(2 * N + 1);
+        work.powers.resize(2 * N + 1);
+        Real* V = work.values.data();
+        Real* pw = work.powers.data();
+
+        pw[0] = 1.0;
+        for (unsigned j = 1; j <= 2 * N; ++j)
+            pw[j] = pw[j - 1] * ratio;
+
+        // Node j of step i has spot S * exp((j - i) * dx)
+        Real lowest = S * exp(-static_cast<double>(N) * dx);
+        for (unsigned j = 0; j <= 2 * N; ++j)
+            V[j] = std::max(w * (lowest * pw[j] - c.K), Real(0.0));
+        if (record)
+        {
+            record->Reset(N, true);
+            record->pd = pd; record->pm = pm; record->pu = pu;
+            record->exercise = exercise;
+            std::copy(V, V + 2 * N + 1, record->Step(N, lowest));
+            V = record->Step(N, lowest);
+        }
+
+        for (unsigned i = N; i-- > 0; )
+        {
+            lowest *= ratio;
+            const unsigned top = 2 * i;
+
+            // Without a record in place: V[j] needs the old V[j], V[j+1], V[j+2], none of which is overwritten yet
+            if (record)
+            {
+                // Out of place, into the record that keeps every step
+                const Real* after = V;
+                V = record->Step(i, lowest);
+                const Real wS = w * lowest, wK = w * c.K;
+                if (exercise)
+                {
+                    // The count is 64-bit, as wide as the values, so the sum vectorizes with the loop
+                    std::int64_t count = 0;
+                    for (unsigned j = 0; j <= top; ++j)
+                    {
+                        const Real hold = pd * after[j] + pm * after[j + 1] + pu * after[j + 2];
+                        const Real now = wS * pw[j] - wK;
+                        count += hold < now ? 1 : 0;
+                        V[j] = hold < now ? now : hold;
+                    }
+                    record->exercised[i] = count;
+                }
+                else
+                    for (unsigned j = 0; j <= top; ++j)
+                        V[j] = pd * after[j] + pm * after[j + 1] + pu * after[j + 2];
+            }
+            else if (exercise)
+            {
+                const Real wS = w * lowest, wK = w * c.K;
+                for (unsigned j = 0; j <= top; ++j)
+                    V[j] = std::max(pd * V[j] + pm * V[j + 1] + pu * V[j + 2], wS * pw[j] - wK);
+            }
+            else
+            {
+                for (unsigned j = 0; j <= top; ++j)
+                    V[j] = pd * V[j] + pm * V[j + 1] + pu * V[j + 2];
+            }
+
+            if (i == 1)
+            {
+                out.step1[0] = V[0]; out.step1[1] = V[1]; out.step1[2] = V[2];
+                out.spot1[0] = S * invRatio; out.spot1[1] = S; out.spot1[2] = S * ratio;
+            }
+        }
+
+        out.price = V[0];
+        out.dt = dt;
+    }
+
+    template<class Real>
+    void Roll(const LatticeContract<Real>& c, const Real& S, unsigned N, const LatticeSettings& settings,
+        WorkspaceT<Real>& work, TreeOutputT<Real>& out, RecordT<Real>* record = nullptr)
+    {
+        if (settings.type == LatticeType::Trinomial)
+            RollTrinomial(c, S, N, settings.earlyExercise, work, out, record);
+        else
+            RollBinomial(c, S, N, settings.type == LatticeType::LeisenReimer, settings.earlyExercise, work, out, record);
+    }
+
+    // Delta, Gamma and Theta from the nodes of the first time steps
+    void NodeGreeks(const TreeOutput& t, bool trinomial, double S, GreeksResult& g)
+    {
+        if (trinomial)
+        {
+            const double* s = t.spot1;
+            const double* v = t.step1;
+            double up = (v[2] - v[1]) / (s[2] - s[1]);
+            double down = (v[1] - v[0]) / (s[1] - s[0]);
+            g.delta = (v[2] - v[0]) / (s[2] - s[0]);
+            g.gamma = (up - down) / (0.5 * (s[2] - s[0]));
+            g.theta = (v[1] - t.price) / t.dt; // middle node of step 1 has spot S
+        }
+        else
+        {
+            const double* s = t.spot2;
+            const double* v = t.step2;
+            double up = (v[2] - v[1]) / (s[2] - s[1]);
+            double down = (v[1] - v[0]) / (s[1] - s[0]);
+            g.delta = (t.step1[1] - t.step1[0]) / (t.spot1[1] - t.spot1[0]);
+            g.gamma = (up - down) / (0.5 * (s[2] - s[0]));
+
+            // The middle node of step 2 has spot S*u*d, which equals S only for CRR; remove the spot move to first order
+            double ds = s[1] - S;
+            g.theta = (v[1] - t.price - g.delta * ds - 0.5 * g.gamma * ds * ds) / (2.0 * t.dt);
+        }
+    }
+
+    // Weights n^p of the Richardson extrapolation between n1 and n2 steps.
+    // Leisen-Reimer converges at second order for European payoffs, but the early-exercise boundary brings
+    // American prices back to first order
+    template<class Real>
+    void RichardsonWeights(const LatticeContract<Real>& c, const LatticeSettings& settings, unsigned n1, unsigned n2,
+        double& w1, double& w2)
+    {
+        const bool exercised = settings.earlyExercise && !(c.call && c.b >= c.r);
+        const double order = (settings.type == LatticeType::LeisenReimer && !exercised) ? 2.0 : 1.0;
+        w2 = std::pow(static_cast<double>(n2), order);
+        w1 = std::pow(static_cast<double>(n1), order);
+    }
+
+    // Extrapolated (or plain) lattice price plus the node Greeks; the Greeks are extrapolated the same way as the price
+    GreeksResult Evaluate(const Contract& c, double S, const LatticeSettings& settings, Workspace& work, bool greeks)
+    {
+        const bool trinomial = settings.type == LatticeType::Trinomial;
+        const unsigned n1 = StepsFor(settings.type, settings.steps);
+
+        GreeksResult g1 = {};
+        TreeOutput t1;
+        Roll(c, S, n1, settings, work, t1);
+        g1.price = t1.price;
+        if (greeks) NodeGreeks(t1, trinomial, S, g1);
+        if (!settings.richardson) return g1;
+
+        const unsigned n2 = StepsFor(settings.type, 2 * n1);
+        GreeksResult g2 = {};
+        TreeOutput t2;
+        Roll(c, S, n2, settings, work, t2);
+        g2.price = t2.price;
+        if (greeks) NodeGreeks(t2, trinomial, S, g2);
+
+        double w1, w2;
+        RichardsonWeights(c, settings, n1, n2, w1, w2);
+        auto extrapolate = [w1, w2](double a, double b) { return (w2 * b - w1 * a) / (w2 - w1); };
+
+        GreeksResult g = {};
+        g.price = extrapolate(g1.price, g2.price);
+        g.delta = extrapolate(g1.delta, g2.delta);
+        g.gamma = extrapolate(g1.gamma, g2.gamma);
+        g.theta = extrapolate(g1.theta, g2.theta);
+        return g;
+    }
+
+    GreeksResult FullGreeks(Contract c, double S, const LatticeSettings& settings, Workspace& work)
+    {
+        GreeksResult g = Evaluate(c, S, settings, work, true);
+
+        // Vega and Rho: the tree geometry depends on sigma and r, so bump and reprice on the same lattice
+        const double hSig = 1e-4, hR = 1e-4;
+        const double sig = c.sig, r = c.r;
+
+        c.sig = sig + hSig; double up = Evaluate(c, S, settings, work, false).price;
+        c.sig = sig - hSig; double down = Evaluate(c, S, settings, work, false).price;
+        g.vega = (up - down) / (2.0 * hSig);
+        c.sig = sig;
+
+        // Rho moves b with r (a fixed dividend yield r - b), matching Greeks::Rho for the plain b = r contract
+        const double b = c.b;
+        c.r = r + hR; c.b = b + hR; up = Evaluate(c, S, settings, work, false).price;
+        c.r = r - hR; c.b = b - hR; down = Evaluate(c, S, settings, work, false).price;
+        g.rho = (up - down) / (2.0 * hR);
+
+        return g;
+    }
+
+    // Buffers of the adjoint sweeps, kept per thread and reused like the tapes of AlgorithmicGreeks
+    template<class T>
+    struct AdjointWorkspace
+    {
+        WorkspaceT<T> tree;
+        RecordT<T> record;
+        std::vector<T> adjoint, next;
+    };
+
+    template<class T>
+    AdjointWorkspace<T>& ThreadAdjointWorkspace()
+    {
+        static thread_local AdjointWorkspace<T> work;
+        return work;
+    }
+
+    // Adjoints of the tree price in the quantities the roll-back reads: the probability of each move (down first),
+    // the strike, and the node spots through spot = sum of a * spot, spotJ = sum of a * spot * j and
+    // spotI = sum of a * spot * i over the nodes (i, j) whose exercise value or payoff was taken.
+    template<class T>
+    struct TreeAdjointT
+    {
+        T move[3];
+        T K;
+        T spot, spotJ, spotI;
+    };
+
+    // Sum of x[j] * y[j] in four independent partial sums, so the adds do not wait on each other
+    template<class T>
+    T Dot(const T* x, const T* y, unsigned n)
+    {
+        T s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        unsigned j = 0;
+        for (; j + 4 <= n; j += 4)
+        {
+            s0 += x[j] * y[j];
+            s1 += x[j + 1] * y[j + 1];
+            s2 += x[j + 2] * y[j + 2];
+            s3 += x[j + 3] * y[j + 3];
+        }
+        for (; j < n; ++j) s0 += x[j] * y[j];
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    // One reverse sweep over a recorded tree, from the root towards maturity. The adjoint a of a node goes to its
+    // exercise value if the roll-back exercised it (at maturity: if the payoff was taken), and otherwise down the
+    // Moves moves (2 binomial, 3 trinomial) to the nodes of the next step, adding a * value of the node reached to the
+    // adjoint of that move's probability. pw holds the spot ratio powers of the roll-back.
+    template<unsigned Moves, class T>
+    TreeAdjointT<T> AdjointTree(const RecordT<T>& record, const T& K, const T* pw, unsigned N, double w,
+        AdjointWorkspace<T>& work)
+    {
+        TreeAdjointT<T> a;
+        a.move[0] = a.move[1] = a.move[2] = a.K = a.spot = a.spotJ = a.spotI = 0.0;
+
+        // Node j of a step is at index pad + j, with zeros on both sides so every node of the next step can gather
+        // from the nodes that lead to it
+        const unsigned spread = Moves - 1, pad = Moves - 1;
+        work.adjoint.assign(spread * N + 1 + 2 * pad, T(0.0));
+        work.next.assign(spread * N + 1 + 2 * pad, T(0.0));
+        work.adjoint[pad] = 1.0;
+
+        const T probability[3] = { record.pd, (Moves == 3) ? record.pm : record.pu, record.pu };
+        const T wK = w * K;
+
+        for (unsigned i = 0; i <= N; ++i)
+        {
+            const unsigned nodes = spread * i + 1;
+            const T lowest = record.lowest[i], wS = w * lowest;
+            const T* after = (i < N) ? record.values.data() + record.Offset(i + 1) : nullptr;
+            T* x = work.adjoint.data() + pad;
+
+            // Exercised nodes hand their adjoint to the strike and the node spot
+            T spot = 0.0, spotJ = 0.0;
+            auto take = [&](unsigned j)
+            {
+                const T s = x[j] * (lowest * pw[j]);
+                spot += s;
+                spotJ += s * static_cast<double>(j);
+                a.K += x[j];
+                x[j] = 0.0;
+            };
+
+            // The tests are the ones the roll-back made: payoff not negative at maturity, continuation below exercise
+            // value (std::max) before. Exercise pays at low spots for a put and high spots for a call, so the nodes
+            // are scanned from that side until the number the roll-back counted at this step have been found.
+            if (!after)
+            {
+                for (unsigned j = 0; j < nodes; ++j)
+                    if (!(w * (lowest * pw[j] - K) < 0.0)) take(j);
+            }
+            else
+            {
+                std::int64_t remaining = record.exercised[i];
+                for (unsigned n = 0; n < nodes && remaining > 0; ++n)
+                {
+                    const unsigned j = (w > 0.0) ? nodes - 1 - n : n;
+                    T hold = probability[0] * after[j];
+                    for (unsigned m = 1; m < Moves; ++m) hold += probability[m] * after[j + m];
+                    if (hold < wS * pw[j] - wK)
+                    {
+                        take(j);
+                        --remaining;
+                    }
+                }
+            }
+            a.spot += spot;
+            a.spotJ += spotJ;
+            a.spotI += spot * static_cast<double>(i);
+            if (!after) break;
+
+            // The others pass it down each move
+            for (unsigned m = 0; m < Moves; ++m)
+                a.move[m] += Dot(x, after + m, nodes);
+
+            T* to = work.next.data() + pad;
+            const T* x1 = x - 1;
+            const T* x2 = x - pad; // x - 2 on the trinomial tree; unused on the binomial one
+            for (unsigned j = 0; j < nodes + spread; ++j)
+                to[j] = (Moves == 3) ? probability[0] * x[j] + probability[1] * x1[j] + probability[2] * x2[j]
+                    : probability[0] * x[j] + probability[1] * x1[j];
+            std::swap(work.adjoint, work.next);
+        }
+
+        // The exercise value and the payoff are w * (spot - K)
+        a.spot *= w; a.spotJ *= w; a.spotI *= w; a.K *= -w;
+        return a;
+    }
+
+    // Price of one tree with N steps and its gradient in (S, K, T, sig, r, b): a recording roll-back, one reverse
+    // sweep, and the chain rule through the tree geometry, a few dozen scalar operations run in vector forward mode
+    template<class T>
+    T TreeGradient(const LatticeContract<T>& c, const T& S, unsigned N, const LatticeSettings& settings, T* gradient)
+    {
+        typedef DualVector<T, 6> Tangent;
+        AdjointWorkspace<T>& work = ThreadAdjointWorkspace<T>();
+        TreeOutputT<T> out;
+        Roll(c, S, N, settings, work.tree, out, &work.record);
+
+        const bool trinomial = settings.type == LatticeType::Trinomial;
+        const T inputs[6] = { S, c.K, c.T, c.sig, c.r, c.b };
+        Tangent x[6];
+        for (std::size_t k = 0; k < 6; ++k) x[k] = Tangent::Variable(inputs[k], k);
+        const LatticeContract<Tangent> tc = { x[2], x[1], x[3], x[4], x[5], c.call };
+        const GeometryT<Tangent> g = trinomial ? TrinomialGeometry(tc, N)
+            : BinomialGeometry(tc, x[0], N, settings.type == LatticeType::LeisenReimer);
+
+        const double w = c.call ? 1.0 : -1.0;
+        const TreeAdjointT<T> a = trinomial
+            ? AdjointTree<3>(work.record, c.K, work.tree.powers.data(), N, w, work)
+            : AdjointTree<2>(work.record, c.K, work.tree.powers.data(), N, w, work);
+
+        // Node (i, j) has spot S * d^(i - j) * u^j on the binomial tree and S * exp((j - i) * dx) on the trinomial one
+        for (std::size_t k = 0; k < 6; ++k)
+        {
+            if (trinomial)
+                gradient[k] = a.move[0] * g.pd.d[k] + a.move[1] * g.pm.d[k] + a.move[2] * g.pu.d[k]
+                    + (a.spotJ - a.spotI) * g.dx.d[k];
+            else
+                gradient[k] = a.move[0] * g.pd.d[k] + a.move[1] * g.pu.d[k]
+                    + a.spotJ / g.u.v * g.u.d[k] + (a.spotI - a.spotJ) / g.d.v * g.d.d[k];
+        }
+        gradient[0] += a.spot / S;
+        gradient[1] += a.K;
+        return out.price;
+    }
+
+    // Lattice price on the tape of Adjoint<T>. The trees are not recorded node by node: TreeGradient gives the price
+    // and its six partials directly (extrapolated like the price), and only those go on the tape: one node per pair of
+    // inputs holding their partials, joined into the output.
+    template<class T>
+    Adjoint<T> AdjointPrice(const LatticeContract<Adjoint<T>>& c, const Adjoint<T>& S, const LatticeSettings& settings)
+    {
+        const Adjoint<T>* inputs[6] = { &S, &c.K, &c.T, &c.sig, &c.r, &c.b };
+        const LatticeContract<T> v = { c.T.value, c.K.value, c.sig.value, c.r.value, c.b.value, c.call };
+
+        T gradient[6];
+        const unsigned n1 = StepsFor(settings.type, settings.steps);
+        T price = TreeGradient(v, S.value, n1, settings, gradient);
+        if (settings.richardson)
+        {
+            const unsigned n2 = StepsFor(settings.type, 2 * n1);
+            T fine[6];
+            const T finePrice = TreeGradient(v, S.value, n2, settings, fine);
+
+            double w1, w2;
+            RichardsonWeights(v, settings, n1, n2, w1, w2);
+            price = (w2 * finePrice - w1 * price) / (w2 - w1);
+            for (std::size_t k = 0; k < 6; ++k) gradient[k] = (w2 * fine[k] - w1 * gradient[k]) / (w2 - w1);
+        }
+
+        Adjoint<T> pairs[3];
+        for (std::size_t k = 0; k < 3; ++k)
+            pairs[k] = Adjoint<T>::Binary(price, *inputs[2 * k], gradient[2 * k], *inputs[2 * k + 1], gradient[2 * k + 1]);
+        const Adjoint<T> joined = Adjoint<T>::Binary(price, pairs[0], T(1.0), pairs[1], T(1.0));
+        return Adjoint<T>::Binary(price, joined, T(1.0), pairs[2], T(1.0));
+    }
+
+    Contract FromBatch(const OptionBatch& batch, std::size_t i)
+    {
+        Contract c = { batch.T[i], batch.K[i], batch.sig[i], batch.r[i], batch.b[i], batch.isCall[i] != 0 };
+        return c;
+    }
+}
+
+double LatticeEngine::Price(const EuropeanOption& opt, double S, const LatticeSettings& settings)
+{
+    Workspace work;
+    return Evaluate(FromOption(opt), S, settings, work, false).price;
+}
+
+GreeksResult LatticeEngine::Greeks(const EuropeanOption& opt, double S, const LatticeSettings& settings)
+{
+    Workspace work;
+    return FullGreeks(FromOption(opt), S, settings, work);
+}
+
+Adjoint<double> LatticeEngine::Price(const LatticeContract<Adjoint<double>>& c, const Adjoint<double>& S,
+    const LatticeSettings& settings)
+{
+    return AdjointPrice(c, S, settings);
+}
+
+Adjoint<Dual> LatticeEngine::Price(const LatticeContract<Adjoint<Dual>>& c, const Adjoint<Dual>& S,
+    const LatticeSettings& settings)
+{
+    return AdjointPrice(c, S, settings);
+}
+
+GreeksResult LatticeEngine::NodeGreeks(const EuropeanOption& opt, double S, const LatticeSettings& settings)
+{
+    Workspace work;
+    GreeksResult g = Evaluate(FromOption(opt), S, settings, work, true);
+    g.vega = g.rho = std::numeric_limits<double>::quiet_NaN();
+    return g;
+}
+
+void LatticeEngine::PriceBatch(const OptionBatch& batch, const double* S, double* out,
+    const LatticeSettings& settings, const ParallelOptions& options)
+{
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+    const std::size_t grain = (options.grain > 0) ? options.grain : 8;
+
+    pool.ParallelFor(batch.Size(), grain, [&](std::size_t begin, std::size_t end)
+    {
+        Workspace work; // one set of buffers per block, grown once to the largest tree
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = Evaluate(FromBatch(batch, i), S[i], settings, work, false).price;
+    }, options.threads);
+}
+
+void LatticeEngine::GreeksBatch(const OptionBatch& batch, const double* S, GreeksResult* out,
+    const LatticeSettings& settings, const ParallelOptions& options)
+{
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+    const std::size_t grain = (options.grain > 0) ? options.grain : 8;
+
+    pool.ParallelFor(batch.Size(), grain, [&](std::size_t begin, std::size_t end)
+    {
+        Workspace work;
+        for (std::size_t i = begin; i < end; ++i)
+            out[i] = FullGreeks(FromBatch(batch, i), S[i], settings, work);
+    }, options.threads);
+}
@@ -4,6 +4,17 @@
 #include <vector>
 #include <iomanip>
 #include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <tuple>
 
 #include "EuropeanOption.h"    // EuropeanOption class: for plain vanilla call/put pricing
 #include "MeshGenerator.h"     // MeshGenerator: builds spot price vectors for vectorized pricing
@@ -11,11 +22,120 @@
 #include "Greeks.h"            // Greeks: compute Delta, Gamma (exact & finite difference)
 #include "OptionUtilities.h"   // Put-Call parity functions
 #include "AmericanOption.h"    // Perpetual American options
+#include "BatchPricer.h"       // OptionBatch/BatchPricer: structure-of-arrays batch pricing
+#include "NormalDistribution.h" // Scalar (Boost) and array (SIMD) normal CDF/PDF
+#include "VectorMath.h"        // SIMD level selection for the array kernels
+#include "ThreadPool.h"        // Work-stealing pool used by the parallel engines
+#include "Surface.h"           // Contiguous surface storage
+#include "ImpliedVolatility.h" // Implied volatility from market prices
+#include "Lattice.h"           // Binomial/trinomial lattice for finite-maturity American options
+#include "PdeSolver.h"         // Crank-Nicolson PDE engine on MeshGenerator grids
+#include "MonteCarlo.h"        // Monte Carlo engine for path-dependent and basket payoffs
+#include "PricingPipeline.h"   // Streaming quote-file driver
+#include "SurfaceFile.h"       // Memory-mapped binary surface files
+#include "PricingKernels.h"    // Compile-time specialised vector kernels
+#include "TickEngine.h"        // Tick-driven repricing engine
+#include "Portfolio.h"         // Position book with aggregated Greeks and scenario grids
+#include "AlgorithmicGreeks.h" // Greeks by algorithmic differentiation
+#include "PriceTable.h"        // Precomputed Chebyshev price tables
+#include "VolSurface.h"        // SVI implied volatility surface
+#include "RateCurve.h"         // Rate and carry term structures
+#include "AmericanApproximation.h" // Barone-Adesi-Whaley and Bjerksund-Stensland approximations
+#include "FourierPricer.h"     // Carr-Madan FFT and COS strike strips
+#include "Metrics.h"           // Optional hot-path call counters, timers and latency histograms
 
 using namespace std;
 
-int main()
+// Counts every heap allocation made by the program, so the demo can check that
+// revaluations into reused buffers allocate nothing after warm-up
+static atomic<size_t> g_allocations(0);
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+// These deletes do pair with the malloc in operator new above, but once a delete is inlined into a destructor GCC
+// sees free() on a pointer from operator new and reports -Wmismatched-new-delete
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Command-line driver for pricing quote files instead of the hard-coded demo inputs:
+//   --price-file <in> --out <out> [--greeks] [--binary-in] [--binary-out] [--chunk-rows N] [--pricers N]
+//   --make-quotes <file> <rows> [--binary]     writes a sample quote file
+// Returns -1 when no driver option is present, so main() runs the demo instead.
+static int RunCommandLine(int argc, char* argv[])
+{
+    vector<string> args(argv + 1, argv + argc);
+    auto has = [&args](const string& flag) { return find(args.begin(), args.end(), flag) != args.end(); };
+    auto value = [&args](const string& flag, size_t offset = 1) -> string
+    {
+        auto it = find(args.begin(), args.end(), flag);
+        return (it != args.end() && size_t(args.end() - it) > offset) ? *(it + offset) : string();
+    };
+
+    if (has("--make-quotes"))
+    {
+        string path = value("--make-quotes");
+        size_t rows = strtoull(value("--make-quotes", 2).c_str(), nullptr, 10);
+        QuoteFormat format = has("--binary") ? QuoteFormat::Binary : QuoteFormat::Csv;
+        if (path.empty() || !PricingPipeline::WriteSampleFile(path, rows, format))
+        {
+            cerr << "usage: --make-quotes <file> <rows> [--binary]\n";
+            return 1;
+        }
+        cout << "Wrote " << rows << " contracts to " << path << endl;
+        return 0;
+    }
+
+    if (!has("--price-file")) return -1;
+
+    string input = value("--price-file"), output = value("--out");
+    if (input.empty() || output.empty())
+    {
+        cerr << "usage: --price-file <in> --out <out> [--greeks] [--binary-in] [--binary-out] [--chunk-rows N] [--pricers N]\n";
+        return 1;
+    }
+
+    PipelineSettings settings;
+    settings.greeks = has("--greeks");
+    settings.inputFormat = has("--binary-in") ? QuoteFormat::Binary : QuoteFormat::Csv;
+    settings.outputFormat = has("--binary-out") ? QuoteFormat::Binary : QuoteFormat::Csv;
+    if (has("--chunk-rows")) settings.chunkRows = strtoull(value("--chunk-rows").c_str(), nullptr, 10);
+    if (has("--pricers")) settings.pricingThreads = static_cast<unsigned>(strtoul(value("--pricers").c_str(), nullptr, 10));
+
+    PipelineStats stats = PricingPipeline::Run(input, output, settings);
+    if (!stats.ok)
+    {
+        cerr << "error: " << stats.error << endl;
+        return 1;
+    }
+
+    cout << fixed << setprecision(0);
+    cout << "Rows priced: " << stats.write.rows << " | rejected lines: " << stats.rejectedRows
+        << " | wall time (s): " << setprecision(3) << stats.wallSeconds << setprecision(0) << endl;
+    cout << "Stage\tRows/sec\tBusy (s)\n";
+    cout << "parse\t" << stats.parse.RowsPerSecond() << "\t" << setprecision(3) << stats.parse.busySeconds << setprecision(0) << endl;
+    cout << "price\t" << stats.price.RowsPerSecond() << "\t" << setprecision(3) << stats.price.busySeconds << setprecision(0) << endl;
+    cout << "write\t" << stats.write.RowsPerSecond() << "\t" << setprecision(3) << stats.write.busySeconds << endl;
+    return 0;
+}
+
+int main(int argc, char* argv[])
 {
+    // Quote-file driver when requested on the command line, otherwise the demo below
+    int commandLineResult = RunCommandLine(argc, argv);
+    if (commandLineResult >= 0) return commandLineResult;
+
     // Fixed decimal precision ensures outputs are readable and comparable across batches
     cout << fixed << setprecision(6);
 
@@ -138,6 +258,431 @@ int main()
             cout << priceSurface[i][j] << "\t";
         cout << "\n";
     }
+    // ---------------- Batch Pricing ----------------
+    cout << "\nBatch Pricing (Structure of Arrays)\n";
+
+    // A large batch of contracts with varying parameters, stored once as contiguous arrays
+    const size_t nBatch = 200000;
+    OptionBatch batch;
+    batch.Reserve(nBatch);
+    vector<double> S_batch(nBatch);
+    vector<EuropeanOption> contracts(nBatch);
+    for (size_t i = 0; i < nBatch; ++i)
+    {
+        EuropeanOption& c = contracts[i];
+        c.T = 0.1 + 0.01 * (i % 200);
+        c.K = 80.0 + (i % 41);
+        c.sig = 0.1 + 0.005 * (i % 60);
+        c.r = 0.01 + 0.001 * (i % 50);
+        c.b = c.r - 0.01;
+        c.optType = (i % 2 == 0) ? "C" : "P";
+        S_batch[i] = 100.0 + 0.5 * ((i % 21) - 10.0);
+        batch.Add(c);
+    }
+
+    // Reference: one virtual Price() call per contract
+    vector<double> refPrices(nBatch);
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < nBatch; ++i)
+        refPrices[i] = contracts[i].Price(S_batch[i]);
+    auto t1 = chrono::steady_clock::now();
+
+    // Batch kernel: one pass over the arrays, no virtual calls or string compares
+    vector<double> batchPrices(nBatch);
+    BatchPricer::PriceBatch(batch, S_batch.data(), batchPrices.data());
+    auto t2 = chrono::steady_clock::now();
+
+    // Current vector loop for the same number of evaluations (single parameter set over a spot mesh)
+    vector<double> vectorPrices = MatrixPricer::Vector(optE, S_batch, OutputType::Price);
+    auto t3 = chrono::steady_clock::now();
+
+    double maxBatchError = 0.0;
+    for (size_t i = 0; i < nBatch; ++i)
+        maxBatchError = max(maxBatchError, fabs(batchPrices[i] - refPrices[i]));
+
+    auto nsPerOption = [nBatch](chrono::steady_clock::duration d)
+    {
+        return chrono::duration<double, nano>(d).count() / nBatch;
+    };
+
+    cout << "Contracts: " << nBatch << endl;
+    cout << "Max |batch - Price()|: " << scientific << maxBatchError << fixed << endl;
+    cout << "Price() loop (ns/option):        " << nsPerOption(t1 - t0) << endl;
+    cout << "BatchPricer (ns/option):         " << nsPerOption(t2 - t1) << endl;
+    cout << "MatrixPricer::Vector (ns/option): " << nsPerOption(t3 - t2) << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Specialised vector kernels ----------------
+    cout << "\nCompile-time specialised kernels vs per-element dispatch (" << S_batch.size() << " spots)\n";
+
+    // Per-element reference: the string compare and OutputType switch on every spot, as the scalar API does
+    auto perElement = [](const EuropeanOption& o, double S, OutputType output) -> double
+    {
+        switch (output)
+        {
+        case OutputType::Price:   return o.Price(S);
+        case OutputType::Delta:   return Greeks::Delta(o, S);
+        case OutputType::Gamma:   return Greeks::Gamma(o, S);
+        case OutputType::Vega:    return Greeks::Vega(o, S);
+        case OutputType::Theta:   return Greeks::Theta(o, S);
+        case OutputType::Rho:     return Greeks::Rho(o, S);
+        case OutputType::DeltaFD: return Greeks::DeltaFD(o, S, 0.01);
+        case OutputType::GammaFD: return Greeks::GammaFD(o, S, 0.01);
+        }
+        return 0.0;
+    };
+
+    const OutputType kernelOutputs[] = { OutputType::Price, OutputType::Delta, OutputType::Gamma, OutputType::Vega,
+        OutputType::Theta, OutputType::Rho, OutputType::DeltaFD, OutputType::GammaFD };
+    const char* kernelNames[] = { "Price", "Delta", "Gamma", "Vega", "Theta", "Rho", "DeltaFD", "GammaFD" };
+
+    vector<double> scalarOut(S_batch.size()), kernelOut(S_batch.size());
+    cout << "Output\tType\tPer-element (ns)\tKernel (ns)\tSpeedup\tMax rel diff\n";
+    for (const char* type : { "C", "P" })
+    {
+        EuropeanOption optK = optE;
+        optK.optType = type;
+        for (size_t k = 0; k < 8; ++k)
+        {
+            auto tk0 = chrono::steady_clock::now();
+            for (size_t i = 0; i < S_batch.size(); ++i)
+                scalarOut[i] = perElement(optK, S_batch[i], kernelOutputs[k]);
+            auto tk1 = chrono::steady_clock::now();
+            MatrixPricer::Vector(optK, S_batch.data(), S_batch.size(), kernelOutputs[k], kernelOut.data());
+            auto tk2 = chrono::steady_clock::now();
+
+            // Relative to the size of the output over the ladder, so values crossing zero do not dominate
+            double scale = 0.0, maxDiff = 0.0;
+            for (size_t i = 0; i < S_batch.size(); ++i)
+            {
+                scale = max(scale, fabs(scalarOut[i]));
+                maxDiff = max(maxDiff, fabs(kernelOut[i] - scalarOut[i]));
+            }
+            double perElementNs = nsPerOption(tk1 - tk0), kernelNs = nsPerOption(tk2 - tk1);
+            cout << kernelNames[k] << "\t" << type << "\t" << setprecision(1) << perElementNs << "\t\t\t" << kernelNs
+                << "\t\t" << perElementNs / kernelNs << "x\t" << scientific << setprecision(1) << maxDiff / scale
+                << fixed << setprecision(6) << endl;
+        }
+    }
+    cout << "----------------------------------------\n";
+
+    // ---------------- Spot-only repricing ----------------
+    cout << "\nSpot-only repricing with cached invariants (" << S_batch.size() << " ticks)\n";
+
+    // Ticks move only the spot. Price() on an option whose cache was never filled recomputes sqrt(T), the
+    // exponentials and the drift every time (the old per-tick cost); Reprice() fills the cache on the first tick.
+    auto tickCost = [&](EuropeanOption& uncached, EuropeanOption& cached, const char* label)
+    {
+        double sumPrice = 0.0, sumReprice = 0.0;
+        bool identical = true;
+        auto tt0 = chrono::steady_clock::now();
+        for (double S : S_batch) sumPrice += uncached.Price(S);
+        auto tt1 = chrono::steady_clock::now();
+        for (double S : S_batch) sumReprice += cached.Reprice(S);
+        auto tt2 = chrono::steady_clock::now();
+        for (size_t i = 0; i < S_batch.size(); i += 97)
+            identical = identical && (uncached.Price(S_batch[i]) == cached.Reprice(S_batch[i]));
+
+        double before = nsPerOption(tt1 - tt0), after = nsPerOption(tt2 - tt1);
+        cout << label << " | Price() (ns/tick): " << setprecision(1) << before << " | Reprice() (ns/tick): " << after
+            << " | speedup: " << before / after << "x | identical: " << (identical && sumPrice == sumReprice ? "YES" : "NO")
+            << setprecision(6) << endl;
+    };
+
+    EuropeanOption tickCall = optE, tickCallCached = optE;
+    tickCall.optType = tickCallCached.optType = "C";
+    tickCost(tickCall, tickCallCached, "European call  ");
+
+    AmericanOption tickPerp("P"), tickPerpCached("P");
+    tickPerp.K = tickPerpCached.K = 100; tickPerp.sig = tickPerpCached.sig = 0.1;
+    tickPerp.r = tickPerpCached.r = 0.1; tickPerp.b = tickPerpCached.b = 0.02;
+    tickCost(tickPerp, tickPerpCached, "Perpetual put  ");
+
+    // Changing a parameter invalidates the cache without any explicit call
+    tickCallCached.sig = 0.3;
+    tickCall.sig = 0.3;
+    cout << "After sig change, Reprice() == Price()? " << (tickCallCached.Reprice(100.0) == tickCall.Price(100.0) ? "YES" : "NO") << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Parallel Matrix Pricing ----------------
+    cout << "\nParallel Matrix Pricing (scaling)\n";
+
+    // 64 parameter rows (volatility sweep) x 4000 spot prices
+    vector<vector<double>> paramMatrixP;
+    for (int i = 0; i < 64; ++i)
+        paramMatrixP.push_back({ 1.0, 100.0, 0.10 + 0.005 * i, 0.05 });
+    vector<double> S_meshP = MeshGenerator::Uniform(50, 150, 0.025);
+
+    // Serial reference; Matrix() writes the row parameters into the option, so give it a copy
+    EuropeanOption serialOpt = optE;
+    auto ts0 = chrono::steady_clock::now();
+    vector<vector<double>> serialSurface = MatrixPricer::Matrix(serialOpt, paramMatrixP, S_meshP, OutputType::Price);
+    auto ts1 = chrono::steady_clock::now();
+    double serialMs = chrono::duration<double, milli>(ts1 - ts0).count();
+
+    cout << "Surface: " << paramMatrixP.size() << " x " << S_meshP.size() << " | serial Matrix (ms): " << serialMs << endl;
+    cout << "Threads\tTime (ms)\tSpeedup\tIdentical\n";
+
+    unsigned maxThreads = ThreadPool::Shared().Workers() + 1;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        ParallelOptions popts;
+        popts.threads = threads;
+        popts.grain = 512;
+
+        auto tp0 = chrono::steady_clock::now();
+        vector<vector<double>> parallelSurface = MatrixPricer::MatrixParallel(optE, paramMatrixP, S_meshP, OutputType::Price, 0.01, popts);
+        auto tp1 = chrono::steady_clock::now();
+        double ms = chrono::duration<double, milli>(tp1 - tp0).count();
+
+        cout << threads << "\t" << ms << "\t" << serialMs / ms << "\t" << (parallelSurface == serialSurface ? "YES" : "NO") << endl;
+
+        if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2; // always finish on the full pool
+    }
+    cout << "----------------------------------------\n";
+
+    // ---------------- Reused Output Buffers ----------------
+    cout << "\nRevaluation into reused buffers (allocation count)\n";
+
+    // Warm-up pass sizes the Surface and the vector buffer once
+    Surface surfaceBuf(0, 0, SurfaceLayout::RowMajor);
+    vector<double> vectorBuf(S_meshP.size());
+    EuropeanOption loopOpt = optE;
+    MatrixPricer::Matrix(loopOpt, paramMatrixP, S_meshP, OutputType::Delta, surfaceBuf);
+
+    const int revaluations = 20;
+    size_t allocBefore = g_allocations.load();
+    for (int k = 0; k < revaluations; ++k)
+    {
+        MatrixPricer::Matrix(loopOpt, paramMatrixP, S_meshP, OutputType::Delta, surfaceBuf);
+        MatrixPricer::Vector(loopOpt, S_meshP.data(), S_meshP.size(), OutputType::Price, vectorBuf.data());
+    }
+    size_t reusedAllocations = g_allocations.load() - allocBefore;
+
+    // Same work through the allocating vector-of-vectors interface
+    allocBefore = g_allocations.load();
+    for (int k = 0; k < revaluations; ++k)
+    {
+        vector<vector<double>> s1 = MatrixPricer::Matrix(loopOpt, paramMatrixP, S_meshP, OutputType::Delta);
+        vector<double> s2 = MatrixPricer::Vector(loopOpt, S_meshP, OutputType::Price);
+    }
+    size_t allocatingAllocations = g_allocations.load() - allocBefore;
+
+    // Column-major layout holds the same values as row-major, only transposed in memory
+    Surface columnBuf(0, 0, SurfaceLayout::ColumnMajor);
+    MatrixPricer::Matrix(loopOpt, paramMatrixP, S_meshP, OutputType::Delta, columnBuf);
+    bool sameValues = true;
+    for (size_t i = 0; i < surfaceBuf.Rows(); ++i)
+        for (size_t j = 0; j < surfaceBuf.Cols(); ++j)
+            sameValues = sameValues && (surfaceBuf(i, j) == columnBuf(i, j));
+
+    cout << "Revaluations: " << revaluations << endl;
+    cout << "Heap allocations with reused Surface/buffer: " << reusedAllocations << endl;
+    cout << "Heap allocations with vector-of-vectors:     " << allocatingAllocations << endl;
+    cout << "Row-major and column-major surfaces agree? " << (sameValues ? "YES" : "NO") << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Memory-mapped surface file ----------------
+    cout << "\nMemory-mapped surface file\n";
+
+    // The parallel pricer writes straight into the mapping; compare with formatting the same surface as text
+    const char* surfacePath = "surface_demo.osf";
+    auto tf0 = chrono::steady_clock::now();
+    bool surfaceWritten = false;
+    {
+        SurfaceFile writer;
+        surfaceWritten = writer.Create(surfacePath, paramMatrixP, S_meshP, OutputType::Price)
+            && MatrixPricer::MatrixParallel(optE, paramMatrixP, S_meshP, OutputType::Price, writer);
+        if (!surfaceWritten) cout << "Create failed: " << writer.Error() << endl;
+    }
+    auto tf1 = chrono::steady_clock::now();
+    {
+        ofstream text("surface_demo.txt");
+        text << setprecision(17);
+        for (const auto& row : serialSurface)
+        {
+            for (double v : row) text << v << ' ';
+            text << '\n';
+        }
+    }
+    auto tf2 = chrono::steady_clock::now();
+
+    SurfaceFile reader;
+    if (surfaceWritten && reader.Open(surfacePath))
+    {
+        // Every value must round-trip exactly; the views read the mapping in place
+        bool sameAsSerial = reader.Output() == OutputType::Price && reader.Rows() == serialSurface.size() && reader.Cols() == S_meshP.size();
+        for (size_t i = 0; sameAsSerial && i < reader.Rows(); ++i)
+        {
+            SurfaceSlice row = reader.Row(i);
+            for (size_t j = 0; j < row.Size(); ++j)
+                sameAsSerial = sameAsSerial && (row[j] == serialSurface[i][j]);
+        }
+
+        size_t atTheMoney = static_cast<size_t>(lower_bound(S_meshP.begin(), S_meshP.end(), 100.0) - S_meshP.begin());
+        SurfaceSlice column = reader.Column(atTheMoney);
+
+        cout << "Surface: " << reader.Rows() << " x " << reader.Cols() << " | column blocks contiguous: " << (column.Contiguous() ? "yes" : "no") << endl;
+        cout << "Write through mmap (ms): " << chrono::duration<double, milli>(tf1 - tf0).count()
+            << " | text formatting (ms): " << chrono::duration<double, milli>(tf2 - tf1).count() << endl;
+        cout << "Reopened file matches serial Matrix()? " << (sameAsSerial ? "YES" : "NO") << endl;
+        cout << "S = " << reader.Spots()[atTheMoney] << ": sig " << reader.Params(0)[2] << " -> " << column[0]
+            << ", sig " << reader.Params(column.Size() - 1)[2] << " -> " << column[column.Size() - 1] << endl;
+        reader.Close();
+    }
+    else if (surfaceWritten)
+        cout << "Open failed: " << reader.Error() << endl;
+
+    remove(surfacePath);
+    remove("surface_demo.txt");
+    cout << "----------------------------------------\n";
+
+    // ---------------- Vectorized Normal Distribution ----------------
+    cout << "\nVectorized N_cdf/N_pdf vs Boost\n";
+
+    // Sample the full double range: both signs, magnitudes from 1e-300 to 1e300 plus a dense sweep of [-40, 40]
+    // where the CDF actually varies, and the special values 0 and +/-infinity.
+    vector<double> xs;
+    for (double e = -300.0; e <= 300.0; e += 0.01)
+    {
+        xs.push_back(pow(10.0, e));
+        xs.push_back(-pow(10.0, e));
+    }
+    for (double x = -40.0; x <= 40.0; x += 1e-4)
+        xs.push_back(x);
+    xs.push_back(0.0);
+    xs.push_back(numeric_limits<double>::infinity());
+    xs.push_back(-numeric_limits<double>::infinity());
+
+    // Reference values from the existing inline Boost functions, timed for throughput
+    vector<double> cdfRef(xs.size()), pdfRef(xs.size());
+    auto tb0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < xs.size(); ++i) cdfRef[i] = N_cdf(xs[i]);
+    auto tb1 = chrono::steady_clock::now();
+    for (size_t i = 0; i < xs.size(); ++i) pdfRef[i] = N_pdf(xs[i]);
+    auto tb2 = chrono::steady_clock::now();
+
+    auto nsPerValue = [&xs](chrono::steady_clock::duration d)
+    {
+        return chrono::duration<double, nano>(d).count() / xs.size();
+    };
+
+    cout << "Detected SIMD level: " << VectorMath::LevelName(VectorMath::DetectedLevel()) << endl;
+    cout << "Values tested: " << xs.size() << endl;
+    cout << "Boost N_cdf (ns/value): " << nsPerValue(tb1 - tb0) << " | Boost N_pdf (ns/value): " << nsPerValue(tb2 - tb1) << endl;
+
+    // Exp over its whole finite range and Log/Sqrt over every binade of the normal doubles, against the std:: functions
+    const size_t mathCount = 1 << 16;
+    vector<double> expArgs(mathCount), logArgs(mathCount), expRef(mathCount), logRef(mathCount), sqrtRef(mathCount);
+    for (size_t i = 0; i < mathCount; ++i)
+    {
+        const double t = (i + 0.5) / mathCount;
+        expArgs[i] = -745.0 + t * (709.78 + 745.0);
+        logArgs[i] = ldexp(1.0 + fmod(i * 0.6180339887498949, 1.0), static_cast<int>(-1022 + t * 2045));
+        expRef[i] = exp(expArgs[i]);
+        logRef[i] = log(logArgs[i]);
+        sqrtRef[i] = sqrt(logArgs[i]);
+    }
+
+    // Compare every level the CPU supports against Boost
+    vector<double> cdfVec(xs.size()), pdfVec(xs.size()), mathVec(mathCount);
+    for (int level = 0; level <= static_cast<int>(VectorMath::DetectedLevel()); ++level)
+    {
+        VectorMath::SetActiveLevel(static_cast<SimdLevel>(level));
+
+        auto tv0 = chrono::steady_clock::now();
+        N_cdf(xs.data(), cdfVec.data(), xs.size());
+        auto tv1 = chrono::steady_clock::now();
+        N_pdf(xs.data(), pdfVec.data(), xs.size());
+        auto tv2 = chrono::steady_clock::now();
+
+        double cdfAbs = 0.0, cdfRel = 0.0, pdfRel = 0.0;
+        for (size_t i = 0; i < xs.size(); ++i)
+        {
+            double dc = fabs(cdfVec[i] - cdfRef[i]);
+            cdfAbs = max(cdfAbs, dc);
+            if (cdfRef[i] >= numeric_limits<double>::min()) cdfRel = max(cdfRel, dc / cdfRef[i]);
+            if (pdfRef[i] >= numeric_limits<double>::min()) pdfRel = max(pdfRel, fabs(pdfVec[i] - pdfRef[i]) / pdfRef[i]);
+        }
+
+        cout << VectorMath::LevelName(VectorMath::ActiveLevel()) << scientific << setprecision(2)
+            << " | cdf max abs err: " << cdfAbs << " | cdf max rel err: " << cdfRel
+            << " | pdf max rel err: " << pdfRel << fixed << setprecision(6)
+            << " | cdf ns/value: " << nsPerValue(tv1 - tv0) << " | pdf ns/value: " << nsPerValue(tv2 - tv1) << endl;
+
+        // Relative errors; Exp results below DBL_MIN are subnormal and only checked through gradual underflow
+        double expRel = 0.0, logRel = 0.0;
+        size_t sqrtMismatches = 0;
+        VectorMath::Exp(expArgs.data(), mathVec.data(), mathCount);
+        for (size_t i = 0; i < mathCount; ++i)
+            if (expRef[i] >= numeric_limits<double>::min()) expRel = max(expRel, fabs(mathVec[i] - expRef[i]) / expRef[i]);
+        VectorMath::Log(logArgs.data(), mathVec.data(), mathCount);
+        for (size_t i = 0; i < mathCount; ++i)
+            if (logRef[i] != 0.0) logRel = max(logRel, fabs(mathVec[i] - logRef[i]) / fabs(logRef[i]));
+        VectorMath::Sqrt(logArgs.data(), mathVec.data(), mathCount);
+        for (size_t i = 0; i < mathCount; ++i)
+            sqrtMismatches += (mathVec[i] != sqrtRef[i]) ? 1 : 0;
+        cout << VectorMath::LevelName(VectorMath::ActiveLevel()) << scientific << setprecision(2)
+            << " | exp max rel err: " << expRel << " | log max rel err: " << logRel << fixed << setprecision(6)
+            << " | sqrt exact: " << (sqrtMismatches == 0 ? "YES" : "NO") << endl;
+    }
+    VectorMath::SetActiveLevel(VectorMath::DetectedLevel());
+    cout << "----------------------------------------\n";
+
+    // ---------------- Implied Volatility ----------------
+    cout << "\nImplied Volatility (batch solver)\n";
+
+    // Round trip on the batch from above: its prices become market quotes, the solver should recover batch.sig
+    vector<double> impliedVols(nBatch);
+    ImpliedVolStats ivStats = ImpliedVolatility::SolveBatch(batch, S_batch.data(), refPrices.data(), impliedVols.data());
+
+    // Where Vega is tiny the quote pins sigma down only loosely, so sigma is compared on quotes with Vega >= 1e-3
+    double maxVolError = 0.0;
+    for (size_t i = 0; i < nBatch; ++i)
+        if (Greeks::Vega(contracts[i], S_batch[i]) >= 1e-3)
+            maxVolError = max(maxVolError, fabs(impliedVols[i] - batch.sig[i]));
+
+    cout << "Quotes: " << ivStats.quotes << " | converged: " << ivStats.converged << " | failed: " << ivStats.failed << endl;
+    cout << "Max |implied - true| sigma (Vega >= 1e-3): " << scientific << maxVolError << fixed << endl;
+    cout << "Mean iterations: " << ivStats.MeanIterations() << " | max: " << ivStats.maxIterations
+        << " | bisection steps: " << ivStats.bisectionSteps << endl;
+    cout << "Throughput (quotes/sec): " << ivStats.QuotesPerSecond() << endl;
+
+    // Hard quotes: deep ITM/OTM strikes and near expiry, where Vega almost vanishes.
+    // For these the price barely depends on sigma, so the check is that repricing at the solved sigma matches the quote.
+    OptionBatch hardBatch;
+    vector<double> hardS;
+    for (double T : { 1.0 / 365.0, 7.0 / 365.0, 0.25, 5.0 })
+        for (double K : { 40.0, 70.0, 100.0, 140.0, 250.0 })
+            for (double sig : { 0.05, 0.3, 1.5 })
+                for (bool call : { true, false })
+                {
+                    hardBatch.Add(T, K, sig, 0.05, 0.02, call);
+                    hardS.push_back(100.0);
+                }
+    vector<double> hardQuotes = BatchPricer::PriceBatch(hardBatch, hardS);
+    vector<double> hardVols(hardBatch.Size());
+    ImpliedVolStats hardStats = ImpliedVolatility::SolveBatch(hardBatch, hardS.data(), hardQuotes.data(), hardVols.data());
+
+    size_t outsideBounds = 0;
+    double maxRepriceError = 0.0;
+    EuropeanOption repricer;
+    for (size_t i = 0; i < hardBatch.Size(); ++i)
+    {
+        if (hardVols[i] != hardVols[i]) { ++outsideBounds; continue; } // quote indistinguishable from intrinsic value
+        repricer.T = hardBatch.T[i]; repricer.K = hardBatch.K[i]; repricer.r = hardBatch.r[i]; repricer.b = hardBatch.b[i];
+        repricer.sig = hardVols[i];
+        repricer.optType = hardBatch.isCall[i] ? "C" : "P";
+        maxRepriceError = max(maxRepriceError, fabs(repricer.Price(hardS[i]) - hardQuotes[i]) / max(hardQuotes[i], 1e-8));
+    }
+
+    cout << "Hard quotes: " << hardStats.quotes << " | solved: " << hardStats.converged
+        << " | at no-arbitrage bound: " << outsideBounds << endl;
+    cout << "Max relative repricing error: " << scientific << maxRepriceError << fixed << endl;
+    cout << "Mean iterations: " << hardStats.MeanIterations() << " | max: " << hardStats.maxIterations
+        << " | bisection steps: " << hardStats.bisectionSteps << endl;
+    cout << "----------------------------------------\n";
+
     cout << "\n----------------------------------------\n";
     cout << "     Option Sensitivities(Greeks)\n";
     cout << "----------------------------------------\n";
@@ -148,12 +693,7 @@ int main()
 
     greekOpt.optType = "P";
     double Z = optE.Price(greekOpt.S);
-    cout << "Put  (computed): " << Z;
-
-    // Print results for this batch
-    cout << "Batch " << i + 1 << endl;
-    cout << "Call (computed): " << C << " | Call (exact): " << b.C_exact << endl;
-    cout << "Put  (computed): " << P << " | Put  (exact): " << b.P_exact << endl;
+    cout << "Put  (computed): " << Z << endl;
 
 
     // ---------------- Exact Delta and Gamma ----------------
@@ -168,6 +708,49 @@ int main()
     cout << "Put Gamma: " << Greeks::Gamma(greekOpt, greekOpt.S) << endl;
     cout << "----------------------------------------\n";
 
+    // ---------------- All Greeks in one pass ----------------
+    cout << "\nAll Greeks in one pass (Greeks::All vs individual functions)\n";
+
+    for (const char* type : { "C", "P" })
+    {
+        greekOpt.optType = type;
+        GreeksResult g = Greeks::All(greekOpt, greekOpt.S);
+
+        double allError = max({ fabs(g.price - greekOpt.Price(greekOpt.S)),
+            fabs(g.delta - Greeks::Delta(greekOpt, greekOpt.S)),
+            fabs(g.gamma - Greeks::Gamma(greekOpt, greekOpt.S)),
+            fabs(g.vega - Greeks::Vega(greekOpt, greekOpt.S)),
+            fabs(g.theta - Greeks::Theta(greekOpt, greekOpt.S)),
+            fabs(g.rho - Greeks::Rho(greekOpt, greekOpt.S)) });
+
+        cout << (greekOpt.optType == "C" ? "Call" : "Put ")
+            << " | Price: " << g.price << " | Delta: " << g.delta << " | Gamma: " << g.gamma
+            << " | Vega: " << g.vega << " | Theta: " << g.theta << " | Rho: " << g.rho
+            << " | Max diff: " << scientific << allError << fixed << endl;
+    }
+
+    // Timing: six separate calls per contract versus one fused call, and the batch version
+    vector<GreeksResult> allGreeks(nBatch);
+    auto ta0 = chrono::steady_clock::now();
+    double sink = 0.0;
+    for (size_t i = 0; i < nBatch; ++i)
+    {
+        const EuropeanOption& c = contracts[i];
+        sink += c.Price(S_batch[i]) + Greeks::Delta(c, S_batch[i]) + Greeks::Gamma(c, S_batch[i])
+            + Greeks::Vega(c, S_batch[i]) + Greeks::Theta(c, S_batch[i]) + Greeks::Rho(c, S_batch[i]);
+    }
+    auto ta1 = chrono::steady_clock::now();
+    for (size_t i = 0; i < nBatch; ++i)
+        allGreeks[i] = Greeks::All(contracts[i], S_batch[i]);
+    auto ta2 = chrono::steady_clock::now();
+    Greeks::AllBatch(batch, S_batch.data(), allGreeks.data());
+    auto ta3 = chrono::steady_clock::now();
+
+    cout << "Separate Price + 5 Greeks (ns/option): " << nsPerOption(ta1 - ta0) << " (checksum " << sink << ")" << endl;
+    cout << "Greeks::All (ns/option):               " << nsPerOption(ta2 - ta1) << endl;
+    cout << "Greeks::AllBatch (ns/option):          " << nsPerOption(ta3 - ta2) << endl;
+    cout << "----------------------------------------\n";
+
     // ---------------- Call Delta vs spot price ----------------
     cout << "\nCall Delta vs Spot Price\n";
 
@@ -272,5 +855,1230 @@ int main()
     }
     cout << "----------------------------------------\n";
 
+    // ---------------- Finite-maturity American options ----------------
+    cout << "\nFinite-maturity American Put on the lattice (T = 1)\n";
+
+    AmericanOption optL("P");
+    optL.T = 1.0; optL.K = 100.0; optL.sig = 0.2; optL.r = 0.06; optL.b = 0.06;
+    optL.method = AmericanMethod::Lattice;
+
+    // Reference from a fine extrapolated Leisen-Reimer tree
+    optL.lattice.type = LatticeType::LeisenReimer;
+    optL.lattice.steps = 20001;
+    double latticeRef = optL.Price(100.0);
+    cout << "Reference price (LR, 20001/40003 steps, extrapolated): " << latticeRef << endl;
+
+    const char* latticeNames[] = { "CRR", "Leisen-Reimer", "Trinomial" };
+    LatticeType latticeTypes[] = { LatticeType::CRR, LatticeType::LeisenReimer, LatticeType::Trinomial };
+    cout << "Tree\t\tSteps\tPlain error\tRichardson error\tRichardson us/price\n";
+    for (int k = 0; k < 3; ++k)
+        for (unsigned steps : { 50u, 200u, 800u })
+        {
+            optL.lattice.type = latticeTypes[k];
+            optL.lattice.steps = steps;
+            optL.lattice.richardson = false;
+            double plain = optL.Price(100.0);
+            optL.lattice.richardson = true;
+            auto tl0 = chrono::steady_clock::now();
+            double extrapolated = optL.Price(100.0);
+            auto tl1 = chrono::steady_clock::now();
+            cout << setw(14) << left << latticeNames[k] << right << "\t" << steps << scientific << setprecision(2)
+                << "\t" << fabs(plain - latticeRef) << "\t" << fabs(extrapolated - latticeRef) << fixed
+                << "\t\t" << chrono::duration<double, micro>(tl1 - tl0).count() << setprecision(6) << endl;
+        }
+
+    // Greeks from the tree; without early exercise they should match the closed-form European Greeks
+    optL.lattice = LatticeSettings();
+    optL.lattice.earlyExercise = false;
+    GreeksResult latticeEuro = optL.LatticeGreeks(100.0);
+    GreeksResult exactEuro = Greeks::All(optL, 100.0);
+    optL.lattice.earlyExercise = true;
+    GreeksResult latticeAmer = optL.LatticeGreeks(100.0);
+
+    cout << "\t\tPrice\t\tDelta\t\tGamma\t\tVega\t\tTheta\t\tRho\n";
+    cout << "European tree\t" << latticeEuro.price << "\t" << latticeEuro.delta << "\t" << latticeEuro.gamma << "\t"
+        << latticeEuro.vega << "\t" << latticeEuro.theta << "\t" << latticeEuro.rho << endl;
+    cout << "European exact\t" << exactEuro.price << "\t" << exactEuro.delta << "\t" << exactEuro.gamma << "\t"
+        << exactEuro.vega << "\t" << exactEuro.theta << "\t" << exactEuro.rho << endl;
+    cout << "American tree\t" << latticeAmer.price << "\t" << latticeAmer.delta << "\t" << latticeAmer.gamma << "\t"
+        << latticeAmer.vega << "\t" << latticeAmer.theta << "\t" << latticeAmer.rho << endl;
+
+    // Batch of American contracts across the pool
+    OptionBatch americanBatch;
+    vector<double> americanSpots;
+    for (int i = 0; i < 2000; ++i)
+    {
+        americanBatch.Add(0.25 + 0.25 * (i % 8), 80.0 + (i % 41), 0.15 + 0.01 * (i % 20), 0.05, 0.03, i % 2 == 0);
+        americanSpots.push_back(100.0);
+    }
+    vector<double> americanPrices(americanBatch.Size());
+    cout << "Batch of " << americanBatch.Size() << " contracts (LR, 201/403 steps):\n";
+    for (unsigned threads : { 1u, ThreadPool::Shared().Workers() + 1 })
+    {
+        ParallelOptions latticeOptions;
+        latticeOptions.threads = threads;
+        auto tb0 = chrono::steady_clock::now();
+        LatticeEngine::PriceBatch(americanBatch, americanSpots.data(), americanPrices.data(), LatticeSettings(), latticeOptions);
+        auto tb1 = chrono::steady_clock::now();
+        cout << "Threads: " << threads << " | contracts/sec: "
+            << americanBatch.Size() / chrono::duration<double>(tb1 - tb0).count() << endl;
+    }
+    cout << "----------------------------------------\n";
+
+    // ---------------- PDE pricing over a spot ladder ----------------
+    cout << "\nCrank-Nicolson PDE over a spot ladder (T = 1 put, S = 50..150)\n";
+
+    // One PDE solve returns the whole curve plus Delta and Gamma at every mesh point
+    EuropeanOption optPde("P");
+    optPde.T = 1.0; optPde.K = 100.0; optPde.sig = 0.2; optPde.r = 0.06; optPde.b = 0.06;
+
+    PdeWorkspace pdeWork;
+    cout << "Spacing\tPoints\tGrid\tPrice err\tDelta err\tGamma err\tPDE us\t\tVector us (price+delta+gamma)\n";
+    for (double spacing : { 0.5, 0.1, 0.025 })
+    {
+        vector<double> ladder = MeshGenerator::Uniform(50, 150, spacing);
+        vector<double> pdePrice(ladder.size()), pdeDelta(ladder.size()), pdeGamma(ladder.size());
+
+        auto tp0 = chrono::steady_clock::now();
+        PdeSolver::Solve(optPde, ladder, PdeSettings(), pdeWork, pdePrice.data(), pdeDelta.data(), pdeGamma.data());
+        auto tp1 = chrono::steady_clock::now();
+        vector<double> exactPrice = MatrixPricer::Vector(optPde, ladder, OutputType::Price);
+        vector<double> exactDelta = MatrixPricer::Vector(optPde, ladder, OutputType::Delta);
+        vector<double> exactGamma = MatrixPricer::Vector(optPde, ladder, OutputType::Gamma);
+        auto tp2 = chrono::steady_clock::now();
+
+        double priceErr = 0.0, deltaErr = 0.0, gammaErr = 0.0;
+        for (size_t i = 0; i < ladder.size(); ++i)
+        {
+            priceErr = max(priceErr, fabs(pdePrice[i] - exactPrice[i]));
+            deltaErr = max(deltaErr, fabs(pdeDelta[i] - exactDelta[i]));
+            gammaErr = max(gammaErr, fabs(pdeGamma[i] - exactGamma[i]));
+        }
+        cout << spacing << "\t" << ladder.size() << "\t" << pdeWork.Grid().size() << scientific << setprecision(2)
+            << "\t" << priceErr << "\t" << deltaErr << "\t" << gammaErr << fixed << setprecision(1)
+            << "\t" << chrono::duration<double, micro>(tp1 - tp0).count()
+            << "\t\t" << chrono::duration<double, micro>(tp2 - tp1).count() << setprecision(6) << endl;
+    }
+
+    // American put: one PDE solve against pricing every ladder point on its own lattice
+    vector<double> ladderA = MeshGenerator::Uniform(50, 150, 0.1);
+    PdeSettings americanPde;
+    americanPde.earlyExercise = true;
+    vector<double> pdeAmerican(ladderA.size());
+    auto tpa0 = chrono::steady_clock::now();
+    PdeSolver::Solve(optPde, ladderA, americanPde, pdeWork, pdeAmerican.data());
+    auto tpa1 = chrono::steady_clock::now();
+
+    AmericanOption optPdeLattice("P");
+    optPdeLattice.T = 1.0; optPdeLattice.K = 100.0; optPdeLattice.sig = 0.2; optPdeLattice.r = 0.06; optPdeLattice.b = 0.06;
+    optPdeLattice.method = AmericanMethod::Lattice;
+    vector<double> latticeAmerican = MatrixPricer::Vector(optPdeLattice, ladderA, OutputType::Price);
+    auto tpa2 = chrono::steady_clock::now();
+
+    double americanDiff = 0.0;
+    for (size_t i = 0; i < ladderA.size(); ++i)
+        americanDiff = max(americanDiff, fabs(pdeAmerican[i] - latticeAmerican[i]));
+    cout << "American put, " << ladderA.size() << " spots: max |PDE - lattice| " << scientific << setprecision(2) << americanDiff
+        << fixed << setprecision(1) << " | PDE (penalty) us: " << chrono::duration<double, micro>(tpa1 - tpa0).count()
+        << " | lattice per point us: " << chrono::duration<double, micro>(tpa2 - tpa1).count() << setprecision(6) << endl;
+
+    // The 201-step lattice is itself least accurate near the exercise boundary; at S = 100 compare with the fine reference
+    size_t atMoney = static_cast<size_t>(lower_bound(ladderA.begin(), ladderA.end(), 100.0 - 1e-9) - ladderA.begin());
+    cout << "American put at S = 100: PDE " << pdeAmerican[atMoney] << " | lattice reference " << latticeRef << endl;
+    cout << "----------------------------------------\n";
+
+    cout << "\n----------------------------------------\n";
+    cout << "         Monte Carlo Pricing\n";
+    cout << "----------------------------------------\n";
+
+    // GBM model taken from an ordinary EuropeanOption; its closed-form price checks the vanilla estimates
+    EuropeanOption optMc("C");
+    optMc.T = 1.0; optMc.K = 100.0; optMc.sig = 0.2; optMc.r = 0.05; optMc.b = 0.03;
+    const double mcSpot = 100.0;
+
+    struct McCase
+    {
+        const char* name;
+        McSampling sampling;
+        bool antithetic;
+        bool control;
+    };
+    const McCase mcCases[] =
+    {
+        { "Pseudo-random          ", McSampling::PseudoRandom, false, false },
+        { "Antithetic             ", McSampling::PseudoRandom, true, false },
+        { "Control variate (BS)   ", McSampling::PseudoRandom, false, true },
+        { "Sobol + Brownian bridge", McSampling::Sobol, false, false },
+        { "Sobol + bridge + CV    ", McSampling::Sobol, false, true }
+    };
+
+    // Vanilla call: the estimate should sit within a few standard errors of Black-Scholes
+    cout << "\nVanilla call, 100000 samples (Black-Scholes " << optMc.Price(mcSpot) << ")\n";
+    VanillaPayoff mcVanilla(optMc.K, true);
+    for (const McCase& c : mcCases)
+    {
+        if (c.control) continue; // the vanilla is its own control, so the estimate would be exact
+        McSettings mcSettings;
+        mcSettings.sampling = c.sampling; mcSettings.antithetic = c.antithetic;
+        McResult res = MonteCarlo::Price(optMc, mcSpot, mcVanilla, mcSettings);
+        cout << c.name << " | price: " << res.price << " | std err: " << scientific << setprecision(2) << res.standardError
+            << fixed << setprecision(6) << " | (MC - BS) / std err: " << (res.price - optMc.Price(mcSpot)) / res.standardError << endl;
+    }
+
+    // Arithmetic Asian call, 12 monthly fixings: no closed form; compare the standard errors
+    cout << "\nArithmetic Asian call, 12 fixings, 100000 samples\n";
+    AsianPayoff mcAsian(optMc.K, true);
+    for (const McCase& c : mcCases)
+    {
+        McSettings mcSettings;
+        mcSettings.steps = 12;
+        mcSettings.sampling = c.sampling; mcSettings.antithetic = c.antithetic; mcSettings.controlVariate = c.control;
+        McResult res = MonteCarlo::Price(optMc, mcSpot, mcAsian, mcSettings);
+        cout << c.name << " | price: " << res.price << " | std err: " << scientific << setprecision(2) << res.standardError
+            << fixed << setprecision(6) << " | paths/sec: " << res.PathsPerSecond() << endl;
+    }
+
+    // Up-and-out call and a three-asset basket
+    McSettings mcExotic;
+    mcExotic.steps = 52;
+    mcExotic.controlVariate = true;
+    BarrierPayoff mcBarrier(optMc.K, 130.0, true, true);
+    McResult barrierRes = MonteCarlo::Price(optMc, mcSpot, mcBarrier, mcExotic);
+    cout << "\nUp-and-out call (barrier 130, weekly monitoring): " << barrierRes.price
+        << " | std err: " << scientific << setprecision(2) << barrierRes.standardError << fixed << setprecision(6) << endl;
+
+    vector<EuropeanOption> basketAssets(3, optMc);
+    basketAssets[1].sig = 0.25; basketAssets[2].sig = 0.3;
+    vector<double> basketSpots = { 100.0, 100.0, 100.0 };
+    vector<vector<double>> basketCorrelation = { { 1.0, 0.5, 0.3 }, { 0.5, 1.0, 0.4 }, { 0.3, 0.4, 1.0 } };
+    BasketPayoff mcBasket({ 1.0 / 3, 1.0 / 3, 1.0 / 3 }, 100.0, true);
+    McSettings mcBasketSettings;
+    mcBasketSettings.sampling = McSampling::Sobol;
+    McResult basketRes = MonteCarlo::PriceBasket(basketAssets, basketSpots, basketCorrelation, mcBasket, mcBasketSettings);
+    cout << "Equally weighted 3-asset basket call (Sobol): " << basketRes.price
+        << " | std err: " << scientific << setprecision(2) << basketRes.standardError << fixed << setprecision(6) << endl;
+
+    // Reproducibility and scaling: the same seed must give bit-identical results for every thread count
+    cout << "\nAsian call, 52 fixings, 400000 samples: threads vs paths/sec\n";
+    McSettings mcScaling;
+    mcScaling.steps = 52;
+    mcScaling.samples = 400000;
+    McResult mcSerial;
+    for (unsigned threads = 1; threads <= ThreadPool::Shared().Workers() + 1; ++threads)
+    {
+        ParallelOptions mcOptions;
+        mcOptions.threads = threads;
+        McResult res = MonteCarlo::Price(optMc, mcSpot, mcAsian, mcScaling, mcOptions);
+        if (threads == 1) mcSerial = res;
+        cout << "Threads: " << threads << " | paths/sec: " << res.PathsPerSecond()
+            << " | identical to 1 thread: " << ((res.price == mcSerial.price && res.standardError == mcSerial.standardError) ? "yes" : "no") << endl;
+    }
+    cout << "----------------------------------------\n";
+
+    // ---------------- Portfolio risk and scenarios ----------------
+    cout << "\nPortfolio risk aggregation and scenario grid\n";
+
+    // 20,000 positions on 5 underlyings drawn from a small set of listed contracts, so many positions share a contract
+    // and the book collapses to far fewer lines. Two perpetual American puts and one lattice put ride along.
+    Portfolio book, europeanBook; // europeanBook holds the European positions alone, for the like-for-like timing
+    const size_t bookSize = 20000;
+    const double bookSpots[] = { 100.0, 50.0, 250.0, 20.0, 80.0 };
+    const double bookMoneyness[] = { 0.8, 0.9, 0.95, 1.0, 1.05, 1.1, 1.25 };
+    const double bookExpiry[] = { 0.1, 0.25, 0.5, 1.0 };
+    const double bookVol[] = { 0.2, 0.3 };
+    for (uint32_t u = 0; u < 5; ++u) { book.SetSpot(u, bookSpots[u]); europeanBook.SetSpot(u, bookSpots[u]); }
+    unsigned bookSeed = 12345;
+    auto nextIndex = [&bookSeed](unsigned n) { bookSeed = bookSeed * 1664525u + 1013904223u; return (bookSeed >> 8) % n; };
+    vector<EuropeanOption> naiveContracts;
+    vector<double> naiveQuantity;
+    vector<uint32_t> naiveUnderlying;
+    naiveContracts.reserve(bookSize);
+    for (size_t i = 0; i < bookSize; ++i)
+    {
+        uint32_t u = nextIndex(5);
+        EuropeanOption opt(nextIndex(2) ? "C" : "P");
+        opt.K = bookSpots[u] * bookMoneyness[nextIndex(7)];
+        opt.T = bookExpiry[nextIndex(4)];
+        opt.sig = bookVol[nextIndex(2)];
+        opt.r = 0.05;
+        opt.b = 0.05;
+        double qty = static_cast<double>(nextIndex(21)) - 10.0;
+        book.Add(opt, qty, u);
+        europeanBook.Add(opt, qty, u);
+        naiveContracts.push_back(opt);
+        naiveQuantity.push_back(qty);
+        naiveUnderlying.push_back(u);
+    }
+    AmericanOption bookPerpetual("P");
+    bookPerpetual.K = 95.0; bookPerpetual.sig = 0.25; bookPerpetual.r = 0.05; bookPerpetual.b = 0.02;
+    book.Add(bookPerpetual, 3.0, 0);
+    book.Add(bookPerpetual, -1.0, 0);
+    AmericanOption bookLattice("P");
+    bookLattice.K = 52.0; bookLattice.T = 0.5; bookLattice.sig = 0.3; bookLattice.r = 0.05; bookLattice.b = 0.05;
+    bookLattice.method = AmericanMethod::Lattice;
+    book.Add(bookLattice, 10.0, 1);
+
+    PortfolioRisk bookRisk = book.Risk();
+
+    // Like for like over the same 20,000 European positions: the grouped Risk() of europeanBook against
+    // Greeks::All on every position one at a time. Best of 5 runs each.
+    PortfolioRisk europeanRisk;
+    double groupedSeconds = 1e300, naiveSeconds = 1e300;
+    vector<BookGreeks> naiveByUnderlying;
+    for (int run = 0; run < 5; ++run)
+    {
+        europeanRisk = europeanBook.Risk();
+        groupedSeconds = min(groupedSeconds, europeanRisk.seconds);
+
+        auto tn0 = chrono::high_resolution_clock::now();
+        naiveByUnderlying.assign(5, BookGreeks());
+        for (size_t i = 0; i < bookSize; ++i)
+        {
+            GreeksResult g = Greeks::All(naiveContracts[i], bookSpots[naiveUnderlying[i]]);
+            BookGreeks& acc = naiveByUnderlying[naiveUnderlying[i]];
+            acc.value += naiveQuantity[i] * g.price;
+            acc.delta += naiveQuantity[i] * g.delta;
+            acc.gamma += naiveQuantity[i] * g.gamma;
+            acc.vega += naiveQuantity[i] * g.vega;
+        }
+        auto tn1 = chrono::high_resolution_clock::now();
+        naiveSeconds = min(naiveSeconds, chrono::duration<double>(tn1 - tn0).count());
+    }
+
+    double naiveValue = 0.0, worstDelta = 0.0;
+    for (uint32_t u = 0; u < 5; ++u)
+    {
+        naiveValue += naiveByUnderlying[u].value;
+        worstDelta = max(worstDelta, fabs(europeanRisk.byUnderlying[u].delta - naiveByUnderlying[u].delta) / max(1.0, fabs(naiveByUnderlying[u].delta)));
+    }
+    // The full book adds the American lines to the European value
+    const double americanValue = 2.0 * bookPerpetual.Price(100.0) + 10.0 * bookLattice.Price(50.0);
+
+    cout << "Positions: " << bookRisk.positions << " | lines evaluated: " << bookRisk.lines << endl;
+    cout << "Book value: " << bookRisk.total.value << " | vega: " << bookRisk.total.vega << " | theta: " << bookRisk.total.theta << endl;
+    for (uint32_t u = 0; u < 5; ++u)
+        cout << "  Underlying " << u << " (S=" << bookSpots[u] << "): value " << bookRisk.byUnderlying[u].value
+            << " | delta " << bookRisk.byUnderlying[u].delta << " | gamma " << bookRisk.byUnderlying[u].gamma << endl;
+    cout << "Risk of the European positions: " << setprecision(3) << groupedSeconds * 1e3 << " ms grouped ("
+        << europeanRisk.lines << " lines) vs " << naiveSeconds * 1e3 << " ms naive (" << bookSize << " positions) | speedup: "
+        << setprecision(1) << naiveSeconds / groupedSeconds << "x" << setprecision(6) << endl;
+    cout << "European value matches naive per-position sum? "
+        << (fabs(europeanRisk.total.value - naiveValue) < 1e-8 * fabs(naiveValue) + 1e-6 ? "YES" : "NO")
+        << " | max relative delta difference: " << scientific << worstDelta << fixed
+        << " | full book = European + American lines? "
+        << (fabs(bookRisk.total.value - naiveValue - americanValue) < 1e-8 * fabs(naiveValue) + 1e-6 ? "YES" : "NO") << endl;
+
+    // Grid of spot moves (every underlying together) and absolute vol shifts
+    vector<double> spotShocks, volShocks;
+    for (int i = -10; i <= 10; ++i) spotShocks.push_back(0.02 * i);
+    for (int j = -2; j <= 2; ++j) volShocks.push_back(0.025 * j);
+    Surface fullPnl, taylorPnl;
+    auto tg0 = chrono::high_resolution_clock::now();
+    book.Scenarios(spotShocks, volShocks, fullPnl, ScenarioMethod::FullRevaluation);
+    auto tg1 = chrono::high_resolution_clock::now();
+    book.Scenarios(spotShocks, volShocks, taylorPnl, ScenarioMethod::Taylor);
+    auto tg2 = chrono::high_resolution_clock::now();
+
+    Surface singlePnl;
+    ParallelOptions oneThread;
+    oneThread.threads = 1;
+    book.Scenarios(spotShocks, volShocks, singlePnl, ScenarioMethod::FullRevaluation, oneThread);
+    bool scenariosIdentical = true;
+    for (size_t i = 0; i < spotShocks.size(); ++i)
+        for (size_t j = 0; j < volShocks.size(); ++j)
+            scenariosIdentical = scenariosIdentical && singlePnl(i, j) == fullPnl(i, j);
+
+    cout << "Scenarios: " << spotShocks.size() << " x " << volShocks.size() << " | full revaluation "
+        << setprecision(3) << chrono::duration<double>(tg1 - tg0).count() * 1e3 << " ms | Taylor "
+        << chrono::duration<double>(tg2 - tg1).count() * 1e3 << " ms" << setprecision(6) << endl;
+    cout << "Spot shock | P&L full | P&L Taylor (vol unchanged)\n";
+    for (size_t i = 0; i < spotShocks.size(); i += 5)
+        cout << setw(9) << spotShocks[i] * 100.0 << "% | " << setw(12) << fullPnl(i, 2) << " | " << setw(12) << taylorPnl(i, 2) << endl;
+    cout << "Zero shock P&L is exactly 0? " << (fullPnl(10, 2) == 0.0 && taylorPnl(10, 2) == 0.0 ? "YES" : "NO")
+        << " | identical with 1 thread? " << (scenariosIdentical ? "YES" : "NO") << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Algorithmic differentiation ----------------
+    cout << "\nGreeks by algorithmic differentiation (adjoint / forward-over-adjoint)\n";
+
+    EuropeanOption adOpt("C");
+    adOpt.K = 105.0; adOpt.T = 0.75; adOpt.sig = 0.25; adOpt.r = 0.04; adOpt.b = 0.01;
+    const double adSpot = 100.0;
+    GreeksResult adExact = Greeks::All(adOpt, adSpot);
+    GreeksResult adGreeks = AlgorithmicGreeks::Greeks(adOpt, adSpot);
+    SecondOrderSensitivities adSecond = AlgorithmicGreeks::Second(adOpt, adSpot);
+
+    double adError = max({ fabs(adGreeks.price - adExact.price), fabs(adGreeks.delta - adExact.delta),
+        fabs(adGreeks.gamma - adExact.gamma), fabs(adGreeks.vega - adExact.vega),
+        fabs(adGreeks.theta - adExact.theta), fabs(adGreeks.rho - adExact.rho) });
+
+    // Closed-form vanna (d2V/dS dsig) and volga (d2V/dsig2) for the second-order check
+    double adSqrtT = sqrt(adOpt.T);
+    double adD1 = (log(adSpot / adOpt.K) + (adOpt.b + 0.5 * adOpt.sig * adOpt.sig) * adOpt.T) / (adOpt.sig * adSqrtT);
+    double adD2 = adD1 - adOpt.sig * adSqrtT;
+    double exactVanna = -exp((adOpt.b - adOpt.r) * adOpt.T) * N_pdf(adD1) * adD2 / adOpt.sig;
+    double exactVolga = adExact.vega * adD1 * adD2 / adOpt.sig;
+
+    cout << "European call: max |AD - closed form| over price and five Greeks: " << scientific << adError << fixed << endl;
+    cout << "Vanna AD: " << adSecond(AdInput::Spot, AdInput::Volatility) << " | exact: " << exactVanna
+        << " | Volga AD: " << adSecond(AdInput::Volatility, AdInput::Volatility) << " | exact: " << exactVolga << endl;
+    cout << "Delta FD (h = 0.01) error: " << scientific << fabs(Greeks::DeltaFD(adOpt, adSpot, 0.01) - adExact.delta)
+        << " | Gamma FD (h = 0.01) error: " << fabs(Greeks::GammaFD(adOpt, adSpot, 0.01) - adExact.gamma)
+        << " | AD Gamma error: " << fabs(adGreeks.gamma - adExact.gamma) << fixed << endl;
+
+    const int adReps = 20000;
+    double adSink = 0.0;
+    auto tad0 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < adReps; ++i) adSink += adOpt.Price(adSpot + 1e-6 * i);
+    auto tad1 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < adReps; ++i) adSink += AlgorithmicGreeks::First(adOpt, adSpot + 1e-6 * i).first[0];
+    auto tad2 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < adReps; ++i) adSink += AlgorithmicGreeks::Greeks(adOpt, adSpot + 1e-6 * i).gamma;
+    auto tad3 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < adReps; ++i)
+    {
+        double s = adSpot + 1e-6 * i;
+        adSink += Greeks::DeltaFD(adOpt, s, 0.01) + Greeks::GammaFD(adOpt, s, 0.01);
+    }
+    auto tad4 = chrono::high_resolution_clock::now();
+    auto perCall = [adReps](chrono::high_resolution_clock::time_point a, chrono::high_resolution_clock::time_point b)
+    { return chrono::duration<double, nano>(b - a).count() / adReps; };
+    cout << setprecision(0) << "Time per call (ns): Price " << perCall(tad0, tad1) << " | adjoint gradient (6 inputs) " << perCall(tad1, tad2)
+        << " | forward-over-adjoint Greeks " << perCall(tad2, tad3) << " | DeltaFD + GammaFD " << perCall(tad3, tad4)
+        << setprecision(6) << (adSink == 0.0 ? " " : "") << endl;
+
+    // Perpetual American put: V = scale * (ratio * S/K)^y2, so Delta = y2 V / S and Gamma = y2 (y2 - 1) V / S^2
+    AmericanOption adPerpetual("P");
+    adPerpetual.K = 100.0; adPerpetual.sig = 0.1; adPerpetual.r = 0.1; adPerpetual.b = 0.02;
+    GreeksResult adPerp = AlgorithmicGreeks::Greeks(adPerpetual, 110.0);
+    double perpSig2 = adPerpetual.sig * adPerpetual.sig;
+    double perpBSig = adPerpetual.b / perpSig2;
+    double perpY2 = 0.5 - perpBSig - sqrt((perpBSig - 0.5) * (perpBSig - 0.5) + 2.0 * adPerpetual.r / perpSig2);
+    double perpV = adPerpetual.Price(110.0);
+    cout << "Perpetual put Delta AD: " << adPerp.delta << " | exact: " << perpY2 * perpV / 110.0
+        << " | Gamma AD: " << adPerp.gamma << " | exact: " << perpY2 * (perpY2 - 1.0) * perpV / (110.0 * 110.0)
+        << " | Vega AD: " << adPerp.vega << endl;
+
+    // American put on the Leisen-Reimer lattice: one adjoint sweep through the roll-back (Gamma from the tree nodes)
+    // versus the bumped lattice Greeks. The adjoint also gives the strike and maturity sensitivities of the tree price.
+    AmericanOption adLattice("P");
+    adLattice.K = 100.0; adLattice.T = 1.0; adLattice.sig = 0.2; adLattice.r = 0.05; adLattice.b = 0.05;
+    adLattice.method = AmericanMethod::Lattice;
+    auto tl0 = chrono::high_resolution_clock::now();
+    GreeksResult latBumped = adLattice.LatticeGreeks(100.0);
+    auto tl1 = chrono::high_resolution_clock::now();
+    GreeksResult latAD = AlgorithmicGreeks::Greeks(adLattice, 100.0);
+    auto tl2 = chrono::high_resolution_clock::now();
+    cout << "Lattice put    price | delta | gamma | vega | rho\n";
+    cout << "  tree/bumped: " << latBumped.price << " | " << latBumped.delta << " | " << latBumped.gamma << " | "
+        << latBumped.vega << " | " << latBumped.rho << " (" << setprecision(2) << chrono::duration<double, milli>(tl1 - tl0).count() << " ms)" << setprecision(6) << endl;
+    cout << "  AD:          " << latAD.price << " | " << latAD.delta << " | " << latAD.gamma << " | "
+        << latAD.vega << " | " << latAD.rho << " (" << setprecision(2) << chrono::duration<double, milli>(tl2 - tl1).count() << " ms)" << setprecision(6) << endl;
+    Sensitivities latFirst = AlgorithmicGreeks::First(adLattice, 100.0);
+    cout << "  AD dV/dK: " << latFirst[AdInput::Strike] << " | dV/dT: " << latFirst[AdInput::Maturity]
+        << " | dV/db: " << latFirst[AdInput::Carry] << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Stencil finite differences ----------------
+    cout << "\nStencil finite-difference Greeks over a spot mesh\n";
+
+    // 9 rows (sigma x maturity grid) over a 161-point mesh with step 0.5: the neighbouring spots give DeltaFD/GammaFD
+    // with h = 0.5, and the neighbouring rows give vega and theta, all from one priced buffer. Vega and theta are
+    // differences over the row grid itself (sigma step 0.05, T step 0.25), so their error is set by that spacing.
+    EuropeanOption stencilOpt("C");
+    vector<double> stencilMesh = MeshGenerator::Uniform(60.0, 140.0, 0.5);
+    vector<vector<double>> stencilRows;
+    for (double T : { 0.5, 0.75, 1.0 })
+        for (double sig : { 0.15, 0.2, 0.25 })
+            stencilRows.push_back({ T, 100.0, sig, 0.05 });
+
+    StencilSurfaces stencil;
+    auto st0 = chrono::high_resolution_clock::now();
+    MatrixPricer::MatrixStencil(stencilOpt, stencilRows, stencilMesh, stencil);
+    auto st1 = chrono::high_resolution_clock::now();
+    vector<vector<double>> bumpDelta = MatrixPricer::Matrix(stencilOpt, stencilRows, stencilMesh, OutputType::DeltaFD, 0.5);
+    vector<vector<double>> bumpGamma = MatrixPricer::Matrix(stencilOpt, stencilRows, stencilMesh, OutputType::GammaFD, 0.5);
+    auto st2 = chrono::high_resolution_clock::now();
+
+    double stencilVsBump = 0.0, stencilErr[4] = { 0.0, 0.0, 0.0, 0.0 };
+    for (size_t i = 0; i < stencilRows.size(); ++i)
+    {
+        EuropeanOption rowOpt("C");
+        rowOpt.T = stencilRows[i][0]; rowOpt.K = stencilRows[i][1]; rowOpt.sig = stencilRows[i][2];
+        rowOpt.r = stencilRows[i][3]; rowOpt.b = rowOpt.r;
+        for (size_t j = 0; j < stencilMesh.size(); ++j)
+        {
+            GreeksResult g = Greeks::All(rowOpt, stencilMesh[j]);
+            stencilVsBump = max({ stencilVsBump, fabs(stencil.delta(i, j) - bumpDelta[i][j]), fabs(stencil.gamma(i, j) - bumpGamma[i][j]) });
+            stencilErr[0] = max(stencilErr[0], fabs(stencil.delta(i, j) - g.delta));
+            stencilErr[1] = max(stencilErr[1], fabs(stencil.gamma(i, j) - g.gamma));
+            stencilErr[2] = max(stencilErr[2], fabs(stencil.vega(i, j) - g.vega));
+            stencilErr[3] = max(stencilErr[3], fabs(stencil.theta(i, j) - g.theta));
+        }
+    }
+    cout << "Pricing calls: " << stencil.pricings << " with stencils vs " << stencil.naivePricings
+        << " bump-and-reprice (" << setprecision(1) << double(stencil.naivePricings) / stencil.pricings << "x fewer)" << setprecision(6) << endl;
+    cout << "Max |stencil - DeltaFD/GammaFD (h = 0.5)|: " << scientific << stencilVsBump << fixed << endl;
+    cout << "Max error vs closed form: delta " << scientific << stencilErr[0] << " | gamma " << stencilErr[1]
+        << " | vega " << stencilErr[2] << " | theta " << stencilErr[3] << fixed << endl;
+    cout << "Time: stencil (5 outputs) " << setprecision(3) << chrono::duration<double, milli>(st1 - st0).count()
+        << " ms | DeltaFD + GammaFD surfaces " << chrono::duration<double, milli>(st2 - st1).count() << " ms" << setprecision(6) << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Precomputed price table ----------------
+    cout << "\nPrecomputed Chebyshev price table\n";
+
+    PriceTable priceTable;
+    auto tp0 = chrono::high_resolution_clock::now();
+    priceTable.Build();
+    auto tp1 = chrono::high_resolution_clock::now();
+    PriceTableValidation tableCheck = priceTable.Validate();
+    const PriceTableErrors& tableEstimates = priceTable.ErrorEstimates();
+    cout << "Build: " << setprecision(1) << chrono::duration<double, milli>(tp1 - tp0).count() << " ms, "
+        << priceTable.Bytes() / 1024 << " KiB, " << priceTable.ExactTiles() << " tiles on the closed form" << setprecision(6) << endl;
+    cout << "Error estimates (per unit discounted strike): price " << scientific << tableEstimates.price << " | dc/dx " << tableEstimates.delta
+        << " | d2c/dx2 " << tableEstimates.gamma << " | dc/dv " << tableEstimates.vega << fixed << endl;
+    cout << "Validation on " << tableCheck.samples << " random points: price " << scientific << tableCheck.priceError
+        << " | dc/dx " << tableCheck.deltaError << " | d2c/dx2 " << tableCheck.gammaError << " | dc/dv " << tableCheck.vegaError
+        << fixed << " | within estimates: " << (tableCheck.withinEstimates ? "YES" : "NO") << endl;
+
+    // The same table prices any strike, rate, carry and maturity; compare on one contract over a spot ladder
+    EuropeanOption tableOpt("P");
+    tableOpt.K = 95.0; tableOpt.T = 0.4; tableOpt.sig = 0.3; tableOpt.r = 0.05; tableOpt.b = 0.02;
+    const OptionInvariants tableInv = tableOpt.ComputeInvariants();
+    double tableErr[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    for (double s = 50.0; s <= 150.0; s += 0.25)
+    {
+        GreeksResult t = priceTable.Greeks(tableInv, s, false);
+        GreeksResult g = Greeks::All(tableOpt, s);
+        tableErr[0] = max(tableErr[0], fabs(t.price - g.price));
+        tableErr[1] = max(tableErr[1], fabs(t.delta - g.delta));
+        tableErr[2] = max(tableErr[2], fabs(t.gamma - g.gamma));
+        tableErr[3] = max(tableErr[3], fabs(t.vega - g.vega));
+        tableErr[4] = max(tableErr[4], fabs(t.theta - g.theta));
+        tableErr[5] = max(tableErr[5], fabs(t.rho - g.rho));
+    }
+    cout << "Put K=95 over S in [50, 150], max error: price " << scientific << tableErr[0] << " | delta " << tableErr[1]
+        << " | gamma " << tableErr[2] << " | vega " << tableErr[3] << " | theta " << tableErr[4] << " | rho " << tableErr[5]
+        << fixed << endl;
+
+    const char* tablePath = "price_table_demo.bin";
+    PriceTable loadedTable;
+    bool tableRoundTrip = priceTable.Save(tablePath) && loadedTable.Load(tablePath)
+        && loadedTable.Price(tableInv, 97.0, false) == priceTable.Price(tableInv, 97.0, false);
+    remove(tablePath);
+    cout << "Save/Load round trip identical: " << (tableRoundTrip ? "YES" : "NO") << endl;
+
+    const int tableReps = 1000000;
+    double tableSink = 0.0;
+    auto tp2 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < tableReps; ++i) tableSink += tableOpt.Reprice(80.0 + 4e-5 * i);
+    auto tp3 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < tableReps; ++i) tableSink += priceTable.Price(tableInv, 80.0 + 4e-5 * i, false);
+    auto tp4 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < tableReps / 10; ++i) tableSink += Greeks::All(tableOpt, 80.0 + 4e-4 * i).gamma;
+    auto tp5 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < tableReps / 10; ++i) tableSink += priceTable.Greeks(tableInv, 80.0 + 4e-4 * i, false).gamma;
+    auto tp6 = chrono::high_resolution_clock::now();
+    auto tableNs = [](chrono::high_resolution_clock::time_point a, chrono::high_resolution_clock::time_point b, int n)
+    { return chrono::duration<double, nano>(b - a).count() / n; };
+    cout << setprecision(1) << "Time per call (ns): exact Reprice " << tableNs(tp2, tp3, tableReps) << " | table price "
+        << tableNs(tp3, tp4, tableReps) << " | exact Greeks::All " << tableNs(tp4, tp5, tableReps / 10) << " | table Greeks "
+        << tableNs(tp5, tp6, tableReps / 10) << setprecision(6) << (tableSink == 0.0 ? " " : "") << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- SVI volatility surface ----------------
+    cout << "\nSVI volatility surface feeding the matrix and batch pricers\n";
+
+    // Quotes generated from known SVI smiles on four expiries (19 strikes each, forwards S exp(bT)), then calibrated
+    const double vsSpot = 100.0, vsRate = 0.03, vsCarry = 0.01;
+    vector<VolQuote> vsQuotes;
+    vector<SviParams> vsTrue;
+    for (double T : { 0.25, 0.5, 1.0, 2.0 })
+    {
+        SviParams p;
+        p.a = 0.02 * T; p.b = 0.08 * sqrt(T); p.rho = -0.6; p.m = 0.02 * T; p.sigma = 0.15 + 0.05 * T;
+        vsTrue.push_back(p);
+        const double F = vsSpot * exp(vsCarry * T);
+        for (double K = 60.0; K <= 150.0; K += 5.0)
+            vsQuotes.push_back({ T, K, F, sqrt(VolSurface::Svi(p, log(K / F)) / T) });
+    }
+
+    VolSurface volSurface;
+    VolCalibrationStats vsStats = volSurface.Calibrate(vsQuotes);
+    double vsParamError = 0.0;
+    for (size_t e = 0; e < volSurface.Slices().size(); ++e)
+    {
+        const SviParams& fit = volSurface.Slices()[e].svi;
+        const SviParams& exact = vsTrue[e];
+        vsParamError = max({ vsParamError, fabs(fit.a - exact.a), fabs(fit.b - exact.b), fabs(fit.rho - exact.rho),
+            fabs(fit.m - exact.m), fabs(fit.sigma - exact.sigma) });
+    }
+    cout << "Calibrated " << vsStats.expiries << " expiries / " << vsStats.quotes << " quotes in " << setprecision(2)
+        << vsStats.seconds * 1e3 << " ms (" << vsStats.iterations << " Nelder-Mead iterations) | max vol RMSE: "
+        << scientific << vsStats.maxRmse << " | max SVI parameter error: " << vsParamError << fixed << setprecision(6) << endl;
+
+    // Between expiries: total variance linear in T at the same forward moneyness
+    const double vsK = 110.0, vsT = 0.75;
+    const double vsK_F = log(vsK / (vsSpot * exp(vsCarry * vsT)));
+    const double vsW = VolSurface::Svi(vsTrue[1], vsK_F) + 0.5 * (VolSurface::Svi(vsTrue[2], vsK_F) - VolSurface::Svi(vsTrue[1], vsK_F));
+    cout << "Vol(K=110, T=0.75): " << volSurface.Vol(vsK, vsT) << " | from the true slices: " << sqrt(vsW / vsT) << endl;
+
+    // Surface vols in place of the per-row sigma: rows (T, K, placeholder sig, r, b) against rows filled by hand
+    EuropeanOption vsOpt("C");
+    vector<double> vsMesh = MeshGenerator::Uniform(80.0, 120.0, 1.0);
+    vector<vector<double>> vsRows, vsRowsManual;
+    for (double T : { 0.3, 0.75, 1.5 })
+        for (double K : { 90.0, 100.0, 110.0 })
+        {
+            vsRows.push_back({ T, K, 0.0, vsRate, vsCarry });
+            vsRowsManual.push_back({ T, K, volSurface.Vol(K, T), vsRate, vsCarry });
+        }
+    Surface vsSurfacePrices;
+    MatrixPricer::MatrixParallel(vsOpt, vsRows, vsMesh, OutputType::Price, volSurface, vsSurfacePrices);
+    vector<vector<double>> vsManualPrices = MatrixPricer::Matrix(vsOpt, vsRowsManual, vsMesh, OutputType::Price);
+    double vsMatrixDiff = 0.0;
+    for (size_t i = 0; i < vsRows.size(); ++i)
+        for (size_t j = 0; j < vsMesh.size(); ++j)
+            vsMatrixDiff = max(vsMatrixDiff, fabs(vsSurfacePrices(i, j) - vsManualPrices[i][j]));
+    cout << "MatrixParallel with the surface vs rows with looked-up sigma, max |diff|: " << scientific << vsMatrixDiff << fixed << endl;
+
+    // Batch: 1M contracts over random strikes and the listed plus intermediate expiries
+    const size_t vsCount = 1000000;
+    OptionBatch vsBatch;
+    vsBatch.Reserve(vsCount);
+    vector<double> vsSpots(vsCount, vsSpot), vsVols(vsCount), vsPriced(vsCount), vsPricedManual(vsCount);
+    unsigned vsSeed = 7;
+    for (size_t i = 0; i < vsCount; ++i)
+    {
+        vsSeed = vsSeed * 1664525u + 1013904223u;
+        const double K = 70.0 + 60.0 * (vsSeed >> 8) / 16777216.0;
+        const double T = 0.1 + 0.1 * (i % 20);
+        vsBatch.Add(T, K, 0.0, vsRate, vsCarry, (i & 1) == 0);
+    }
+    auto tv0 = chrono::high_resolution_clock::now();
+    volSurface.Vol(vsBatch.K.data(), vsBatch.T.data(), vsCount, vsVols.data());
+    auto tv1 = chrono::high_resolution_clock::now();
+    BatchPricer::PriceBatch(vsBatch, volSurface, vsSpots.data(), vsPriced.data());
+    auto tv2 = chrono::high_resolution_clock::now();
+    vsBatch.sig = vsVols;
+    BatchPricer::PriceBatch(vsBatch, vsSpots.data(), vsPricedManual.data());
+    auto tv3 = chrono::high_resolution_clock::now();
+    double vsBatchDiff = 0.0;
+    for (size_t i = 0; i < vsCount; ++i) vsBatchDiff = max(vsBatchDiff, fabs(vsPriced[i] - vsPricedManual[i]));
+    auto vsNs = [vsCount](chrono::high_resolution_clock::time_point a, chrono::high_resolution_clock::time_point b)
+    { return chrono::duration<double, nano>(b - a).count() / vsCount; };
+    cout << "PriceBatch with the surface vs batch sig filled by Vol(K[], T[]), max |diff|: " << scientific << vsBatchDiff << fixed << endl;
+    cout << setprecision(1) << "Time per contract (ns): Vol(K[], T[]) " << vsNs(tv0, tv1) << " | PriceBatch with surface "
+        << vsNs(tv1, tv2) << " | PriceBatch with sig " << vsNs(tv2, tv3) << setprecision(6) << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Rate and carry curves ----------------
+    cout << "\nTerm-structure rate and carry curves\n";
+
+    // Piecewise-flat forward rates and a piecewise-linear carry (dividend yield rising with maturity)
+    RateCurve rateCurve, carryCurve;
+    rateCurve.Set({ 0.5, 1.0, 2.0, 5.0 }, { 0.030, 0.035, 0.040, 0.045 }, CurveInterpolation::PiecewiseFlat);
+    carryCurve.Set({ 0.25, 1.0, 3.0 }, { 0.020, 0.010, 0.000 }, CurveInterpolation::PiecewiseLinear);
+    TermStructure curves(rateCurve, carryCurve);
+
+    EuropeanOption curveOpt("P");
+    curveOpt.K = 100.0; curveOpt.T = 1.5; curveOpt.sig = 0.22;
+    const double curveSpot = 95.0;
+    EuropeanOption zeroRateOpt = curveOpt;
+    zeroRateOpt.r = curves.Rate().ZeroRate(curveOpt.T);
+    zeroRateOpt.b = curves.Carry().ZeroRate(curveOpt.T);
+    cout << "Put T=1.5 on curves: " << curveOpt.Price(curveSpot, curves) << " | flat at the zero rates (r = "
+        << zeroRateOpt.r << ", b = " << zeroRateOpt.b << "): " << zeroRateOpt.Price(curveSpot) << endl;
+
+    // Theta and Rho against bumps of the maturity (curves fixed) and of both curves in parallel
+    GreeksResult curveGreeks = Greeks::All(curveOpt, curveSpot, curves);
+    const double curveH = 1e-5;
+    EuropeanOption curveUp = curveOpt, curveDown = curveOpt;
+    curveUp.T += curveH; curveDown.T -= curveH;
+    const double thetaFD = -(curveUp.Price(curveSpot, curves) - curveDown.Price(curveSpot, curves)) / (2.0 * curveH);
+    auto shifted = [&curves](double shift)
+    {
+        RateCurve rate = curves.Rate(), carry = curves.Carry();
+        vector<double> rf = rate.Forwards(), bf = carry.Forwards();
+        for (double& f : rf) f += shift;
+        for (double& f : bf) f += shift;
+        rate.Set(rate.Times(), rf, rate.Interpolation());
+        carry.Set(carry.Times(), bf, carry.Interpolation());
+        return TermStructure(rate, carry);
+    };
+    const double rhoFD = (curveOpt.Price(curveSpot, shifted(curveH)) - curveOpt.Price(curveSpot, shifted(-curveH))) / (2.0 * curveH);
+    cout << "Theta: " << curveGreeks.theta << " | bumped T: " << thetaFD << " | flat Theta at the zero rates: "
+        << Greeks::Theta(zeroRateOpt, curveSpot) << endl;
+    cout << "Rho: " << curveGreeks.rho << " | parallel curve shift: " << rhoFD << endl;
+
+    // Book of 1M contracts on 12 listed expiries: curve factors per distinct expiry versus per contract
+    const size_t curveCount = 1000000;
+    OptionBatch curveBatch;
+    curveBatch.Reserve(curveCount);
+    vector<double> curveExpiries;
+    for (int e = 1; e <= 12; ++e) curveExpiries.push_back(e / 4.0);
+    unsigned curveSeed = 11;
+    for (size_t i = 0; i < curveCount; ++i)
+    {
+        curveSeed = curveSeed * 1664525u + 1013904223u;
+        curveBatch.Add(curveExpiries[(curveSeed >> 8) % 12], 80.0 + 40.0 * (i % 101) / 100.0, 0.2, 0.0, 0.0, (i & 1) == 0);
+    }
+    vector<double> curveSpots(curveCount, 100.0), curvePrices(curveCount), curvePerContract(curveCount);
+    BatchPricer::PriceBatch(curveBatch, curveSpots.data(), curvePerContract.data()); // warm-up, touches every buffer
+    auto tc0 = chrono::high_resolution_clock::now();
+    BatchPricer::PriceBatch(curveBatch, curves, curveSpots.data(), curvePrices.data());
+    auto tc1 = chrono::high_resolution_clock::now();
+    curves.Rate().ZeroRates(curveBatch.T.data(), curveCount, curveBatch.r.data());
+    curves.Carry().ZeroRates(curveBatch.T.data(), curveCount, curveBatch.b.data());
+    BatchPricer::PriceBatch(curveBatch, curveSpots.data(), curvePerContract.data());
+    auto tc2 = chrono::high_resolution_clock::now();
+    double curveDiff = 0.0;
+    for (size_t i = 0; i < curveCount; ++i) curveDiff = max(curveDiff, fabs(curvePrices[i] - curvePerContract[i]) / max(1.0, curvePrices[i]));
+    cout << "Batch on curves vs zero rates filled per contract, max relative diff: " << scientific << curveDiff << fixed << endl;
+    cout << setprecision(1) << "Time per contract (ns): shared expiry factors " << chrono::duration<double, nano>(tc1 - tc0).count() / curveCount
+        << " | per-contract zero rates and exponentials " << chrono::duration<double, nano>(tc2 - tc1).count() / curveCount
+        << setprecision(6) << endl;
+
+    // Matrix rows (T, K, sig) priced on the curves against rows carrying the zero rates
+    vector<vector<double>> curveRows, curveRowsManual;
+    for (double T : { 0.25, 1.5, 4.0 })
+        for (double K : { 90.0, 110.0 })
+        {
+            curveRows.push_back({ T, K, 0.25, 0.0 });
+            curveRowsManual.push_back({ T, K, 0.25, curves.Rate().ZeroRate(T), curves.Carry().ZeroRate(T) });
+        }
+    curves.Precompute({ 0.25, 1.5, 4.0 });
+    vector<double> curveMesh = MeshGenerator::Uniform(80.0, 120.0, 2.0);
+    Surface curveSurface;
+    MatrixPricer::MatrixParallel(curveOpt, curveRows, curveMesh, OutputType::Price, curves, curveSurface);
+    vector<vector<double>> curveManual = MatrixPricer::Matrix(curveOpt, curveRowsManual, curveMesh, OutputType::Price);
+    double curveMatrixDiff = 0.0;
+    for (size_t i = 0; i < curveRows.size(); ++i)
+        for (size_t j = 0; j < curveMesh.size(); ++j)
+            curveMatrixDiff = max(curveMatrixDiff, fabs(curveSurface(i, j) - curveManual[i][j]));
+    cout << "MatrixParallel on curves (" << curves.CachedMaturities() << " cached maturities) vs rows with zero rates, max |diff|: "
+        << scientific << curveMatrixDiff << fixed << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Closed-form American approximations ----------------
+    cout << "\nFinite-maturity American approximations vs a reference lattice\n";
+
+    // Dividend-paying calls (b < r) and puts across maturities, volatilities and moneyness
+    vector<AmericanOption> aaContracts;
+    for (int call = 0; call < 2; ++call)
+        for (double T : { 0.1, 0.5, 1.0, 3.0 })
+            for (double sig : { 0.15, 0.35 })
+            {
+                AmericanOption o(call ? "C" : "P");
+                o.K = 100.0; o.T = T; o.sig = sig; o.r = 0.06; o.b = call ? -0.02 : 0.02;
+                aaContracts.push_back(o);
+            }
+    // Low volatility, where beta of Bjerksund-Stensland runs into the hundreds: reported in their own column
+    for (int call = 0; call < 2; ++call)
+        for (double sig : { 0.01, 0.02 })
+        {
+            AmericanOption o(call ? "C" : "P");
+            o.K = 100.0; o.T = 1.0; o.sig = sig; o.r = 0.05; o.b = call ? 0.0 : 0.05;
+            aaContracts.push_back(o);
+        }
+    const double aaLowVol = 0.1;
+    const vector<double> aaSpots = { 80.0, 90.0, 100.0, 110.0, 120.0 };
+
+    // Reference: extrapolated Leisen-Reimer tree with 1501/3003 steps
+    vector<double> aaReference;
+    for (AmericanOption o : aaContracts)
+    {
+        o.method = AmericanMethod::Lattice;
+        o.lattice.steps = 1501;
+        for (double S : aaSpots) aaReference.push_back(o.Price(S));
+    }
+
+    struct AaRow { const char* name; AmericanMethod method; unsigned steps; };
+    const AaRow aaRows[] = {
+        { "European (no premium)", AmericanMethod::Perpetual, 0 },
+        { "Barone-Adesi-Whaley", AmericanMethod::BaroneAdesiWhaley, 0 },
+        { "Bjerksund-Stensland", AmericanMethod::BjerksundStensland, 0 },
+        { "Lattice LR 25/51", AmericanMethod::Lattice, 25 },
+        { "Lattice LR 101/203", AmericanMethod::Lattice, 101 },
+        { "Lattice LR 401/803", AmericanMethod::Lattice, 401 } };
+    cout << "Method\t\t\tMax err T<=0.5\tMax err T>=1\tRMS err\t\tLow vol err\tus/price\n";
+    for (const AaRow& row : aaRows)
+    {
+        double shortErr = 0.0, longErr = 0.0, sumSq = 0.0, lowErr = 0.0;
+        size_t index = 0, priced = 0, counted = 0;
+        auto ta0 = chrono::high_resolution_clock::now();
+        for (int repeat = 0; repeat < (row.method == AmericanMethod::Lattice ? 1 : 20); ++repeat)
+        {
+            index = 0;
+            for (AmericanOption o : aaContracts)
+            {
+                o.method = row.method;
+                o.lattice.steps = row.steps;
+                for (double S : aaSpots)
+                {
+                    const double price = (row.method == AmericanMethod::Perpetual) ? EuropeanOption(o).Price(S) : o.Price(S);
+                    const double err = fabs(price - aaReference[index++]);
+                    if (repeat > 0) continue;
+                    if (o.sig < aaLowVol)
+                    {
+                        lowErr = max(lowErr, err != err ? HUGE_VAL : err); // a NaN counts as the worst error
+                        continue;
+                    }
+                    (o.T <= 0.5 ? shortErr : longErr) = max(o.T <= 0.5 ? shortErr : longErr, err);
+                    sumSq += err * err;
+                    ++counted;
+                }
+                priced += aaSpots.size();
+            }
+        }
+        auto ta1 = chrono::high_resolution_clock::now();
+        cout << setw(24) << left << row.name << right << scientific << setprecision(2) << shortErr << "\t" << longErr
+            << "\t" << sqrt(sumSq / counted) << "\t" << lowErr << fixed << setprecision(3) << "\t"
+            << chrono::duration<double, micro>(ta1 - ta0).count() / priced << setprecision(6) << endl;
+    }
+
+    // Strike ladder on one expiry: S*/K does not depend on K, so the ratio carried from the previous strike
+    // leaves Newton's method with nothing to do
+    AmericanOption aaLadder("P");
+    aaLadder.T = 1.0; aaLadder.sig = 0.25; aaLadder.r = 0.06; aaLadder.b = 0.02;
+    const int aaStrikes = 20001;
+    double aaColdSum = 0.0, aaWarmSum = 0.0, aaRatio = 0.0, aaLadderDiff = 0.0;
+    auto tw0 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < aaStrikes; ++i)
+    {
+        aaLadder.K = 60.0 + 80.0 * i / (aaStrikes - 1);
+        aaColdSum += AmericanApproximation::BaroneAdesiWhaley(aaLadder, 100.0);
+    }
+    auto tw1 = chrono::high_resolution_clock::now();
+    for (int i = 0; i < aaStrikes; ++i)
+    {
+        aaLadder.K = 60.0 + 80.0 * i / (aaStrikes - 1);
+        const double warm = AmericanApproximation::BaroneAdesiWhaley(aaLadder, 100.0, &aaRatio);
+        aaWarmSum += warm;
+        if (i % 1000 == 0) aaLadderDiff = max(aaLadderDiff, fabs(warm - AmericanApproximation::BaroneAdesiWhaley(aaLadder, 100.0)));
+    }
+    auto tw2 = chrono::high_resolution_clock::now();
+    cout << "BAW strike ladder (" << aaStrikes << " strikes), ns/price: seeded " << setprecision(1)
+        << chrono::duration<double, nano>(tw1 - tw0).count() / aaStrikes << " | warm-started "
+        << chrono::duration<double, nano>(tw2 - tw1).count() / aaStrikes << setprecision(6)
+        << " | critical price S* = " << aaRatio * aaLadder.K << " at K = " << aaLadder.K
+        << " | max |warm - seeded| " << scientific << aaLadderDiff << fixed << endl;
+
+    // Batch over SoA arrays, ordered by expiry then strike, against one Price() per contract
+    OptionBatch aaBatch;
+    for (double T : { 0.25, 0.5, 1.0, 2.0 })
+        for (int i = 0; i < 50000; ++i)
+            aaBatch.Add(T, 70.0 + 60.0 * (i / 2) / 24999.0, 0.3, 0.05, 0.01, i % 2 == 0);
+    vector<double> aaBatchSpots(aaBatch.Size(), 100.0), aaBatchPrices(aaBatch.Size());
+    for (AmericanMethod method : { AmericanMethod::BaroneAdesiWhaley, AmericanMethod::BjerksundStensland })
+    {
+        auto tq0 = chrono::high_resolution_clock::now();
+        AmericanApproximation::PriceBatch(aaBatch, method, aaBatchSpots.data(), aaBatchPrices.data());
+        auto tq1 = chrono::high_resolution_clock::now();
+        double batchDiff = 0.0;
+        for (size_t i = 0; i < aaBatch.Size(); i += 97)
+        {
+            AmericanOption o(aaBatch.isCall[i] ? "C" : "P");
+            o.T = aaBatch.T[i]; o.K = aaBatch.K[i]; o.sig = aaBatch.sig[i]; o.r = aaBatch.r[i]; o.b = aaBatch.b[i];
+            o.method = method;
+            batchDiff = max(batchDiff, fabs(aaBatchPrices[i] - o.Price(100.0)));
+        }
+        cout << (method == AmericanMethod::BaroneAdesiWhaley ? "BAW" : "BjS") << " batch of " << aaBatch.Size()
+            << " contracts on the pool: " << setprecision(0) << aaBatch.Size() / chrono::duration<double>(tq1 - tq0).count()
+            << " contracts/sec" << setprecision(6) << " | max |batch - Price()| " << scientific << batchDiff << fixed << endl;
+    }
+    cout << "----------------------------------------\n";
+
+    // ---------------- Fourier strike strips ----------------
+    cout << "\nStrike strips from the characteristic function (Carr-Madan FFT and COS)\n";
+
+    // Black-Scholes strip against the closed form
+    EuropeanOption fpOpt("C");
+    fpOpt.T = 1.0; fpOpt.sig = 0.25; fpOpt.r = 0.05; fpOpt.b = 0.02;
+    const double fpSpot = 100.0;
+    vector<double> fpStrikes = MeshGenerator::Uniform(50.0, 150.0, 0.5);
+    FourierSettings fpCos, fpFft;
+    fpFft.method = FourierMethod::CarrMadan;
+    for (const FourierSettings& settings : { fpCos, fpFft })
+    {
+        vector<double> strip = FourierPricer::Strip(fpOpt, fpSpot, fpStrikes, settings);
+        double fpErr = 0.0;
+        EuropeanOption fpCheck = fpOpt;
+        for (size_t i = 0; i < fpStrikes.size(); ++i)
+        {
+            fpCheck.K = fpStrikes[i];
+            fpErr = max(fpErr, fabs(strip[i] - fpCheck.Price(fpSpot)));
+        }
+        cout << (settings.method == FourierMethod::COS ? "COS (256 terms)" : "Carr-Madan (4096-point FFT)") << ", "
+            << fpStrikes.size() << " strikes, max |strip - closed form|: " << scientific << fpErr << fixed << endl;
+    }
+
+    // Time per strike: closed form per (K, S) cell through MatrixPricer::Matrix, the strip with a reused workspace,
+    // and the same COS expansion redone for each strike on its own
+    BlackScholesModel fpModel(fpOpt.sig, fpOpt.b);
+    FourierWorkspace fpWork;
+    cout << "Strikes\tMatrix ns/strike\tCOS strip\tCarr-Madan strip\tCOS per strike\n";
+    for (size_t strikes : { 21, 201, 2001 })
+    {
+        vector<double> K(strikes), fpOut(strikes);
+        vector<vector<double>> fpRows;
+        for (size_t i = 0; i < strikes; ++i)
+        {
+            K[i] = 50.0 + 100.0 * i / (strikes - 1);
+            fpRows.push_back({ fpOpt.T, K[i], fpOpt.sig, fpOpt.r, fpOpt.b });
+        }
+        const int reps = static_cast<int>(200000 / strikes);
+        Surface fpSurface(strikes, 1);
+        const vector<double> fpSpotMesh = { fpSpot };
+
+        auto tf0 = chrono::high_resolution_clock::now();
+        for (int rep = 0; rep < reps; ++rep)
+            MatrixPricer::Matrix(fpOpt, fpRows, fpSpotMesh, OutputType::Price, fpSurface);
+        auto tf1 = chrono::high_resolution_clock::now();
+        for (int rep = 0; rep < reps; ++rep)
+            FourierPricer::Strip(fpModel, fpSpot, fpOpt.T, fpOpt.r, K.data(), strikes, true, fpCos, fpWork, fpOut.data());
+        auto tf2 = chrono::high_resolution_clock::now();
+        for (int rep = 0; rep < reps; ++rep)
+            FourierPricer::Strip(fpModel, fpSpot, fpOpt.T, fpOpt.r, K.data(), strikes, true, fpFft, fpWork, fpOut.data());
+        auto tf3 = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < strikes; ++i)
+            FourierPricer::Strip(fpModel, fpSpot, fpOpt.T, fpOpt.r, &K[i], 1, true, fpCos, fpWork, &fpOut[i]);
+        auto tf4 = chrono::high_resolution_clock::now();
+
+        const double cells = static_cast<double>(reps) * strikes;
+        cout << strikes << setprecision(1) << "\t" << chrono::duration<double, nano>(tf1 - tf0).count() / cells
+            << "\t\t\t" << chrono::duration<double, nano>(tf2 - tf1).count() / cells
+            << "\t\t" << chrono::duration<double, nano>(tf3 - tf2).count() / cells
+            << "\t\t\t" << chrono::duration<double, nano>(tf4 - tf3).count() / strikes << setprecision(6) << endl;
+    }
+
+    // Models without a Black-Scholes closed form through the same engine: Merton against its Poisson series of
+    // Black-Scholes prices, Heston priced both ways
+    const double fpT = 0.5, fpR = 0.05, fpB = 0.03, fpSig = 0.2, fpLambda = 0.8, fpJumpMean = -0.1, fpJumpVol = 0.15;
+    MertonModel fpMerton(fpSig, fpB, fpLambda, fpJumpMean, fpJumpVol);
+    vector<double> fpMertonK = MeshGenerator::Uniform(80.0, 120.0, 1.0);
+    vector<double> fpMertonCos = FourierPricer::Strip(fpMerton, fpSpot, fpT, fpR, fpMertonK, true, fpCos);
+    vector<double> fpMertonFft = FourierPricer::Strip(fpMerton, fpSpot, fpT, fpR, fpMertonK, true, fpFft);
+    const double fpKappa = exp(fpJumpMean + 0.5 * fpJumpVol * fpJumpVol) - 1.0;
+    double fpMertonErr = 0.0, fpMertonFftErr = 0.0;
+    for (size_t i = 0; i < fpMertonK.size(); ++i)
+    {
+        // n jumps: variance sig^2 + n jumpVol^2 / T, carry b - lambda kappa + n ln(1 + kappa) / T, Poisson(lambda T) weight
+        double series = 0.0, weight = exp(-fpLambda * fpT);
+        for (int jumps = 0; jumps < 60; ++jumps)
+        {
+            if (jumps > 0) weight *= fpLambda * fpT / jumps;
+            EuropeanOption fpTerm("C");
+            fpTerm.K = fpMertonK[i]; fpTerm.T = fpT; fpTerm.r = fpR;
+            fpTerm.sig = sqrt(fpSig * fpSig + jumps * fpJumpVol * fpJumpVol / fpT);
+            fpTerm.b = fpB - fpLambda * fpKappa + jumps * log(1.0 + fpKappa) / fpT;
+            series += weight * fpTerm.Price(fpSpot);
+        }
+        fpMertonErr = max(fpMertonErr, fabs(fpMertonCos[i] - series));
+        fpMertonFftErr = max(fpMertonFftErr, fabs(fpMertonFft[i] - series));
+    }
+    cout << "Merton calls, " << fpMertonK.size() << " strikes, max |strip - series|: COS " << scientific << fpMertonErr
+        << " | Carr-Madan " << fpMertonFftErr << fixed << endl;
+
+    HestonModel fpHeston(fpB, 0.04, 1.5, 0.04, 0.5, -0.7);
+    vector<double> fpHestonCos = FourierPricer::Strip(fpHeston, fpSpot, 1.0, fpR, fpMertonK, false, fpCos);
+    vector<double> fpHestonFft = FourierPricer::Strip(fpHeston, fpSpot, 1.0, fpR, fpMertonK, false, fpFft);
+    double fpHestonDiff = 0.0;
+    for (size_t i = 0; i < fpMertonK.size(); ++i)
+        fpHestonDiff = max(fpHestonDiff, fabs(fpHestonCos[i] - fpHestonFft[i]));
+    cout << "Heston puts (T = 1, v0 = theta = 0.04, xi = 0.5, rho = -0.7): ATM " << fpHestonCos[20]
+        << " | max |COS - Carr-Madan| " << scientific << fpHestonDiff << fixed << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Single and mixed precision batches ----------------
+    cout << "\nSingle- and mixed-precision batch pricing against the double path\n";
+
+    // Strikes 50-150% of spot, maturities 0.02-5 years, volatilities 10-80%: the book the documented bounds cover
+    const size_t mxCount = 1 << 18;
+    OptionBatch mxBatch;
+    mxBatch.Reserve(mxCount);
+    vector<double> mxSpots(mxCount);
+    for (size_t i = 0; i < mxCount; ++i)
+    {
+        const double u = static_cast<double>(i);
+        mxSpots[i] = 80.0 + 40.0 * fmod(u * 0.2360679775, 1.0);
+        mxBatch.Add(0.02 + 4.98 * fmod(u * 0.6180339887, 1.0), mxSpots[i] * (0.5 + fmod(u * 0.4142135624, 1.0)),
+            0.10 + 0.70 * fmod(u * 0.7320508076, 1.0), 0.08 * fmod(u * 0.1231056256, 1.0),
+            0.08 * fmod(u * 0.3166247904, 1.0) - 0.04, i % 2 == 0);
+    }
+    OptionBatchF mxBatchF;
+    mxBatchF.Assign(mxBatch);
+    vector<float> mxSpotsF(mxSpots.begin(), mxSpots.end());
+
+    vector<double> mxDouble(mxCount), mxMixed(mxCount), mxDefault(mxCount), mxWide(mxCount);
+    vector<float> mxFloat(mxCount);
+    const int mxReps = 10;
+    auto tm0 = chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < mxReps; ++rep) BatchPricer::PriceBatch(mxBatch, mxSpots.data(), mxDouble.data());
+    auto tm1 = chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < mxReps; ++rep) BatchPricer::PriceBatch(mxBatchF, mxSpotsF.data(), mxFloat.data());
+    auto tm2 = chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < mxReps; ++rep) BatchPricer::PriceBatchMixed(mxBatch, mxSpots.data(), mxMixed.data(), 0.1);
+    auto tm3 = chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < mxReps; ++rep) BatchPricer::PriceBatchMixed(mxBatch, mxSpots.data(), mxDefault.data());
+    auto tm4 = chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < mxReps; ++rep) BatchPricer::PriceBatchMixed(mxBatch, mxSpots.data(), mxWide.data(), 0.5);
+    auto tm5 = chrono::high_resolution_clock::now();
+
+    // Largest error scaled by S + K over the book, and relative to the price among the contracts within band
+    // standard deviations of the forward; the share of the book in the band is what the mixed path reprices
+    auto mxErrors = [&](auto& prices, double band)
+    {
+        double all = 0.0, near = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < mxCount; ++i)
+        {
+            all = max(all, fabs(prices[i] - mxDouble[i]) / (mxSpots[i] + mxBatch.K[i]));
+            const double forward = mxSpots[i] * exp(mxBatch.b[i] * mxBatch.T[i]);
+            if (fabs(log(forward / mxBatch.K[i])) <= band * mxBatch.sig[i] * sqrt(mxBatch.T[i]))
+            {
+                ++count;
+                near = max(near, fabs(prices[i] - mxDouble[i]) / mxDouble[i]);
+            }
+        }
+        return make_tuple(all, near, 100.0 * count / mxCount);
+    };
+    const double mxOps = static_cast<double>(mxReps) * mxCount;
+    cout << mxCount << " contracts\nPath\t\tns/option\tmax |err| / (S + K)\tin band\tmax relative err in band\n";
+    cout << "double\t\t" << setprecision(2) << chrono::duration<double, nano>(tm1 - tm0).count() / mxOps << endl;
+    const tuple<const char*, double, double> mxRows[] = {
+        make_tuple("float (0.25 sd)", chrono::duration<double, nano>(tm2 - tm1).count() / mxOps, 0.25),
+        make_tuple("mixed, 0.1 sd", chrono::duration<double, nano>(tm3 - tm2).count() / mxOps, 0.1),
+        make_tuple("mixed, 0.25 sd", chrono::duration<double, nano>(tm4 - tm3).count() / mxOps, 0.25),
+        make_tuple("mixed, 0.5 sd", chrono::duration<double, nano>(tm5 - tm4).count() / mxOps, 0.5) };
+    const vector<double>* mxMixedResults[] = { &mxMixed, &mxDefault, &mxWide };
+    for (int row = 0; row < 4; ++row)
+    {
+        const double band = get<2>(mxRows[row]);
+        const auto errors = (row == 0) ? mxErrors(mxFloat, band) : mxErrors(*mxMixedResults[row - 1], band);
+        cout << get<0>(mxRows[row]) << "\t" << fixed << get<1>(mxRows[row]) << "\t\t" << scientific << get<0>(errors)
+            << "\t\t" << fixed << setprecision(1) << get<2>(errors) << "%\t" << scientific << setprecision(2)
+            << get<1>(errors) << endl;
+    }
+    cout << fixed << setprecision(6);
+
+    // Greeks in float against the double kernel, each error in the scale of the bound in Greeks.h (X = S + K)
+    vector<GreeksResult> mxGreeks(mxCount);
+    vector<GreeksResultF> mxGreeksF(mxCount);
+    Greeks::AllBatch(mxBatch, mxSpots.data(), mxGreeks.data());
+    Greeks::AllBatch(mxBatchF, mxSpotsF.data(), mxGreeksF.data());
+    double mxG[6] = {};
+    for (size_t i = 0; i < mxCount; ++i)
+    {
+        const GreeksResult& d = mxGreeks[i];
+        const GreeksResultF& f = mxGreeksF[i];
+        const double S = mxSpots[i], X = S + mxBatch.K[i], T = mxBatch.T[i];
+        mxG[0] = max(mxG[0], fabs(f.price - d.price) / X);
+        mxG[1] = max(mxG[1], fabs(f.delta - d.delta));
+        mxG[2] = max(mxG[2], fabs(f.gamma - d.gamma) * S * S / X);
+        mxG[3] = max(mxG[3], fabs(f.vega - d.vega) / (X * sqrt(T)));
+        mxG[4] = max(mxG[4], fabs(f.theta - d.theta) * T / X);
+        mxG[5] = max(mxG[5], fabs(f.rho - d.rho) / (X * T));
+    }
+    cout << "Float Greeks, scaled errors (bounds 2e-7, 4e-6, 1e-4, 2e-6, 1e-7, 2e-6):" << scientific << setprecision(2);
+    for (double e : mxG) cout << " " << e;
+    cout << fixed << setprecision(6) << endl;
+    cout << "----------------------------------------\n";
+
+    // ---------------- Runtime metrics ----------------
+    cout << "\nRuntime metrics of the instrumented hot paths\n";
+    if (!Metrics::Compiled)
+    {
+        cout << "Not compiled in (configure with -DOPTIONPRICING_METRICS=ON); snapshot enabled = "
+            << (Metrics::Snapshot().enabled ? "true" : "false") << endl;
+    }
+    else
+    {
+        // A known amount of work on four threads, each recording into its own block; the blocks of the
+        // finished threads are merged into the snapshot
+        Metrics::Reset();
+        const int mtThreads = 4, mtCalls = 2000, mtVectors = 50;
+        vector<double> mtSums(mtThreads);
+        vector<thread> mtWorkers;
+        for (int t = 0; t < mtThreads; ++t)
+            mtWorkers.emplace_back([t, &mtSums]()
+            {
+                EuropeanOption opt;
+                opt.K = 95.0 + 5.0 * t;
+                vector<double> spots = MeshGenerator::Uniform(60.0, 140.0, 80.0 / 255.0);
+                vector<double> values(spots.size());
+                double sum = 0.0;
+                for (int i = 0; i < mtCalls; ++i)
+                {
+                    sum += opt.Price(80.0 + 0.02 * i);
+                    sum += Greeks::All(opt, 80.0 + 0.02 * i).delta;
+                }
+                for (int i = 0; i < mtVectors; ++i)
+                {
+                    MatrixPricer::Vector(opt, spots.data(), spots.size(), OutputType::Price, values.data());
+                    MatrixPricer::Vector(opt, spots.data(), spots.size(), OutputType::Delta, values.data());
+                }
+                mtSums[t] = sum + values[0];
+            });
+        for (thread& worker : mtWorkers) worker.join();
+
+        EuropeanOption mtOpt;
+        const vector<vector<double>> mtParams = { { 0.5, 100.0, 0.2, 0.05 }, { 1.0, 100.0, 0.25, 0.05 } };
+        const vector<double> mtSpots = { 90.0, 100.0, 110.0 };
+        MatrixPricer::Matrix(mtOpt, mtParams, mtSpots, OutputType::Gamma);
+
+        const MetricsSnapshot mt = Metrics::Snapshot();
+        cout << "Timestamp counter: " << setprecision(3) << mt.ticksPerNs << " ticks/ns, " << mt.threads
+            << " threads recorded\nSite\t\t\tcalls\telements\tns/call\n";
+        for (size_t s = 0; s < MetricSiteCount; ++s)
+        {
+            if (mt.sites[s].calls == 0) continue;
+            const string name = Metrics::SiteName(static_cast<MetricSite>(s));
+            cout << name << (name.size() < 16 ? "\t\t" : "\t") << mt.sites[s].calls << "\t" << mt.sites[s].elements
+                << "\t\t" << setprecision(1) << mt.sites[s].ns / mt.sites[s].calls << endl;
+        }
+        const MetricsSnapshot::Latency& mtPrice = mt.latency[0][static_cast<size_t>(OutputType::Price)];
+        cout << "Vector/Price latency: p50 " << mtPrice.p50Ns << " ns, p99 " << mtPrice.p99Ns << " ns, max "
+            << mtPrice.maxNs << " ns over " << mtPrice.count << " calls\n";
+
+        const auto mtCount = [&](MetricSite site) { return mt.sites[static_cast<size_t>(site)].calls; };
+        const bool mtExact = mtCount(MetricSite::All) == static_cast<uint64_t>(mtThreads * mtCalls)
+            && mtCount(MetricSite::Vector) == static_cast<uint64_t>(2 * mtThreads * mtVectors)
+            && mtCount(MetricSite::Matrix) == 1 && mtCount(MetricSite::EuropeanPrice) >= static_cast<uint64_t>(mtThreads * mtCalls)
+            && mt.sites[static_cast<size_t>(MetricSite::Matrix)].elements == 6;
+        cout << "Counts match the work done: " << (mtExact ? "yes" : "NO") << endl;
+
+        // Prometheus text written atomically to a file a node exporter would pick up, then read back
+        const string mtPath = "metrics_demo.prom";
+        string mtError;
+        if (!Metrics::Write(mtPath, MetricsFormat::Prometheus, mtError))
+            cout << "Write failed: " << mtError << endl;
+        else
+        {
+            ifstream mtIn(mtPath);
+            string mtLine;
+            int mtShown = 0;
+            size_t mtLines = 0;
+            while (getline(mtIn, mtLine))
+            {
+                ++mtLines;
+                if (mtLine.find("Greeks::All\"") != string::npos && mtShown++ < 2) cout << "  " << mtLine << endl;
+            }
+            cout << mtLines << " lines in " << mtPath << endl;
+            mtIn.close();
+            remove(mtPath.c_str());
+        }
+        cout << "JSON snapshot: " << mt.Json().size() << " bytes\n";
+        if (!Metrics::Send("/nonexistent/pricing.sock", MetricsFormat::Json, mtError))
+            cout << "Send to a missing socket: " << mtError << endl;
+        cout << fixed << setprecision(6);
+    }
+    cout << "----------------------------------------\n";
+
+    // ---------------- Tick-driven repricing ----------------
+    cout << "\nTick-driven repricing engine (replayed feed)\n";
+
+    // Three underlyings: a call and a put on each, a perpetual American put on the first and a finite-maturity
+    // American put (51-step lattice) on the second. The lattice Greeks take tens of microseconds, far longer than the
+    // 2-microsecond tick spacing, so most ticks are coalesced and every repricing uses the newest spot.
+    const char* replayPath = "ticks_demo.csv";
+    const size_t replayCount = 100000;
+    TickReplay::WriteSample(replayPath, replayCount, 3, 2000);
+
+    vector<ReplayTick> replay;
+    string replayError;
+    if (!TickReplay::Load(replayPath, replay, replayError)) cout << replayError << endl;
+    remove(replayPath);
+
+    TickEngine tickEngine;
+    vector<EuropeanOption> tickContracts;
+    vector<uint32_t> tickUnderlying;
+    for (uint32_t u = 0; u < 3; ++u)
+        for (const char* type : { "C", "P" })
+        {
+            EuropeanOption o(type);
+            o.K = 100.0 + 10.0 * u; o.T = 0.5; o.sig = 0.2 + 0.05 * u; o.r = 0.03; o.b = 0.01;
+            tickEngine.Subscribe(o, u);
+            tickContracts.push_back(o);
+            tickUnderlying.push_back(u);
+        }
+    AmericanOption tickPerpetual("P");
+    tickPerpetual.K = 100.0; tickPerpetual.sig = 0.2; tickPerpetual.r = 0.03; tickPerpetual.b = 0.01;
+    size_t perpetualSub = tickEngine.Subscribe(tickPerpetual, 0);
+    AmericanOption tickLattice("P");
+    tickLattice.K = 110.0; tickLattice.T = 0.5; tickLattice.sig = 0.25; tickLattice.r = 0.03; tickLattice.b = 0.01;
+    tickLattice.method = AmericanMethod::Lattice;
+    tickLattice.lattice.steps = 51;
+    size_t latticeSub = tickEngine.Subscribe(tickLattice, 1);
+
+    // A consumer that keeps up and one that reads in bursts through a small ring, so its updates get coalesced
+    size_t fastConsumer = tickEngine.AddConsumer(1 << 14);
+    size_t slowConsumer = tickEngine.AddConsumer(16);
+    atomic<bool> feedDone(false);
+    vector<uint64_t> fastLastSequence(tickEngine.Subscriptions(), 0);
+    size_t fastReceived = 0, slowReceived = 0;
+
+    tickEngine.Start();
+    thread fastThread([&]
+    {
+        PriceUpdate up;
+        for (;;)
+        {
+            bool done = feedDone.load();
+            bool any = false;
+            while (tickEngine.Poll(fastConsumer, up)) { fastLastSequence[up.subscription] = up.sequence; ++fastReceived; any = true; }
+            if (done && !any) break;
+            if (!any) this_thread::yield();
+        }
+    });
+    thread slowThread([&]
+    {
+        PriceUpdate up;
+        while (!feedDone.load())
+        {
+            while (tickEngine.Poll(slowConsumer, up)) ++slowReceived;
+            this_thread::sleep_for(chrono::milliseconds(2));
+        }
+        while (tickEngine.Poll(slowConsumer, up)) ++slowReceived;
+    });
+
+    auto tr0 = chrono::steady_clock::now();
+    size_t replayed = TickReplay::Play(tickEngine, replay, 1.0); // recorded spacing: one tick every 2 microseconds
+    auto tr1 = chrono::steady_clock::now();
+    tickEngine.Stop();      // prices whatever is still queued
+    feedDone.store(true);
+    fastThread.join();
+    slowThread.join();
+
+    TickEngineStats tickStats = tickEngine.Stats();
+    const LatencyHistogram& tickLatency = tickEngine.TickToPrice();
+    cout << "Ticks replayed: " << replayed << " in " << setprecision(3) << chrono::duration<double>(tr1 - tr0).count() << " s"
+        << " | coalesced: " << tickStats.ticksCoalesced << " | repricings: " << tickStats.repricings << endl;
+    cout << "Updates to fast consumer: " << fastReceived << " | to slow consumer: " << slowReceived
+        << " | coalesced for slow consumer: " << tickStats.updatesCoalesced << endl;
+    cout << "Tick-to-price latency (us): p50 " << tickLatency.Percentile(0.5) / 1e3 << " | p99 " << tickLatency.Percentile(0.99) / 1e3
+        << " | p99.9 " << tickLatency.Percentile(0.999) / 1e3 << " | max " << tickLatency.Max() / 1e3 << setprecision(6) << endl;
+
+    // The newest published values must be the prices at each underlying's last replayed spot,
+    // and the fast consumer must have received every subscription's final update
+    vector<double> lastSpot(3, 0.0);
+    for (const ReplayTick& t : replay) lastSpot[t.underlying] = t.spot;
+    double maxTickError = 0.0;
+    bool finalDelivered = true;
+    for (size_t k = 0; k < tickEngine.Subscriptions(); ++k)
+    {
+        PriceUpdate latest;
+        if (!tickEngine.Latest(k, latest)) { finalDelivered = false; continue; }
+        double expected = (k == perpetualSub) ? tickPerpetual.Price(lastSpot[0])
+            : (k == latticeSub) ? tickLattice.Price(lastSpot[1])
+            : tickContracts[k].Price(lastSpot[tickUnderlying[k]]);
+        maxTickError = max(maxTickError, fabs(latest.values.price - expected));
+        finalDelivered = finalDelivered && (fastLastSequence[k] == latest.sequence);
+    }
+    cout << "Max |latest price - Price(last spot)|: " << scientific << maxTickError << fixed
+        << " | fast consumer has every final update? " << (finalDelivered ? "YES" : "NO") << endl;
+    cout << "----------------------------------------\n";
+
     return 0;
 }
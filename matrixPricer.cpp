@@ -1,39 +1,166 @@
 // Implements vectorized and matrix-based option pricing and Greek computations
 
 #include "MatrixPricer.h"
+#include "Metrics.h"
+#include "SurfaceFile.h"
+#include "PricingKernels.h"
+#include "VolSurface.h"
+#include "RateCurve.h"
+#include <array>
+#include <atomic>
+#include <map>
 #include <vector>
+#include <memory>
+
+namespace
+{
+    // Three-point weights (below, centre, above) for a derivative at x0 from values at x0 - hm, x0 and x0 + hp.
+    // With hm == hp they are the usual central differences: (-1, 0, 1) / 2h and (1, -2, 1) / h^2.
+    struct Stencil3
+    {
+        double below, centre, above;
+
+        double Apply(double fBelow, double fCentre, double fAbove) const
+        {
+            return below * fBelow + centre * fCentre + above * fAbove;
+        }
+    };
+
+    Stencil3 FirstDerivative(double hm, double hp)
+    {
+        Stencil3 s = { -hp / (hm * (hm + hp)), (hp - hm) / (hm * hp), hm / (hp * (hm + hp)) };
+        return s;
+    }
+
+    Stencil3 SecondDerivative(double hm, double hp)
+    {
+        Stencil3 s = { 2.0 / (hm * (hm + hp)), -2.0 / (hm * hp), 2.0 / (hp * (hm + hp)) };
+        return s;
+    }
+
+    // Private copies of the option for the tasks of one parallel call. A task claims a free copy, cloning it on first
+    // use, and hands it back when done, so the call clones once per thread that takes part instead of once per task.
+    // A task that finds every copy taken (more tasks in flight than threads, possible when a worker runs another task
+    // while blocked in a nested ParallelFor) works on a clone of its own.
+    class OptionCopies
+    {
+    public:
+        OptionCopies(const EuropeanOption& opt, const ThreadPool& pool, unsigned threads)
+            : opt(opt), slots((threads == 0 || threads - 1 > pool.Workers()) ? pool.Workers() + 1 : threads)
+        {
+        }
+
+        template<class Body>
+        void With(Body&& body)
+        {
+            for (Slot& slot : slots)
+            {
+                if (slot.busy.exchange(true, std::memory_order_acquire)) continue;
+                if (!slot.copy) slot.copy = opt.Clone();
+                body(*slot.copy);
+                slot.busy.store(false, std::memory_order_release);
+                return;
+            }
+            std::unique_ptr<EuropeanOption> own = opt.Clone();
+            body(*own);
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<bool> busy{ false };
+            std::unique_ptr<EuropeanOption> copy;
+        };
+
+        const EuropeanOption& opt;
+        std::vector<Slot> slots;
+    };
+
+    // Resolved row parameters in paramMatrix order: T, K, sig, r, b
+    typedef std::array<double, 5> RowParams;
+    const std::size_t RowT = 0;
+    const std::size_t RowSig = 2;
+
+    // Distinct rows to be priced over the extended mesh; equal rows (including bumped rows that coincide with a row of
+    // paramMatrix) share one price buffer
+    struct RowSet
+    {
+        std::map<RowParams, std::size_t> index;
+        std::vector<RowParams> rows;
+
+        std::size_t Add(const RowParams& p)
+        {
+            auto it = index.find(p);
+            if (it != index.end()) return it->second;
+            index.emplace(p, rows.size());
+            rows.push_back(p);
+            return rows.size() - 1;
+        }
+    };
+
+    // Rows priced at x0 - hm and x0 + hp along one parameter
+    struct Neighbours
+    {
+        std::size_t below, above;
+        double hm, hp;
+    };
+
+    // Nearest rows of the original set that differ from row i only in parameter k, one on each side.
+    // A missing side mirrors the other (or uses bump when there is neither), staying above zero for sigma and T.
+    Neighbours FindNeighbours(const std::vector<RowParams>& original, std::size_t i, std::size_t k, double bump, RowSet& set)
+    {
+        const RowParams& p = original[i];
+        const double x0 = p[k];
+        bool hasBelow = false, hasAbove = false;
+        double below = 0.0, above = 0.0;
+
+        for (const RowParams& q : original)
+        {
+            bool same = true;
+            for (std::size_t m = 0; m < q.size() && same; ++m)
+                same = (m == k) || q[m] == p[m];
+            if (!same) continue;
+
+            if (q[k] < x0 && (!hasBelow || q[k] > below)) { below = q[k]; hasBelow = true; }
+            if (q[k] > x0 && (!hasAbove || q[k] < above)) { above = q[k]; hasAbove = true; }
+        }
+
+        if (!hasAbove) above = x0 + (hasBelow ? x0 - below : bump);
+        if (!hasBelow)
+        {
+            below = x0 - (above - x0);
+            if (below <= 0.0) below = 0.5 * x0;
+        }
+
+        RowParams pb = p, pa = p;
+        pb[k] = below;
+        pa[k] = above;
+
+        Neighbours n;
+        n.below = set.Add(pb);
+        n.above = set.Add(pa);
+        n.hm = x0 - below;
+        n.hp = above - x0;
+        return n;
+    }
+}
 
 // Computes a vector of outputs (price or Greek) across a range of spot prices
-// using a simple range-based for loop over S values 
 
 std::vector<double> MatrixPricer::Vector(EuropeanOption& opt,
     const std::vector<double>& S_values,
     OutputType output,
     double h)
 {
-    std::vector<double> result; // Will store the computed vector
-    result.reserve(S_values.size()); 
-
-    for (double S : S_values)
-    {
-        switch (output)
-        {
-        case OutputType::Price:     result.push_back(opt.Price(S)); break;      // Exact option price
-        case OutputType::Delta:     result.push_back(Greeks::Delta(opt, S)); break; // Exact Delta
-        case OutputType::Gamma:     result.push_back(Greeks::Gamma(opt, S)); break; // Exact Gamma
-        case OutputType::Vega:      result.push_back(Greeks::Vega(opt, S)); break;  // Exact Vega
-        case OutputType::Theta:     result.push_back(Greeks::Theta(opt, S)); break; // Exact Theta
-        case OutputType::Rho:       result.push_back(Greeks::Rho(opt, S)); break;   // Exact Rho
-        case OutputType::DeltaFD:   result.push_back(Greeks::DeltaFD(opt, S, h)); break; // Numerical Delta
-        case OutputType::GammaFD:   result.push_back(Greeks::GammaFD(opt, S, h)); break; // Numerical Gamma
-        }
-    }
+    PRICING_METRICS_SCOPE_OUTPUT(Vector, output, S_values.size());
 
+    std::vector<double> result(S_values.size()); // Will store the computed vector
+    Fill(opt, S_values.data(), S_values.size(), output, result.data(), 1, h);
     return result; // Return the full vector
 }
 
 // Computes a surface of outputs for multiple sets of option parameters and spot prices.
-// Outer loop iterates over parameter sets; inner computation uses Vector() over S values.
+// Outer loop iterates over parameter sets; inner computation fills one row over the S values.
 // This produces a vector-of-vectors (surface) representing Price/Greek vs Spot Price and Parameter Sweep
 
 std::vector<std::vector<double>> MatrixPricer::Matrix(EuropeanOption& opt,
@@ -42,21 +169,478 @@ std::vector<std::vector<double>> MatrixPricer::Matrix(EuropeanOption& opt,
     OutputType output,
     double h)
 {
+    PRICING_METRICS_SCOPE_OUTPUT(Matrix, output, paramMatrix.size() * S_values.size());
+
     std::vector<std::vector<double>> surface;
     surface.reserve(paramMatrix.size());
 
     for (const auto& p : paramMatrix)
     {
         // Map paramMatrix row to option object
-        opt.T = p[0];              // Maturity
-        opt.K = p[1];              // Strike
-        opt.sig = p[2];            // Volatility
-        opt.r = p[3];              // Risk-free rate
-        opt.b = (p.size() > 4 ? p[4] : opt.r); // Cost-of-carry, default to r if not provided
+        ApplyParams(opt, p);
 
-        // Use the Vector method to compute values for this parameter set
-        surface.push_back(Vector(opt, S_values, output, h));
+        // Same values as Vector() for this parameter set, without counting each row as a Vector call
+        std::vector<double> row(S_values.size());
+        Fill(opt, S_values.data(), S_values.size(), output, row.data(), 1, h);
+        surface.push_back(std::move(row));
     }
 
     return surface; // Return the full surface
 }
+
+// Computes every exact Greek plus the price at each spot price in one pass per point
+std::vector<GreeksResult> MatrixPricer::VectorAll(const EuropeanOption& opt,
+    const std::vector<double>& S_values)
+{
+    std::vector<GreeksResult> result;
+    result.reserve(S_values.size());
+
+    for (double S : S_values)
+        result.push_back(Greeks::All(opt, S));
+
+    return result;
+}
+
+// Surface of all Greeks: same parameter mapping as Matrix(), with VectorAll() as the inner computation
+std::vector<std::vector<GreeksResult>> MatrixPricer::MatrixAll(EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values)
+{
+    std::vector<std::vector<GreeksResult>> surface;
+    surface.reserve(paramMatrix.size());
+
+    for (const auto& p : paramMatrix)
+    {
+        ApplyParams(opt, p);
+        surface.push_back(VectorAll(opt, S_values));
+    }
+
+    return surface;
+}
+
+std::vector<std::vector<double>> MatrixPricer::MatrixParallel(const EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    double h,
+    const ParallelOptions& options)
+{
+    Surface flat;
+    MatrixParallel(opt, paramMatrix, S_values, output, flat, h, options);
+
+    std::vector<std::vector<double>> surface;
+    surface.reserve(flat.Rows());
+    for (std::size_t i = 0; i < flat.Rows(); ++i)
+        surface.emplace_back(flat.Data() + i * flat.Cols(), flat.Data() + (i + 1) * flat.Cols());
+    return surface;
+}
+
+// Writes one output per spot into the caller's buffer; no allocation
+void MatrixPricer::Vector(const EuropeanOption& opt,
+    const double* S_values, std::size_t n,
+    OutputType output,
+    double* out,
+    double h)
+{
+    PRICING_METRICS_SCOPE_OUTPUT(Vector, output, n);
+    Fill(opt, S_values, n, output, out, 1, h);
+}
+
+// Serial surface into a caller-owned buffer, in either layout
+void MatrixPricer::Matrix(EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    double* out,
+    SurfaceLayout layout,
+    double h)
+{
+    const std::size_t rows = paramMatrix.size();
+    const std::size_t nS = S_values.size();
+    PRICING_METRICS_SCOPE_OUTPUT(Matrix, output, rows * nS);
+    if (layout == SurfaceLayout::RowMajor)
+        MatrixStrided(opt, paramMatrix, S_values, output, out, nS, 1, h);
+    else
+        MatrixStrided(opt, paramMatrix, S_values, output, out, 1, rows, h);
+}
+
+// Each parameter row is one Fill() over the spots, written with a stride of colStride
+void MatrixPricer::MatrixStrided(EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    double* out, std::size_t rowStride, std::size_t colStride,
+    double h,
+    const TermFactors* rowFactors)
+{
+    const std::size_t rows = paramMatrix.size();
+    const std::size_t nS = S_values.size();
+
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        const TermFactors* factors = rowFactors ? rowFactors + i : nullptr;
+        ApplyParams(opt, paramMatrix[i], factors);
+
+        Fill(opt, S_values.data(), nS, output, out + i * rowStride, colStride, h, factors);
+    }
+}
+
+void MatrixPricer::Matrix(EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    Surface& out,
+    double h)
+{
+    out.Resize(paramMatrix.size(), S_values.size());
+    Matrix(opt, paramMatrix, S_values, output, out.Data(), out.Layout(), h);
+}
+
+// Tiles are numbered row by row: tile t covers parameter row t / blocksPerRow and spot block t % blocksPerRow.
+// Each task clones the option once and re-applies the row parameters per tile, so workers never share mutable state,
+// and every value goes through the same Fill() as the serial path.
+void MatrixPricer::MatrixParallel(const EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    double* out,
+    SurfaceLayout layout,
+    double h,
+    const ParallelOptions& options)
+{
+    const std::size_t rows = paramMatrix.size();
+    const std::size_t nS = S_values.size();
+    if (layout == SurfaceLayout::RowMajor)
+        MatrixParallelStrided(opt, paramMatrix, S_values, output, out, nS, 1, h, options);
+    else
+        MatrixParallelStrided(opt, paramMatrix, S_values, output, out, 1, rows, h, options);
+}
+
+void MatrixPricer::MatrixParallelStrided(const EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    double* out, std::size_t rowStride, std::size_t colStride,
+    double h,
+    const ParallelOptions& options,
+    const TermFactors* rowFactors)
+{
+    const std::size_t rows = paramMatrix.size();
+    const std::size_t nS = S_values.size();
+    if (rows == 0 || nS == 0) return;
+
+    const std::size_t grain = (options.grain > 0) ? options.grain : 256;
+    const std::size_t blocksPerRow = (nS + grain - 1) / grain;
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+
+    OptionCopies copies(opt, pool, options.threads);
+
+    pool.ParallelFor(rows * blocksPerRow, 1, [&](std::size_t begin, std::size_t end)
+    {
+        copies.With([&](EuropeanOption& local)
+        {
+            for (std::size_t t = begin; t < end; ++t)
+            {
+                std::size_t row = t / blocksPerRow;
+                std::size_t j0 = (t % blocksPerRow) * grain;
+                std::size_t j1 = (j0 + grain < nS) ? j0 + grain : nS;
+
+                const TermFactors* factors = rowFactors ? rowFactors + row : nullptr;
+                ApplyParams(local, paramMatrix[row], factors);
+
+                Fill(local, S_values.data() + j0, j1 - j0, output, out + row * rowStride + j0 * colStride, colStride,
+                    h, factors);
+            }
+        });
+    }, options.threads);
+}
+
+void MatrixPricer::MatrixParallel(const EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    Surface& out,
+    double h,
+    const ParallelOptions& options)
+{
+    out.Resize(paramMatrix.size(), S_values.size());
+    MatrixParallel(opt, paramMatrix, S_values, output, out.Data(), out.Layout(), h, options);
+}
+
+bool MatrixPricer::Matches(const SurfaceFile& out, std::size_t rows, std::size_t cols, OutputType output)
+{
+    return out.IsOpen() && out.Writable() && out.Rows() == rows && out.Cols() == cols && out.Output() == output;
+}
+
+// The file's strides already include the 64-byte block padding, so the strided loops write the mapping in place
+bool MatrixPricer::Matrix(EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    SurfaceFile& out,
+    double h)
+{
+    if (!Matches(out, paramMatrix.size(), S_values.size(), output)) return false;
+    PRICING_METRICS_SCOPE_OUTPUT(Matrix, output, paramMatrix.size() * S_values.size());
+    MatrixStrided(opt, paramMatrix, S_values, output, out.Data(), out.RowStride(), out.ColStride(), h);
+    return true;
+}
+
+bool MatrixPricer::MatrixParallel(const EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    SurfaceFile& out,
+    double h,
+    const ParallelOptions& options)
+{
+    if (!Matches(out, paramMatrix.size(), S_values.size(), output)) return false;
+    MatrixParallelStrided(opt, paramMatrix, S_values, output, out.Data(), out.RowStride(), out.ColStride(), h, options);
+    return true;
+}
+
+void MatrixPricer::Fill(const EuropeanOption& opt, const double* S, std::size_t n, OutputType output,
+    double* out, std::size_t stride, double h, const TermFactors* factors)
+{
+    if (PricingKernels::Supports(opt, output))
+    {
+        PricingKernels::Vector(opt, S, n, output, out, stride, h, factors);
+        return;
+    }
+
+    for (std::size_t j = 0; j < n; ++j)
+        out[j * stride] = Evaluate(opt, S[j], output, h);
+}
+
+double MatrixPricer::Evaluate(const EuropeanOption& opt, double S, OutputType output, double h)
+{
+    switch (output)
+    {
+    case OutputType::Price:     return opt.Price(S);               // Exact option price
+    case OutputType::Delta:     return Greeks::Delta(opt, S);      // Exact Delta
+    case OutputType::Gamma:     return Greeks::Gamma(opt, S);      // Exact Gamma
+    case OutputType::Vega:      return Greeks::Vega(opt, S);       // Exact Vega
+    case OutputType::Theta:     return Greeks::Theta(opt, S);      // Exact Theta
+    case OutputType::Rho:       return Greeks::Rho(opt, S);        // Exact Rho
+    case OutputType::DeltaFD:   return Greeks::DeltaFD(opt, S, h); // Numerical Delta
+    case OutputType::GammaFD:   return Greeks::GammaFD(opt, S, h); // Numerical Gamma
+    }
+    return 0.0;
+}
+
+// Pricing work: one Fill() per distinct row over nS + 2 spots, against 10 evaluations per point for per-point bumping
+// (price 1, DeltaFD 2, GammaFD 3, vega 2, theta 2)
+bool MatrixPricer::MatrixStencil(const EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    StencilSurfaces& out,
+    const StencilSettings& settings,
+    const ParallelOptions& options)
+{
+    const std::size_t rows = paramMatrix.size();
+    const std::size_t nS = S_values.size();
+    if (nS < 2) return false;
+    for (std::size_t j = 1; j < nS; ++j)
+        if (!(S_values[j] > S_values[j - 1])) return false;
+
+    // Extended mesh: one point below and one above, mirroring the end steps (halving the lowest spot instead of
+    // going to S <= 0)
+    const std::size_t width = nS + 2;
+    std::vector<double> ext(width);
+    ext[0] = S_values[0] - (S_values[1] - S_values[0]);
+    if (ext[0] <= 0.0) ext[0] = 0.5 * S_values[0];
+    for (std::size_t j = 0; j < nS; ++j) ext[j + 1] = S_values[j];
+    ext[nS + 1] = S_values[nS - 1] + (S_values[nS - 1] - S_values[nS - 2]);
+
+    // Resolve the rows (b defaults to r) and collect the distinct rows every stencil needs
+    RowSet set;
+    std::vector<RowParams> original(rows);
+    std::vector<std::size_t> self(rows);
+    std::unique_ptr<EuropeanOption> proto = opt.Clone();
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        ApplyParams(*proto, paramMatrix[i]);
+        original[i] = RowParams{ { proto->T, proto->K, proto->sig, proto->r, proto->b } };
+        self[i] = set.Add(original[i]);
+    }
+
+    std::vector<Neighbours> vol(rows), time(rows);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        vol[i] = FindNeighbours(original, i, RowSig, settings.volBump, set);
+        time[i] = FindNeighbours(original, i, RowT, settings.timeBump, set);
+    }
+
+    // Every distinct row priced once over the extended mesh, one task per row
+    const std::size_t distinct = set.rows.size();
+    std::vector<double> prices(distinct * width);
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+
+    OptionCopies copies(opt, pool, options.threads);
+
+    pool.ParallelFor(distinct, 1, [&](std::size_t begin, std::size_t end)
+    {
+        copies.With([&](EuropeanOption& local)
+        {
+            for (std::size_t r = begin; r < end; ++r)
+            {
+                const RowParams& p = set.rows[r];
+                local.T = p[0]; local.K = p[1]; local.sig = p[2]; local.r = p[3]; local.b = p[4];
+                Fill(local, ext.data(), width, OutputType::Price, prices.data() + r * width, 1, 0.0);
+            }
+        });
+    }, options.threads);
+
+    out.price.Resize(rows, nS);
+    out.delta.Resize(rows, nS);
+    out.gamma.Resize(rows, nS);
+    out.vega.Resize(rows, nS);
+    out.theta.Resize(rows, nS);
+
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        // P[j + 1] is the price at S_values[j]
+        const double* P = prices.data() + self[i] * width;
+        const double* volBelow = prices.data() + vol[i].below * width;
+        const double* volAbove = prices.data() + vol[i].above * width;
+        const double* timeBelow = prices.data() + time[i].below * width;
+        const double* timeAbove = prices.data() + time[i].above * width;
+        const Stencil3 dSig = FirstDerivative(vol[i].hm, vol[i].hp);
+        const Stencil3 dT = FirstDerivative(time[i].hm, time[i].hp);
+
+        for (std::size_t j = 0; j < nS; ++j)
+        {
+            const double hm = ext[j + 1] - ext[j];
+            const double hp = ext[j + 2] - ext[j + 1];
+
+            out.price(i, j) = P[j + 1];
+            out.delta(i, j) = FirstDerivative(hm, hp).Apply(P[j], P[j + 1], P[j + 2]);
+            out.gamma(i, j) = SecondDerivative(hm, hp).Apply(P[j], P[j + 1], P[j + 2]);
+            out.vega(i, j) = dSig.Apply(volBelow[j + 1], P[j + 1], volAbove[j + 1]);
+            out.theta(i, j) = -dT.Apply(timeBelow[j + 1], P[j + 1], timeAbove[j + 1]);
+        }
+    }
+
+    out.pricings = distinct * width;
+    out.naivePricings = rows * nS * 10;
+    return true;
+}
+
+bool MatrixPricer::VectorStencil(const EuropeanOption& opt,
+    const std::vector<double>& S_values,
+    StencilSurfaces& out,
+    const StencilSettings& settings)
+{
+    const std::vector<std::vector<double>> row = { { opt.T, opt.K, opt.sig, opt.r, opt.b } };
+    return MatrixStencil(opt, row, S_values, out, settings);
+}
+
+std::vector<std::vector<double>> MatrixPricer::Matrix(EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    const VolSurface& vols,
+    double h)
+{
+    return Matrix(opt, WithSurfaceVols(paramMatrix, vols), S_values, output, h);
+}
+
+void MatrixPricer::MatrixParallel(const EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    const VolSurface& vols,
+    Surface& out,
+    double h,
+    const ParallelOptions& options)
+{
+    MatrixParallel(opt, WithSurfaceVols(paramMatrix, vols), S_values, output, out, h, options);
+}
+
+std::vector<std::vector<double>> MatrixPricer::WithSurfaceVols(const std::vector<std::vector<double>>& paramMatrix,
+    const VolSurface& vols)
+{
+    const std::size_t rows = paramMatrix.size();
+    std::vector<double> K(rows), T(rows), sig(rows);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        T[i] = paramMatrix[i][0];
+        K[i] = paramMatrix[i][1];
+    }
+    vols.Vol(K.data(), T.data(), rows, sig.data());
+
+    std::vector<std::vector<double>> resolved(paramMatrix);
+    for (std::size_t i = 0; i < rows; ++i)
+        resolved[i][2] = sig[i];
+    return resolved;
+}
+
+// Same rows as Matrix(), with each row's curve factors passed down to the pricing loops
+std::vector<std::vector<double>> MatrixPricer::Matrix(EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    const TermStructure& curves,
+    double h)
+{
+    PRICING_METRICS_SCOPE_OUTPUT(Matrix, output, paramMatrix.size() * S_values.size());
+    const std::vector<TermFactors> factors = RowFactors(paramMatrix, curves);
+
+    std::vector<std::vector<double>> surface;
+    surface.reserve(paramMatrix.size());
+    for (std::size_t i = 0; i < paramMatrix.size(); ++i)
+    {
+        ApplyParams(opt, paramMatrix[i], &factors[i]);
+        std::vector<double> row(S_values.size());
+        Fill(opt, S_values.data(), S_values.size(), output, row.data(), 1, h, &factors[i]);
+        surface.push_back(std::move(row));
+    }
+    return surface;
+}
+
+void MatrixPricer::MatrixParallel(const EuropeanOption& opt,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    const TermStructure& curves,
+    Surface& out,
+    double h,
+    const ParallelOptions& options)
+{
+    const std::vector<TermFactors> factors = RowFactors(paramMatrix, curves);
+    out.Resize(paramMatrix.size(), S_values.size());
+    MatrixParallelStrided(opt, paramMatrix, S_values, output, out.Data(), out.RowStride(), out.ColStride(), h, options,
+        factors.data());
+}
+
+std::vector<TermFactors> MatrixPricer::RowFactors(const std::vector<std::vector<double>>& paramMatrix,
+    const TermStructure& curves)
+{
+    const std::size_t rows = paramMatrix.size();
+    std::vector<double> T(rows);
+    for (std::size_t i = 0; i < rows; ++i) T[i] = paramMatrix[i][0];
+    const std::vector<TermFactors> expiries = curves.DistinctFactors(T.data(), rows);
+
+    std::vector<TermFactors> factors(rows);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        const TermFactors* found = TermStructure::Find(expiries, T[i]);
+        factors[i] = found ? *found : curves.Factors(T[i]); // NaN maturities are not in the table
+    }
+    return factors;
+}
+
+void MatrixPricer::ApplyParams(EuropeanOption& opt, const std::vector<double>& p, const TermFactors* factors)
+{
+    opt.T = p[0];              // Maturity
+    opt.K = p[1];              // Strike
+    opt.sig = p[2];            // Volatility
+    if (factors)               // Zero rates of the curves; the row's r and b are ignored
+    {
+        opt.r = factors->r;
+        opt.b = factors->b;
+        return;
+    }
+    opt.r = p[3];              // Risk-free rate
+    opt.b = (p.size() > 4 ? p[4] : opt.r); // Cost-of-carry, default to r if not provided
+}
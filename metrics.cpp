@@ -0,0 +1,352 @@
+
+#include "Metrics.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Blocks of the live threads plus the totals of the threads that have exited. Never destroyed, so worker threads
+    // that exit during static destruction (the shared ThreadPool) can still retire their blocks.
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<MetricsThreadBlock*> live;
+        MetricsThreadBlock retired;
+        std::size_t threads = 0;
+
+        // Timestamp-counter origin for the tick rate
+        std::uint64_t startTicks = Metrics::Ticks();
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    };
+
+    Registry& TheRegistry()
+    {
+        static Registry* registry = new Registry;
+        return *registry;
+    }
+
+    void MergeBlock(MetricsThreadBlock& into, const MetricsThreadBlock& from)
+    {
+        for (std::size_t s = 0; s < MetricSiteCount; ++s)
+        {
+            into.calls[s].Add(from.calls[s].Load());
+            into.ticks[s].Add(from.ticks[s].Load());
+            into.elements[s].Add(from.elements[s].Load());
+        }
+        for (std::size_t kind = 0; kind < 2; ++kind)
+            for (std::size_t o = 0; o < MetricOutputCount; ++o)
+            {
+                into.latencyTicks[kind][o].Add(from.latencyTicks[kind][o].Load());
+                into.latency[kind][o].Merge(from.latency[kind][o]);
+            }
+    }
+
+    void ResetBlock(MetricsThreadBlock& block)
+    {
+        for (std::size_t s = 0; s < MetricSiteCount; ++s)
+        {
+            block.calls[s].value.store(0, std::memory_order_relaxed);
+            block.ticks[s].value.store(0, std::memory_order_relaxed);
+            block.elements[s].value.store(0, std::memory_order_relaxed);
+        }
+        for (std::size_t kind = 0; kind < 2; ++kind)
+            for (std::size_t o = 0; o < MetricOutputCount; ++o)
+            {
+                block.latencyTicks[kind][o].value.store(0, std::memory_order_relaxed);
+                block.latency[kind][o].Reset();
+            }
+    }
+
+    // Moves the block of an exiting thread into the retired totals
+    struct Retirer
+    {
+        MetricsThreadBlock* block = nullptr;
+
+        ~Retirer()
+        {
+            if (!block) return;
+            Registry& registry = TheRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            MergeBlock(registry.retired, *block);
+            for (std::size_t i = 0; i < registry.live.size(); ++i)
+                if (registry.live[i] == block)
+                {
+                    registry.live[i] = registry.live.back();
+                    registry.live.pop_back();
+                    break;
+                }
+            metricsThreadBlock = nullptr;
+            delete block;
+        }
+    };
+
+    // Ticks per nanosecond over the life of the registry; a short life is extended to 10 ms for a stable rate
+    double TickRate(const Registry& registry)
+    {
+#if METRICS_TSC
+        auto elapsed = std::chrono::steady_clock::now() - registry.startTime;
+        while (elapsed < std::chrono::milliseconds(10))
+            elapsed = std::chrono::steady_clock::now() - registry.startTime;
+        const std::uint64_t ticks = Metrics::Ticks() - registry.startTicks;
+        return static_cast<double>(ticks) / static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+#else
+        (void)registry;
+        return 1.0;
+#endif
+    }
+
+    const char* const SiteNames[MetricSiteCount] = {
+        "EuropeanOption::Price", "AmericanOption::Price", "Greeks::Delta", "Greeks::Gamma", "Greeks::Vega",
+        "Greeks::Theta", "Greeks::Rho", "Greeks::All", "Greeks::AllBatch", "Greeks::DeltaFD", "Greeks::GammaFD",
+        "MatrixPricer::Vector", "MatrixPricer::Matrix" };
+
+    const char* const OutputNames[MetricOutputCount] = {
+        "Price", "Delta", "Gamma", "Vega", "Theta", "Rho", "DeltaFD", "GammaFD" };
+
+    const char* const LatencySites[2] = { "MatrixPricer::Vector", "MatrixPricer::Matrix" };
+}
+
+const char* Metrics::SiteName(MetricSite site)
+{
+    const std::size_t s = static_cast<std::size_t>(site);
+    return s < MetricSiteCount ? SiteNames[s] : "";
+}
+
+const char* Metrics::OutputName(OutputType output)
+{
+    const std::size_t o = static_cast<std::size_t>(output);
+    return o < MetricOutputCount ? OutputNames[o] : "";
+}
+
+MetricsThreadBlock& Metrics::Register()
+{
+    static thread_local Retirer retirer;
+
+    MetricsThreadBlock* block = new MetricsThreadBlock;
+    Registry& registry = TheRegistry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.live.push_back(block);
+        ++registry.threads;
+    }
+    retirer.block = block;
+    metricsThreadBlock = block;
+    return *block;
+}
+
+MetricsSnapshot Metrics::Snapshot()
+{
+    MetricsSnapshot snapshot;
+    snapshot.enabled = Compiled;
+    if (!Compiled) return snapshot;
+
+    // Merged outside the blocks so the owners keep recording undisturbed
+    std::unique_ptr<MetricsThreadBlock> total(new MetricsThreadBlock);
+    Registry& registry = TheRegistry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        MergeBlock(*total, registry.retired);
+        for (const MetricsThreadBlock* block : registry.live)
+            MergeBlock(*total, *block);
+        snapshot.threads = registry.threads;
+    }
+
+    const double rate = TickRate(registry);
+    snapshot.ticksPerNs = rate;
+    for (std::size_t s = 0; s < MetricSiteCount; ++s)
+    {
+        snapshot.sites[s].calls = total->calls[s].Load();
+        snapshot.sites[s].elements = total->elements[s].Load();
+        snapshot.sites[s].ns = static_cast<double>(total->ticks[s].Load()) / rate;
+    }
+    for (std::size_t kind = 0; kind < 2; ++kind)
+        for (std::size_t o = 0; o < MetricOutputCount; ++o)
+        {
+            const LatencyHistogram& h = total->latency[kind][o];
+            MetricsSnapshot::Latency& l = snapshot.latency[kind][o];
+            l.count = h.Count();
+            l.sumNs = static_cast<double>(total->latencyTicks[kind][o].Load()) / rate;
+            l.p50Ns = static_cast<double>(h.Percentile(0.5)) / rate;
+            l.p90Ns = static_cast<double>(h.Percentile(0.9)) / rate;
+            l.p99Ns = static_cast<double>(h.Percentile(0.99)) / rate;
+            l.p999Ns = static_cast<double>(h.Percentile(0.999)) / rate;
+            l.maxNs = static_cast<double>(h.Max()) / rate;
+        }
+    return snapshot;
+}
+
+void Metrics::Reset()
+{
+    Registry& registry = TheRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    ResetBlock(registry.retired);
+    for (MetricsThreadBlock* block : registry.live)
+        ResetBlock(*block);
+}
+
+// Sites with no calls and empty histograms are left out of both formats
+std::string MetricsSnapshot::Json() const
+{
+    std::ostringstream out;
+    out << std::setprecision(10);
+    out << "{\n  \"enabled\": " << (enabled ? "true" : "false") << ",\n  \"ticks_per_ns\": " << ticksPerNs
+        << ",\n  \"threads\": " << threads << ",\n  \"sites\": [";
+
+    bool first = true;
+    for (std::size_t s = 0; s < MetricSiteCount; ++s)
+    {
+        if (sites[s].calls == 0) continue;
+        out << (first ? "\n" : ",\n") << "    { \"site\": \"" << SiteNames[s] << "\", \"calls\": " << sites[s].calls
+            << ", \"elements\": " << sites[s].elements << ", \"ns\": " << sites[s].ns
+            << ", \"ns_per_call\": " << sites[s].ns / static_cast<double>(sites[s].calls) << " }";
+        first = false;
+    }
+    out << (first ? "" : "\n  ") << "],\n  \"latency\": [";
+
+    first = true;
+    for (std::size_t kind = 0; kind < 2; ++kind)
+        for (std::size_t o = 0; o < MetricOutputCount; ++o)
+        {
+            const Latency& l = latency[kind][o];
+            if (l.count == 0) continue;
+            out << (first ? "\n" : ",\n") << "    { \"site\": \"" << LatencySites[kind] << "\", \"output\": \""
+                << OutputNames[o] << "\", \"count\": " << l.count << ", \"sum_ns\": " << l.sumNs
+                << ", \"p50_ns\": " << l.p50Ns << ", \"p90_ns\": " << l.p90Ns << ", \"p99_ns\": " << l.p99Ns
+                << ", \"p999_ns\": " << l.p999Ns << ", \"max_ns\": " << l.maxNs << " }";
+            first = false;
+        }
+    out << (first ? "" : "\n  ") << "]\n}\n";
+    return out.str();
+}
+
+// Text exposition format 0.0.4: three counters per site and one summary per (site, output), in seconds
+std::string MetricsSnapshot::Prometheus() const
+{
+    std::ostringstream out;
+    out << std::setprecision(10);
+
+    out << "# HELP optionpricing_calls_total Calls of each instrumented pricing function.\n"
+        << "# TYPE optionpricing_calls_total counter\n";
+    for (std::size_t s = 0; s < MetricSiteCount; ++s)
+        if (sites[s].calls)
+            out << "optionpricing_calls_total{site=\"" << SiteNames[s] << "\"} " << sites[s].calls << "\n";
+
+    out << "# HELP optionpricing_seconds_total Time inside each instrumented pricing function.\n"
+        << "# TYPE optionpricing_seconds_total counter\n";
+    for (std::size_t s = 0; s < MetricSiteCount; ++s)
+        if (sites[s].calls)
+            out << "optionpricing_seconds_total{site=\"" << SiteNames[s] << "\"} " << sites[s].ns * 1e-9 << "\n";
+
+    out << "# HELP optionpricing_elements_total Points or contracts priced by each instrumented function.\n"
+        << "# TYPE optionpricing_elements_total counter\n";
+    for (std::size_t s = 0; s < MetricSiteCount; ++s)
+        if (sites[s].calls)
+            out << "optionpricing_elements_total{site=\"" << SiteNames[s] << "\"} " << sites[s].elements << "\n";
+
+    out << "# HELP optionpricing_call_latency_seconds Latency of MatrixPricer calls by output.\n"
+        << "# TYPE optionpricing_call_latency_seconds summary\n";
+    for (std::size_t kind = 0; kind < 2; ++kind)
+        for (std::size_t o = 0; o < MetricOutputCount; ++o)
+        {
+            const Latency& l = latency[kind][o];
+            if (l.count == 0) continue;
+            const std::string labels = std::string("site=\"") + LatencySites[kind] + "\",output=\"" + OutputNames[o] + "\"";
+            const std::pair<const char*, double> quantiles[] = {
+                { "0.5", l.p50Ns }, { "0.9", l.p90Ns }, { "0.99", l.p99Ns }, { "0.999", l.p999Ns } };
+            for (const auto& q : quantiles)
+                out << "optionpricing_call_latency_seconds{" << labels << ",quantile=\"" << q.first << "\"} "
+                    << q.second * 1e-9 << "\n";
+            out << "optionpricing_call_latency_seconds_sum{" << labels << "} " << l.sumNs * 1e-9 << "\n";
+            out << "optionpricing_call_latency_seconds_count{" << labels << "} " << l.count << "\n";
+        }
+    return out.str();
+}
+
+bool Metrics::Write(const std::string& path, MetricsFormat format, std::string& error)
+{
+    const std::string text = Snapshot().Format(format);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            error = "cannot open " + temporary;
+            return false;
+        }
+        file << text;
+        if (!file.flush())
+        {
+            error = "cannot write " + temporary;
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str()); // rename does not replace an existing file on Windows
+#endif
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        error = "cannot rename " + temporary + " to " + path;
+        return false;
+    }
+    return true;
+}
+
+bool Metrics::Send(const std::string& socketPath, MetricsFormat format, std::string& error)
+{
+#ifdef _WIN32
+    (void)socketPath; (void)format;
+    error = "Unix-domain sockets are not supported on this platform";
+    return false;
+#else
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+    {
+        error = "invalid socket path " + socketPath;
+        return false;
+    }
+    socketPath.copy(address.sun_path, socketPath.size());
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        error = "cannot create a socket";
+        return false;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        ::close(fd);
+        error = "cannot connect to " + socketPath;
+        return false;
+    }
+
+    const std::string text = Snapshot().Format(format);
+    std::size_t sent = 0;
+    while (sent < text.size())
+    {
+        const ssize_t n = ::write(fd, text.data() + sent, text.size() - sent);
+        if (n <= 0)
+        {
+            ::close(fd);
+            error = "write to " + socketPath + " failed";
+            return false;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+    return true;
+#endif
+}
@@ -0,0 +1,452 @@
+
+#include "MonteCarlo.h"
+#include "NormalDistribution.h"
+#include "Philox.h"
+#include "Sobol.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// ---------------- Payoffs ----------------
+
+void VanillaPayoff::Evaluate(const double* S, std::size_t paths, std::size_t steps, std::size_t, double* out) const
+{
+    const double* ST = S + (steps - 1) * paths;
+    const double w = call ? 1.0 : -1.0;
+    for (std::size_t p = 0; p < paths; ++p)
+        out[p] = std::max(w * (ST[p] - K), 0.0);
+}
+
+void AsianPayoff::Evaluate(const double* S, std::size_t paths, std::size_t steps, std::size_t, double* out) const
+{
+    for (std::size_t p = 0; p < paths; ++p)
+        out[p] = 0.0;
+    for (std::size_t k = 0; k < steps; ++k)
+        for (std::size_t p = 0; p < paths; ++p)
+            out[p] += S[k * paths + p];
+
+    const double w = call ? 1.0 : -1.0;
+    const double invSteps = 1.0 / steps;
+    for (std::size_t p = 0; p < paths; ++p)
+        out[p] = std::max(w * (out[p] * invSteps - K), 0.0);
+}
+
+void BarrierPayoff::Evaluate(const double* S, std::size_t paths, std::size_t steps, std::size_t, double* out) const
+{
+    // out first holds 1 while the path is alive, then the payoff
+    for (std::size_t p = 0; p < paths; ++p)
+        out[p] = 1.0;
+    for (std::size_t k = 0; k < steps; ++k)
+        for (std::size_t p = 0; p < paths; ++p)
+        {
+            bool hit = up ? (S[k * paths + p] >= barrier) : (S[k * paths + p] <= barrier);
+            out[p] = hit ? 0.0 : out[p];
+        }
+
+    const double* ST = S + (steps - 1) * paths;
+    const double w = call ? 1.0 : -1.0;
+    for (std::size_t p = 0; p < paths; ++p)
+        out[p] *= std::max(w * (ST[p] - K), 0.0);
+}
+
+void BasketPayoff::Evaluate(const double* S, std::size_t paths, std::size_t steps, std::size_t assets, double* out) const
+{
+    for (std::size_t p = 0; p < paths; ++p)
+        out[p] = 0.0;
+    for (std::size_t a = 0; a < assets && a < weights.size(); ++a)
+    {
+        const double* ST = S + (a * steps + steps - 1) * paths;
+        for (std::size_t p = 0; p < paths; ++p)
+            out[p] += weights[a] * ST[p];
+    }
+
+    const double w = call ? 1.0 : -1.0;
+    for (std::size_t p = 0; p < paths; ++p)
+        out[p] = std::max(w * (out[p] - K), 0.0);
+}
+
+// ---------------- Engine ----------------
+
+namespace
+{
+    // Brownian bridge over dates t_k = (k + 1) * dt, k = 0..M-1 (Jaeckel's construction, any M).
+    // Normal i fills date bridge[i] from its neighbours: W[bridge] = leftW * W[left - 1] + rightW * W[right] + sd * z_i,
+    // where left == 0 means the left neighbour is W(0) = 0. Normal 0 sets the terminal value.
+    struct BrownianBridge
+    {
+        std::vector<std::size_t> left, right, bridge;
+        std::vector<double> leftW, rightW, sd;
+
+        BrownianBridge(std::size_t M, double dt)
+            : left(M), right(M), bridge(M), leftW(M), rightW(M), sd(M)
+        {
+            std::vector<double> t(M);
+            for (std::size_t k = 0; k < M; ++k) t[k] = (k + 1) * dt;
+
+            std::vector<std::size_t> filled(M, 0);
+            filled[M - 1] = 1;
+            bridge[0] = M - 1;
+            sd[0] = std::sqrt(t[M - 1]);
+
+            for (std::size_t i = 1, j = 0; i < M; ++i)
+            {
+                while (filled[j]) ++j;          // first empty date
+                std::size_t k = j;
+                while (!filled[k]) ++k;         // next filled date to its right
+                std::size_t l = j + ((k - 1 - j) >> 1);
+
+                filled[l] = i;
+                bridge[i] = l; left[i] = j; right[i] = k;
+
+                double tLeft = (j == 0) ? 0.0 : t[j - 1];
+                leftW[i] = (t[k] - t[l]) / (t[k] - tLeft);
+                rightW[i] = (t[l] - tLeft) / (t[k] - tLeft);
+                sd[i] = std::sqrt((t[l] - tLeft) * (t[k] - t[l]) / (t[k] - tLeft));
+
+                j = k + 1;
+                if (j >= M) j = 0;
+            }
+        }
+    };
+
+    // Everything fixed for one pricing run
+    struct Plan
+    {
+        std::size_t assets, steps, dims;
+        double dt, disc;
+        std::vector<double> logS0, driftDt, sig, chol; // chol: lower-triangular Cholesky factor, assets x assets
+        double controlK, controlW;
+        BrownianBridge bridge;
+        SobolSequence sobol;
+        std::vector<std::uint32_t> shifts;             // replicates x sobol dimensions
+        Philox rng, fillRng;                           // fillRng: coordinates beyond the Sobol dimensions
+
+        Plan(std::size_t A, std::size_t M, double T, std::uint64_t seed)
+            : assets(A), steps(M), dims(A * M), dt(T / M), disc(0.0), logS0(A), driftDt(A), sig(A), chol(A * A),
+              controlK(0.0), controlW(1.0), bridge(M, T / M),
+              sobol(static_cast<unsigned>(std::min<std::size_t>(A * M, SobolSequence::MaxDimensions))),
+              rng(seed), fillRng(seed ^ 0x9E3779B97F4A7C15ull)
+        {
+        }
+    };
+
+    struct BlockSums
+    {
+        double n, y, x, yy, xx, xy;
+    };
+
+    struct Buffers
+    {
+        std::vector<double> z, S, payoff;
+        std::vector<std::uint32_t> point;
+    };
+
+    bool Cholesky(const std::vector<std::vector<double>>& C, std::size_t n, std::vector<double>& L)
+    {
+        if (C.size() != n) return false;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (C[i].size() != n) return false;
+            for (std::size_t j = 0; j <= i; ++j)
+            {
+                double sum = C[i][j];
+                for (std::size_t k = 0; k < j; ++k)
+                    sum -= L[i * n + k] * L[j * n + k];
+                if (i == j)
+                {
+                    if (!(sum > 0.0)) return false;
+                    L[i * n + i] = std::sqrt(sum);
+                }
+                else
+                    L[i * n + j] = sum / L[j * n + j];
+            }
+        }
+        return true;
+    }
+
+    // Simulates `count` samples and accumulates their discounted payoff (y) and control (x) sums.
+    // index0 is the first sample's counter (pseudo-random) or Sobol point index; replicate selects the digital shift.
+    void SimulateBlock(const Plan& plan, const McPayoff& payoff, const McSettings& st, std::uint64_t index0,
+        std::size_t count, unsigned replicate, Buffers& buf, BlockSums& sums)
+    {
+        const std::size_t A = plan.assets, M = plan.steps, D = plan.dims;
+        const std::size_t P = st.antithetic ? 2 * count : count; // simulated paths
+        const bool quasi = (st.sampling == McSampling::Sobol);
+        const unsigned sobolDims = plan.sobol.Dimensions();
+
+        buf.z.resize(D * count);
+        buf.S.resize(D * P);
+        buf.payoff.resize(P);
+        buf.point.resize(sobolDims);
+        double* z = buf.z.data();
+        double* S = buf.S.data();
+
+        // 1. Uniforms for coordinate e = k * A + a (date-major in bridge order, so the first Sobol coordinates drive the
+        //    terminal values of every asset), stored as z[(a * M + k) * count + p], then mapped to normals
+        for (std::size_t p = 0; p < count; ++p)
+        {
+            const std::uint64_t index = index0 + p;
+            std::size_t e = 0;
+
+            if (quasi)
+            {
+                if (p == 0) plan.sobol.Point(index, buf.point.data());
+                else plan.sobol.Next(index, buf.point.data());
+
+                const std::uint32_t* shift = &plan.shifts[replicate * sobolDims];
+                for (; e < sobolDims; ++e)
+                    z[((e % A) * M + e / A) * count + p] = ((buf.point[e] ^ shift[e]) + 0.5) * (1.0 / 4294967296.0);
+            }
+
+            // Pseudo-random coordinates (all of them, or those beyond the Sobol dimensions); two per Philox call
+            const Philox& rng = quasi ? plan.fillRng : plan.rng;
+            const std::uint64_t counter = quasi ? (static_cast<std::uint64_t>(replicate) << 48) + index : index;
+            for (std::size_t pair = e / 2; 2 * pair < D; ++pair)
+            {
+                double u[2];
+                rng.Uniform2(counter, pair, u[0], u[1]);
+                for (std::size_t h = 0; h < 2; ++h)
+                {
+                    std::size_t c = 2 * pair + h;
+                    if (c >= e && c < D) z[((c % A) * M + c / A) * count + p] = u[h];
+                }
+            }
+        }
+        N_inv(z, z, D * count);
+
+        // 2. Brownian paths W[(a * M + k) * P + p] at every date, by bridge or by cumulative sums
+        for (std::size_t a = 0; a < A; ++a)
+        {
+            const double* za = z + a * M * count;
+            double* W = S + a * M * P;
+
+            if (st.brownianBridge)
+            {
+                const BrownianBridge& bb = plan.bridge;
+                for (std::size_t p = 0; p < count; ++p)
+                    W[bb.bridge[0] * P + p] = bb.sd[0] * za[p];
+                for (std::size_t i = 1; i < M; ++i)
+                {
+                    double* Wl = W + bb.bridge[i] * P;
+                    const double* Wr = W + bb.right[i] * P;
+                    const double* zi = za + i * count;
+                    const double lw = bb.leftW[i], rw = bb.rightW[i], sd = bb.sd[i];
+                    if (bb.left[i] == 0)
+                        for (std::size_t p = 0; p < count; ++p)
+                            Wl[p] = rw * Wr[p] + sd * zi[p];
+                    else
+                    {
+                        const double* Wj = W + (bb.left[i] - 1) * P;
+                        for (std::size_t p = 0; p < count; ++p)
+                            Wl[p] = lw * Wj[p] + rw * Wr[p] + sd * zi[p];
+                    }
+                }
+            }
+            else
+            {
+                const double sqrtDt = std::sqrt(plan.dt);
+                for (std::size_t k = 0; k < M; ++k)
+                    for (std::size_t p = 0; p < count; ++p)
+                        W[k * P + p] = (k ? W[(k - 1) * P + p] : 0.0) + sqrtDt * za[k * count + p];
+            }
+
+            // Mirror paths: the bridge is linear in z, so -z gives -W
+            if (st.antithetic)
+                for (std::size_t k = 0; k < M; ++k)
+                    for (std::size_t p = 0; p < count; ++p)
+                        W[k * P + count + p] = -W[k * P + p];
+
+            // Increments dW_k = W_k - W_(k-1)
+            for (std::size_t k = M; k-- > 1; )
+                for (std::size_t p = 0; p < P; ++p)
+                    W[k * P + p] -= W[(k - 1) * P + p];
+        }
+
+        // 3. Correlate the increments across assets: dW <- L dW (in place, highest asset first)
+        if (A > 1)
+            for (std::size_t k = 0; k < M; ++k)
+                for (std::size_t a = A; a-- > 0; )
+                {
+                    double* dWa = S + (a * M + k) * P;
+                    const double Laa = plan.chol[a * A + a];
+                    for (std::size_t p = 0; p < P; ++p)
+                        dWa[p] *= Laa;
+                    for (std::size_t b = 0; b < a; ++b)
+                    {
+                        const double Lab = plan.chol[a * A + b];
+                        const double* dWb = S + (b * M + k) * P;
+                        for (std::size_t p = 0; p < P; ++p)
+                            dWa[p] += Lab * dWb[p];
+                    }
+                }
+
+        // 4. Log-spot paths, then one array exponential over the whole block
+        for (std::size_t a = 0; a < A; ++a)
+        {
+            double* x = S + a * M * P;
+            const double drift = plan.driftDt[a], sig = plan.sig[a], x0 = plan.logS0[a];
+            for (std::size_t p = 0; p < P; ++p)
+                x[p] = x0 + drift + sig * x[p];
+            for (std::size_t k = 1; k < M; ++k)
+                for (std::size_t p = 0; p < P; ++p)
+                    x[k * P + p] = x[(k - 1) * P + p] + drift + sig * x[k * P + p];
+        }
+        VectorMath::Exp(S, S, D * P);
+
+        // 5. Payoffs and control, summed in sample order
+        payoff.Evaluate(S, P, M, A, buf.payoff.data());
+
+        const double* ST = S + (M - 1) * P; // asset 0 at maturity
+        const double* f = buf.payoff.data();
+        BlockSums s = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        for (std::size_t p = 0; p < count; ++p)
+        {
+            double y = f[p];
+            double x = std::max(plan.controlW * (ST[p] - plan.controlK), 0.0);
+            if (st.antithetic)
+            {
+                y = 0.5 * (y + f[count + p]);
+                x = 0.5 * (x + std::max(plan.controlW * (ST[count + p] - plan.controlK), 0.0));
+            }
+            y *= plan.disc;
+            x *= plan.disc;
+
+            s.n += 1.0;
+            s.y += y; s.x += x;
+            s.yy += y * y; s.xx += x * x; s.xy += x * y;
+        }
+        sums = s;
+    }
+}
+
+McResult MonteCarlo::Price(const EuropeanOption& model, double S, const McPayoff& payoff,
+    const McSettings& settings, const ParallelOptions& options)
+{
+    std::vector<EuropeanOption> assets(1, model);
+    std::vector<double> spots(1, S);
+    std::vector<std::vector<double>> correlation(1, std::vector<double>(1, 1.0));
+    return PriceBasket(assets, spots, correlation, payoff, settings, options);
+}
+
+McResult MonteCarlo::PriceBasket(const std::vector<EuropeanOption>& assets, const std::vector<double>& spots,
+    const std::vector<std::vector<double>>& correlation, const McPayoff& payoff,
+    const McSettings& settings, const ParallelOptions& options)
+{
+    McResult result;
+    const std::size_t A = assets.size();
+    const std::size_t M = std::max(1u, settings.steps);
+    if (A == 0 || spots.size() != A || settings.samples == 0)
+    {
+        result.price = result.standardError = std::numeric_limits<double>::quiet_NaN();
+        return result;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    const EuropeanOption& first = assets[0];
+    Plan plan(A, M, first.T, settings.seed);
+    plan.disc = std::exp(-first.r * first.T);
+    plan.controlK = first.K;
+    plan.controlW = (first.optType == "C") ? 1.0 : -1.0;
+    for (std::size_t a = 0; a < A; ++a)
+    {
+        plan.logS0[a] = std::log(spots[a]);
+        plan.sig[a] = assets[a].sig;
+        plan.driftDt[a] = (assets[a].b - 0.5 * assets[a].sig * assets[a].sig) * plan.dt;
+    }
+    if (!Cholesky(correlation, A, plan.chol))
+    {
+        result.price = result.standardError = std::numeric_limits<double>::quiet_NaN();
+        return result;
+    }
+
+    // Block layout. Sobol: `replicates` copies of the same point set, each with its own digital shift.
+    const bool quasi = (settings.sampling == McSampling::Sobol);
+    const unsigned R = quasi ? std::max(2u, settings.replicates) : 1u;
+    const std::size_t B = std::max<std::size_t>(1, settings.blockSize);
+    const std::size_t perReplicate = (settings.samples + R - 1) / R;
+    const std::size_t blocksPerReplicate = (perReplicate + B - 1) / B;
+    const std::size_t blocks = blocksPerReplicate * R;
+
+    if (quasi)
+    {
+        const unsigned sobolDims = plan.sobol.Dimensions();
+        plan.shifts.resize(R * sobolDims);
+        Philox shiftRng(settings.seed ^ 0xD1B54A32D192ED03ull);
+        for (unsigned r = 0; r < R; ++r)
+            for (unsigned d = 0; d < sobolDims; ++d)
+                plan.shifts[r * sobolDims + d] = shiftRng(r, d, 0, 0).v[0];
+    }
+
+    std::vector<BlockSums> sums(blocks);
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+    const std::size_t grain = (options.grain > 0) ? options.grain : 1;
+
+    pool.ParallelFor(blocks, grain, [&](std::size_t begin, std::size_t end)
+    {
+        Buffers buf;
+        for (std::size_t blk = begin; blk < end; ++blk)
+        {
+            const unsigned replicate = static_cast<unsigned>(blk / blocksPerReplicate);
+            const std::size_t first = (blk % blocksPerReplicate) * B; // sample offset within the replicate
+            const std::size_t count = std::min(B, perReplicate - first);
+            const std::uint64_t index0 = quasi ? first : static_cast<std::uint64_t>(replicate) * perReplicate + first;
+            SimulateBlock(plan, payoff, settings, index0, count, replicate, buf, sums[blk]);
+        }
+    }, options.threads);
+
+    // Reduction in block order: independent of the number of threads
+    BlockSums total = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    std::vector<BlockSums> perRep(R, total);
+    for (std::size_t blk = 0; blk < blocks; ++blk)
+    {
+        BlockSums& t = perRep[blk / blocksPerReplicate];
+        const BlockSums& s = sums[blk];
+        t.n += s.n; t.y += s.y; t.x += s.x; t.yy += s.yy; t.xx += s.xx; t.xy += s.xy;
+    }
+    for (const BlockSums& t : perRep)
+    {
+        total.n += t.n; total.y += t.y; total.x += t.x; total.yy += t.yy; total.xx += t.xx; total.xy += t.xy;
+    }
+
+    const double n = total.n;
+    const double varY = total.yy - total.y * total.y / n;
+    const double varX = total.xx - total.x * total.x / n;
+    const double covXY = total.xy - total.x * total.y / n;
+
+    // Control variate: Y - beta * (X - E[X]) with E[X] the Black-Scholes price of the vanilla on asset 0
+    double beta = 0.0, expectedX = 0.0;
+    if (settings.controlVariate && varX > 0.0)
+    {
+        beta = covXY / varX;
+        expectedX = first.Price(spots[0]);
+    }
+
+    if (quasi)
+    {
+        // Randomised QMC: the replicate estimates are i.i.d., their spread gives the standard error
+        double sum = 0.0, sumSq = 0.0;
+        for (const BlockSums& t : perRep)
+        {
+            double estimate = (t.y - beta * (t.x - t.n * expectedX)) / t.n;
+            sum += estimate;
+            sumSq += estimate * estimate;
+        }
+        result.price = sum / R;
+        result.standardError = std::sqrt(std::max(sumSq / R - result.price * result.price, 0.0) / (R - 1));
+    }
+    else
+    {
+        double residualVar = (varY - 2.0 * beta * covXY + beta * beta * varX) / (n - 1.0);
+        result.price = total.y / n - beta * (total.x / n - expectedX);
+        result.standardError = std::sqrt(std::max(residualVar, 0.0) / n);
+    }
+
+    result.samples = static_cast<std::size_t>(n);
+    result.paths = settings.antithetic ? 2 * result.samples : result.samples;
+    result.beta = beta;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,265 @@
+
+#include "PdeSolver.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // Solves the tridiagonal system (lower, diag + penalty, upper) x = rhs + penalty * target with the Thomas algorithm.
+    // penalty may be null. cp is scratch of the same length; x may not alias rhs.
+    void ThomasSolve(const double* lower, const double* diag, const double* upper, const double* rhs,
+        const double* penalty, const double* target, double* x, double* cp, std::size_t n)
+    {
+        double b = diag[0] + (penalty ? penalty[0] : 0.0);
+        double d = rhs[0] + (penalty ? penalty[0] * target[0] : 0.0);
+        cp[0] = upper[0] / b;
+        x[0] = d / b;
+        for (std::size_t i = 1; i < n; ++i)
+        {
+            b = diag[i] + (penalty ? penalty[i] : 0.0) - lower[i] * cp[i - 1];
+            d = rhs[i] + (penalty ? penalty[i] * target[i] : 0.0);
+            cp[i] = upper[i] / b;
+            x[i] = (d - lower[i] * x[i - 1]) / b;
+        }
+        for (std::size_t i = n - 1; i-- > 0; )
+            x[i] -= cp[i] * x[i + 1];
+    }
+}
+
+void PdeSolver::Solve(const EuropeanOption& opt, const std::vector<double>& S_mesh, const PdeSettings& settings,
+    PdeWorkspace& work, double* price, double* delta, double* gamma)
+{
+    const std::size_t m = S_mesh.size();
+
+    bool valid = (m >= 2) && S_mesh[0] >= 0.0 && opt.T > 0.0 && opt.sig > 0.0 && settings.timeSteps > 0;
+    for (std::size_t k = 1; valid && k < m; ++k)
+        valid = S_mesh[k] > S_mesh[k - 1];
+    if (!valid)
+    {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        for (std::size_t k = 0; k < m; ++k)
+        {
+            price[k] = nan;
+            if (delta) delta[k] = nan;
+            if (gamma) gamma[k] = nan;
+        }
+        return;
+    }
+
+    // ---- Grid: geometric extension down to S = 0, the mesh refined to the resolution, geometric extension up to
+    // the far field ----
+    std::vector<double>& grid = work.grid;
+    std::vector<std::size_t>& meshIndex = work.meshIndex;
+    grid.clear();
+    meshIndex.resize(m);
+
+    // The mesh with nodes inserted between spots further apart than the resolution allows, built after the
+    // extension below so the spacing it starts from is known first
+    const double spacing = settings.resolution * opt.sig * std::sqrt(opt.T);
+    auto intervals = [&](std::size_t k) -> std::size_t
+    {
+        const double gap = S_mesh[k + 1] - S_mesh[k];
+        const double limit = spacing * std::max(opt.K, S_mesh[k]);
+        return (limit > 0.0 && gap > limit) ? static_cast<std::size_t>(std::ceil(gap / limit)) : 1;
+    };
+
+    double step = (S_mesh[1] - S_mesh[0]) / intervals(0);
+    double s = S_mesh[0];
+    while (s > 0.0)
+    {
+        step *= settings.growth;
+        s = (s - step > 0.5 * step) ? s - step : 0.0; // never leave a sliver of an interval next to zero
+        grid.push_back(s);
+    }
+    std::reverse(grid.begin(), grid.end());
+
+    for (std::size_t k = 0; k + 1 < m; ++k)
+    {
+        meshIndex[k] = grid.size();
+        const std::size_t parts = intervals(k);
+        const double h = (S_mesh[k + 1] - S_mesh[k]) / parts;
+        grid.push_back(S_mesh[k]);
+        for (std::size_t j = 1; j < parts; ++j) grid.push_back(S_mesh[k] + j * h);
+    }
+    meshIndex[m - 1] = grid.size();
+    grid.push_back(S_mesh[m - 1]);
+
+    const double farSpot = std::max(S_mesh[m - 1], opt.K)
+        * std::exp(settings.farField * opt.sig * std::sqrt(opt.T) + std::max(opt.b, 0.0) * opt.T);
+    const std::size_t top = grid.size(); // nodes up to the last mesh spot
+    step = grid[top - 1] - grid[top - 2];
+    s = S_mesh[m - 1];
+    do
+    {
+        step *= settings.growth;
+        s += step;
+        grid.push_back(s);
+    } while (s < farSpot || grid.size() < top + 2);
+
+    const std::size_t n = grid.size();
+    const std::size_t last = n - 1;
+
+    work.lower.resize(n); work.diag.resize(n); work.upper.resize(n);
+    work.aLower.resize(n); work.aDiag.resize(n); work.aUpper.resize(n);
+    work.factor.resize(n); work.pivot.resize(n);
+    work.values.resize(n); work.rhs.resize(n); work.payoff.resize(n);
+
+    // ---- Spatial operator L V = 0.5 sig^2 S^2 V_SS + b S V_S - r V with three-point non-uniform differences ----
+    double* l = work.lower.data();
+    double* d = work.diag.data();
+    double* u = work.upper.data();
+    const double* S = grid.data();
+
+    const double halfSig2 = 0.5 * opt.sig * opt.sig;
+    l[0] = 0.0; d[0] = -opt.r; u[0] = 0.0; // S = 0: dV/dt = -rV
+    for (std::size_t i = 1; i < last; ++i)
+    {
+        double hm = S[i] - S[i - 1], hp = S[i + 1] - S[i];
+        double diffusion = halfSig2 * S[i] * S[i];
+        double convection = opt.b * S[i];
+
+        l[i] = (2.0 * diffusion - convection * hp) / (hm * (hm + hp));
+        u[i] = (2.0 * diffusion + convection * hm) / (hp * (hm + hp));
+        d[i] = (-2.0 * diffusion + convection * (hp - hm)) / (hm * hp) - opt.r;
+    }
+    l[last] = 0.0; d[last] = 0.0; u[last] = 0.0; // far-field Dirichlet row
+
+    // ---- A = I - 0.5*dt*L (identity in the Dirichlet row), factorised once ----
+    const unsigned N = settings.timeSteps;
+    const double dt = opt.T / N;
+    const double halfDt = 0.5 * dt;
+
+    double* aL = work.aLower.data();
+    double* aD = work.aDiag.data();
+    double* aU = work.aUpper.data();
+    double* cp = work.factor.data();
+    double* piv = work.pivot.data();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        aL[i] = -halfDt * l[i];
+        aD[i] = (i == last) ? 1.0 : 1.0 - halfDt * d[i];
+        aU[i] = -halfDt * u[i];
+
+        piv[i] = 1.0 / ((i == 0) ? aD[i] : aD[i] - aL[i] * cp[i - 1]);
+        cp[i] = aU[i] * piv[i];
+    }
+
+    // ---- Payoff and time stepping in tau = time to maturity ----
+    const bool call = (opt.optType == "C");
+    const double w = call ? 1.0 : -1.0;
+    double* V = work.values.data();
+    double* g = work.payoff.data();
+    double* rhs = work.rhs.data();
+    for (std::size_t i = 0; i < n; ++i)
+        g[i] = V[i] = std::max(w * (S[i] - opt.K), 0.0);
+
+    // Calls with b >= r are never exercised early
+    const bool exercise = settings.earlyExercise && !(call && opt.b >= opt.r);
+    if (exercise)
+    {
+        work.iterate.resize(n);
+        work.penalty.resize(n);
+        work.scratch.resize(n);
+    }
+
+    // Rannacher start-up: the first rannacherSteps steps are each taken as two implicit Euler half steps
+    const unsigned startSteps = std::min(settings.rannacherSteps, N);
+    const unsigned subSteps = 2 * startSteps + (N - startSteps);
+
+    double tau = 0.0;
+    for (unsigned k = 0; k < subSteps; ++k)
+    {
+        const bool implicitHalf = k < 2 * startSteps;
+        tau += implicitHalf ? halfDt : dt;
+
+        // Right-hand side: V for an implicit Euler half step, (I + 0.5*dt*L) V for Crank-Nicolson
+        if (implicitHalf)
+            std::copy(V, V + n, rhs);
+        else
+        {
+            rhs[0] = V[0] + halfDt * d[0] * V[0];
+            for (std::size_t i = 1; i < last; ++i)
+                rhs[i] = V[i] + halfDt * (l[i] * V[i - 1] + d[i] * V[i] + u[i] * V[i + 1]);
+        }
+
+        // Far field: European asymptote (deep ITM call, worthless put), floored by the payoff when exercise is allowed
+        double boundary = call ? S[last] * std::exp((opt.b - opt.r) * tau) - opt.K * std::exp(-opt.r * tau) : 0.0;
+        rhs[last] = exercise ? std::max(boundary, g[last]) : boundary;
+
+        if (!exercise)
+        {
+            // Forward and back substitution with the stored factorisation
+            V[0] = rhs[0] * piv[0];
+            for (std::size_t i = 1; i < n; ++i)
+                V[i] = (rhs[i] - aL[i] * V[i - 1]) * piv[i];
+            for (std::size_t i = n - 1; i-- > 0; )
+                V[i] -= cp[i] * V[i + 1];
+        }
+        else if (settings.method == EarlyExerciseMethod::PSOR)
+        {
+            // Projected SOR on A V = rhs, V >= payoff, starting from the previous time level
+            for (unsigned it = 0; it < settings.maxIterations; ++it)
+            {
+                double change = 0.0, scale = 1.0;
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    double r = rhs[i] - (i > 0 ? aL[i] * V[i - 1] : 0.0) - (i < last ? aU[i] * V[i + 1] : 0.0);
+                    double next = std::max(g[i], V[i] + settings.omega * (r / aD[i] - V[i]));
+                    change = std::max(change, std::fabs(next - V[i]));
+                    scale = std::max(scale, std::fabs(next));
+                    V[i] = next;
+                }
+                if (change <= settings.tolerance * scale) break;
+            }
+        }
+        else
+        {
+            // Penalty iteration: (A + P) V = rhs + P * payoff with P = penalty where V < payoff,
+            // starting from the previous time level and stopping once the active set no longer changes
+            double* P = work.penalty.data();
+            double* prev = work.iterate.data();
+            for (unsigned it = 0; it < settings.maxIterations; ++it)
+            {
+                for (std::size_t i = 0; i < n; ++i)
+                    P[i] = (V[i] < g[i]) ? settings.penalty : 0.0;
+
+                std::copy(V, V + n, prev);
+                ThomasSolve(aL, aD, aU, rhs, P, g, V, work.scratch.data(), n);
+
+                double change = 0.0, scale = 1.0;
+                bool sameActiveSet = true;
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    change = std::max(change, std::fabs(V[i] - prev[i]));
+                    scale = std::max(scale, std::fabs(V[i]));
+                    sameActiveSet = sameActiveSet && ((V[i] < g[i]) == (P[i] > 0.0));
+                }
+                if (sameActiveSet || change <= settings.tolerance * scale) break;
+            }
+        }
+    }
+
+    // ---- Results at the mesh spots; Delta and Gamma from non-uniform differences on the grid ----
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        std::size_t i = meshIndex[k];
+        price[k] = V[i];
+        if (!delta && !gamma) continue;
+
+        std::size_t c = (i == 0) ? 1 : i; // S = 0 on the mesh: use the first interior node
+        double hm = S[c] - S[c - 1], hp = S[c + 1] - S[c];
+        double dV = (-hp / (hm * (hm + hp))) * V[c - 1] + ((hp - hm) / (hm * hp)) * V[c] + (hm / (hp * (hm + hp))) * V[c + 1];
+        double d2V = 2.0 * (V[c - 1] / (hm * (hm + hp)) - V[c] / (hm * hp) + V[c + 1] / (hp * (hm + hp)));
+        if (delta) delta[k] = (i == 0) ? (V[1] - V[0]) / hm : dV;
+        if (gamma) gamma[k] = d2V;
+    }
+}
+
+std::vector<double> PdeSolver::Vector(const EuropeanOption& opt, const std::vector<double>& S_mesh, const PdeSettings& settings)
+{
+    PdeWorkspace work;
+    std::vector<double> result(S_mesh.size());
+    Solve(opt, S_mesh, settings, work, result.data());
+    return result;
+}
@@ -0,0 +1,358 @@
+
+#include "Portfolio.h"
+#include "AmericanOption.h"
+#include "BatchPricer.h"
+#include "Greeks.h"
+#include "RateCurve.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <typeinfo>
+
+namespace
+{
+    const std::size_t ChunkLines = 4096;  // European lines per structure-of-arrays chunk
+    const double MinShockedVol = 1e-4;    // shocked volatilities are floored here instead of going negative
+
+    // Grouping key: everything that determines a line's value apart from the quantity. Ordered by underlying, then
+    // expiry, rates and volatility ahead of the strike, so the lines sharing a slice (T, r, b) sit next to each other.
+    struct LineKey
+    {
+        int kind;                 // 0 European closed form, 1 AmericanOption, 2 any other type (never merged)
+        std::uint32_t underlying;
+        bool call;
+        double T, K, sig, r, b;
+        int method, latticeType;
+        unsigned steps;
+        bool richardson, earlyExercise;
+        std::size_t unique;       // position index for kind 2, else 0
+
+        bool operator<(const LineKey& o) const
+        {
+            return std::tie(kind, underlying, T, r, b, sig, call, K, method, latticeType, steps, richardson, earlyExercise, unique)
+                < std::tie(o.kind, o.underlying, o.T, o.r, o.b, o.sig, o.call, o.K, o.method, o.latticeType, o.steps, o.richardson, o.earlyExercise, o.unique);
+        }
+    };
+
+    // Value and Greeks of a contract without a batch kernel: the lattice gives all of them for finite-maturity
+    // AmericanOption; otherwise central differences on Price() in spot, volatility and rate (with carry moving along,
+    // as in the lattice engine) and a one-day backward difference in maturity (zero for perpetual contracts).
+    GreeksResult ValueSingle(const EuropeanOption& opt, double S)
+    {
+        const AmericanOption* american = dynamic_cast<const AmericanOption*>(&opt);
+        if (american && american->method == AmericanMethod::Lattice)
+            return american->LatticeGreeks(S);
+
+        GreeksResult g;
+        g.price = opt.Price(S);
+
+        const double h = 1e-4 * S;
+        const double up = opt.Price(S + h), down = opt.Price(S - h);
+        g.delta = (up - down) / (2.0 * h);
+        g.gamma = (up - 2.0 * g.price + down) / (h * h);
+
+        std::unique_ptr<EuropeanOption> bumped = opt.Clone();
+        const double dv = 1e-4;
+        bumped->sig = opt.sig + dv;
+        const double vegaUp = bumped->Price(S);
+        bumped->sig = opt.sig - dv;
+        g.vega = (vegaUp - bumped->Price(S)) / (2.0 * dv);
+        bumped->sig = opt.sig;
+
+        const double dr = 1e-4;
+        bumped->r = opt.r + dr; bumped->b = opt.b + dr;
+        const double rhoUp = bumped->Price(S);
+        bumped->r = opt.r - dr; bumped->b = opt.b - dr;
+        g.rho = (rhoUp - bumped->Price(S)) / (2.0 * dr);
+        bumped->r = opt.r; bumped->b = opt.b;
+
+        const double dt = 1.0 / 365.0;
+        if (opt.T > dt)
+        {
+            bumped->T = opt.T - dt;
+            g.theta = (bumped->Price(S) - g.price) / dt;
+        }
+        else
+            g.theta = 0.0;
+        return g;
+    }
+
+    void Accumulate(BookGreeks& acc, const GreeksResult& g, double quantity)
+    {
+        acc.value += quantity * g.price;
+        acc.delta += quantity * g.delta;
+        acc.gamma += quantity * g.gamma;
+        acc.vega += quantity * g.vega;
+        acc.theta += quantity * g.theta;
+        acc.rho += quantity * g.rho;
+    }
+
+    void Accumulate(BookGreeks& acc, const BookGreeks& part)
+    {
+        acc.value += part.value;
+        acc.delta += part.delta;
+        acc.gamma += part.gamma;
+        acc.vega += part.vega;
+        acc.theta += part.theta;
+        acc.rho += part.rho;
+    }
+}
+
+struct Portfolio::Book
+{
+    struct Chunk
+    {
+        OptionBatch batch;
+        std::vector<double> quantity;
+        std::vector<std::uint32_t> underlying;
+        std::vector<TermFactors> factors;   // one entry per run of lines with the same T, r and b
+        std::vector<std::uint32_t> expiry;  // line -> its entry of factors
+    };
+
+    std::vector<Chunk> chunks;                  // European lines
+    std::vector<const EuropeanOption*> singles; // all other lines (representative position's option)
+    std::vector<double> singleQuantity;
+    std::vector<std::uint32_t> singleUnderlying;
+    std::size_t lines = 0;
+};
+
+// Lines of the book, keyed by contract: key -> (representative position, summed quantity)
+struct Portfolio::LineIndex
+{
+    std::map<LineKey, std::pair<std::size_t, double>> lines;
+};
+
+Portfolio::Portfolio() : index(new LineIndex) {}
+Portfolio::~Portfolio() {}
+
+std::size_t Portfolio::Add(const EuropeanOption& opt, double quantity, std::uint32_t underlying)
+{
+    Position p;
+    p.option = opt.Clone();
+    p.quantity = quantity;
+    p.underlying = underlying;
+    positions.push_back(std::move(p));
+
+    // Merge into the line of an identical contract, or start a new line with this position as representative
+    const std::size_t i = positions.size() - 1;
+    const AmericanOption* american = dynamic_cast<const AmericanOption*>(&opt);
+    LineKey key;
+    key.kind = (typeid(opt) == typeid(EuropeanOption)) ? 0 : (american ? 1 : 2);
+    key.underlying = underlying;
+    key.call = opt.optType == "C";
+    key.T = opt.T; key.K = opt.K; key.sig = opt.sig; key.r = opt.r; key.b = opt.b;
+    key.method = american ? static_cast<int>(american->method) : 0;
+    key.latticeType = american ? static_cast<int>(american->lattice.type) : 0;
+    key.steps = american ? american->lattice.steps : 0;
+    key.richardson = american ? american->lattice.richardson : false;
+    key.earlyExercise = american ? american->lattice.earlyExercise : false;
+    key.unique = (key.kind == 2) ? i : 0;
+
+    auto it = index->lines.find(key);
+    if (it == index->lines.end()) index->lines.emplace(key, std::make_pair(i, quantity));
+    else it->second.second += quantity;
+
+    if (spots.size() <= underlying)
+        spots.resize(static_cast<std::size_t>(underlying) + 1, std::numeric_limits<double>::quiet_NaN());
+    return positions.size() - 1;
+}
+
+void Portfolio::SetSpot(std::uint32_t underlying, double S)
+{
+    if (spots.size() <= underlying)
+        spots.resize(static_cast<std::size_t>(underlying) + 1, std::numeric_limits<double>::quiet_NaN());
+    spots[underlying] = S;
+}
+
+double Portfolio::Spot(std::uint32_t underlying) const
+{
+    return underlying < spots.size() ? spots[underlying] : std::numeric_limits<double>::quiet_NaN();
+}
+
+// Builds the chunks from the lines merged in Add(); the map keeps lines in key order, so the book is built the same
+// way every time
+void Portfolio::Group(Book& book) const
+{
+    const std::map<LineKey, std::pair<std::size_t, double>>& lines = index->lines;
+
+    book.lines = lines.size();
+    for (const auto& line : lines)
+    {
+        const Position& p = positions[line.second.first];
+        if (line.first.kind == 0)
+        {
+            if (book.chunks.empty() || book.chunks.back().quantity.size() == ChunkLines)
+            {
+                book.chunks.emplace_back();
+                book.chunks.back().batch.Reserve(ChunkLines);
+            }
+            Book::Chunk& c = book.chunks.back();
+            const EuropeanOption& opt = *p.option;
+            if (c.factors.empty() || c.factors.back().T != opt.T || c.factors.back().r != opt.r || c.factors.back().b != opt.b)
+            {
+                // Flat rates: the zero rates and the forwards are r and b themselves
+                TermFactors f;
+                f.T = opt.T;
+                f.r = f.forwardR = opt.r;
+                f.b = f.forwardB = opt.b;
+                f.discount = std::exp(-opt.r * opt.T);
+                f.carry = std::exp((opt.b - opt.r) * opt.T);
+                c.factors.push_back(f);
+            }
+            c.expiry.push_back(static_cast<std::uint32_t>(c.factors.size() - 1));
+            c.batch.Add(opt);
+            c.quantity.push_back(line.second.second);
+            c.underlying.push_back(p.underlying);
+        }
+        else
+        {
+            book.singles.push_back(p.option.get());
+            book.singleQuantity.push_back(line.second.second);
+            book.singleUnderlying.push_back(p.underlying);
+        }
+    }
+}
+
+PortfolioRisk Portfolio::Risk(const ParallelOptions& options) const
+{
+    auto start = std::chrono::steady_clock::now();
+
+    Book book;
+    Group(book);
+
+    PortfolioRisk risk;
+    risk.positions = positions.size();
+    risk.lines = book.lines;
+    risk.byUnderlying.assign(spots.size(), BookGreeks());
+
+    const std::size_t nChunks = book.chunks.size();
+    const std::size_t nSingles = book.singles.size();
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+
+    // One task per European chunk and one per single line; each writes only its own partial results
+    std::vector<std::vector<BookGreeks>> chunkPartial(nChunks, std::vector<BookGreeks>(spots.size()));
+    std::vector<GreeksResult> singleResult(nSingles);
+
+    pool.ParallelFor(nChunks + nSingles, 1, [&](std::size_t begin, std::size_t end)
+    {
+        std::vector<double> S;
+        std::vector<GreeksResult> g;
+        for (std::size_t t = begin; t < end; ++t)
+        {
+            if (t < nChunks)
+            {
+                const Book::Chunk& c = book.chunks[t];
+                const std::size_t n = c.quantity.size();
+                S.resize(n);
+                g.resize(n);
+                for (std::size_t i = 0; i < n; ++i) S[i] = spots[c.underlying[i]];
+                Greeks::AllBatch(c.batch, c.factors.data(), c.expiry.data(), S.data(), g.data());
+                for (std::size_t i = 0; i < n; ++i)
+                    Accumulate(chunkPartial[t][c.underlying[i]], g[i], c.quantity[i]);
+            }
+            else
+            {
+                const std::size_t k = t - nChunks;
+                singleResult[k] = ValueSingle(*book.singles[k], spots[book.singleUnderlying[k]]);
+            }
+        }
+    }, options.threads);
+
+    // Fixed merge order: chunks, then single lines, each in book order
+    for (std::size_t c = 0; c < nChunks; ++c)
+        for (std::size_t u = 0; u < spots.size(); ++u)
+            Accumulate(risk.byUnderlying[u], chunkPartial[c][u]);
+    for (std::size_t k = 0; k < nSingles; ++k)
+        Accumulate(risk.byUnderlying[book.singleUnderlying[k]], singleResult[k], book.singleQuantity[k]);
+    for (const BookGreeks& u : risk.byUnderlying)
+        Accumulate(risk.total, u);
+
+    risk.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return risk;
+}
+
+void Portfolio::Scenarios(const std::vector<double>& spotShocks, const std::vector<double>& volShocks,
+    Surface& pnl, ScenarioMethod method, const ParallelOptions& options) const
+{
+    const std::size_t nS = spotShocks.size();
+    const std::size_t nV = volShocks.size();
+    pnl.Resize(nS, nV);
+    if (nS == 0 || nV == 0) return;
+
+    if (method == ScenarioMethod::Taylor)
+    {
+        // Per-underlying delta/gamma against that underlying's spot move; vega against the common vol shift
+        PortfolioRisk risk = Risk(options);
+        for (std::size_t i = 0; i < nS; ++i)
+            for (std::size_t j = 0; j < nV; ++j)
+            {
+                double v = risk.total.vega * volShocks[j];
+                for (std::size_t u = 0; u < spots.size(); ++u)
+                {
+                    const BookGreeks& g = risk.byUnderlying[u];
+                    if (g.delta == 0.0 && g.gamma == 0.0) continue; // no positions (spot may be unset)
+                    const double dS = spots[u] * spotShocks[i];
+                    v += g.delta * dS + 0.5 * g.gamma * dS * dS;
+                }
+                pnl(i, j) = v;
+            }
+        return;
+    }
+
+    Book book;
+    Group(book);
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+
+    // Book value at one (spot shock, vol shock), summed in book order. Each task owns its scratch batch and clones.
+    struct Scratch
+    {
+        OptionBatch batch;
+        std::vector<double> S, price;
+        std::vector<std::unique_ptr<EuropeanOption>> singles;
+    };
+    auto value = [&](double ds, double dv, Scratch& w)
+    {
+        double total = 0.0;
+        for (const Book::Chunk& c : book.chunks)
+        {
+            const std::size_t n = c.quantity.size();
+            w.batch = c.batch; // keeps capacity after the first chunk
+            for (std::size_t i = 0; i < n; ++i) w.batch.sig[i] = std::max(c.batch.sig[i] + dv, MinShockedVol);
+            w.S.resize(n);
+            w.price.resize(n);
+            for (std::size_t i = 0; i < n; ++i) w.S[i] = spots[c.underlying[i]] * (1.0 + ds);
+            BatchPricer::PriceBatch(w.batch, c.factors.data(), c.expiry.data(), w.S.data(), w.price.data());
+            for (std::size_t i = 0; i < n; ++i) total += c.quantity[i] * w.price[i];
+        }
+        for (std::size_t k = 0; k < book.singles.size(); ++k)
+        {
+            EuropeanOption& opt = *w.singles[k];
+            opt.sig = std::max(book.singles[k]->sig + dv, MinShockedVol);
+            total += book.singleQuantity[k] * opt.Price(spots[book.singleUnderlying[k]] * (1.0 + ds));
+        }
+        return total;
+    };
+    auto prepare = [&](Scratch& w)
+    {
+        w.singles.clear();
+        for (const EuropeanOption* opt : book.singles) w.singles.push_back(opt->Clone());
+    };
+
+    Scratch base;
+    prepare(base);
+    const double baseValue = value(0.0, 0.0, base);
+
+    pool.ParallelFor(nS * nV, 1, [&](std::size_t begin, std::size_t end)
+    {
+        Scratch w;
+        prepare(w);
+        for (std::size_t t = begin; t < end; ++t)
+        {
+            const std::size_t i = t / nV, j = t % nV;
+            pnl(i, j) = value(spotShocks[i], volShocks[j], w) - baseValue;
+        }
+    }, options.threads);
+}
@@ -0,0 +1,560 @@
+
+#include "PriceTable.h"
+#include "NormalDistribution.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace
+{
+    const double Pi = 3.14159265358979323846;
+
+    struct PriceTableHeader
+    {
+        char magic[8];            // "OPTCHEB" followed by a zero byte
+        std::uint32_t version;
+        std::uint32_t byteOrder;  // 0x01020304 as written by the producing machine
+        std::uint32_t zTiles;
+        std::uint32_t vTiles;
+        std::uint32_t degree;
+        std::uint32_t reserved;
+        double zMax, vMin, vMax;
+        PriceTableErrors tolerance;
+        std::uint64_t count;      // coefficients that follow the header, then 4 estimates per tile
+    };
+
+    const char Magic[8] = { 'O', 'P', 'T', 'C', 'H', 'E', 'B', '\0' };
+    const std::uint32_t ByteOrder = 0x01020304u;
+
+    // Normalised values come from EuropeanOption::Price on unit contracts (K = 1, T = 1, r = b = 0, sigma = v) at
+    // S = exp(x); the table fits the out-of-the-money one of the pair
+    struct UnitContracts
+    {
+        EuropeanOption call, put;
+
+        UnitContracts() : call("C"), put("P")
+        {
+            for (EuropeanOption* o : { &call, &put }) { o->K = 1.0; o->T = 1.0; o->r = 0.0; o->b = 0.0; }
+        }
+
+        EuropeanOption& OutOfTheMoney(double x) { return (x < 0.0) ? call : put; }
+
+        double Price(double x, double v)
+        {
+            EuropeanOption& o = OutOfTheMoney(x);
+            o.sig = v;
+            return o.Price(std::exp(x));
+        }
+    };
+
+    // Closed-form normalised call or put value and its derivatives in x and v, ex = exp(x):
+    //   call: c_x = exp(x) N(d1),  put: c_x = -exp(x) N(-d1),  both: c_xx = c_x + n(d2) / v,  c_v = n(d2)
+    // using exp(x) n(d1) = n(d2). Written for the out-of-the-money one of the pair, where neither form cancels.
+    void ClosedForm(bool call, double x, double ex, double v, double& c, double* cx, double* cxx, double* cv)
+    {
+        const double d1 = x / v + 0.5 * v, d2 = d1 - v;
+        const double density = N_pdf(d2);
+        double first;
+        if (call)
+        {
+            first = ex * N_cdf(d1);
+            c = first - N_cdf(d2);
+        }
+        else
+        {
+            first = -ex * N_cdf(-d1);
+            c = N_cdf(-d2) + first;
+        }
+        if (cx) *cx = first;
+        if (cxx) *cxx = first + density / v;
+        if (cv) *cv = density;
+    }
+
+    // Monomial coefficients of the Chebyshev polynomials: T_i(u) = sum_k C[i][k] u^k
+    void ChebyshevToPower(unsigned n, double C[][PriceTable::MaxDegree])
+    {
+        for (unsigned i = 0; i < n; ++i)
+            for (unsigned k = 0; k < n; ++k) C[i][k] = 0.0;
+        C[0][0] = 1.0;
+        if (n > 1) C[1][1] = 1.0;
+        for (unsigned i = 2; i < n; ++i)
+            for (unsigned k = 0; k < n; ++k)
+                C[i][k] = (k > 0 ? 2.0 * C[i - 1][k - 1] : 0.0) - C[i - 2][k];
+    }
+
+    // u^0..u^{n-1} by products of lower powers, so the dependency chain is log2(n) multiplies long instead of n
+    void Powers(double u, unsigned n, double* p)
+    {
+        p[0] = 1.0; p[1] = u;
+        for (unsigned k = 2; k < n; ++k) p[k] = p[k / 2] * p[k - k / 2];
+    }
+}
+
+PriceTable::PriceTable()
+    : zScale(0.0), vScale(0.0)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    estimates = { nan, nan, nan, nan };
+}
+
+bool PriceTable::Build(const PriceTableSettings& s, const ParallelOptions& options)
+{
+    if (!(s.zMax > 0.0) || !(s.vMin > 0.0) || !(s.vMax > s.vMin) || s.zTiles == 0 || s.zTiles % 2 != 0 || s.vTiles == 0
+        || s.degree < 2 || s.degree > MaxDegree)
+    {
+        error = "invalid price table settings";
+        return false;
+    }
+
+    settings = s;
+    zScale = s.zTiles / (2.0 * s.zMax);
+    vScale = s.vTiles / (s.vMax - s.vMin);
+    const std::size_t tiles = static_cast<std::size_t>(s.zTiles) * s.vTiles;
+    coefficients.assign(static_cast<std::size_t>(s.degree) * s.degree * tiles, 0.0);
+
+    // One task per row of tiles; each tile writes only its own coefficients and estimates
+    std::vector<PriceTableErrors> perTile(tiles);
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+    pool.ParallelFor(s.vTiles, 1, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t vi = begin; vi < end; ++vi)
+            for (unsigned zi = 0; zi < s.zTiles; ++zi)
+                FitTile(zi, static_cast<unsigned>(vi), perTile[vi * s.zTiles + zi]);
+    }, options.threads);
+
+    tileEstimates.resize(4 * tiles);
+    for (std::size_t t = 0; t < tiles; ++t)
+    {
+        double* b = &tileEstimates[4 * t];
+        b[0] = perTile[t].price; b[1] = perTile[t].delta; b[2] = perTile[t].gamma; b[3] = perTile[t].vega;
+    }
+    ApplyTolerance();
+    error.clear();
+    return true;
+}
+
+// Outside [-zMax, zMax] the out-of-the-money value and its derivatives are taken as zero. There, with
+// a = zMax - vMax/2 and Mills' ratio N(-d) <= n(d)/d for d > 0: the call has c, c_x <= N(-a) and c_v = n(d2) <= n(zMax);
+// the put has c <= N(-a), |c_x| = exp(x) N(-d1) <= n(d2)/d1 <= n(a)/zMax and c_v = n(d2) <= n(a); c_xx = c_x + c_v / v.
+void PriceTable::ApplyTolerance()
+{
+    const PriceTableErrors& tol = settings.tolerance;
+    const double a = settings.zMax - 0.5 * settings.vMax;
+    const double density = N_pdf(std::max(a, 0.0));
+    estimates.price = N_cdf(-a);
+    estimates.delta = std::max(estimates.price, density / settings.zMax);
+    estimates.gamma = estimates.delta + density / settings.vMin;
+    estimates.vega = density;
+
+    const std::size_t tiles = tileEstimates.size() / 4;
+    exact.assign(tiles, 0);
+    for (std::size_t t = 0; t < tiles; ++t)
+    {
+        const double* b = &tileEstimates[4 * t];
+        if (!(b[0] <= tol.price && b[1] <= tol.delta && b[2] <= tol.gamma && b[3] <= tol.vega))
+        {
+            exact[t] = 1; // the closed form's own rounding only
+            continue;
+        }
+        estimates.price = std::max(estimates.price, b[0]);
+        estimates.delta = std::max(estimates.delta, b[1]);
+        estimates.gamma = std::max(estimates.gamma, b[2]);
+        estimates.vega = std::max(estimates.vega, b[3]);
+    }
+}
+
+std::size_t PriceTable::ExactTiles() const
+{
+    return static_cast<std::size_t>(std::count(exact.begin(), exact.end(), 1));
+}
+
+// Coefficients from the values at the Chebyshev points cos(pi (k + 1/2) / n) of both directions:
+//   a_ij = (c_i c_j / n^2) sum_k sum_l f(u_k, w_l) T_i(u_k) T_j(w_l),  c_0 = 1, c_i = 2 otherwise
+void PriceTable::FitTile(unsigned zi, unsigned vi, PriceTableErrors& tileEstimate)
+{
+    const unsigned n = settings.degree;
+    const double z0 = -settings.zMax + zi / zScale;
+    const double v0 = settings.vMin + vi / vScale;
+    const double zHalf = 0.5 / zScale, vHalf = 0.5 / vScale;
+    UnitContracts unit;
+
+    double nodes[MaxDegree];
+    double Tk[MaxDegree][MaxDegree]; // Tk[i][k] = T_i(node k)
+    for (unsigned k = 0; k < n; ++k)
+    {
+        nodes[k] = std::cos(Pi * (k + 0.5) / n);
+        for (unsigned i = 0; i < n; ++i) Tk[i][k] = std::cos(i * Pi * (k + 0.5) / n);
+    }
+
+    double f[MaxDegree][MaxDegree]; // f[l][k]: v node l, z node k
+    for (unsigned l = 0; l < n; ++l)
+    {
+        const double v = v0 + (nodes[l] + 1.0) * vHalf;
+        for (unsigned k = 0; k < n; ++k)
+        {
+            const double z = z0 + (nodes[k] + 1.0) * zHalf;
+            f[l][k] = unit.Price(z * v, v);
+        }
+    }
+
+    double* a = coefficients.data() + (static_cast<std::size_t>(vi) * settings.zTiles + zi) * n * n;
+    for (unsigned j = 0; j < n; ++j)
+        for (unsigned i = 0; i < n; ++i)
+        {
+            double sum = 0.0;
+            for (unsigned l = 0; l < n; ++l)
+                for (unsigned k = 0; k < n; ++k)
+                    sum += f[l][k] * Tk[i][k] * Tk[j][l];
+            a[j * n + i] = sum * (i == 0 ? 1.0 : 2.0) * (j == 0 ? 1.0 : 2.0) / (n * n);
+        }
+
+    // Tail: the highest-order coefficients in either direction
+    double tail = 0.0;
+    for (unsigned i = 0; i < n; ++i)
+        tail += std::fabs(a[(n - 1) * n + i]) + std::fabs(a[i * n + (n - 1)]);
+
+    // Stored in the monomial basis, b_jk = sum_j' sum_i a_j'i C[j'][j] C[i][k]: a lookup then needs powers of u and w
+    // (a short dependency chain) instead of the Chebyshev recurrences. The conversion loses a few ulps times the size of
+    // C's entries (64 at degree 8), far below the fitting error, and the measured error below includes it.
+    double C[MaxDegree][MaxDegree];
+    ChebyshevToPower(n, C);
+    double half[MaxDegree][MaxDegree]; // converted in u only: half[j'][k]
+    for (unsigned jj = 0; jj < n; ++jj)
+        for (unsigned k = 0; k < n; ++k)
+        {
+            double sum = 0.0;
+            for (unsigned i = k; i < n; ++i) sum += a[jj * n + i] * C[i][k];
+            half[jj][k] = sum;
+        }
+    for (unsigned j = 0; j < n; ++j)
+        for (unsigned k = 0; k < n; ++k)
+        {
+            double sum = 0.0;
+            for (unsigned jj = j; jj < n; ++jj) sum += half[jj][k] * C[jj][j];
+            a[j * n + k] = sum;
+        }
+
+    // Check grid of m = 4n points per direction, tile edges included. The tile's side of z = 0 fixes the type, so the
+    // edge at z = 0 is compared with the same type as the rest of the tile.
+    const unsigned m = 4 * n;
+    const std::size_t tile = static_cast<std::size_t>(vi) * settings.zTiles + zi;
+    const bool call = z0 + zHalf < 0.0;
+    std::vector<double> errors(4 * m * m); // quantity q at grid point (l, k): errors[(q * m + l) * m + k]
+    for (unsigned l = 0; l < m; ++l)
+    {
+        const double w = -1.0 + 2.0 * l / (m - 1);
+        const double v = v0 + (w + 1.0) * vHalf;
+        for (unsigned k = 0; k < m; ++k)
+        {
+            const double u = -1.0 + 2.0 * k / (m - 1);
+            const double z = z0 + (u + 1.0) * zHalf;
+            const double x = z * v;
+
+            double g, gz, gzz, gv, c, cx, cxx, cv;
+            Evaluate(tile, u, w, &g, &gz, &gzz, &gv);
+            ClosedForm(call, x, std::exp(x), v, c, &cx, &cxx, &cv);
+            errors[(0 * m + l) * m + k] = g - c;
+            errors[(1 * m + l) * m + k] = gz / v - cx;
+            errors[(2 * m + l) * m + k] = gzz / (v * v) - cxx;
+            errors[(3 * m + l) * m + k] = gv - gz * z / v - cv;
+        }
+    }
+
+    // Estimate: the largest error on the grid plus the largest changes between neighbours in u and in w
+    double estimate[4];
+    for (unsigned q = 0; q < 4; ++q)
+    {
+        const double* e = &errors[q * m * m];
+        double largest = 0.0, stepU = 0.0, stepW = 0.0;
+        for (unsigned l = 0; l < m; ++l)
+            for (unsigned k = 0; k < m; ++k)
+            {
+                const double here = e[l * m + k];
+                largest = std::max(largest, std::fabs(here));
+                if (k + 1 < m) stepU = std::max(stepU, std::fabs(e[l * m + k + 1] - here));
+                if (l + 1 < m) stepW = std::max(stepW, std::fabs(e[(l + 1) * m + k] - here));
+            }
+        estimate[q] = largest + stepU + stepW;
+    }
+
+    tileEstimate.price = std::max(tail, estimate[0]);
+    tileEstimate.delta = estimate[1];
+    tileEstimate.gamma = estimate[2];
+    tileEstimate.vega = estimate[3];
+}
+
+// Tile lookup: two multiplies and truncations, the index clamped into the table
+std::size_t PriceTable::Locate(double z, double v, double& u, double& w) const
+{
+    const double zPos = (z + settings.zMax) * zScale;
+    const double vPos = (v - settings.vMin) * vScale;
+    const unsigned zi = std::min(static_cast<unsigned>(std::max(zPos, 0.0)), settings.zTiles - 1);
+    const unsigned vi = std::min(static_cast<unsigned>(std::max(vPos, 0.0)), settings.vTiles - 1);
+    u = 2.0 * (zPos - zi) - 1.0;
+    w = 2.0 * (vPos - vi) - 1.0;
+    return static_cast<std::size_t>(vi) * settings.zTiles + zi;
+}
+
+// The tile's coefficients are contracted with the powers of w (and their derivatives) down to one column per z order,
+// and the column with the powers of u and their derivatives
+void PriceTable::Evaluate(std::size_t tile, double u, double w, double* value, double* dz, double* dzz, double* dv) const
+{
+    const double* a = coefficients.data() + tile * settings.degree * settings.degree;
+
+    switch (settings.degree)
+    {
+    case 6: Contract<6>(a, 6, u, w, value, dz, dzz, dv); break;
+    case 8: Contract<8>(a, 8, u, w, value, dz, dzz, dv); break;
+    case 10: Contract<10>(a, 10, u, w, value, dz, dzz, dv); break;
+    case 12: Contract<12>(a, 12, u, w, value, dz, dzz, dv); break;
+    default: Contract<0>(a, settings.degree, u, w, value, dz, dzz, dv); break;
+    }
+
+    // d/dz = du/dz d/du with du/dz = 2 zScale; likewise for v
+    if (dz) *dz *= 2.0 * zScale;
+    if (dzz) *dzz *= 4.0 * zScale * zScale;
+    if (dv) *dv *= 2.0 * vScale;
+}
+
+// Degree != 0 fixes the loop lengths at compile time so they unroll and vectorise; Degree = 0 uses n.
+// The final sums over u alternate between two accumulators to halve their dependency chains.
+template<unsigned Degree>
+void PriceTable::Contract(const double* a, unsigned n, double u, double w, double* value, double* du, double* duu, double* dw)
+{
+    const unsigned N = Degree ? Degree : n;
+    double up[MaxDegree + 1], wp[MaxDegree];
+    Powers(u, N, up);
+    Powers(w, N, wp);
+    up[N] = 0.0; // pairs the last term when N is odd
+
+    double column[MaxDegree + 1], columnW[MaxDegree + 1];
+    for (unsigned i = 0; i < N; ++i) column[i] = a[i];
+    column[N] = 0.0;
+    for (unsigned j = 1; j < N; ++j)
+        for (unsigned i = 0; i < N; ++i) column[i] += a[j * N + i] * wp[j];
+    if (dw)
+    {
+        for (unsigned i = 0; i < N; ++i) columnW[i] = a[N + i];
+        columnW[N] = 0.0;
+        for (unsigned j = 2; j < N; ++j)
+            for (unsigned i = 0; i < N; ++i) columnW[i] += a[j * N + i] * (j * wp[j - 1]);
+    }
+
+    double s0 = 0.0, s1 = 0.0;
+    for (unsigned i = 0; i < N; i += 2) { s0 += column[i] * up[i]; s1 += column[i + 1] * up[i + 1]; }
+    *value = s0 + s1;
+    if (du)
+    {
+        s0 = 0.0; s1 = 0.0;
+        for (unsigned i = 1; i < N; i += 2) { s0 += column[i] * (i * up[i - 1]); s1 += column[i + 1] * ((i + 1) * up[i]); }
+        *du = s0 + s1;
+    }
+    if (duu)
+    {
+        s0 = 0.0; s1 = 0.0;
+        for (unsigned i = 2; i < N; i += 2)
+        {
+            s0 += column[i] * (i * (i - 1) * up[i - 2]);
+            s1 += column[i + 1] * ((i + 1) * i * up[i - 1]);
+        }
+        *duu = s0 + s1;
+    }
+    if (dw)
+    {
+        s0 = 0.0; s1 = 0.0;
+        for (unsigned i = 0; i < N; i += 2) { s0 += columnW[i] * up[i]; s1 += columnW[i + 1] * up[i + 1]; }
+        *dw = s0 + s1;
+    }
+}
+
+// In x: c_x = g_z / v and c_xx = g_zz / v^2; in v at fixed x: c_v = g_v - g_z z / v. Exact tiles take the closed form
+// of the out-of-the-money type instead. The in-the-money type adds the parity term +-(exp(x) - 1), whose x-derivatives are both exp(x).
+void PriceTable::Normalised(double x, double ex, double v, bool call, double& c, double* cx, double* cxx, double* cv) const
+{
+    const double z = x / v;
+    if (z > settings.zMax || z < -settings.zMax)
+    {
+        c = 0.0;
+        if (cx) *cx = 0.0;
+        if (cxx) *cxx = 0.0;
+        if (cv) *cv = 0.0;
+    }
+    else
+    {
+        double u, w;
+        const std::size_t tile = Locate(z, v, u, w);
+        if (exact[tile])
+            ClosedForm(x < 0.0, x, ex, v, c, cx, cxx, cv);
+        else
+        {
+            double gz, gzz, gv;
+            Evaluate(tile, u, w, &c, cx ? &gz : nullptr, cxx ? &gzz : nullptr, cv ? &gv : nullptr);
+            if (cx) *cx = gz / v;
+            if (cxx) *cxx = gzz / (v * v);
+            if (cv) *cv = gv - gz * z / v;
+        }
+    }
+
+    if (call == (x < 0.0)) return;
+    const double sign = call ? 1.0 : -1.0; // call = put + (exp(x) - 1), put = call - (exp(x) - 1)
+    c += sign * (ex - 1.0);
+    if (cx) *cx += sign * ex;
+    if (cxx) *cxx += sign * ex;
+}
+
+bool PriceTable::Covers(const OptionInvariants& c) const
+{
+    return Built() && c.volSqrtT >= settings.vMin && c.volSqrtT <= settings.vMax;
+}
+
+// exp(x) = F/K = S carry / K_df, so x costs one log and the put needs no extra exponential
+double PriceTable::Price(const OptionInvariants& c, double S, bool call) const
+{
+    if (!Covers(c)) return std::numeric_limits<double>::quiet_NaN();
+
+    const double ex = S * c.carry / c.K_df;
+    double value;
+    Normalised(std::log(ex), ex, c.volSqrtT, call, value, nullptr, nullptr, nullptr);
+    return c.K_df * value;
+}
+
+// V = K_df c(x, v) with x = log(S/K) + bT and v = sigma sqrt(T):
+//   delta = K_df c_x / S,  gamma = K_df (c_xx - c_x) / S^2,  vega = K_df c_v sqrt(T)
+//   theta = -dV/dT = r V - K_df (b c_x + sigma c_v / (2 sqrt(T))),  rho (b moving with r) = T (K_df c_x - V)
+GreeksResult PriceTable::Greeks(const OptionInvariants& c, double S, bool call) const
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    GreeksResult g = { nan, nan, nan, nan, nan, nan };
+    if (!Covers(c)) return g;
+
+    const double ex = S * c.carry / c.K_df;
+    double value, cx, cxx, cv;
+    Normalised(std::log(ex), ex, c.volSqrtT, call, value, &cx, &cxx, &cv);
+
+    const double sqrtT = c.volSqrtT / c.sig;
+    g.price = c.K_df * value;
+    g.delta = c.K_df * cx / S;
+    g.gamma = c.K_df * (cxx - cx) / (S * S);
+    g.vega = c.K_df * cv * sqrtT;
+    g.theta = c.r * g.price - c.K_df * (c.b * cx + c.sig * cv / (2.0 * sqrtT));
+    g.rho = c.T * (c.K_df * cx - g.price);
+    return g;
+}
+
+double PriceTable::Price(const EuropeanOption& opt, double S) const
+{
+    return Price(opt.ComputeInvariants(), S, opt.optType == "C");
+}
+
+GreeksResult PriceTable::Greeks(const EuropeanOption& opt, double S) const
+{
+    return Greeks(opt.ComputeInvariants(), S, opt.optType == "C");
+}
+
+// Exact derivatives on the out-of-the-money unit contract: c_x = S delta, c_xx = S^2 gamma + c_x, c_v = vega.
+// z is drawn from [-1.25 zMax, 1.25 zMax] so the region beyond the tiles is checked as well.
+PriceTableValidation PriceTable::Validate(std::size_t samples, std::uint32_t seed) const
+{
+    PriceTableValidation result;
+    if (!Built()) return result;
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> zDist(-1.25 * settings.zMax, 1.25 * settings.zMax);
+    std::uniform_real_distribution<double> vDist(settings.vMin, settings.vMax);
+    UnitContracts unit;
+
+    for (std::size_t k = 0; k < samples; ++k)
+    {
+        const double v = vDist(rng);
+        const double x = zDist(rng) * v;
+        const bool call = x < 0.0;
+        EuropeanOption& o = unit.OutOfTheMoney(x);
+        o.sig = v;
+        const double S = std::exp(x);
+        GreeksResult exact = ::Greeks::All(o, S);
+        const double exactCx = S * exact.delta;
+
+        double c, cx, cxx, cv;
+        Normalised(x, S, v, call, c, &cx, &cxx, &cv);
+        result.priceError = std::max(result.priceError, std::fabs(c - exact.price));
+        result.deltaError = std::max(result.deltaError, std::fabs(cx - exactCx));
+        result.gammaError = std::max(result.gammaError, std::fabs(cxx - (S * S * exact.gamma + exactCx)));
+        result.vegaError = std::max(result.vegaError, std::fabs(cv - exact.vega));
+    }
+
+    result.samples = samples;
+    result.withinEstimates = result.priceError <= estimates.price && result.deltaError <= estimates.delta
+        && result.gammaError <= estimates.gamma && result.vegaError <= estimates.vega;
+    return result;
+}
+
+bool PriceTable::Save(const std::string& path) const
+{
+    if (!Built()) return false;
+
+    PriceTableHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, Magic, sizeof(Magic));
+    h.version = Version;
+    h.byteOrder = ByteOrder;
+    h.zTiles = settings.zTiles;
+    h.vTiles = settings.vTiles;
+    h.degree = settings.degree;
+    h.zMax = settings.zMax;
+    h.vMin = settings.vMin;
+    h.vMax = settings.vMax;
+    h.tolerance = settings.tolerance;
+    h.count = coefficients.size();
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    const bool ok = std::fwrite(&h, sizeof(h), 1, file) == 1
+        && std::fwrite(coefficients.data(), sizeof(double), coefficients.size(), file) == coefficients.size()
+        && std::fwrite(tileEstimates.data(), sizeof(double), tileEstimates.size(), file) == tileEstimates.size();
+    return (std::fclose(file) == 0) && ok;
+}
+
+bool PriceTable::Load(const std::string& path)
+{
+    auto fail = [this, &path](const char* problem)
+    {
+        error = path + ": " + problem;
+        return false;
+    };
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return fail("cannot open");
+
+    PriceTableHeader h;
+    if (std::fread(&h, sizeof(h), 1, file) != 1) { std::fclose(file); return fail("too small to be a price table"); }
+    if (std::memcmp(h.magic, Magic, sizeof(Magic)) != 0) { std::fclose(file); return fail("not a price table"); }
+    if (h.version != Version) { std::fclose(file); return fail("unsupported version"); }
+    if (h.byteOrder != ByteOrder) { std::fclose(file); return fail("written with a different byte order"); }
+    if (h.degree < 2 || h.degree > MaxDegree || h.zTiles == 0 || h.vTiles == 0
+        || h.count != static_cast<std::uint64_t>(h.degree) * h.degree * h.zTiles * h.vTiles)
+    {
+        std::fclose(file);
+        return fail("inconsistent table shape");
+    }
+
+    std::vector<double> data(static_cast<std::size_t>(h.count));
+    std::vector<double> dataEstimates(4 * static_cast<std::size_t>(h.zTiles) * h.vTiles);
+    const bool ok = std::fread(data.data(), sizeof(double), data.size(), file) == data.size()
+        && std::fread(dataEstimates.data(), sizeof(double), dataEstimates.size(), file) == dataEstimates.size();
+    std::fclose(file);
+    if (!ok) return fail("truncated coefficient section");
+
+    settings.zMax = h.zMax; settings.vMin = h.vMin; settings.vMax = h.vMax;
+    settings.zTiles = h.zTiles; settings.vTiles = h.vTiles; settings.degree = h.degree;
+    zScale = settings.zTiles / (2.0 * settings.zMax);
+    vScale = settings.vTiles / (settings.vMax - settings.vMin);
+    settings.tolerance = h.tolerance;
+    coefficients.swap(data);
+    tileEstimates.swap(dataEstimates);
+    ApplyTolerance();
+    error.clear();
+    return true;
+}
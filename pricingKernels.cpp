@@ -0,0 +1,168 @@
+
+#include "PricingKernels.h"
+#include "NormalDistribution.h"
+#include "RateCurve.h"
+#include "VectorMath.h"
+#include <cmath>
+#include <typeinfo>
+
+namespace
+{
+    const std::size_t CHUNK = 256;
+
+    // Spot-independent part of the Black-Scholes formulas, computed once per Vector() call
+    struct Invariants
+    {
+        double sig, r, b, T;
+        double sqrtT;
+        double volSqrtT;  // sigma*sqrt(T)
+        double drift;     // (b + sigma^2/2) T, the spot-free part of d1's numerator
+        double invK;      // 1/K, so log(S/K) = log(S * invK)
+        double carry;     // exp((b-r)T)
+        double K_df;      // K exp(-rT)
+    };
+
+    Invariants MakeInvariants(const EuropeanOption& opt, const TermFactors* factors)
+    {
+        Invariants c;
+        c.sig = opt.sig; c.T = opt.T;
+        c.r = factors ? factors->r : opt.r;
+        c.b = factors ? factors->b : opt.b;
+        c.sqrtT = std::sqrt(opt.T);
+        c.volSqrtT = opt.sig * c.sqrtT;
+        c.drift = (c.b + 0.5 * opt.sig * opt.sig) * opt.T;
+        c.invK = 1.0 / opt.K;
+        c.carry = factors ? factors->carry : std::exp((c.b - c.r) * opt.T);
+        c.K_df = opt.K * (factors ? factors->discount : std::exp(-c.r * opt.T));
+        return c;
+    }
+
+    // Exact outputs for m <= CHUNK spots. Calls and puts share one expression through the constant sign w:
+    //   price = w (S carry N(w d1) - K df N(w d2)),  delta = w carry N(w d1),  rho = w K T df N(w d2)
+    //   theta = -S carry sig n(d1) / (2 sqrt(T)) - w ((b-r) S carry N(w d1) + r K df N(w d2))
+    //   gamma = carry n(d1) / (S sig sqrt(T)),       vega = S carry n(d1) sqrt(T)
+    // which are the formulas of Greeks::All; only the terms the output uses are evaluated.
+    template <OptionKind Kind, OutputType Output>
+    void ExactChunk(const Invariants& c, const double* S, std::size_t m, double* out, std::size_t stride)
+    {
+        constexpr double w = (Kind == OptionKind::Call) ? 1.0 : -1.0;
+        constexpr bool needNd1 = Output == OutputType::Price || Output == OutputType::Delta || Output == OutputType::Theta;
+        constexpr bool needNd2 = Output == OutputType::Price || Output == OutputType::Theta || Output == OutputType::Rho;
+        constexpr bool needPdf = Output == OutputType::Gamma || Output == OutputType::Vega || Output == OutputType::Theta;
+
+        double d1[CHUNK];
+        double Nd1[CHUNK];
+        double Nd2[CHUNK];
+        double pdf[CHUNK];
+
+        for (std::size_t j = 0; j < m; ++j)
+            d1[j] = S[j] * c.invK;
+        VectorMath::Log(d1, d1, m);
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            d1[j] = (d1[j] + c.drift) / c.volSqrtT;
+            if constexpr (needNd1) Nd1[j] = w * d1[j];
+            if constexpr (needNd2) Nd2[j] = w * (d1[j] - c.volSqrtT);
+        }
+
+        if constexpr (needNd1) N_cdf(Nd1, Nd1, m);
+        if constexpr (needNd2) N_cdf(Nd2, Nd2, m);
+        if constexpr (needPdf) N_pdf(d1, pdf, m);
+
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            double v;
+            if constexpr (Output == OutputType::Price)
+                v = w * (S[j] * c.carry * Nd1[j] - c.K_df * Nd2[j]);
+            else if constexpr (Output == OutputType::Delta)
+                v = w * c.carry * Nd1[j];
+            else if constexpr (Output == OutputType::Gamma)
+                v = c.carry * pdf[j] / (S[j] * c.volSqrtT);
+            else if constexpr (Output == OutputType::Vega)
+                v = S[j] * c.carry * pdf[j] * c.sqrtT;
+            else if constexpr (Output == OutputType::Theta)
+                v = -(S[j] * c.carry * c.sig * pdf[j]) / (2 * c.sqrtT)
+                    - w * ((c.b - c.r) * S[j] * c.carry * Nd1[j] + c.r * c.K_df * Nd2[j]);
+            else
+                v = w * c.K_df * c.T * Nd2[j];
+            out[j * stride] = v;
+        }
+    }
+
+    // DeltaFD / GammaFD: the same central differences as Greeks::DeltaFD / GammaFD, on chunked price evaluations
+    template <OptionKind Kind, OutputType Output>
+    void FiniteDifferenceChunk(const Invariants& c, const double* S, std::size_t m, double* out, std::size_t stride, double h)
+    {
+        double shifted[CHUNK];
+        double up[CHUNK];
+        double down[CHUNK];
+        double mid[CHUNK];
+
+        for (std::size_t j = 0; j < m; ++j) shifted[j] = S[j] + h;
+        ExactChunk<Kind, OutputType::Price>(c, shifted, m, up, 1);
+        for (std::size_t j = 0; j < m; ++j) shifted[j] = S[j] - h;
+        ExactChunk<Kind, OutputType::Price>(c, shifted, m, down, 1);
+
+        if constexpr (Output == OutputType::DeltaFD)
+        {
+            for (std::size_t j = 0; j < m; ++j)
+                out[j * stride] = (up[j] - down[j]) / (2.0 * h);
+        }
+        else
+        {
+            ExactChunk<Kind, OutputType::Price>(c, S, m, mid, 1);
+            for (std::size_t j = 0; j < m; ++j)
+                out[j * stride] = (up[j] - 2.0 * mid[j] + down[j]) / (h * h);
+        }
+    }
+}
+
+template <OptionKind Kind, OutputType Output>
+void PricingKernels::Loop(const EuropeanOption& opt, const TermFactors* factors, const double* S, std::size_t n,
+    double* out, std::size_t stride, double h)
+{
+    const Invariants c = MakeInvariants(opt, factors);
+
+    for (std::size_t start = 0; start < n; start += CHUNK)
+    {
+        const std::size_t m = (n - start < CHUNK) ? n - start : CHUNK;
+        if constexpr (Output == OutputType::DeltaFD || Output == OutputType::GammaFD)
+            FiniteDifferenceChunk<Kind, Output>(c, S + start, m, out + start * stride, stride, h);
+        else
+            ExactChunk<Kind, Output>(c, S + start, m, out + start * stride, stride);
+    }
+}
+
+bool PricingKernels::Supports(const EuropeanOption& opt, OutputType output)
+{
+    // Price-based outputs follow the dynamic type's Price(); only the plain European closed form is specialised here
+    const bool priceBased = output == OutputType::Price || output == OutputType::DeltaFD || output == OutputType::GammaFD;
+    return !priceBased || typeid(opt) == typeid(EuropeanOption);
+}
+
+void PricingKernels::Vector(const EuropeanOption& opt, const double* S, std::size_t n,
+    OutputType output, double* out, std::size_t stride, double h, const TermFactors* factors)
+{
+    // The only run-time decisions: one string compare and one switch per call, not per element
+    const bool call = KindOf(opt) == OptionKind::Call;
+
+    switch (output)
+    {
+    case OutputType::Price:
+        return call ? Loop<OptionKind::Call, OutputType::Price>(opt, factors, S, n, out, stride, h) : Loop<OptionKind::Put, OutputType::Price>(opt, factors, S, n, out, stride, h);
+    case OutputType::Delta:
+        return call ? Loop<OptionKind::Call, OutputType::Delta>(opt, factors, S, n, out, stride, h) : Loop<OptionKind::Put, OutputType::Delta>(opt, factors, S, n, out, stride, h);
+    case OutputType::Gamma:
+        return Loop<OptionKind::Call, OutputType::Gamma>(opt, factors, S, n, out, stride, h); // same for puts
+    case OutputType::Vega:
+        return Loop<OptionKind::Call, OutputType::Vega>(opt, factors, S, n, out, stride, h);  // same for puts
+    case OutputType::Theta:
+        return call ? Loop<OptionKind::Call, OutputType::Theta>(opt, factors, S, n, out, stride, h) : Loop<OptionKind::Put, OutputType::Theta>(opt, factors, S, n, out, stride, h);
+    case OutputType::Rho:
+        return call ? Loop<OptionKind::Call, OutputType::Rho>(opt, factors, S, n, out, stride, h) : Loop<OptionKind::Put, OutputType::Rho>(opt, factors, S, n, out, stride, h);
+    case OutputType::DeltaFD:
+        return call ? Loop<OptionKind::Call, OutputType::DeltaFD>(opt, factors, S, n, out, stride, h) : Loop<OptionKind::Put, OutputType::DeltaFD>(opt, factors, S, n, out, stride, h);
+    case OutputType::GammaFD:
+        return call ? Loop<OptionKind::Call, OutputType::GammaFD>(opt, factors, S, n, out, stride, h) : Loop<OptionKind::Put, OutputType::GammaFD>(opt, factors, S, n, out, stride, h);
+    }
+}
@@ -0,0 +1,452 @@
+
+#include "PricingPipeline.h"
+#include "BatchPricer.h"
+#include "BoundedQueue.h"
+#include "Greeks.h"
+#include "Philox.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double Seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+    // One unit of work passed between the stages. Allocated once per pipeline and recycled.
+    struct Chunk
+    {
+        std::size_t sequence = 0;   // position in the file, so the writer can restore order
+        OptionBatch batch;
+        std::vector<double> S;
+        std::vector<double> prices;
+        std::vector<GreeksResult> greeks;
+        std::vector<std::size_t> rejected;  // rows holding a placeholder for a malformed line, ascending
+
+        void Clear() { batch.Clear(); S.clear(); rejected.clear(); }
+        std::size_t Rows() const { return S.size(); }
+    };
+
+    // Parses one CSV line [p, end) "T,K,sig,r,b,S,type" into the chunk. Returns false for malformed lines.
+    bool ParseLine(const char* p, const char* end, Chunk& chunk)
+    {
+        double v[6];
+        for (int f = 0; f < 6; ++f)
+        {
+            while (p < end && (*p == ' ' || *p == '\t')) ++p;
+            std::from_chars_result res = std::from_chars(p, end, v[f]);
+            if (res.ec != std::errc()) return false;
+            p = res.ptr;
+            while (p < end && (*p == ' ' || *p == '\t')) ++p;
+            if (p == end || *p != ',') return false;
+            ++p;
+        }
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '"')) ++p;
+        if (p == end) return false;
+
+        bool call;
+        if (*p == 'C' || *p == 'c') call = true;
+        else if (*p == 'P' || *p == 'p') call = false;
+        else return false;
+
+        chunk.batch.Add(v[0], v[1], v[2], v[3], v[4], call);
+        chunk.S.push_back(v[5]);
+        return true;
+    }
+
+    // A header names the fields: a line none of whose comma-separated fields starts with a number. Any other line
+    // that fails ParseLine is a malformed contract, even when it is the first line of the file.
+    bool IsHeader(const char* p, const char* end)
+    {
+        while (p < end)
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '"')) ++p;
+            double v;
+            if (p < end && std::from_chars(p, end, v).ec == std::errc()) return false;
+            p = std::find(p, end, ',');
+            if (p < end) ++p;
+        }
+        return true;
+    }
+
+    // Holds the place of a malformed line, so output row i is still input contract i; the writer emits NaN for it
+    void RejectLine(Chunk& chunk)
+    {
+        chunk.rejected.push_back(chunk.Rows());
+        chunk.batch.Add(1.0, 1.0, 0.2, 0.0, 0.0, true);
+        chunk.S.push_back(1.0);
+    }
+
+    // Appends the results of one chunk to the output buffer, flushing it to the file as it fills
+    class Writer
+    {
+    public:
+        Writer(std::ofstream& out, std::size_t bytes, const PipelineSettings& settings)
+            : out(out), buffer(std::max<std::size_t>(bytes, 4096)), used(0), settings(settings) {}
+
+        void Header()
+        {
+            if (settings.outputFormat != QuoteFormat::Csv) return;
+            const char* header = settings.greeks ? "price,delta,gamma,vega,theta,rho\n" : "price\n";
+            for (const char* c = header; *c; ++c) buffer[used++] = *c;
+        }
+
+        void Write(const Chunk& chunk)
+        {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            const double rejectedValues[6] = { nan, nan, nan, nan, nan, nan };
+            const std::size_t n = chunk.Rows();
+            std::size_t nextRejected = 0;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                if (nextRejected < chunk.rejected.size() && chunk.rejected[nextRejected] == i)
+                {
+                    ++nextRejected;
+                    Row(rejectedValues, settings.greeks ? 6 : 1);
+                }
+                else if (settings.greeks)
+                {
+                    const GreeksResult& g = chunk.greeks[i];
+                    double values[6] = { g.price, g.delta, g.gamma, g.vega, g.theta, g.rho };
+                    Row(values, 6);
+                }
+                else
+                    Row(&chunk.prices[i], 1);
+            }
+        }
+
+        void Flush()
+        {
+            out.write(buffer.data(), static_cast<std::streamsize>(used));
+            used = 0;
+        }
+
+    private:
+        void Row(const double* values, int count)
+        {
+            // Worst case per value: 24 characters for the shortest round-trip form plus a separator
+            if (buffer.size() - used < 32 * static_cast<std::size_t>(count)) Flush();
+
+            if (settings.outputFormat == QuoteFormat::Binary)
+            {
+                const char* bytes = reinterpret_cast<const char*>(values);
+                std::copy(bytes, bytes + count * sizeof(double), buffer.data() + used);
+                used += count * sizeof(double);
+                return;
+            }
+
+            char* p = buffer.data() + used;
+            char* end = buffer.data() + buffer.size();
+            for (int k = 0; k < count; ++k)
+            {
+                p = std::to_chars(p, end, values[k]).ptr;
+                *p++ = (k + 1 < count) ? ',' : '\n';
+            }
+            used = p - buffer.data();
+        }
+
+        std::ofstream& out;
+        std::vector<char> buffer;
+        std::size_t used;
+        const PipelineSettings& settings;
+    };
+}
+
+PipelineStats PricingPipeline::Run(const std::string& inputPath, const std::string& outputPath, const PipelineSettings& settings)
+{
+    PipelineStats stats;
+    auto wallStart = Clock::now();
+
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) { stats.error = "cannot open input file " + inputPath; return stats; }
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out) { stats.error = "cannot open output file " + outputPath; return stats; }
+
+    const std::size_t chunkRows = std::max<std::size_t>(settings.chunkRows, 1);
+    const std::size_t chunkCount = std::max<std::size_t>(settings.chunks, 2);
+    const unsigned pricers = std::max(1u, settings.pricingThreads);
+
+    // All chunks are created up front; after this point the pipeline does not allocate per row
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    BoundedQueue<Chunk*> freeChunks(chunkCount), parsed(chunkCount), priced(chunkCount);
+    for (std::size_t c = 0; c < chunkCount; ++c)
+    {
+        chunks.emplace_back(new Chunk);
+        Chunk& chunk = *chunks.back();
+        chunk.batch.Reserve(chunkRows);
+        chunk.S.reserve(chunkRows);
+        chunk.prices.resize(chunkRows);
+        if (settings.greeks) chunk.greeks.resize(chunkRows);
+        freeChunks.Push(&chunk);
+    }
+
+    // ---------------- Parser ----------------
+    std::thread parser([&]
+    {
+        auto start = Clock::now();
+        Clock::duration waiting(0);
+        std::size_t sequence = 0;
+
+        Chunk* chunk = nullptr;
+        auto nextChunk = [&]() -> bool
+        {
+            auto w0 = Clock::now();
+            bool ok = freeChunks.Pop(chunk);
+            waiting += Clock::now() - w0;
+            if (ok) { chunk->Clear(); chunk->sequence = sequence++; }
+            return ok;
+        };
+        auto handOver = [&]
+        {
+            stats.parse.rows += chunk->Rows();
+            auto w0 = Clock::now();
+            parsed.Push(chunk);
+            waiting += Clock::now() - w0;
+            chunk = nullptr;
+        };
+
+        if (nextChunk())
+        {
+            if (settings.inputFormat == QuoteFormat::Binary)
+            {
+                std::vector<QuoteRecord> records(chunkRows);
+                for (;;)
+                {
+                    in.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(chunkRows * sizeof(QuoteRecord)));
+                    std::size_t n = static_cast<std::size_t>(in.gcount()) / sizeof(QuoteRecord);
+                    for (std::size_t i = 0; i < n; ++i)
+                    {
+                        const QuoteRecord& q = records[i];
+                        chunk->batch.Add(q.T, q.K, q.sig, q.r, q.b, q.call != 0);
+                        chunk->S.push_back(q.S);
+                    }
+                    if (n < chunkRows)
+                    {
+                        // A truncated last record still gets its (NaN) output row; n < chunkRows leaves room for it
+                        if (static_cast<std::size_t>(in.gcount()) % sizeof(QuoteRecord) != 0)
+                        {
+                            RejectLine(*chunk);
+                            ++stats.rejectedRows;
+                        }
+                        break;
+                    }
+                    handOver();
+                    if (!nextChunk()) break;
+                }
+            }
+            else
+            {
+                // Fixed read buffer; a line cut by the end of a block is moved to the front before the next read
+                std::vector<char> buffer(std::max<std::size_t>(settings.ioBufferBytes, 4096));
+                std::size_t carried = 0;
+                bool firstLine = true, eof = false;
+                bool skipping = false; // discarding the rest of a line longer than the buffer
+
+                while (!eof && chunk)
+                {
+                    in.read(buffer.data() + carried, static_cast<std::streamsize>(buffer.size() - carried));
+                    std::size_t filled = carried + static_cast<std::size_t>(in.gcount());
+                    eof = !in;
+
+                    const char* p = buffer.data();
+                    const char* end = buffer.data() + filled;
+                    for (;;)
+                    {
+                        const char* nl = std::find(p, end, '\n');
+                        if (nl == end && !eof) break; // incomplete line: wait for the next block
+                        if (p == end) break;
+
+                        const char* lineEnd = (nl > p && nl[-1] == '\r') ? nl - 1 : nl;
+                        if (skipping)
+                            skipping = false;
+                        else if (lineEnd > p)
+                        {
+                            if (!ParseLine(p, lineEnd, *chunk) && !(firstLine && IsHeader(p, lineEnd)))
+                            {
+                                RejectLine(*chunk);
+                                ++stats.rejectedRows;
+                            }
+                            firstLine = false;
+                            if (chunk->Rows() == chunkRows)
+                            {
+                                handOver();
+                                if (!nextChunk()) break;
+                            }
+                        }
+                        p = (nl == end) ? end : nl + 1;
+                    }
+
+                    carried = static_cast<std::size_t>(end - p);
+                    if (carried == buffer.size() && chunk)
+                    {
+                        // Line longer than the buffer: one rejected row, and the rest of the line is skipped
+                        carried = 0;
+                        if (!skipping)
+                        {
+                            RejectLine(*chunk);
+                            ++stats.rejectedRows;
+                            firstLine = false;
+                            skipping = true;
+                            if (chunk->Rows() == chunkRows)
+                            {
+                                handOver();
+                                if (!nextChunk()) break;
+                            }
+                        }
+                    }
+                    std::copy(p, end, buffer.data());
+                }
+            }
+
+            if (chunk)
+            {
+                if (chunk->Rows() > 0) handOver();
+                else freeChunks.Push(chunk);
+            }
+        }
+        parsed.Close();
+        stats.parse.busySeconds = Seconds(Clock::now() - start - waiting);
+    });
+
+    // ---------------- Pricers ----------------
+    std::atomic<unsigned> pricersLeft(pricers);
+    std::atomic<std::size_t> pricedRows(0);
+    std::vector<double> pricerBusy(pricers, 0.0);
+    std::vector<std::thread> pricerThreads;
+    for (unsigned t = 0; t < pricers; ++t)
+        pricerThreads.emplace_back([&, t]
+        {
+            Clock::duration busy(0);
+            Chunk* chunk;
+            while (parsed.Pop(chunk))
+            {
+                auto b0 = Clock::now();
+                if (settings.greeks)
+                    Greeks::AllBatch(chunk->batch, chunk->S.data(), chunk->greeks.data());
+                else
+                    BatchPricer::PriceBatch(chunk->batch, chunk->S.data(), chunk->prices.data());
+                busy += Clock::now() - b0;
+                pricedRows += chunk->Rows();
+                priced.Push(chunk);
+            }
+            pricerBusy[t] = Seconds(busy);
+            if (--pricersLeft == 0) priced.Close();
+        });
+
+    // ---------------- Writer (this thread) ----------------
+    {
+        auto start = Clock::now();
+        Clock::duration waiting(0);
+        Writer writer(out, settings.ioBufferBytes, settings);
+        writer.Header();
+
+        // Chunks priced out of order wait here; at most chunkCount of them exist
+        std::vector<Chunk*> pending;
+        std::size_t next = 0;
+        Chunk* chunk;
+        for (;;)
+        {
+            auto w0 = Clock::now();
+            bool ok = priced.Pop(chunk);
+            waiting += Clock::now() - w0;
+            if (!ok) break;
+
+            pending.push_back(chunk);
+            for (bool progress = true; progress; )
+            {
+                progress = false;
+                for (std::size_t i = 0; i < pending.size(); ++i)
+                    if (pending[i]->sequence == next)
+                    {
+                        Chunk* ready = pending[i];
+                        pending.erase(pending.begin() + i);
+                        writer.Write(*ready);
+                        stats.write.rows += ready->Rows();
+                        ++next;
+                        freeChunks.Push(ready);
+                        progress = true;
+                        break;
+                    }
+            }
+        }
+        writer.Flush();
+        out.flush();
+        if (!out) stats.error = "error writing output file " + outputPath;
+        stats.write.busySeconds = Seconds(Clock::now() - start - waiting);
+    }
+
+    parser.join();
+    for (std::thread& t : pricerThreads) t.join();
+
+    stats.price.rows = pricedRows;
+    for (double b : pricerBusy) stats.price.busySeconds += b / pricers;
+    stats.ok = stats.error.empty();
+    stats.wallSeconds = Seconds(Clock::now() - wallStart);
+    return stats;
+}
+
+bool PricingPipeline::WriteSampleFile(const std::string& path, std::size_t rows, QuoteFormat format, std::uint64_t seed)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    Philox rng(seed);
+    std::vector<char> buffer(1 << 20);
+    std::size_t used = 0;
+    auto flush = [&] { out.write(buffer.data(), static_cast<std::streamsize>(used)); used = 0; };
+
+    if (format == QuoteFormat::Csv)
+    {
+        const char header[] = "T,K,sig,r,b,S,type\n";
+        std::copy(header, header + sizeof(header) - 1, buffer.data());
+        used = sizeof(header) - 1;
+    }
+
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        Philox::Block bits = rng(static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(i >> 32), 0, 0);
+        Philox::Block more = rng(static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(i >> 32), 1, 0);
+        auto unit = [](std::uint32_t x) { return (x + 0.5) / 4294967296.0; };
+
+        QuoteRecord q;
+        q.T = 0.05 + 2.95 * unit(bits.v[0]);
+        q.K = 50.0 + 100.0 * unit(bits.v[1]);
+        q.sig = 0.05 + 0.75 * unit(bits.v[2]);
+        q.r = 0.08 * unit(bits.v[3]);
+        q.b = q.r - 0.04 * unit(more.v[0]);
+        q.S = 60.0 + 80.0 * unit(more.v[1]);
+        q.call = (more.v[2] & 1) ? 1 : 0;
+        q.pad = 0;
+
+        if (buffer.size() - used < 256) flush();
+        if (format == QuoteFormat::Binary)
+        {
+            const char* bytes = reinterpret_cast<const char*>(&q);
+            std::copy(bytes, bytes + sizeof(q), buffer.data() + used);
+            used += sizeof(q);
+        }
+        else
+        {
+            char* p = buffer.data() + used;
+            char* end = buffer.data() + buffer.size();
+            const double fields[6] = { q.T, q.K, q.sig, q.r, q.b, q.S };
+            for (double f : fields)
+            {
+                p = std::to_chars(p, end, f).ptr;
+                *p++ = ',';
+            }
+            *p++ = q.call ? 'C' : 'P';
+            *p++ = '\n';
+            used = p - buffer.data();
+        }
+    }
+    flush();
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,200 @@
+
+#include "RateCurve.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const std::uint64_t Golden = 0x9E3779B97F4A7C15ull; // 2^64 / golden ratio
+
+    std::uint64_t Bits(double T)
+    {
+        std::uint64_t key;
+        std::memcpy(&key, &T, sizeof(key));
+        return key;
+    }
+}
+
+RateCurve::RateCurve(double rate)
+    : times(1, 1.0), forwards(1, rate), integrals(1, rate), interpolation(CurveInterpolation::PiecewiseFlat)
+{
+}
+
+bool RateCurve::Set(const std::vector<double>& times_, const std::vector<double>& forwards_,
+    CurveInterpolation interpolation_)
+{
+    if (times_.empty() || times_.size() != forwards_.size() || !(times_[0] > 0.0)) return false;
+    for (std::size_t i = 1; i < times_.size(); ++i)
+        if (!(times_[i] > times_[i - 1])) return false;
+
+    times = times_;
+    forwards = forwards_;
+    interpolation = interpolation_;
+
+    // Cumulative integral at each knot: the first segment runs from 0 at forwards[0] in both schemes
+    integrals.resize(times.size());
+    integrals[0] = forwards[0] * times[0];
+    for (std::size_t i = 1; i < times.size(); ++i)
+    {
+        const double dt = times[i] - times[i - 1];
+        const double average = (interpolation == CurveInterpolation::PiecewiseFlat)
+            ? forwards[i] : 0.5 * (forwards[i - 1] + forwards[i]);
+        integrals[i] = integrals[i - 1] + average * dt;
+    }
+    return true;
+}
+
+std::size_t RateCurve::Segment(double T) const
+{
+    return std::lower_bound(times.begin(), times.end(), T) - times.begin();
+}
+
+double RateCurve::Forward(double T) const
+{
+    const std::size_t i = Segment(T);
+    if (i == 0) return forwards[0];
+    if (i == times.size()) return forwards.back();
+    if (interpolation == CurveInterpolation::PiecewiseFlat) return forwards[i];
+
+    const double weight = (T - times[i - 1]) / (times[i] - times[i - 1]);
+    return forwards[i - 1] + weight * (forwards[i] - forwards[i - 1]);
+}
+
+// Integral from the knot below T: f is constant there (flat) or linear, f(T) = f_i-1 + slope (T - t_i-1)
+double RateCurve::Integral(double T) const
+{
+    const std::size_t i = Segment(T);
+    if (i == 0) return forwards[0] * T;
+    if (i == times.size()) return integrals.back() + forwards.back() * (T - times.back());
+
+    const double dt = T - times[i - 1];
+    if (interpolation == CurveInterpolation::PiecewiseFlat) return integrals[i - 1] + forwards[i] * dt;
+
+    const double slope = (forwards[i] - forwards[i - 1]) / (times[i] - times[i - 1]);
+    return integrals[i - 1] + dt * (forwards[i - 1] + 0.5 * slope * dt);
+}
+
+double RateCurve::ZeroRate(double T) const
+{
+    return (T > 0.0) ? Integral(T) / T : forwards[0];
+}
+
+double RateCurve::Discount(double T) const
+{
+    return std::exp(-Integral(T));
+}
+
+void RateCurve::ZeroRates(const double* T, std::size_t n, double* out) const
+{
+    for (std::size_t i = 0; i < n; ++i) out[i] = ZeroRate(T[i]);
+}
+
+// Integrals first, then one SIMD exponential over the whole array
+void RateCurve::Discounts(const double* T, std::size_t n, double* out) const
+{
+    for (std::size_t i = 0; i < n; ++i) out[i] = -Integral(T[i]);
+    VectorMath::Exp(out, out, n);
+}
+
+void TermStructure::Precompute(const std::vector<double>& maturities)
+{
+    std::vector<double> positive;
+    for (double T : maturities)
+        if (T > 0.0) positive.push_back(T);
+    grid.clear(); // so the new grid is computed from the current curves
+    grid = DistinctFactors(positive.data(), positive.size());
+}
+
+MaturityIndex::MaturityIndex()
+    : slots(16, Slot{ 0, 0 }), shift(60)
+{
+}
+
+// Linear probing from the hashed slot; the table is kept at most half full
+std::size_t MaturityIndex::Add(double T)
+{
+    const std::uint64_t key = Bits(T);
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = static_cast<std::size_t>((key * Golden) >> shift);; i = (i + 1) & mask)
+    {
+        Slot& slot = slots[i];
+        if (slot.position != 0)
+        {
+            if (slot.key == key) return slot.position - 1;
+            continue;
+        }
+        if (2 * (maturities.size() + 1) > slots.size())
+        {
+            Grow();
+            return Add(T);
+        }
+        slot.key = key;
+        maturities.push_back(T);
+        slot.position = maturities.size();
+        return maturities.size() - 1;
+    }
+}
+
+void MaturityIndex::Grow()
+{
+    slots.assign(2 * slots.size(), Slot{ 0, 0 });
+    --shift;
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t p = 0; p < maturities.size(); ++p)
+    {
+        const std::uint64_t key = Bits(maturities[p]);
+        std::size_t i = static_cast<std::size_t>((key * Golden) >> shift);
+        while (slots[i].position != 0) i = (i + 1) & mask;
+        slots[i] = Slot{ key, p + 1 };
+    }
+}
+
+// One hash pass collects the distinct maturities; only those are sorted, then evaluated once each
+std::vector<TermFactors> TermStructure::DistinctFactors(const double* T, std::size_t n) const
+{
+    MaturityIndex index;
+    for (std::size_t i = 0; i < n; ++i)
+        if (T[i] == T[i]) index.Add(T[i]); // NaN has no place in the order
+    std::vector<double> sorted = index.Maturities();
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<TermFactors> table;
+    table.reserve(sorted.size());
+    for (double t : sorted) table.push_back(Factors(t));
+    return table;
+}
+
+const TermFactors* TermStructure::Find(const std::vector<TermFactors>& table, double T)
+{
+    auto it = std::lower_bound(table.begin(), table.end(), T, [](const TermFactors& f, double t) { return f.T < t; });
+    return (it != table.end() && it->T == T) ? &*it : nullptr;
+}
+
+TermFactors TermStructure::Compute(double T) const
+{
+    TermFactors f;
+    f.T = T;
+    const double rateIntegral = rate.Integral(T);
+    const double carryIntegral = carry.Integral(T);
+    f.r = (T > 0.0) ? rateIntegral / T : rate.Forward(0.0);
+    f.b = (T > 0.0) ? carryIntegral / T : carry.Forward(0.0);
+    f.discount = std::exp(-rateIntegral);
+    f.carry = std::exp(carryIntegral - rateIntegral);
+    f.forwardR = rate.Forward(T);
+    f.forwardB = carry.Forward(T);
+    return f;
+}
+
+TermFactors TermStructure::Factors(double T) const
+{
+    const TermFactors* cached = Find(grid, T);
+    return cached ? *cached : Compute(T);
+}
+
+void TermStructure::Factors(const double* T, std::size_t n, TermFactors* out) const
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = (i > 0 && T[i] == T[i - 1]) ? out[i - 1] : Factors(T[i]);
+}
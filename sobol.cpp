@@ -0,0 +1,91 @@
+
+#include "Sobol.h"
+
+namespace
+{
+    // Joe-Kuo new-joe-kuo-6.21201 parameters for dimensions 2..21: degree s, polynomial coefficients a, initial m_1..m_s.
+    // Dimension 1 is the van der Corput sequence (all m = 1).
+    struct Primitive
+    {
+        unsigned s;
+        unsigned a;
+        unsigned m[7];
+    };
+
+    const Primitive JoeKuo[] =
+    {
+        { 1, 0,  { 1 } },
+        { 2, 1,  { 1, 3 } },
+        { 3, 1,  { 1, 3, 1 } },
+        { 3, 2,  { 1, 1, 1 } },
+        { 4, 1,  { 1, 1, 3, 3 } },
+        { 4, 4,  { 1, 3, 5, 13 } },
+        { 5, 2,  { 1, 1, 5, 5, 17 } },
+        { 5, 4,  { 1, 1, 5, 5, 5 } },
+        { 5, 7,  { 1, 1, 7, 11, 19 } },
+        { 5, 11, { 1, 1, 5, 1, 1 } },
+        { 5, 13, { 1, 1, 1, 3, 11 } },
+        { 5, 14, { 1, 3, 5, 5, 31 } },
+        { 6, 1,  { 1, 3, 3, 9, 7, 49 } },
+        { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+        { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+        { 6, 19, { 1, 1, 1, 15, 7, 5 } },
+        { 6, 22, { 1, 3, 1, 15, 13, 25 } },
+        { 6, 25, { 1, 1, 5, 5, 19, 61 } },
+        { 7, 1,  { 1, 3, 7, 11, 23, 15, 103 } },
+        { 7, 4,  { 1, 3, 7, 13, 13, 15, 69 } }
+    };
+
+    unsigned LowestZeroBit(std::uint64_t x)
+    {
+        unsigned c = 0;
+        while (x & 1) { x >>= 1; ++c; }
+        return c;
+    }
+}
+
+SobolSequence::SobolSequence(unsigned dimensions)
+    : dims(dimensions < 1 ? 1 : (dimensions > MaxDimensions ? MaxDimensions : dimensions)),
+      directions(dims * 32)
+{
+    for (unsigned bit = 0; bit < 32; ++bit)
+        directions[bit] = 1u << (31 - bit);
+
+    for (unsigned d = 1; d < dims; ++d)
+    {
+        const Primitive& p = JoeKuo[d - 1];
+        std::uint32_t* v = &directions[d * 32];
+
+        for (unsigned bit = 0; bit < p.s; ++bit)
+            v[bit] = p.m[bit] << (31 - bit);
+
+        // Recurrence from the primitive polynomial x^s + a_1 x^(s-1) + ... + a_(s-1) x + 1
+        for (unsigned bit = p.s; bit < 32; ++bit)
+        {
+            v[bit] = v[bit - p.s] ^ (v[bit - p.s] >> p.s);
+            for (unsigned k = 1; k < p.s; ++k)
+                if ((p.a >> (p.s - 1 - k)) & 1)
+                    v[bit] ^= v[bit - k];
+        }
+    }
+}
+
+void SobolSequence::Point(std::uint64_t n, std::uint32_t* out) const
+{
+    const std::uint64_t gray = n ^ (n >> 1);
+    for (unsigned d = 0; d < dims; ++d)
+    {
+        std::uint32_t x = 0;
+        for (unsigned bit = 0; bit < 32; ++bit)
+            if ((gray >> bit) & 1) x ^= directions[d * 32 + bit];
+        out[d] = x;
+    }
+}
+
+void SobolSequence::Next(std::uint64_t n, std::uint32_t* out) const
+{
+    // Gray codes of n - 1 and n differ in the lowest zero bit of n - 1
+    const unsigned bit = LowestZeroBit(n - 1);
+    for (unsigned d = 0; d < dims; ++d)
+        out[d] ^= directions[d * 32 + bit];
+}
@@ -0,0 +1,22 @@
+
+#include "Surface.h"
+
+Surface::Surface()
+    : rows(0), cols(0), layout(SurfaceLayout::RowMajor)
+{
+}
+
+Surface::Surface(std::size_t rows_, std::size_t cols_, SurfaceLayout layout_)
+    : rows(rows_), cols(cols_), layout(layout_), data(rows_ * cols_)
+{
+}
+
+void Surface::Resize(std::size_t rows_, std::size_t cols_, SurfaceLayout layout_)
+{
+    rows = rows_;
+    cols = cols_;
+    layout = layout_;
+
+    // std::vector::resize only reallocates when growing past the current capacity
+    data.resize(rows * cols);
+}
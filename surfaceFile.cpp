@@ -0,0 +1,294 @@
+
+#include "SurfaceFile.h"
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char Magic[8] = { 'O', 'P', 'T', 'S', 'U', 'R', 'F', 0 };
+    const std::uint32_t ByteOrderTag = 0x01020304u;
+    const std::size_t ParamsPerRow = 5;
+    const std::size_t PageBytes = 4096;
+    const std::size_t BlockAlignDoubles = 64 / sizeof(double);
+
+    std::size_t RoundUp(std::size_t n, std::size_t multiple)
+    {
+        return (n + multiple - 1) / multiple * multiple;
+    }
+
+    // True when count doubles starting at offset end at or before end. Written without adding or multiplying the
+    // header's values, which come from the file and could wrap around in 64 bits.
+    bool Fits(std::uint64_t offset, std::uint64_t count, std::uint64_t end)
+    {
+        return offset <= end && count <= (end - offset) / sizeof(double);
+    }
+}
+
+static_assert(sizeof(SurfaceFileHeader) == 128, "SurfaceFileHeader must stay 128 bytes: it is the on-disk format");
+
+SurfaceFile::SurfaceFile()
+    : base(nullptr), bytes(0), writable(false)
+#ifdef _WIN32
+    , fileHandle(nullptr), mappingHandle(nullptr)
+#else
+    , fd(-1)
+#endif
+{
+}
+
+SurfaceFile::~SurfaceFile()
+{
+    Close();
+}
+
+// Opens the file and maps 'bytes' of it (create = true: read-write, truncated and resized first;
+// create = false: read-only, bytes = 0 maps the whole file)
+bool SurfaceFile::Map(const std::string& path, std::size_t size, bool create)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), create ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+        FILE_SHARE_READ, nullptr, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) { error = "cannot open " + path; return false; }
+
+    if (!create)
+    {
+        LARGE_INTEGER length;
+        if (!GetFileSizeEx(file, &length)) { CloseHandle(file); error = "cannot stat " + path; return false; }
+        size = static_cast<std::size_t>(length.QuadPart);
+    }
+    if (size < sizeof(SurfaceFileHeader)) { CloseHandle(file); error = path + " is too small to be a surface file"; return false; }
+
+    // CreateFileMapping with an explicit size grows a new file to that size
+    const unsigned long long size64 = size;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, create ? PAGE_READWRITE : PAGE_READONLY,
+        static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFFu), nullptr);
+    if (!mapping) { CloseHandle(file); error = "cannot map " + path; return false; }
+
+    void* view = MapViewOfFile(mapping, create ? (FILE_MAP_READ | FILE_MAP_WRITE) : FILE_MAP_READ, 0, 0, size);
+    if (!view) { CloseHandle(mapping); CloseHandle(file); error = "cannot map " + path; return false; }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    base = static_cast<unsigned char*>(view);
+#else
+    int handle = create ? ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : ::open(path.c_str(), O_RDONLY);
+    if (handle < 0) { error = "cannot open " + path; return false; }
+
+    if (create)
+    {
+        // ftruncate leaves a sparse file of zeros; pages are allocated as the pricer writes them
+        if (::ftruncate(handle, static_cast<off_t>(size)) != 0) { ::close(handle); error = "cannot resize " + path; return false; }
+    }
+    else
+    {
+        struct stat st;
+        if (::fstat(handle, &st) != 0) { ::close(handle); error = "cannot stat " + path; return false; }
+        size = static_cast<std::size_t>(st.st_size);
+    }
+    if (size < sizeof(SurfaceFileHeader)) { ::close(handle); error = path + " is too small to be a surface file"; return false; }
+
+    void* view = ::mmap(nullptr, size, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, handle, 0);
+    if (view == MAP_FAILED) { ::close(handle); error = "cannot map " + path; return false; }
+
+    fd = handle;
+    base = static_cast<unsigned char*>(view);
+#endif
+    bytes = size;
+    writable = create;
+    return true;
+}
+
+bool SurfaceFile::Create(const std::string& path,
+    const std::vector<std::vector<double>>& paramMatrix,
+    const std::vector<double>& S_values,
+    OutputType output,
+    SurfaceLayout layout)
+{
+    Close();
+    error.clear();
+
+    for (const auto& p : paramMatrix)
+        if (p.size() < 4) { error = "parameter rows need at least T, K, sig, r"; return false; }
+
+    const std::size_t rows = paramMatrix.size();
+    const std::size_t cols = S_values.size();
+    const std::size_t blocks = (layout == SurfaceLayout::ColumnMajor) ? cols : rows;
+    const std::size_t blockLength = (layout == SurfaceLayout::ColumnMajor) ? rows : cols;
+    const std::size_t blockStride = RoundUp(blockLength, BlockAlignDoubles);
+
+    const std::size_t paramOffset = sizeof(SurfaceFileHeader);
+    const std::size_t spotOffset = paramOffset + rows * ParamsPerRow * sizeof(double);
+    const std::size_t dataOffset = RoundUp(spotOffset + cols * sizeof(double), PageBytes);
+    const std::size_t fileBytes = dataOffset + blocks * blockStride * sizeof(double);
+
+    if (!Map(path, fileBytes, true)) return false;
+
+    SurfaceFileHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, Magic, sizeof(Magic));
+    h.version = Version;
+    h.byteOrder = ByteOrderTag;
+    h.outputType = static_cast<std::uint32_t>(output);
+    h.layout = static_cast<std::uint32_t>(layout);
+    h.rows = rows;
+    h.cols = cols;
+    h.paramsPerRow = ParamsPerRow;
+    h.paramOffset = paramOffset;
+    h.spotOffset = spotOffset;
+    h.dataOffset = dataOffset;
+    h.blockStride = blockStride;
+    h.fileBytes = fileBytes;
+    std::memcpy(base, &h, sizeof(h));
+
+    // Parameter rows are stored normalised to (T, K, sig, r, b), with b defaulting to r as in MatrixPricer
+    double* params = reinterpret_cast<double*>(base + paramOffset);
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        const std::vector<double>& p = paramMatrix[i];
+        for (std::size_t k = 0; k < 4; ++k)
+            params[i * ParamsPerRow + k] = p[k];
+        params[i * ParamsPerRow + 4] = (p.size() > 4) ? p[4] : p[3];
+    }
+
+    if (cols > 0)
+        std::memcpy(base + spotOffset, S_values.data(), cols * sizeof(double));
+
+    return true;
+}
+
+bool SurfaceFile::Open(const std::string& path)
+{
+    Close();
+    error.clear();
+
+    if (!Map(path, 0, false)) return false;
+
+    // Every offset and size is checked against the mapped length before any accessor can dereference it. The
+    // checks compare each offset with the end of its section before anything is added to it, and divide instead of
+    // multiplying counts, so no corrupt value can wrap around past them.
+    const SurfaceFileHeader& h = header();
+    const char* problem = nullptr;
+
+    if (std::memcmp(h.magic, Magic, sizeof(Magic)) != 0) problem = "not a surface file";
+    else if (h.byteOrder != ByteOrderTag) problem = "written with a different byte order";
+    else if (h.version != Version) problem = "unsupported surface file version";
+    else if (h.outputType > static_cast<std::uint32_t>(OutputType::GammaFD)) problem = "unknown output type";
+    else if (h.layout > static_cast<std::uint32_t>(SurfaceLayout::ColumnMajor)) problem = "unknown layout";
+    else if (h.paramsPerRow != ParamsPerRow) problem = "unexpected parameter row width";
+    else
+    {
+        const std::uint64_t blocks = (h.layout == static_cast<std::uint32_t>(SurfaceLayout::ColumnMajor)) ? h.cols : h.rows;
+        const std::uint64_t blockLength = (h.layout == static_cast<std::uint32_t>(SurfaceLayout::ColumnMajor)) ? h.rows : h.cols;
+        const std::uint64_t limit = bytes / sizeof(double);
+
+        if (h.rows > limit || h.cols > limit || h.blockStride > limit) problem = "corrupt shape";
+        else if (h.fileBytes != bytes) problem = "file size does not match its header (truncated?)";
+        else if (h.paramOffset < sizeof(SurfaceFileHeader) || h.paramOffset % sizeof(double) != 0
+            || h.spotOffset % sizeof(double) != 0 || h.dataOffset % sizeof(double) != 0
+            || h.spotOffset > bytes || h.dataOffset > bytes
+            || !Fits(h.paramOffset, h.rows * ParamsPerRow, h.spotOffset)
+            || !Fits(h.spotOffset, h.cols, h.dataOffset)) problem = "corrupt section offsets";
+        else if (h.blockStride < blockLength
+            || (h.blockStride > 0 && blocks > (bytes - h.dataOffset) / sizeof(double) / h.blockStride))
+            problem = "data section out of range";
+    }
+
+    if (problem)
+    {
+        Close();
+        error = path + ": " + problem;
+        return false;
+    }
+    return true;
+}
+
+bool SurfaceFile::Flush()
+{
+    if (!base || !writable) return false;
+#ifdef _WIN32
+    return FlushViewOfFile(base, bytes) != 0 && FlushFileBuffers(static_cast<HANDLE>(fileHandle)) != 0;
+#else
+    return ::msync(base, bytes, MS_SYNC) == 0;
+#endif
+}
+
+void SurfaceFile::Close()
+{
+    if (!base) return;
+
+    // Writable mappings are written back synchronously so a reader opening the file right after sees every value
+    if (writable) Flush();
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    ::munmap(base, bytes);
+    ::close(fd);
+    fd = -1;
+#endif
+    base = nullptr;
+    bytes = 0;
+    writable = false;
+}
+
+const double* SurfaceFile::Params(std::size_t row) const
+{
+    if (!base) return nullptr;
+    return reinterpret_cast<const double*>(base + header().paramOffset) + row * ParamsPerRow;
+}
+
+const double* SurfaceFile::Spots() const
+{
+    if (!base) return nullptr;
+    return reinterpret_cast<const double*>(base + header().spotOffset);
+}
+
+double* SurfaceFile::Data()
+{
+    if (!base) return nullptr;
+    return reinterpret_cast<double*>(base + header().dataOffset);
+}
+
+const double* SurfaceFile::Data() const
+{
+    if (!base) return nullptr;
+    return reinterpret_cast<const double*>(base + header().dataOffset);
+}
+
+std::size_t SurfaceFile::RowStride() const
+{
+    if (!base) return 0;
+    return Layout() == SurfaceLayout::RowMajor ? static_cast<std::size_t>(header().blockStride) : 1;
+}
+
+std::size_t SurfaceFile::ColStride() const
+{
+    if (!base) return 0;
+    return Layout() == SurfaceLayout::RowMajor ? 1 : static_cast<std::size_t>(header().blockStride);
+}
+
+SurfaceSlice SurfaceFile::Row(std::size_t row) const
+{
+    SurfaceSlice s = { Data() + row * RowStride(), Cols(), ColStride() };
+    return s;
+}
+
+SurfaceSlice SurfaceFile::Column(std::size_t col) const
+{
+    SurfaceSlice s = { Data() + col * ColStride(), Rows(), RowStride() };
+    return s;
+}
@@ -0,0 +1,301 @@
+
+#include "ThreadPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    // One ParallelFor call. Lives on the caller's stack until every range has run.
+    struct Job
+    {
+        const ThreadPool::RangeFunction* body;
+        unsigned maxWorker;                  // workers with index >= maxWorker may not run this job
+        std::atomic<std::size_t> remaining;  // ranges not yet finished
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    struct Task
+    {
+        Job* job;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    // Double-ended ring of tasks over a power-of-two array. Unlike std::deque, which allocates and frees blocks as
+    // tasks come and go, the array only grows and is kept across jobs, so once the pool has queued its largest job
+    // pushing tasks allocates nothing.
+    class TaskRing
+    {
+    public:
+        bool Empty() const { return count == 0; }
+        const Task& Front() const { return slots[head]; }
+        const Task& Back() const { return slots[(head + count - 1) & (slots.size() - 1)]; }
+
+        void PushBack(const Task& task)
+        {
+            if (count == slots.size()) Grow();
+            slots[(head + count) & (slots.size() - 1)] = task;
+            ++count;
+        }
+
+        void PopBack() { --count; }
+
+        void PopFront()
+        {
+            head = (head + 1) & (slots.size() - 1);
+            --count;
+        }
+
+        // Removes the oldest task of job, closing the gap; false when there is none
+        bool Take(const Job* job, Task& out)
+        {
+            const std::size_t mask = slots.size() - 1;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (slots[(head + i) & mask].job != job) continue;
+                out = slots[(head + i) & mask];
+                for (std::size_t k = i + 1; k < count; ++k) slots[(head + k - 1) & mask] = slots[(head + k) & mask];
+                --count;
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        void Grow()
+        {
+            std::vector<Task> larger(slots.empty() ? 64 : 2 * slots.size());
+            for (std::size_t i = 0; i < count; ++i) larger[i] = slots[(head + i) & (slots.size() - 1)];
+            slots.swap(larger);
+            head = 0;
+        }
+
+        std::vector<Task> slots;
+        std::size_t head = 0;
+        std::size_t count = 0;
+    };
+
+    // Task deque of one worker. A mutex per deque keeps the owner and thieves correct
+    // while contention stays low because each thread mostly touches its own deque.
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        TaskRing tasks;
+    };
+
+    // Pool and deque index of the worker running on this thread, so a ParallelFor called from inside a task
+    // knows it is blocking one of the pool's own workers
+    thread_local const void* currentPool = nullptr;
+    thread_local unsigned currentWorker = 0;
+}
+
+struct ThreadPool::Impl
+{
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+
+    // The flags are atomic so the idle checks read them without the lock. Writers change them first and then take and
+    // release sleepMutex before notifying: a waiter that tested its predicate under the lock is then already waiting.
+    std::mutex sleepMutex;
+    std::condition_variable wake;  // signalled when new tasks are pushed or on shutdown
+    std::condition_variable done;  // signalled when a job's last task finishes, and when tasks are pushed (for nested callers)
+    std::atomic<std::size_t> generation{ 0 }; // bumped every time tasks are pushed
+    std::atomic<bool> stopping{ false };
+
+    void Notify(std::condition_variable& cv)
+    {
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        cv.notify_all();
+    }
+
+    // Owner side: newest task from the back of its own deque
+    bool PopOwn(unsigned index, Task& out)
+    {
+        WorkQueue& q = *queues[index];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.Empty()) return false;
+        out = q.tasks.Back();
+        q.tasks.PopBack();
+        return true;
+    }
+
+    // Thief side: oldest task from the front of another deque. 'self' is the stealing worker (or queues.size() for the caller);
+    // 'only' restricts the caller to tasks of its own job, which are taken from anywhere in a deque since tasks of
+    // other jobs may be queued ahead of them.
+    bool Steal(unsigned self, const Job* only, Task& out)
+    {
+        const unsigned n = static_cast<unsigned>(queues.size());
+        for (unsigned k = 1; k <= n; ++k)
+        {
+            unsigned victim = (self + k) % n;
+            WorkQueue& q = *queues[victim];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.Empty()) continue;
+
+            if (only)
+            {
+                if (q.tasks.Take(only, out)) return true;
+                continue;
+            }
+
+            const Task& front = q.tasks.Front();
+            if (self >= front.job->maxWorker) continue;
+
+            out = front;
+            q.tasks.PopFront();
+            return true;
+        }
+        return false;
+    }
+
+    // Runs one task; the one that brings its job's remaining count to zero wakes the waiting callers, so the lock is
+    // taken once per job instead of once per task. The job lives on its caller's stack and may be gone as soon as the
+    // count reaches zero, so nothing of it is touched after the decrement.
+    void RunTask(const Task& task)
+    {
+        Job& job = *task.job;
+        try
+        {
+            (*job.body)(task.begin, task.end);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(job.errorMutex);
+            if (!job.error) job.error = std::current_exception();
+        }
+        if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) Notify(done);
+    }
+
+    void WorkerLoop(unsigned index)
+    {
+        currentPool = this;
+        currentWorker = index;
+
+        for (;;)
+        {
+            // Remember which batch of pushes we have seen before looking for work, so a push that lands
+            // between the failed search and the wait below is not missed
+            if (stopping.load(std::memory_order_acquire)) return;
+            const std::size_t seen = generation.load(std::memory_order_acquire);
+
+            Task task;
+            if (PopOwn(index, task) || Steal(index, nullptr, task))
+            {
+                RunTask(task);
+                continue;
+            }
+
+            // Nothing this worker may take: sleep until the next push or shutdown
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this, seen]
+            {
+                return stopping.load(std::memory_order_acquire) || generation.load(std::memory_order_acquire) != seen;
+            });
+        }
+    }
+};
+
+ThreadPool::ThreadPool(unsigned workers)
+    : impl(new Impl)
+{
+    if (workers == 0)
+    {
+        unsigned hw = std::thread::hardware_concurrency();
+        workers = (hw > 1) ? hw - 1 : 1;
+    }
+
+    for (unsigned i = 0; i < workers; ++i)
+        impl->queues.emplace_back(new WorkQueue);
+    for (unsigned i = 0; i < workers; ++i)
+        impl->threads.emplace_back([this, i] { impl->WorkerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    impl->stopping.store(true, std::memory_order_release);
+    impl->Notify(impl->wake);
+    for (std::thread& t : impl->threads) t.join();
+}
+
+unsigned ThreadPool::Workers() const
+{
+    return static_cast<unsigned>(impl->threads.size());
+}
+
+void ThreadPool::ParallelFor(std::size_t count, std::size_t grain, const RangeFunction& body, unsigned threads)
+{
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    const std::size_t ranges = (count + grain - 1) / grain;
+    const unsigned workers = Workers();
+    const unsigned helpers = (threads == 0 || threads - 1 > workers) ? workers : threads - 1;
+
+    // Nothing to share: run inline without touching the queues
+    if (helpers == 0 || ranges == 1)
+    {
+        for (std::size_t begin = 0; begin < count; begin += grain)
+            body(begin, (begin + grain < count) ? begin + grain : count);
+        return;
+    }
+
+    Job job;
+    job.body = &body;
+    job.maxWorker = helpers;
+    job.remaining.store(ranges);
+
+    // Deal the ranges round-robin onto the deques of the participating workers
+    for (std::size_t r = 0; r < ranges; ++r)
+    {
+        std::size_t begin = r * grain;
+        Task task = { &job, begin, (begin + grain < count) ? begin + grain : count };
+        WorkQueue& q = *impl->queues[r % helpers];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.PushBack(task);
+    }
+    impl->generation.fetch_add(1, std::memory_order_acq_rel);
+    impl->Notify(impl->wake);
+    impl->done.notify_all(); // nested callers waiting below also look for new tasks
+
+    // The caller runs ranges of its own job until none are left, then waits for the ones still running.
+    // Called from inside a task (nested ParallelFor) the caller is one of the workers: while it waits it runs any
+    // task that worker may take, so every worker blocked in a nested call still drains the queues and the pool
+    // cannot deadlock with all of its workers waiting.
+    const bool nested = currentPool == impl.get();
+    const unsigned callerIndex = nested ? currentWorker : workers;
+    Task task;
+    while (impl->Steal(callerIndex, &job, task))
+        impl->RunTask(task);
+
+    while (job.remaining.load(std::memory_order_acquire) != 0)
+    {
+        const std::size_t seen = impl->generation.load(std::memory_order_acquire);
+
+        if (nested && (impl->Steal(callerIndex, &job, task) || impl->PopOwn(callerIndex, task) ||
+            impl->Steal(callerIndex, nullptr, task)))
+        {
+            impl->RunTask(task);
+            continue;
+        }
+
+        // Sleep until the job's last task finishes or, for a nested caller, new tasks are pushed
+        std::unique_lock<std::mutex> lock(impl->sleepMutex);
+        impl->done.wait(lock, [&]
+        {
+            return job.remaining.load(std::memory_order_acquire) == 0
+                || (nested && impl->generation.load(std::memory_order_acquire) != seen);
+        });
+    }
+
+    if (job.error) std::rethrow_exception(job.error);
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,427 @@
+
+#include "TickEngine.h"
+#include "AmericanOption.h"
+#include "Philox.h"
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+struct TickEngine::Subscription
+{
+    std::unique_ptr<EuropeanOption> option;  // private clone, repriced in place
+    AmericanOption* american;                // same object when it is an AmericanOption, else nullptr
+    std::uint32_t underlying;
+    std::uint64_t sequence;
+};
+
+// Update stream of one consumer. The parked updates are touched only by the engine thread.
+struct TickEngine::Consumer
+{
+    SpscRing<PriceUpdate> ring;
+    std::vector<PriceUpdate> parked;         // newest undelivered update per subscription while the ring was full
+    std::vector<unsigned char> isParked;
+    std::vector<std::uint32_t> parkedOrder;  // subscriptions in the order they were parked
+
+    explicit Consumer(std::size_t capacity) : ring(capacity) {}
+};
+
+// Latest-value slot: a sequence lock over atomic fields. The engine makes the version odd while writing and even
+// again afterwards; a reader retries when the version was odd or changed underneath it.
+struct TickEngine::BoardSlot
+{
+    std::atomic<std::uint64_t> version{ 0 };
+    std::atomic<std::uint32_t> underlying{ 0 };
+    std::atomic<double> spot{ 0.0 }, price{ 0.0 }, delta{ 0.0 }, gamma{ 0.0 }, vega{ 0.0 }, theta{ 0.0 }, rho{ 0.0 };
+    std::atomic<std::int64_t> tickNs{ 0 }, publishNs{ 0 };
+    std::atomic<std::uint64_t> sequence{ 0 };
+};
+
+TickEngine::TickEngine(const TickEngineSettings& settings_)
+    : settings(settings_), ticks(settings_.inputCapacity), running(false), started(false),
+    ticksReceived(0), ticksCoalesced(0), ticksRejected(0), pushFailures(0),
+    repricings(0), updatesPublished(0), updatesCoalesced(0)
+{
+    if (settings.maxBatch == 0) settings.maxBatch = 1;
+}
+
+TickEngine::~TickEngine()
+{
+    Stop();
+}
+
+std::int64_t TickEngine::NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::size_t TickEngine::Subscribe(const EuropeanOption& opt, std::uint32_t underlying)
+{
+    if (started) return NotRegistered;
+
+    std::unique_ptr<Subscription> sub(new Subscription);
+    sub->option = opt.Clone();
+    sub->american = dynamic_cast<AmericanOption*>(sub->option.get());
+    sub->underlying = underlying;
+    sub->sequence = 0;
+
+    if (byUnderlying.size() <= underlying) byUnderlying.resize(static_cast<std::size_t>(underlying) + 1);
+    byUnderlying[underlying].push_back(subscriptions.size());
+    subscriptions.push_back(std::move(sub));
+    return subscriptions.size() - 1;
+}
+
+std::size_t TickEngine::AddConsumer(std::size_t capacity)
+{
+    if (started) return NotRegistered;
+    consumers.emplace_back(new Consumer(capacity));
+    return consumers.size() - 1;
+}
+
+void TickEngine::Start()
+{
+    if (started) return;
+    started = true;
+
+    // Everything the hot path touches is sized here, so the engine thread never allocates
+    board.reset(new BoardSlot[subscriptions.size() ? subscriptions.size() : 1]);
+    for (auto& c : consumers)
+    {
+        c->parked.resize(subscriptions.size());
+        c->isParked.assign(subscriptions.size(), 0);
+        c->parkedOrder.reserve(subscriptions.size());
+    }
+    pending.resize(byUnderlying.size());
+    hasPending.assign(byUnderlying.size(), 0);
+    touched.reserve(byUnderlying.size());
+
+    running.store(true, std::memory_order_release);
+    worker = std::thread([this] { Run(); });
+}
+
+void TickEngine::Stop()
+{
+    if (!worker.joinable()) return;
+    running.store(false, std::memory_order_release);
+    worker.join();
+}
+
+bool TickEngine::PushTick(std::uint32_t underlying, double spot)
+{
+    Tick t = { underlying, spot, NowNs() };
+    if (ticks.TryPush(t)) return true;
+    pushFailures.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool TickEngine::Poll(std::size_t consumer, PriceUpdate& out)
+{
+    return consumers[consumer]->ring.TryPop(out);
+}
+
+bool TickEngine::Latest(std::size_t subscription, PriceUpdate& out) const
+{
+    if (!board || subscription >= subscriptions.size()) return false;
+    const BoardSlot& slot = board[subscription];
+
+    for (;;)
+    {
+        const std::uint64_t before = slot.version.load(std::memory_order_acquire);
+        if (before == 0) return false;
+        if (before & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        out.subscription = static_cast<std::uint32_t>(subscription);
+        out.underlying = slot.underlying.load(std::memory_order_relaxed);
+        out.spot = slot.spot.load(std::memory_order_relaxed);
+        out.values.price = slot.price.load(std::memory_order_relaxed);
+        out.values.delta = slot.delta.load(std::memory_order_relaxed);
+        out.values.gamma = slot.gamma.load(std::memory_order_relaxed);
+        out.values.vega = slot.vega.load(std::memory_order_relaxed);
+        out.values.theta = slot.theta.load(std::memory_order_relaxed);
+        out.values.rho = slot.rho.load(std::memory_order_relaxed);
+        out.tickNs = slot.tickNs.load(std::memory_order_relaxed);
+        out.publishNs = slot.publishNs.load(std::memory_order_relaxed);
+        out.sequence = slot.sequence.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) == before) return true;
+    }
+}
+
+TickEngineStats TickEngine::Stats() const
+{
+    TickEngineStats s;
+    s.ticksReceived = ticksReceived.load(std::memory_order_relaxed);
+    s.ticksCoalesced = ticksCoalesced.load(std::memory_order_relaxed);
+    s.ticksRejected = ticksRejected.load(std::memory_order_relaxed);
+    s.pushFailures = pushFailures.load(std::memory_order_relaxed);
+    s.repricings = repricings.load(std::memory_order_relaxed);
+    s.updatesPublished = updatesPublished.load(std::memory_order_relaxed);
+    s.updatesCoalesced = updatesCoalesced.load(std::memory_order_relaxed);
+    return s;
+}
+
+void TickEngine::Run()
+{
+    unsigned idle = 0;
+    while (running.load(std::memory_order_acquire))
+    {
+        bool busy = ProcessBatch();
+        for (auto& c : consumers)
+            if (!c->parkedOrder.empty())
+            {
+                FlushParked(*c);
+                busy = true;
+            }
+
+        if (busy) idle = 0;
+        else if (++idle > settings.idleSpins) std::this_thread::yield();
+    }
+
+    // Price what was queued before Stop(); parked updates get one last chance at the consumer rings
+    while (ProcessBatch()) {}
+    for (auto& c : consumers) FlushParked(*c);
+}
+
+// Drains up to maxBatch ticks, keeping the newest per underlying, then prices each touched underlying once
+bool TickEngine::ProcessBatch()
+{
+    Tick t;
+    std::size_t drained = 0;
+    while (drained < settings.maxBatch && ticks.TryPop(t))
+    {
+        ++drained;
+        if (t.underlying >= byUnderlying.size() || byUnderlying[t.underlying].empty())
+        {
+            ticksRejected.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (hasPending[t.underlying])
+            ticksCoalesced.fetch_add(1, std::memory_order_relaxed);
+        else
+        {
+            hasPending[t.underlying] = 1;
+            touched.push_back(t.underlying);
+        }
+        pending[t.underlying] = t;
+    }
+    if (drained == 0) return false;
+    ticksReceived.fetch_add(drained, std::memory_order_relaxed);
+
+    for (std::uint32_t u : touched)
+    {
+        PriceUnderlying(pending[u]);
+        hasPending[u] = 0;
+    }
+    touched.clear();
+    return true;
+}
+
+void TickEngine::PriceUnderlying(const Tick& tick)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double S = tick.spot;
+
+    for (std::size_t index : byUnderlying[tick.underlying])
+    {
+        Subscription& sub = *subscriptions[index];
+        GreeksResult g = { nan, nan, nan, nan, nan, nan };
+
+        if (sub.american && sub.american->method == AmericanMethod::Lattice)
+        {
+            if (settings.greeks) g = sub.american->LatticeGreeks(S);
+            else g.price = sub.american->Price(S);
+        }
+        else if (sub.american)
+        {
+            // Perpetual and closed-form approximations: spot sensitivities through the price; perpetual contracts
+            // have no time decay, the approximations take it from a one-day step back in maturity
+            g.price = sub.american->Reprice(S);
+            if (settings.greeks)
+            {
+                const double h = 1e-4 * S;
+                const double up = sub.american->Reprice(S + h), down = sub.american->Reprice(S - h);
+                g.delta = (up - down) / (2.0 * h);
+                g.gamma = (up - 2.0 * g.price + down) / (h * h);
+                g.theta = 0.0;
+
+                const double dt = 1.0 / 365.0;
+                AmericanOption& american = *sub.american;
+                if (american.method != AmericanMethod::Perpetual && american.T > dt)
+                {
+                    const double T = american.T;
+                    american.T = T - dt;
+                    g.theta = (american.Price(S) - g.price) / dt;
+                    american.T = T;
+                }
+            }
+        }
+        else if (settings.greeks)
+            g = Greeks::All(*sub.option, S);
+        else
+            g.price = sub.option->Reprice(S);
+
+        PriceUpdate update;
+        update.subscription = static_cast<std::uint32_t>(index);
+        update.underlying = tick.underlying;
+        update.spot = S;
+        update.values = g;
+        update.tickNs = tick.timestampNs;
+        update.sequence = ++sub.sequence;
+        update.publishNs = NowNs();
+
+        repricings.fetch_add(1, std::memory_order_relaxed);
+        Publish(update);
+        latency.Record(static_cast<std::uint64_t>(update.publishNs > update.tickNs ? update.publishNs - update.tickNs : 0));
+    }
+}
+
+void TickEngine::Publish(const PriceUpdate& update)
+{
+    // Latest-value board
+    BoardSlot& slot = board[update.subscription];
+    const std::uint64_t v = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.underlying.store(update.underlying, std::memory_order_relaxed);
+    slot.spot.store(update.spot, std::memory_order_relaxed);
+    slot.price.store(update.values.price, std::memory_order_relaxed);
+    slot.delta.store(update.values.delta, std::memory_order_relaxed);
+    slot.gamma.store(update.values.gamma, std::memory_order_relaxed);
+    slot.vega.store(update.values.vega, std::memory_order_relaxed);
+    slot.theta.store(update.values.theta, std::memory_order_relaxed);
+    slot.rho.store(update.values.rho, std::memory_order_relaxed);
+    slot.tickNs.store(update.tickNs, std::memory_order_relaxed);
+    slot.publishNs.store(update.publishNs, std::memory_order_relaxed);
+    slot.sequence.store(update.sequence, std::memory_order_relaxed);
+    slot.version.store(v + 2, std::memory_order_release);
+
+    // Streams: an update already parked for this subscription is stale and gets replaced, so per-subscription
+    // order is kept and a full ring never blocks the engine
+    for (auto& cp : consumers)
+    {
+        Consumer& c = *cp;
+        if (c.isParked[update.subscription])
+        {
+            c.parked[update.subscription] = update;
+            updatesCoalesced.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (c.ring.TryPush(update))
+            updatesPublished.fetch_add(1, std::memory_order_relaxed);
+        else
+        {
+            c.parked[update.subscription] = update;
+            c.isParked[update.subscription] = 1;
+            c.parkedOrder.push_back(update.subscription);
+        }
+    }
+}
+
+void TickEngine::FlushParked(Consumer& c)
+{
+    std::size_t sent = 0;
+    while (sent < c.parkedOrder.size() && c.ring.TryPush(c.parked[c.parkedOrder[sent]]))
+    {
+        c.isParked[c.parkedOrder[sent]] = 0;
+        ++sent;
+    }
+    if (sent == 0) return;
+    updatesPublished.fetch_add(sent, std::memory_order_relaxed);
+    c.parkedOrder.erase(c.parkedOrder.begin(), c.parkedOrder.begin() + static_cast<std::ptrdiff_t>(sent));
+}
+
+// ---------------- Replay ----------------
+
+bool TickReplay::Load(const std::string& path, std::vector<ReplayTick>& ticks, std::string& error)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    ticks.clear();
+    std::string line;
+    std::size_t lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        ReplayTick t;
+        const char* p = line.data();
+        const char* end = p + line.size();
+        std::from_chars_result a = std::from_chars(p, end, t.timestampNs);
+        std::from_chars_result b = (a.ec == std::errc() && a.ptr != end && *a.ptr == ',')
+            ? std::from_chars(a.ptr + 1, end, t.underlying) : std::from_chars_result{ end, std::errc::invalid_argument };
+        std::from_chars_result c = (b.ec == std::errc() && b.ptr != end && *b.ptr == ',')
+            ? std::from_chars(b.ptr + 1, end, t.spot) : std::from_chars_result{ end, std::errc::invalid_argument };
+        if (c.ec != std::errc() || c.ptr != end)
+        {
+            error = path + ": malformed tick on line " + std::to_string(lineNumber);
+            return false;
+        }
+        ticks.push_back(t);
+    }
+    return true;
+}
+
+std::size_t TickReplay::Play(TickEngine& engine, const std::vector<ReplayTick>& ticks, double speed)
+{
+    if (ticks.empty()) return 0;
+
+    const std::int64_t origin = ticks.front().timestampNs;
+    const std::int64_t wallStart = TickEngine::NowNs();
+    std::size_t pushed = 0;
+
+    for (const ReplayTick& t : ticks)
+    {
+        if (speed > 0.0)
+        {
+            const std::int64_t due = wallStart + static_cast<std::int64_t>(static_cast<double>(t.timestampNs - origin) / speed);
+            while (TickEngine::NowNs() < due) std::this_thread::yield();
+        }
+        while (!engine.PushTick(t.underlying, t.spot)) std::this_thread::yield();
+        ++pushed;
+    }
+    return pushed;
+}
+
+bool TickReplay::WriteSample(const std::string& path, std::size_t count, std::uint32_t underlyings,
+    std::int64_t intervalNs, std::uint64_t seed)
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out || underlyings == 0) return false;
+
+    Philox rng(seed);
+    std::vector<double> spot(underlyings);
+    for (std::uint32_t u = 0; u < underlyings; ++u) spot[u] = 100.0 + 10.0 * u;
+
+    out << "# timestamp_ns,underlying,spot\n";
+    char buffer[96];
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        double u0, u1;
+        rng.Uniform2(i, 0, u0, u1);
+        const std::uint32_t name = static_cast<std::uint32_t>(u0 * underlyings) % underlyings;
+        spot[name] *= 1.0 + 0.002 * (u1 - 0.5); // small multiplicative random walk
+
+        // Each field stops short of the end of the buffer, leaving room for its separator
+        char* const last = buffer + sizeof(buffer) - 1;
+        char* p = std::to_chars(buffer, last, static_cast<std::int64_t>(i) * intervalNs).ptr;
+        *p++ = ',';
+        p = std::to_chars(p, last, name).ptr;
+        *p++ = ',';
+        p = std::to_chars(p, last, spot[name]).ptr;
+        *p++ = '\n';
+        out.write(buffer, p - buffer);
+    }
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,859 @@
+
+#include "VectorMath.h"
+#include <cmath>
+#include <cstdint>
+#include <atomic>
+#include <limits>
+
+// The SIMD kernels are compiled for x86 only. Each kernel carries its own target attribute on GCC/Clang,
+// so this file builds without -mavx2/-mavx512f and the right kernel is chosen at runtime.
+// MSVC accepts the intrinsics without extra flags.
+#if defined(__x86_64__) || defined(_M_X64)
+#define VM_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define VM_TARGET_AVX2
+#define VM_TARGET_AVX512
+#else
+#define VM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define VM_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#endif
+#else
+#define VM_X86 0
+#endif
+
+namespace
+{
+    // ---------------- Shared constants ----------------
+
+    const double LOG2E = 1.4426950408889634074;
+    const double LN2_HI = 6.93147180369123816490e-01; // ln(2) split into a high part with trailing zero bits...
+    const double LN2_LO = 1.90821492927058770002e-10; // ...and the remainder, so n*LN2_HI is exact
+    const double SQRT2 = 1.4142135623730950488;
+    const double INV_SQRT_2PI = 0.39894228040143267794;
+
+    const double EXP_HI = 709.782712893383973; // ln(DBL_MAX): above this exp overflows
+    const double EXP_LO = -745.133219101941108; // below this exp underflows to zero
+
+    // Taylor coefficients 1/k! for exp(r) on |r| <= ln(2)/2; degree 12 keeps the truncation error below 2e-16
+    const double EXP_C[13] = {
+        1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+        1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600
+    };
+
+    // 1/(2k+1) for the atanh series log(m) = 2*atanh(f), f = (m-1)/(m+1), |f| <= 0.1716
+    const double LOG_C[12] = {
+        1.0, 1.0 / 3, 1.0 / 5, 1.0 / 7, 1.0 / 9, 1.0 / 11,
+        1.0 / 13, 1.0 / 15, 1.0 / 17, 1.0 / 19, 1.0 / 21, 1.0 / 23
+    };
+
+    // Hart (1968) rational approximation for the normal tail, as published by West (2005).
+    // For |x| < 4 the tail is exp(-x^2/2) * P(|x|) / Q(|x|) (relative error <= 3e-13 there). Beyond that the rational
+    // loses relative accuracy, so the Laplace continued fraction for the Mills ratio takes over, with 32 terms
+    // instead of the published four-term version (which is only good to ~1e-8 relative).
+    const double CDF_P[7] = {
+        3.52624965998911e-02, 0.700383064443688, 6.37396220353165, 33.912866078383,
+        112.079291497871, 221.213596169931, 220.206867912376
+    };
+    const double CDF_Q[8] = {
+        8.83883476483184e-02, 1.75566716318264, 16.064177579207, 86.7807322029461,
+        296.564248779674, 637.333633378831, 793.826512519948, 440.413735824752
+    };
+    const double CDF_SPLIT = 4.0;
+    const double CDF_CUTOFF = 38.5;            // the tail underflows to zero beyond this point
+    const int CDF_CF_TERMS = 32;               // continued fraction depth for the far tail
+
+    // Single precision: the same algorithms with the series cut where their truncation error falls below float
+    // rounding (2^-24 = 6e-8), so each float lane costs less work as well as half the register width
+    const float LOG2E_F = 1.44269504f;
+    const float LN2_HI_F = 0.693359375f;       // ln(2) = LN2_HI_F + LN2_LO_F with 9 significant bits in LN2_HI_F
+    const float LN2_LO_F = -2.12194440e-4f;
+    const float SQRT2_F = 1.41421356f;
+    const float INV_SQRT_2PI_F = 0.398942280f;
+    const float EXP_HI_F = 88.7228394f;        // ln(FLT_MAX)
+    const float EXP_LO_F = -103.972084f;       // below this exp underflows to zero
+    const int EXP_DEGREE_F = 7;                // Taylor degree of exp(r) on |r| <= ln(2)/2 (truncation 5e-9)
+    const int LOG_TERMS_F = 5;                 // atanh series terms (truncation 2e-9)
+    const float CDF_CUTOFF_F = 14.5f;          // the tail underflows to zero beyond this point
+    const int CDF_CF_TERMS_F = 16;
+
+    std::atomic<SimdLevel>& ActiveLevelRef();
+
+    // ---------------- Scalar kernels ----------------
+    // The scalar level uses the standard library for exp/log/sqrt and the same Hart algorithm for the CDF
+
+    inline double CdfScalar(double x)
+    {
+        double a = std::fabs(x);
+        double tail = 0.0;
+
+        if (a < CDF_CUTOFF)
+        {
+            double e = std::exp(-0.5 * a * a);
+            if (a < CDF_SPLIT)
+            {
+                double p = CDF_P[0];
+                for (int k = 1; k < 7; ++k) p = p * a + CDF_P[k];
+                double q = CDF_Q[0];
+                for (int k = 1; k < 8; ++k) q = q * a + CDF_Q[k];
+                tail = e * p / q;
+            }
+            else
+            {
+                double cf = a;
+                for (int k = CDF_CF_TERMS; k >= 1; --k) cf = a + k / cf;
+                tail = e / cf * INV_SQRT_2PI;
+            }
+        }
+
+        if (x != x) return x; // NaN propagates
+        return (x > 0.0) ? 1.0 - tail : tail;
+    }
+
+    void ExpScalarArray(const double* x, double* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = std::exp(x[i]);
+    }
+
+    void LogScalarArray(const double* x, double* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = std::log(x[i]);
+    }
+
+    void SqrtScalarArray(const double* x, double* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = std::sqrt(x[i]);
+    }
+
+    void CdfScalarArray(const double* x, double* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = CdfScalar(x[i]);
+    }
+
+    void PdfScalarArray(const double* x, double* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = INV_SQRT_2PI * std::exp(-0.5 * x[i] * x[i]);
+    }
+
+    // Single-precision scalar level: the double functions rounded once to float
+    void ExpFScalarArray(const float* x, float* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = std::exp(x[i]);
+    }
+
+    void LogFScalarArray(const float* x, float* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = std::log(x[i]);
+    }
+
+    void SqrtFScalarArray(const float* x, float* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = std::sqrt(x[i]);
+    }
+
+    void CdfFScalarArray(const float* x, float* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = static_cast<float>(CdfScalar(x[i]));
+    }
+
+    void PdfFScalarArray(const float* x, float* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = static_cast<float>(INV_SQRT_2PI * std::exp(-0.5 * static_cast<double>(x[i]) * x[i]));
+    }
+
+#if VM_X86
+
+    // ---------------- AVX2 kernels (4 doubles per register) ----------------
+
+    VM_TARGET_AVX2 inline __m256d Pow2Avx2(__m128i k)
+    {
+        // Builds 2^k directly in the exponent field; valid for k in [-1022, 1023]
+        __m256i e = _mm256_add_epi64(_mm256_cvtepi32_epi64(k), _mm256_set1_epi64x(1023));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(e, 52));
+    }
+
+    VM_TARGET_AVX2 inline __m256d ExpAvx2(__m256d x)
+    {
+        // Clamp first so the exponent arithmetic cannot overflow; out-of-range lanes are patched at the end
+        __m256d xc = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(EXP_LO)), _mm256_set1_pd(EXP_HI));
+
+        // x = n*ln2 + r with |r| <= ln2/2
+        __m256d n = _mm256_round_pd(_mm256_mul_pd(xc, _mm256_set1_pd(LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_HI), xc);
+        r = _mm256_fnmadd_pd(n, _mm256_set1_pd(LN2_LO), r);
+
+        __m256d p = _mm256_set1_pd(EXP_C[12]);
+        for (int k = 11; k >= 0; --k)
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_C[k]));
+
+        // Scale by 2^n in two halves so both the overflow edge (n = 1024) and denormal results (n < -1022) stay representable
+        __m128i ni = _mm256_cvtpd_epi32(n);
+        __m128i n1 = _mm_srai_epi32(ni, 1);
+        __m128i n2 = _mm_sub_epi32(ni, n1);
+        __m256d result = _mm256_mul_pd(_mm256_mul_pd(p, Pow2Avx2(n1)), Pow2Avx2(n2));
+
+        result = _mm256_blendv_pd(result, _mm256_setzero_pd(), _mm256_cmp_pd(x, _mm256_set1_pd(EXP_LO), _CMP_LT_OQ));
+        result = _mm256_blendv_pd(result, _mm256_set1_pd(HUGE_VAL), _mm256_cmp_pd(x, _mm256_set1_pd(EXP_HI), _CMP_GT_OQ));
+        return _mm256_blendv_pd(result, x, _mm256_cmp_pd(x, x, _CMP_UNORD_Q)); // NaN in, NaN out
+    }
+
+    VM_TARGET_AVX2 inline __m256d LogAvx2(__m256d x)
+    {
+        // Split x = m * 2^e with m in [1, 2) by working on the bit pattern (valid for positive normal x)
+        __m256i bits = _mm256_castpd_si256(x);
+        __m256i eBits = _mm256_srli_epi64(bits, 52);
+        __m256d e = _mm256_sub_pd(
+            _mm256_castsi256_pd(_mm256_or_si256(eBits, _mm256_set1_epi64x(0x4330000000000000LL))),
+            _mm256_set1_pd(4503599627370496.0 + 1023.0)); // exponent bits as double, minus 2^52 and the bias
+
+        __m256d m = _mm256_castsi256_pd(_mm256_or_si256(
+            _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+            _mm256_set1_epi64x(0x3FF0000000000000LL)));
+
+        // Re-centre the mantissa on [sqrt(1/2), sqrt(2)) so the series argument stays small
+        __m256d big = _mm256_cmp_pd(m, _mm256_set1_pd(SQRT2), _CMP_GT_OQ);
+        m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+        e = _mm256_add_pd(e, _mm256_and_pd(big, _mm256_set1_pd(1.0)));
+
+        __m256d f = _mm256_div_pd(_mm256_sub_pd(m, _mm256_set1_pd(1.0)), _mm256_add_pd(m, _mm256_set1_pd(1.0)));
+        __m256d s = _mm256_mul_pd(f, f);
+
+        __m256d p = _mm256_set1_pd(LOG_C[11]);
+        for (int k = 10; k >= 0; --k)
+            p = _mm256_fmadd_pd(p, s, _mm256_set1_pd(LOG_C[k]));
+
+        __m256d logm = _mm256_mul_pd(_mm256_add_pd(f, f), p);
+        return _mm256_fmadd_pd(e, _mm256_set1_pd(LN2_HI), _mm256_fmadd_pd(e, _mm256_set1_pd(LN2_LO), logm));
+    }
+
+    VM_TARGET_AVX2 inline __m256d CdfAvx2(__m256d x)
+    {
+        __m256d a = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x); // |x|
+        __m256d e = ExpAvx2(_mm256_mul_pd(_mm256_set1_pd(-0.5), _mm256_mul_pd(a, a)));
+
+        __m256d p = _mm256_set1_pd(CDF_P[0]);
+        for (int k = 1; k < 7; ++k) p = _mm256_fmadd_pd(p, a, _mm256_set1_pd(CDF_P[k]));
+        __m256d q = _mm256_set1_pd(CDF_Q[0]);
+        for (int k = 1; k < 8; ++k) q = _mm256_fmadd_pd(q, a, _mm256_set1_pd(CDF_Q[k]));
+        __m256d tail = _mm256_div_pd(_mm256_mul_pd(e, p), q);
+
+        // The continued fraction is only needed when some lane is in the far tail
+        __m256d far = _mm256_cmp_pd(a, _mm256_set1_pd(CDF_SPLIT), _CMP_GE_OQ);
+        if (_mm256_movemask_pd(far))
+        {
+            __m256d cf = a;
+            for (int k = CDF_CF_TERMS; k >= 1; --k)
+                cf = _mm256_add_pd(a, _mm256_div_pd(_mm256_set1_pd(k), cf));
+            __m256d farTail = _mm256_mul_pd(_mm256_div_pd(e, cf), _mm256_set1_pd(INV_SQRT_2PI));
+            tail = _mm256_blendv_pd(tail, farTail, far);
+            tail = _mm256_blendv_pd(tail, _mm256_setzero_pd(), _mm256_cmp_pd(a, _mm256_set1_pd(CDF_CUTOFF), _CMP_GE_OQ));
+        }
+
+        __m256d positive = _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_GT_OQ);
+        __m256d result = _mm256_blendv_pd(tail, _mm256_sub_pd(_mm256_set1_pd(1.0), tail), positive);
+        return _mm256_blendv_pd(result, x, _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+    }
+
+    VM_TARGET_AVX2 inline __m256d SqrtAvx2(__m256d x)
+    {
+        return _mm256_sqrt_pd(x);
+    }
+
+    VM_TARGET_AVX2 inline __m256d PdfAvx2(__m256d x)
+    {
+        return _mm256_mul_pd(_mm256_set1_pd(INV_SQRT_2PI),
+            ExpAvx2(_mm256_mul_pd(_mm256_set1_pd(-0.5), _mm256_mul_pd(x, x))));
+    }
+
+    // Applies a 4-wide kernel to an array. The tail is padded into a local register-sized buffer
+    // so every element goes through the same instructions regardless of its position.
+    template <__m256d (*Kernel)(__m256d)>
+    VM_TARGET_AVX2 inline void ApplyAvx2(const double* x, double* out, std::size_t n)
+    {
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(out + i, Kernel(_mm256_loadu_pd(x + i)));
+
+        if (i < n)
+        {
+            double buf[4] = { 1.0, 1.0, 1.0, 1.0 };
+            for (std::size_t j = i; j < n; ++j) buf[j - i] = x[j];
+            _mm256_storeu_pd(buf, Kernel(_mm256_loadu_pd(buf)));
+            for (std::size_t j = i; j < n; ++j) out[j] = buf[j - i];
+        }
+    }
+
+    VM_TARGET_AVX2 void ExpAvx2Array(const double* x, double* out, std::size_t n)
+    {
+        ApplyAvx2<ExpAvx2>(x, out, n);
+    }
+
+    VM_TARGET_AVX2 void LogAvx2Array(const double* x, double* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; i += 4)
+        {
+            std::size_t count = (n - i < 4) ? n - i : 4;
+            double buf[4] = { 1.0, 1.0, 1.0, 1.0 };
+            for (std::size_t j = 0; j < count; ++j) buf[j] = x[i + j];
+
+            __m256d v = _mm256_loadu_pd(buf);
+            __m256d res = LogAvx2(v);
+
+            // Lanes outside the positive normal range (0, negatives, denormals, inf, NaN) take the library result
+            __m256d ok = _mm256_and_pd(
+                _mm256_cmp_pd(v, _mm256_set1_pd(std::numeric_limits<double>::min()), _CMP_GE_OQ),
+                _mm256_cmp_pd(v, _mm256_set1_pd(HUGE_VAL), _CMP_LT_OQ));
+            _mm256_storeu_pd(buf + 0, res);
+            int okMask = _mm256_movemask_pd(ok);
+            for (std::size_t j = 0; j < count; ++j)
+                out[i + j] = (okMask & (1 << j)) ? buf[j] : std::log(x[i + j]);
+        }
+    }
+
+    VM_TARGET_AVX2 void SqrtAvx2Array(const double* x, double* out, std::size_t n)
+    {
+        ApplyAvx2<SqrtAvx2>(x, out, n);
+    }
+
+    VM_TARGET_AVX2 void CdfAvx2Array(const double* x, double* out, std::size_t n)
+    {
+        ApplyAvx2<CdfAvx2>(x, out, n);
+    }
+
+    VM_TARGET_AVX2 void PdfAvx2Array(const double* x, double* out, std::size_t n)
+    {
+        ApplyAvx2<PdfAvx2>(x, out, n);
+    }
+
+    // ---------------- AVX2 single-precision kernels (8 floats per register) ----------------
+
+    VM_TARGET_AVX2 inline __m256 Pow2Avx2F(__m256i k)
+    {
+        // 2^k in the float exponent field; valid for k in [-126, 127]
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(k, _mm256_set1_epi32(127)), 23));
+    }
+
+    VM_TARGET_AVX2 inline __m256 ExpAvx2F(__m256 x)
+    {
+        __m256 xc = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_LO_F)), _mm256_set1_ps(EXP_HI_F));
+
+        __m256 n = _mm256_round_ps(_mm256_mul_ps(xc, _mm256_set1_ps(LOG2E_F)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_HI_F), xc);
+        r = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_LO_F), r);
+
+        __m256 p = _mm256_set1_ps(static_cast<float>(EXP_C[EXP_DEGREE_F]));
+        for (int k = EXP_DEGREE_F - 1; k >= 0; --k)
+            p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(static_cast<float>(EXP_C[k])));
+
+        // Two half-scalings, as in the double kernel, keep n = 128 and denormal results representable
+        __m256i ni = _mm256_cvtps_epi32(n);
+        __m256i n1 = _mm256_srai_epi32(ni, 1);
+        __m256i n2 = _mm256_sub_epi32(ni, n1);
+        __m256 result = _mm256_mul_ps(_mm256_mul_ps(p, Pow2Avx2F(n1)), Pow2Avx2F(n2));
+
+        result = _mm256_blendv_ps(result, _mm256_setzero_ps(), _mm256_cmp_ps(x, _mm256_set1_ps(EXP_LO_F), _CMP_LT_OQ));
+        result = _mm256_blendv_ps(result, _mm256_set1_ps(HUGE_VALF), _mm256_cmp_ps(x, _mm256_set1_ps(EXP_HI_F), _CMP_GT_OQ));
+        return _mm256_blendv_ps(result, x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+    }
+
+    VM_TARGET_AVX2 inline __m256 LogAvx2F(__m256 x)
+    {
+        // x = m * 2^e with m in [1, 2), valid for positive normal x
+        __m256i bits = _mm256_castps_si256(x);
+        __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+        __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+            _mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000)));
+
+        __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT2_F), _CMP_GT_OQ);
+        m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+        e = _mm256_add_ps(e, _mm256_and_ps(big, _mm256_set1_ps(1.0f)));
+
+        __m256 f = _mm256_div_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)), _mm256_add_ps(m, _mm256_set1_ps(1.0f)));
+        __m256 s = _mm256_mul_ps(f, f);
+
+        __m256 p = _mm256_set1_ps(static_cast<float>(LOG_C[LOG_TERMS_F - 1]));
+        for (int k = LOG_TERMS_F - 2; k >= 0; --k)
+            p = _mm256_fmadd_ps(p, s, _mm256_set1_ps(static_cast<float>(LOG_C[k])));
+
+        __m256 logm = _mm256_mul_ps(_mm256_add_ps(f, f), p);
+        return _mm256_fmadd_ps(e, _mm256_set1_ps(LN2_HI_F), _mm256_fmadd_ps(e, _mm256_set1_ps(LN2_LO_F), logm));
+    }
+
+    // exp(-x^2/2) with x^2 split into hi + lo by an FMA: rounding x^2 to float alone would cost a relative error of
+    // x^2 * 6e-8 in the result, 4e-6 in the tail at x = 8
+    VM_TARGET_AVX2 inline __m256 GaussAvx2F(__m256 x)
+    {
+        __m256 hi = _mm256_mul_ps(x, x);
+        __m256 lo = _mm256_fmsub_ps(x, x, hi);
+        return _mm256_mul_ps(ExpAvx2F(_mm256_mul_ps(_mm256_set1_ps(-0.5f), hi)),
+            _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), lo, _mm256_set1_ps(1.0f)));
+    }
+
+    VM_TARGET_AVX2 inline __m256 CdfAvx2F(__m256 x)
+    {
+        __m256 a = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+        __m256 e = GaussAvx2F(a);
+
+        __m256 p = _mm256_set1_ps(static_cast<float>(CDF_P[0]));
+        for (int k = 1; k < 7; ++k) p = _mm256_fmadd_ps(p, a, _mm256_set1_ps(static_cast<float>(CDF_P[k])));
+        __m256 q = _mm256_set1_ps(static_cast<float>(CDF_Q[0]));
+        for (int k = 1; k < 8; ++k) q = _mm256_fmadd_ps(q, a, _mm256_set1_ps(static_cast<float>(CDF_Q[k])));
+        __m256 tail = _mm256_div_ps(_mm256_mul_ps(e, p), q);
+
+        __m256 far = _mm256_cmp_ps(a, _mm256_set1_ps(static_cast<float>(CDF_SPLIT)), _CMP_GE_OQ);
+        if (_mm256_movemask_ps(far))
+        {
+            __m256 cf = a;
+            for (int k = CDF_CF_TERMS_F; k >= 1; --k)
+                cf = _mm256_add_ps(a, _mm256_div_ps(_mm256_set1_ps(static_cast<float>(k)), cf));
+            __m256 farTail = _mm256_mul_ps(_mm256_div_ps(e, cf), _mm256_set1_ps(INV_SQRT_2PI_F));
+            tail = _mm256_blendv_ps(tail, farTail, far);
+            tail = _mm256_blendv_ps(tail, _mm256_setzero_ps(), _mm256_cmp_ps(a, _mm256_set1_ps(CDF_CUTOFF_F), _CMP_GE_OQ));
+        }
+
+        __m256 positive = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ);
+        __m256 result = _mm256_blendv_ps(tail, _mm256_sub_ps(_mm256_set1_ps(1.0f), tail), positive);
+        return _mm256_blendv_ps(result, x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+    }
+
+    VM_TARGET_AVX2 inline __m256 SqrtAvx2F(__m256 x)
+    {
+        return _mm256_sqrt_ps(x);
+    }
+
+    VM_TARGET_AVX2 inline __m256 PdfAvx2F(__m256 x)
+    {
+        return _mm256_mul_ps(_mm256_set1_ps(INV_SQRT_2PI_F), GaussAvx2F(x));
+    }
+
+    template <__m256 (*Kernel)(__m256)>
+    VM_TARGET_AVX2 inline void ApplyAvx2F(const float* x, float* out, std::size_t n)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(out + i, Kernel(_mm256_loadu_ps(x + i)));
+
+        if (i < n)
+        {
+            float buf[8] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+            for (std::size_t j = i; j < n; ++j) buf[j - i] = x[j];
+            _mm256_storeu_ps(buf, Kernel(_mm256_loadu_ps(buf)));
+            for (std::size_t j = i; j < n; ++j) out[j] = buf[j - i];
+        }
+    }
+
+    VM_TARGET_AVX2 void ExpFAvx2Array(const float* x, float* out, std::size_t n)
+    {
+        ApplyAvx2F<ExpAvx2F>(x, out, n);
+    }
+
+    VM_TARGET_AVX2 void LogFAvx2Array(const float* x, float* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; i += 8)
+        {
+            std::size_t count = (n - i < 8) ? n - i : 8;
+            float buf[8] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+            for (std::size_t j = 0; j < count; ++j) buf[j] = x[i + j];
+
+            __m256 v = _mm256_loadu_ps(buf);
+            __m256 ok = _mm256_and_ps(
+                _mm256_cmp_ps(v, _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_GE_OQ),
+                _mm256_cmp_ps(v, _mm256_set1_ps(HUGE_VALF), _CMP_LT_OQ));
+            _mm256_storeu_ps(buf, LogAvx2F(v));
+            int okMask = _mm256_movemask_ps(ok);
+            for (std::size_t j = 0; j < count; ++j)
+                out[i + j] = (okMask & (1 << j)) ? buf[j] : std::log(x[i + j]);
+        }
+    }
+
+    VM_TARGET_AVX2 void SqrtFAvx2Array(const float* x, float* out, std::size_t n)
+    {
+        ApplyAvx2F<SqrtAvx2F>(x, out, n);
+    }
+
+    VM_TARGET_AVX2 void CdfFAvx2Array(const float* x, float* out, std::size_t n)
+    {
+        ApplyAvx2F<CdfAvx2F>(x, out, n);
+    }
+
+    VM_TARGET_AVX2 void PdfFAvx2Array(const float* x, float* out, std::size_t n)
+    {
+        ApplyAvx2F<PdfAvx2F>(x, out, n);
+    }
+
+    // ---------------- AVX-512 kernels (8 doubles per register) ----------------
+
+    // GCC's unmasked AVX-512 intrinsics (min/max, roundscale, scalef, getexp/getmant, sqrt) pass an undefined
+    // register as the merge source of an all-ones mask, which -Wmaybe-uninitialized reports once inlined (suppressed
+    // down to the end of the single-precision section)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+    VM_TARGET_AVX512 inline __m512d ExpAvx512(__m512d x)
+    {
+        __m512d xc = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(EXP_LO - 1.0)), _mm512_set1_pd(EXP_HI + 1.0));
+
+        __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(xc, _mm512_set1_pd(LOG2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_HI), xc);
+        r = _mm512_fnmadd_pd(n, _mm512_set1_pd(LN2_LO), r);
+
+        __m512d p = _mm512_set1_pd(EXP_C[12]);
+        for (int k = 11; k >= 0; --k)
+            p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_C[k]));
+
+        // scalef computes p * 2^n with correct overflow to infinity and gradual underflow
+        __m512d result = _mm512_scalef_pd(p, n);
+        return _mm512_mask_mov_pd(result, _mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q), x);
+    }
+
+    VM_TARGET_AVX512 inline __m512d LogAvx512(__m512d x)
+    {
+        // getexp/getmant split x = m * 2^e with m in [1, 2), including denormal inputs
+        __m512d e = _mm512_getexp_pd(x);
+        __m512d m = _mm512_getmant_pd(x, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+
+        __mmask8 big = _mm512_cmp_pd_mask(m, _mm512_set1_pd(SQRT2), _CMP_GT_OQ);
+        m = _mm512_mask_mul_pd(m, big, m, _mm512_set1_pd(0.5));
+        e = _mm512_mask_add_pd(e, big, e, _mm512_set1_pd(1.0));
+
+        __m512d f = _mm512_div_pd(_mm512_sub_pd(m, _mm512_set1_pd(1.0)), _mm512_add_pd(m, _mm512_set1_pd(1.0)));
+        __m512d s = _mm512_mul_pd(f, f);
+
+        __m512d p = _mm512_set1_pd(LOG_C[11]);
+        for (int k = 10; k >= 0; --k)
+            p = _mm512_fmadd_pd(p, s, _mm512_set1_pd(LOG_C[k]));
+
+        __m512d logm = _mm512_mul_pd(_mm512_add_pd(f, f), p);
+        return _mm512_fmadd_pd(e, _mm512_set1_pd(LN2_HI), _mm512_fmadd_pd(e, _mm512_set1_pd(LN2_LO), logm));
+    }
+
+    VM_TARGET_AVX512 inline __m512d CdfAvx512(__m512d x)
+    {
+        __m512d a = _mm512_abs_pd(x);
+        __m512d e = ExpAvx512(_mm512_mul_pd(_mm512_set1_pd(-0.5), _mm512_mul_pd(a, a)));
+
+        __m512d p = _mm512_set1_pd(CDF_P[0]);
+        for (int k = 1; k < 7; ++k) p = _mm512_fmadd_pd(p, a, _mm512_set1_pd(CDF_P[k]));
+        __m512d q = _mm512_set1_pd(CDF_Q[0]);
+        for (int k = 1; k < 8; ++k) q = _mm512_fmadd_pd(q, a, _mm512_set1_pd(CDF_Q[k]));
+        __m512d tail = _mm512_div_pd(_mm512_mul_pd(e, p), q);
+
+        __mmask8 far = _mm512_cmp_pd_mask(a, _mm512_set1_pd(CDF_SPLIT), _CMP_GE_OQ);
+        if (far)
+        {
+            __m512d cf = a;
+            for (int k = CDF_CF_TERMS; k >= 1; --k)
+                cf = _mm512_add_pd(a, _mm512_div_pd(_mm512_set1_pd(k), cf));
+            tail = _mm512_mask_mul_pd(tail, far, _mm512_div_pd(e, cf), _mm512_set1_pd(INV_SQRT_2PI));
+            tail = _mm512_mask_mov_pd(tail, _mm512_cmp_pd_mask(a, _mm512_set1_pd(CDF_CUTOFF), _CMP_GE_OQ), _mm512_setzero_pd());
+        }
+
+        __mmask8 positive = _mm512_cmp_pd_mask(x, _mm512_setzero_pd(), _CMP_GT_OQ);
+        __m512d result = _mm512_mask_sub_pd(tail, positive, _mm512_set1_pd(1.0), tail);
+        return _mm512_mask_mov_pd(result, _mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q), x);
+    }
+
+    VM_TARGET_AVX512 inline __m512d SqrtAvx512(__m512d x)
+    {
+        return _mm512_sqrt_pd(x);
+    }
+
+    VM_TARGET_AVX512 inline __m512d PdfAvx512(__m512d x)
+    {
+        return _mm512_mul_pd(_mm512_set1_pd(INV_SQRT_2PI),
+            ExpAvx512(_mm512_mul_pd(_mm512_set1_pd(-0.5), _mm512_mul_pd(x, x))));
+    }
+
+    // Applies an 8-wide kernel; the tail uses masked loads/stores instead of a scalar loop
+    template <__m512d (*Kernel)(__m512d)>
+    VM_TARGET_AVX512 inline void ApplyAvx512(const double* x, double* out, std::size_t n)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm512_storeu_pd(out + i, Kernel(_mm512_loadu_pd(x + i)));
+
+        if (i < n)
+        {
+            __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1u);
+            __m512d v = _mm512_mask_loadu_pd(_mm512_set1_pd(1.0), m, x + i);
+            _mm512_mask_storeu_pd(out + i, m, Kernel(v));
+        }
+    }
+
+    VM_TARGET_AVX512 void ExpAvx512Array(const double* x, double* out, std::size_t n)
+    {
+        ApplyAvx512<ExpAvx512>(x, out, n);
+    }
+
+    VM_TARGET_AVX512 void LogAvx512Array(const double* x, double* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; i += 8)
+        {
+            std::size_t count = (n - i < 8) ? n - i : 8;
+            __mmask8 m = static_cast<__mmask8>((1u << count) - 1u);
+            __m512d v = _mm512_mask_loadu_pd(_mm512_set1_pd(1.0), m, x + i);
+
+            // getexp/getmant handle denormals; zero, negatives, inf and NaN take the library result
+            __mmask8 ok = _mm512_cmp_pd_mask(v, _mm512_setzero_pd(), _CMP_GT_OQ)
+                & _mm512_cmp_pd_mask(v, _mm512_set1_pd(HUGE_VAL), _CMP_LT_OQ);
+            _mm512_mask_storeu_pd(out + i, m, LogAvx512(v));
+
+            __mmask8 bad = static_cast<__mmask8>(m & ~ok);
+            for (std::size_t j = 0; bad && j < count; ++j)
+                if (bad & (1u << j)) out[i + j] = std::log(x[i + j]);
+        }
+    }
+
+    VM_TARGET_AVX512 void SqrtAvx512Array(const double* x, double* out, std::size_t n)
+    {
+        ApplyAvx512<SqrtAvx512>(x, out, n);
+    }
+
+    VM_TARGET_AVX512 void CdfAvx512Array(const double* x, double* out, std::size_t n)
+    {
+        ApplyAvx512<CdfAvx512>(x, out, n);
+    }
+
+    VM_TARGET_AVX512 void PdfAvx512Array(const double* x, double* out, std::size_t n)
+    {
+        ApplyAvx512<PdfAvx512>(x, out, n);
+    }
+
+    // ---------------- AVX-512 single-precision kernels (16 floats per register) ----------------
+
+    VM_TARGET_AVX512 inline __m512 ExpAvx512F(__m512 x)
+    {
+        __m512 xc = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(EXP_LO_F - 1.0f)), _mm512_set1_ps(EXP_HI_F + 1.0f));
+
+        __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(xc, _mm512_set1_ps(LOG2E_F)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(LN2_HI_F), xc);
+        r = _mm512_fnmadd_ps(n, _mm512_set1_ps(LN2_LO_F), r);
+
+        __m512 p = _mm512_set1_ps(static_cast<float>(EXP_C[EXP_DEGREE_F]));
+        for (int k = EXP_DEGREE_F - 1; k >= 0; --k)
+            p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(static_cast<float>(EXP_C[k])));
+
+        __m512 result = _mm512_scalef_ps(p, n);
+        return _mm512_mask_mov_ps(result, _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q), x);
+    }
+
+    VM_TARGET_AVX512 inline __m512 LogAvx512F(__m512 x)
+    {
+        __m512 e = _mm512_getexp_ps(x);
+        __m512 m = _mm512_getmant_ps(x, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+
+        __mmask16 big = _mm512_cmp_ps_mask(m, _mm512_set1_ps(SQRT2_F), _CMP_GT_OQ);
+        m = _mm512_mask_mul_ps(m, big, m, _mm512_set1_ps(0.5f));
+        e = _mm512_mask_add_ps(e, big, e, _mm512_set1_ps(1.0f));
+
+        __m512 f = _mm512_div_ps(_mm512_sub_ps(m, _mm512_set1_ps(1.0f)), _mm512_add_ps(m, _mm512_set1_ps(1.0f)));
+        __m512 s = _mm512_mul_ps(f, f);
+
+        __m512 p = _mm512_set1_ps(static_cast<float>(LOG_C[LOG_TERMS_F - 1]));
+        for (int k = LOG_TERMS_F - 2; k >= 0; --k)
+            p = _mm512_fmadd_ps(p, s, _mm512_set1_ps(static_cast<float>(LOG_C[k])));
+
+        __m512 logm = _mm512_mul_ps(_mm512_add_ps(f, f), p);
+        return _mm512_fmadd_ps(e, _mm512_set1_ps(LN2_HI_F), _mm512_fmadd_ps(e, _mm512_set1_ps(LN2_LO_F), logm));
+    }
+
+    VM_TARGET_AVX512 inline __m512 GaussAvx512F(__m512 x)
+    {
+        __m512 hi = _mm512_mul_ps(x, x);
+        __m512 lo = _mm512_fmsub_ps(x, x, hi);
+        return _mm512_mul_ps(ExpAvx512F(_mm512_mul_ps(_mm512_set1_ps(-0.5f), hi)),
+            _mm512_fnmadd_ps(_mm512_set1_ps(0.5f), lo, _mm512_set1_ps(1.0f)));
+    }
+
+    VM_TARGET_AVX512 inline __m512 CdfAvx512F(__m512 x)
+    {
+        __m512 a = _mm512_abs_ps(x);
+        __m512 e = GaussAvx512F(a);
+
+        __m512 p = _mm512_set1_ps(static_cast<float>(CDF_P[0]));
+        for (int k = 1; k < 7; ++k) p = _mm512_fmadd_ps(p, a, _mm512_set1_ps(static_cast<float>(CDF_P[k])));
+        __m512 q = _mm512_set1_ps(static_cast<float>(CDF_Q[0]));
+        for (int k = 1; k < 8; ++k) q = _mm512_fmadd_ps(q, a, _mm512_set1_ps(static_cast<float>(CDF_Q[k])));
+        __m512 tail = _mm512_div_ps(_mm512_mul_ps(e, p), q);
+
+        __mmask16 far = _mm512_cmp_ps_mask(a, _mm512_set1_ps(static_cast<float>(CDF_SPLIT)), _CMP_GE_OQ);
+        if (far)
+        {
+            __m512 cf = a;
+            for (int k = CDF_CF_TERMS_F; k >= 1; --k)
+                cf = _mm512_add_ps(a, _mm512_div_ps(_mm512_set1_ps(static_cast<float>(k)), cf));
+            tail = _mm512_mask_mul_ps(tail, far, _mm512_div_ps(e, cf), _mm512_set1_ps(INV_SQRT_2PI_F));
+            tail = _mm512_mask_mov_ps(tail, _mm512_cmp_ps_mask(a, _mm512_set1_ps(CDF_CUTOFF_F), _CMP_GE_OQ), _mm512_setzero_ps());
+        }
+
+        __mmask16 positive = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ);
+        __m512 result = _mm512_mask_sub_ps(tail, positive, _mm512_set1_ps(1.0f), tail);
+        return _mm512_mask_mov_ps(result, _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q), x);
+    }
+
+    VM_TARGET_AVX512 inline __m512 SqrtAvx512F(__m512 x)
+    {
+        return _mm512_sqrt_ps(x);
+    }
+
+    VM_TARGET_AVX512 inline __m512 PdfAvx512F(__m512 x)
+    {
+        return _mm512_mul_ps(_mm512_set1_ps(INV_SQRT_2PI_F), GaussAvx512F(x));
+    }
+
+    template <__m512 (*Kernel)(__m512)>
+    VM_TARGET_AVX512 inline void ApplyAvx512F(const float* x, float* out, std::size_t n)
+    {
+        std::size_t i = 0;
+        for (; i + 16 <= n; i += 16)
+            _mm512_storeu_ps(out + i, Kernel(_mm512_loadu_ps(x + i)));
+
+        if (i < n)
+        {
+            __mmask16 m = static_cast<__mmask16>((1u << (n - i)) - 1u);
+            __m512 v = _mm512_mask_loadu_ps(_mm512_set1_ps(1.0f), m, x + i);
+            _mm512_mask_storeu_ps(out + i, m, Kernel(v));
+        }
+    }
+
+    VM_TARGET_AVX512 void ExpFAvx512Array(const float* x, float* out, std::size_t n)
+    {
+        ApplyAvx512F<ExpAvx512F>(x, out, n);
+    }
+
+    VM_TARGET_AVX512 void LogFAvx512Array(const float* x, float* out, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; i += 16)
+        {
+            std::size_t count = (n - i < 16) ? n - i : 16;
+            __mmask16 m = static_cast<__mmask16>((1u << count) - 1u);
+            __m512 v = _mm512_mask_loadu_ps(_mm512_set1_ps(1.0f), m, x + i);
+
+            __mmask16 ok = _mm512_cmp_ps_mask(v, _mm512_setzero_ps(), _CMP_GT_OQ)
+                & _mm512_cmp_ps_mask(v, _mm512_set1_ps(HUGE_VALF), _CMP_LT_OQ);
+            _mm512_mask_storeu_ps(out + i, m, LogAvx512F(v));
+
+            __mmask16 bad = static_cast<__mmask16>(m & ~ok);
+            for (std::size_t j = 0; bad && j < count; ++j)
+                if (bad & (1u << j)) out[i + j] = std::log(x[i + j]);
+        }
+    }
+
+    VM_TARGET_AVX512 void SqrtFAvx512Array(const float* x, float* out, std::size_t n)
+    {
+        ApplyAvx512F<SqrtAvx512F>(x, out, n);
+    }
+
+    VM_TARGET_AVX512 void CdfFAvx512Array(const float* x, float* out, std::size_t n)
+    {
+        ApplyAvx512F<CdfAvx512F>(x, out, n);
+    }
+
+    VM_TARGET_AVX512 void PdfFAvx512Array(const float* x, float* out, std::size_t n)
+    {
+        ApplyAvx512F<PdfAvx512F>(x, out, n);
+    }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // VM_X86
+
+    // ---------------- Runtime detection ----------------
+
+    SimdLevel Detect()
+    {
+#if VM_X86 && defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return SimdLevel::Scalar;
+
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool fma = (info[2] & (1 << 12)) != 0;
+        if (!osxsave) return SimdLevel::Scalar;
+
+        unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0 && fma && (xcr0 & 0x6) == 0x6;
+        bool avx512 = (info[1] & (1 << 16)) != 0 && avx2 && (xcr0 & 0xE6) == 0xE6;
+
+        if (avx512) return SimdLevel::AVX512;
+        if (avx2) return SimdLevel::AVX2;
+#elif VM_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+#endif
+        return SimdLevel::Scalar;
+    }
+
+    std::atomic<SimdLevel>& ActiveLevelRef()
+    {
+        static std::atomic<SimdLevel> level(VectorMath::DetectedLevel());
+        return level;
+    }
+
+    // Picks the kernel for the active level; the switch costs one predictable branch per array call
+    template <typename ArrayKernel>
+    inline ArrayKernel Select(ArrayKernel scalar, ArrayKernel avx2, ArrayKernel avx512)
+    {
+        switch (ActiveLevelRef().load(std::memory_order_relaxed))
+        {
+        case SimdLevel::AVX512: return avx512;
+        case SimdLevel::AVX2:   return avx2;
+        default:                return scalar;
+        }
+    }
+}
+
+#if VM_X86
+#define VM_SELECT(name) Select(name##ScalarArray, name##Avx2Array, name##Avx512Array)
+#else
+#define VM_SELECT(name) name##ScalarArray
+#endif
+
+SimdLevel VectorMath::DetectedLevel()
+{
+    static const SimdLevel detected = Detect();
+    return detected;
+}
+
+SimdLevel VectorMath::ActiveLevel()
+{
+    return ActiveLevelRef().load();
+}
+
+void VectorMath::SetActiveLevel(SimdLevel level)
+{
+    if (static_cast<int>(level) > static_cast<int>(DetectedLevel()))
+        level = DetectedLevel();
+    ActiveLevelRef().store(level);
+}
+
+const char* VectorMath::LevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX512: return "AVX-512";
+    case SimdLevel::AVX2:   return "AVX2";
+    default:                return "Scalar";
+    }
+}
+
+void VectorMath::Exp(const double* x, double* out, std::size_t n)     { VM_SELECT(Exp)(x, out, n); }
+void VectorMath::Log(const double* x, double* out, std::size_t n)     { VM_SELECT(Log)(x, out, n); }
+void VectorMath::Sqrt(const double* x, double* out, std::size_t n)    { VM_SELECT(Sqrt)(x, out, n); }
+void VectorMath::NormCdf(const double* x, double* out, std::size_t n) { VM_SELECT(Cdf)(x, out, n); }
+void VectorMath::NormPdf(const double* x, double* out, std::size_t n) { VM_SELECT(Pdf)(x, out, n); }
+
+void VectorMath::Exp(const float* x, float* out, std::size_t n)      { VM_SELECT(ExpF)(x, out, n); }
+void VectorMath::Log(const float* x, float* out, std::size_t n)      { VM_SELECT(LogF)(x, out, n); }
+void VectorMath::Sqrt(const float* x, float* out, std::size_t n)     { VM_SELECT(SqrtF)(x, out, n); }
+void VectorMath::NormCdf(const float* x, float* out, std::size_t n)  { VM_SELECT(CdfF)(x, out, n); }
+void VectorMath::NormPdf(const float* x, float* out, std::size_t n)  { VM_SELECT(PdfF)(x, out, n); }
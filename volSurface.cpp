@@ -0,0 +1,452 @@
+
+#include "VolSurface.h"
+#include "VectorMath.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+
+namespace
+{
+    // Quotes of one expiry in SVI coordinates: log forward moneyness and total variance
+    struct SliceQuotes
+    {
+        double T = 0.0;
+        double forward = 0.0;
+        std::vector<double> k, w, weight, vol;
+    };
+
+    // Weighted least squares of w on up to three basis functions: basis[p][j] is function p at quote j.
+    // Returns false when the normal equations are singular.
+    bool LeastSquares(const SliceQuotes& q, const std::vector<double>* basis, int count, double* coef)
+    {
+        double A[3][4] = {};
+        const std::size_t n = q.w.size();
+        for (std::size_t j = 0; j < n; ++j)
+            for (int r = 0; r < count; ++r)
+            {
+                const double br = q.weight[j] * basis[r][j];
+                for (int c = 0; c < count; ++c) A[r][c] += br * basis[c][j];
+                A[r][count] += br * q.w[j];
+            }
+
+        // Gaussian elimination with partial pivoting
+        for (int c = 0; c < count; ++c)
+        {
+            int pivot = c;
+            for (int r = c + 1; r < count; ++r)
+                if (std::fabs(A[r][c]) > std::fabs(A[pivot][c])) pivot = r;
+            if (!(std::fabs(A[pivot][c]) > 1e-300)) return false;
+            for (int k = 0; k <= count; ++k) std::swap(A[c][k], A[pivot][k]);
+            for (int r = c + 1; r < count; ++r)
+            {
+                const double f = A[r][c] / A[c][c];
+                for (int k = c; k <= count; ++k) A[r][k] -= f * A[c][k];
+            }
+        }
+        for (int r = count - 1; r >= 0; --r)
+        {
+            double sum = A[r][count];
+            for (int c = r + 1; c < count; ++c) sum -= A[r][c] * coef[c];
+            coef[r] = sum / A[r][r];
+        }
+        return true;
+    }
+
+    double Objective(const SliceQuotes& q, const SviParams& p)
+    {
+        double sum = 0.0;
+        for (std::size_t j = 0; j < q.w.size(); ++j)
+        {
+            const double e = VolSurface::Svi(p, q.k[j]) - q.w[j];
+            sum += q.weight[j] * e * e;
+        }
+        return sum;
+    }
+
+    // Best (a, b, rho) for fixed (m, sigma): the free solution of w = a + c y + d sqrt(y^2 + sigma^2) (y = k - m,
+    // c = b rho, d = b) when it meets the SVI constraints, otherwise the best of the boundary fits rho = +1, rho = -1
+    // and b = 0
+    SviParams InnerFit(const SliceQuotes& q, double m, double sigma, double& objective)
+    {
+        const std::size_t n = q.w.size();
+        std::vector<double> basis[3];
+        basis[0].assign(n, 1.0);
+        basis[1].resize(n);
+        basis[2].resize(n);
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            const double y = q.k[j] - m;
+            basis[1][j] = y;
+            basis[2][j] = std::sqrt(y * y + sigma * sigma);
+        }
+
+        // Flat smile: always admissible
+        SviParams best;
+        best.m = m; best.sigma = sigma;
+        double sumW = 0.0, sumWeight = 0.0;
+        for (std::size_t j = 0; j < n; ++j) { sumW += q.weight[j] * q.w[j]; sumWeight += q.weight[j]; }
+        best.a = sumW / sumWeight;
+        objective = Objective(q, best);
+
+        auto consider = [&](double a, double c, double d)
+        {
+            if (!(d >= 0.0) || !(std::fabs(c) <= d * (1.0 + 1e-12))) return;
+            SviParams p;
+            p.a = a; p.b = d; p.rho = (d > 0.0) ? std::max(-1.0, std::min(1.0, c / d)) : 0.0; p.m = m; p.sigma = sigma;
+            if (!(p.a + p.b * p.sigma * std::sqrt(std::max(0.0, 1.0 - p.rho * p.rho)) >= 0.0)) return;
+            const double f = Objective(q, p);
+            if (f < objective) { objective = f; best = p; }
+        };
+
+        double coef[3];
+        if (LeastSquares(q, basis, 3, coef)) consider(coef[0], coef[1], coef[2]);
+
+        // rho = +1 / -1: w = a + b (sqrt(y^2 + sigma^2) +- y)
+        for (double rho : { 1.0, -1.0 })
+        {
+            std::vector<double> edge[2] = { basis[0], basis[2] };
+            for (std::size_t j = 0; j < n; ++j) edge[1][j] += rho * basis[1][j];
+            if (LeastSquares(q, edge, 2, coef)) consider(coef[0], rho * coef[1], coef[1]);
+        }
+        return best;
+    }
+
+    // Nelder-Mead over x = (m, log sigma) with the linear parameters solved inside; returns iterations used
+    int Search(const SliceQuotes& q, double x[2], const VolCalibrationSettings& settings)
+    {
+        auto f = [&q](const double* p)
+        {
+            double objective;
+            InnerFit(q, p[0], std::exp(std::max(-9.0, std::min(2.0, p[1]))), objective);
+            return objective;
+        };
+
+        double simplex[3][2] = { { x[0], x[1] }, { x[0] + 0.1, x[1] }, { x[0], x[1] + 1.0 } };
+        double values[3];
+        for (int i = 0; i < 3; ++i) values[i] = f(simplex[i]);
+
+        int iteration = 0;
+        for (; iteration < settings.maxIterations; ++iteration)
+        {
+            // Order: best, middle, worst
+            int order[3] = { 0, 1, 2 };
+            std::sort(order, order + 3, [&values](int a, int b) { return values[a] < values[b]; });
+            const int best = order[0], middle = order[1], worst = order[2];
+            if (values[worst] - values[best] <= settings.tolerance) break;
+
+            double centroid[2], trial[2], expanded[2];
+            for (int d = 0; d < 2; ++d)
+            {
+                centroid[d] = 0.5 * (simplex[best][d] + simplex[middle][d]);
+                trial[d] = 2.0 * centroid[d] - simplex[worst][d];
+            }
+            const double fr = f(trial);
+
+            if (fr < values[best])
+            {
+                for (int d = 0; d < 2; ++d) expanded[d] = 3.0 * centroid[d] - 2.0 * simplex[worst][d];
+                const double fe = f(expanded);
+                const double* keep = (fe < fr) ? expanded : trial;
+                for (int d = 0; d < 2; ++d) simplex[worst][d] = keep[d];
+                values[worst] = std::min(fe, fr);
+            }
+            else if (fr < values[middle])
+            {
+                for (int d = 0; d < 2; ++d) simplex[worst][d] = trial[d];
+                values[worst] = fr;
+            }
+            else
+            {
+                // Contract towards the better of the worst point and its reflection
+                const bool outside = fr < values[worst];
+                for (int d = 0; d < 2; ++d)
+                    trial[d] = centroid[d] + 0.5 * ((outside ? trial[d] : simplex[worst][d]) - centroid[d]);
+                const double fc = f(trial);
+                if (fc < std::min(fr, values[worst]))
+                {
+                    for (int d = 0; d < 2; ++d) simplex[worst][d] = trial[d];
+                    values[worst] = fc;
+                }
+                else
+                {
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        if (i == best) continue;
+                        for (int d = 0; d < 2; ++d) simplex[i][d] = simplex[best][d] + 0.5 * (simplex[i][d] - simplex[best][d]);
+                        values[i] = f(simplex[i]);
+                    }
+                }
+            }
+        }
+
+        const int best = static_cast<int>(std::min_element(values, values + 3) - values);
+        x[0] = simplex[best][0];
+        x[1] = simplex[best][1];
+        return iteration;
+    }
+
+    // Fits one expiry: a search from the quote with the lowest variance, then a restart from the result
+    VolSlice FitSlice(const SliceQuotes& q, const VolCalibrationSettings& settings, int& iterations)
+    {
+        VolSlice slice;
+        slice.T = q.T;
+        slice.forward = q.forward;
+        slice.quotes = q.w.size();
+        iterations = 0;
+
+        double objective;
+        if (q.w.size() < 5)
+        {
+            double sumW = 0.0, sumWeight = 0.0;
+            for (std::size_t j = 0; j < q.w.size(); ++j) { sumW += q.weight[j] * q.w[j]; sumWeight += q.weight[j]; }
+            slice.svi.a = sumW / sumWeight;
+        }
+        else
+        {
+            const std::size_t lowest = std::min_element(q.w.begin(), q.w.end()) - q.w.begin();
+            double x[2] = { q.k[lowest], std::log(0.1) };
+            iterations += Search(q, x, settings);
+            iterations += Search(q, x, settings);
+            slice.svi = InnerFit(q, x[0], std::exp(std::max(-9.0, std::min(2.0, x[1]))), objective);
+        }
+
+        double sumSq = 0.0;
+        for (std::size_t j = 0; j < q.w.size(); ++j)
+        {
+            const double e = std::sqrt(std::max(0.0, VolSurface::Svi(slice.svi, q.k[j])) / q.T) - q.vol[j];
+            sumSq += e * e;
+        }
+        slice.rmse = std::sqrt(sumSq / q.w.size());
+        return slice;
+    }
+}
+
+double VolSurface::Svi(const SviParams& p, double k)
+{
+    const double y = k - p.m;
+    return p.a + p.b * (p.rho * y + std::sqrt(y * y + p.sigma * p.sigma));
+}
+
+VolCalibrationStats VolSurface::Calibrate(const std::vector<VolQuote>& quotes,
+    const VolCalibrationSettings& settings,
+    const ParallelOptions& options)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    VolCalibrationStats stats;
+
+    // Group by expiry; the map keeps the expiries in increasing order
+    std::map<double, SliceQuotes> byExpiry;
+    for (const VolQuote& quote : quotes)
+    {
+        if (!(quote.T > 0.0) || !(quote.K > 0.0) || !(quote.forward > 0.0) || !(quote.vol > 0.0) || !(quote.weight > 0.0))
+        {
+            ++stats.rejected;
+            continue;
+        }
+        SliceQuotes& q = byExpiry[quote.T];
+        if (q.w.empty()) { q.T = quote.T; q.forward = quote.forward; }
+        q.k.push_back(std::log(quote.K / quote.forward));
+        q.w.push_back(quote.vol * quote.vol * quote.T);
+        q.weight.push_back(quote.weight);
+        q.vol.push_back(quote.vol);
+        ++stats.quotes;
+    }
+
+    std::vector<const SliceQuotes*> expiries;
+    for (const auto& e : byExpiry) expiries.push_back(&e.second);
+
+    // One task per expiry; each writes only its own slot
+    std::vector<VolSlice> fitted(expiries.size());
+    std::vector<int> iterations(expiries.size(), 0);
+    ThreadPool& pool = options.pool ? *options.pool : ThreadPool::Shared();
+    pool.ParallelFor(expiries.size(), 1, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t e = begin; e < end; ++e)
+            fitted[e] = FitSlice(*expiries[e], settings, iterations[e]);
+    }, options.threads);
+
+    slices.swap(fitted);
+    Rebuild();
+
+    stats.expiries = slices.size();
+    for (std::size_t e = 0; e < slices.size(); ++e)
+    {
+        stats.iterations += iterations[e];
+        stats.maxRmse = std::max(stats.maxRmse, slices[e].rmse);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return stats;
+}
+
+bool VolSurface::SetSlice(const VolSlice& slice)
+{
+    const SviParams& p = slice.svi;
+    if (!(slice.T > 0.0) || !(slice.forward > 0.0) || !(p.b >= 0.0) || !(std::fabs(p.rho) <= 1.0) || !(p.sigma > 0.0)
+        || !(p.a + p.b * p.sigma * std::sqrt(1.0 - p.rho * p.rho) >= 0.0))
+        return false;
+
+    auto it = std::lower_bound(slices.begin(), slices.end(), slice.T,
+        [](const VolSlice& s, double T) { return s.T < T; });
+    if (it != slices.end() && it->T == slice.T) *it = slice;
+    else slices.insert(it, slice);
+    Rebuild();
+    return true;
+}
+
+void VolSurface::Clear()
+{
+    slices.clear();
+    coefficients.clear();
+}
+
+void VolSurface::Rebuild()
+{
+    const std::size_t n = slices.size();
+    coefficients.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const SviParams& p = slices[i].svi;
+        Coefficients& c = coefficients[i];
+        c.T = slices[i].T;
+        c.logForward = std::log(slices[i].forward);
+        c.a = p.a; c.bRho = p.b * p.rho; c.b = p.b; c.m = p.m; c.sigma2 = p.sigma * p.sigma;
+    }
+    for (std::size_t i = 0; i + 1 < n; ++i)
+    {
+        coefficients[i].invSpan = 1.0 / (coefficients[i + 1].T - coefficients[i].T);
+        coefficients[i].logForwardSlope = (coefficients[i + 1].logForward - coefficients[i].logForward) * coefficients[i].invSpan;
+    }
+    if (n > 0)
+    {
+        coefficients[n - 1].invSpan = 0.0;
+        coefficients[n - 1].logForwardSlope = (n > 1) ? coefficients[n - 2].logForwardSlope : 0.0;
+    }
+}
+
+double VolSurface::Evaluate(const Coefficients& c, double k)
+{
+    const double y = k - c.m;
+    return c.a + c.bRho * y + c.b * std::sqrt(y * y + c.sigma2);
+}
+
+std::size_t VolSurface::Interval(double T, std::size_t hint) const
+{
+    const std::size_t n = coefficients.size();
+    if (hint < n && coefficients[hint].T <= T && (hint + 1 == n || T < coefficients[hint + 1].T)) return hint;
+
+    auto it = std::upper_bound(coefficients.begin(), coefficients.end(), T,
+        [](double t, const Coefficients& c) { return t < c.T; });
+    const std::size_t i = it - coefficients.begin();
+    return (i == 0) ? 0 : i - 1;
+}
+
+// Inside [T_i, T_i+1): linear in T between the two slices at the same k. Before the first or after the last expiry
+// the nearest slice is scaled by T / T_i, which holds its implied vol at that k.
+double VolSurface::VarianceAt(double logK, double T, std::size_t i) const
+{
+    const Coefficients& c = coefficients[i];
+    const double k = logK - (c.logForward + c.logForwardSlope * (T - c.T));
+    const double w0 = Evaluate(c, k);
+
+    double w;
+    if (T < c.T || c.invSpan == 0.0)
+        w = w0 * T / c.T;
+    else
+        w = w0 + (T - c.T) * c.invSpan * (Evaluate(coefficients[i + 1], k) - w0);
+    return std::max(w, 0.0);
+}
+
+double VolSurface::TotalVariance(double K, double T) const
+{
+    if (coefficients.empty() || !(K > 0.0) || !(T > 0.0)) return std::numeric_limits<double>::quiet_NaN();
+    return VarianceAt(std::log(K), T, Interval(T, 0));
+}
+
+double VolSurface::Vol(double K, double T) const
+{
+    return std::sqrt(TotalVariance(K, T) / T);
+}
+
+// Per chunk: the logs in SIMD; one pass resolving the interval and forward shift once per run of equal T and
+// collecting y^2 + sigma^2 for the slices on both sides; the square roots of both in SIMD; one pass assembling
+// w / T; and its square root in SIMD. The arithmetic is VarianceAt()'s in the same order, so the result equals Vol().
+void VolSurface::Vol(const double* K, const double* T, std::size_t n, double* out) const
+{
+    const std::size_t CHUNK = 256;
+    const std::size_t none = static_cast<std::size_t>(-1);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    if (coefficients.empty())
+    {
+        for (std::size_t i = 0; i < n; ++i) out[i] = nan;
+        return;
+    }
+
+    double logK[CHUNK], y0[CHUNK], y1[CHUNK], root0[CHUNK], root1[CHUNK], variance[CHUNK];
+    std::size_t slice[CHUNK];
+    std::size_t hint = 0;
+    for (std::size_t start = 0; start < n; start += CHUNK)
+    {
+        const std::size_t m = std::min(CHUNK, n - start);
+        VectorMath::Log(K + start, logK, m);
+
+        double runT = nan, shift = 0.0;
+        bool between = false;
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            const std::size_t i = start + j;
+            if (!(K[i] > 0.0) || !(T[i] > 0.0))
+            {
+                slice[j] = none;
+                root0[j] = root1[j] = 0.0;
+                continue;
+            }
+            if (T[i] != runT)
+            {
+                runT = T[i];
+                hint = Interval(runT, hint);
+                const Coefficients& c = coefficients[hint];
+                shift = c.logForward + c.logForwardSlope * (runT - c.T);
+                between = !(runT < c.T || c.invSpan == 0.0);
+            }
+
+            const Coefficients& c = coefficients[hint];
+            const double k = logK[j] - shift;
+            slice[j] = hint;
+            y0[j] = k - c.m;
+            root0[j] = y0[j] * y0[j] + c.sigma2;
+            if (between)
+            {
+                const Coefficients& d = coefficients[hint + 1];
+                y1[j] = k - d.m;
+                root1[j] = y1[j] * y1[j] + d.sigma2;
+            }
+            else
+                root1[j] = 0.0;
+        }
+
+        VectorMath::Sqrt(root0, root0, m);
+        VectorMath::Sqrt(root1, root1, m);
+
+        for (std::size_t j = 0; j < m; ++j)
+        {
+            if (slice[j] == none) { variance[j] = nan; continue; }
+            const Coefficients& c = coefficients[slice[j]];
+            const double t = T[start + j];
+            const double w0 = c.a + c.bRho * y0[j] + c.b * root0[j];
+
+            double w;
+            if (t < c.T || c.invSpan == 0.0)
+                w = w0 * t / c.T;
+            else
+            {
+                const Coefficients& d = coefficients[slice[j] + 1];
+                w = w0 + (t - c.T) * c.invSpan * (d.a + d.bRho * y1[j] + d.b * root1[j] - w0);
+            }
+            variance[j] = std::max(w, 0.0) / t;
+        }
+
+        VectorMath::Sqrt(variance, out + start, m);
+    }
+}